@@ -6,11 +6,15 @@
 
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE /*hPrev*/, LPWSTR /*lpCmdLine*/, const int nCmdShow)
 {
-    // Create your thread pool (adjust constructor to your implementation)
-    StdThreadPool pool(4); // assumes a constructor that takes thread count
+    // Create registry facade: default cache config, with change notifications so cached keys
+    // stay valid until they change instead of expiring after the TTLs. Declared before the pool:
+    // the pool's destructor waits for tasks still using the facade.
+    core::registry::RegistryFacade::WatchConfig watchConfig;
+    watchConfig.enabled = true;
+    core::registry::RegistryFacade facade(core::registry::RegistryFacade::CacheConfig{}, watchConfig);
 
-    // Create registry facade (default config)
-    core::registry::RegistryFacade facade;
+    // Create your thread pool (adjust constructor to your implementation)
+    StdThreadPool pool(4, SchedulingMode::WorkStealing);
 
     // Create and initialize the main window (UI thread).
     MainWindow wnd(hInstance, &pool, &facade);
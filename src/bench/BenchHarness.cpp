@@ -0,0 +1,156 @@
+// BenchHarness.cpp
+#include "BenchHarness.h"
+#include <windows.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <thread>
+
+namespace bench
+{
+
+namespace {
+
+    void AppendString(std::string& out, const std::string_view text)
+    {
+        out += '"';
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out += '\\';
+                out += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out += escaped;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    void AppendNumber(std::string& out, const double value)
+    {
+        char buffer[32];
+        if (!std::isfinite(value))
+        {
+            out += "null";
+            return;
+        }
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        out += buffer;
+    }
+
+    void AppendField(std::string& out, const std::string_view name, const double value)
+    {
+        out += ',';
+        AppendString(out, name);
+        out += ':';
+        AppendNumber(out, value);
+    }
+
+    double Percentile(std::vector<double> const& sorted, const double fraction)
+    {
+        const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+} // anonymous namespace
+
+Summary Summarize(std::vector<double>& samples)
+{
+    Summary summary;
+    if (samples.empty())
+    {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    summary.min = samples.front();
+    summary.p50 = Percentile(samples, 0.50);
+    summary.p90 = Percentile(samples, 0.90);
+    summary.p99 = Percentile(samples, 0.99);
+    summary.max = samples.back();
+    return summary;
+}
+
+bool Selected(BenchConfig const& config, const std::string_view bench)
+{
+    return config.filter.empty() || bench.find(config.filter) != std::string_view::npos;
+}
+
+Reporter::Reporter(std::FILE* out) noexcept
+    : m_out(out)
+{
+}
+
+void Reporter::Header(BenchConfig const& config)
+{
+    SYSTEMTIME now;
+    GetSystemTime(&now);
+    char timestamp[32];
+    std::snprintf(timestamp, sizeof(timestamp), "%04u-%02u-%02uT%02u:%02u:%02uZ",
+                  now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond);
+
+    std::string line = "{\"suite\":\"core_bench\",\"format\":1,\"timestamp\":";
+    AppendString(line, timestamp);
+    AppendField(line, "hardware_threads", std::thread::hardware_concurrency());
+    line += ",\"quick\":";
+    line += config.quick ? "true" : "false";
+    AppendField(line, "repeat", static_cast<double>(config.repeat));
+    line += ",\"filter\":";
+    AppendString(line, config.filter);
+    line += '}';
+    Emit(line);
+}
+
+void Reporter::Result(BenchResult const& result)
+{
+    std::string line = "{\"bench\":";
+    AppendString(line, result.bench);
+    line += ",\"variant\":";
+    AppendString(line, result.variant);
+    AppendField(line, "iterations", static_cast<double>(result.iterations));
+    line += ",\"unit\":";
+    AppendString(line, result.unit);
+    AppendField(line, "mean", result.summary.mean);
+    AppendField(line, "min", result.summary.min);
+    AppendField(line, "p50", result.summary.p50);
+    AppendField(line, "p90", result.summary.p90);
+    AppendField(line, "p99", result.summary.p99);
+    AppendField(line, "max", result.summary.max);
+    for (const auto& [name, value] : result.metrics)
+    {
+        AppendField(line, name, value);
+    }
+    line += '}';
+    Emit(line);
+}
+
+void Reporter::Error(const std::string_view bench, const std::string_view variant, const std::string_view error)
+{
+    std::string line = "{\"bench\":";
+    AppendString(line, bench);
+    line += ",\"variant\":";
+    AppendString(line, variant);
+    line += ",\"error\":";
+    AppendString(line, error);
+    line += '}';
+    Emit(line);
+}
+
+void Reporter::Emit(const std::string_view line)
+{
+    std::fwrite(line.data(), 1, line.size(), m_out);
+    std::fputc('\n', m_out);
+    std::fflush(m_out);
+}
+
+} // namespace bench
@@ -0,0 +1,92 @@
+// BenchHarness.h
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * core_bench harness.
+ *
+ * Every measurement is written as one NDJSON line:
+ *   {"bench":"registry.list_subkeys","variant":"wide/cold","iterations":50,"unit":"ns",
+ *    "mean":..,"min":..,"p50":..,"p90":..,"p99":..,"max":..,<metric>:..}
+ * preceded by one {"suite":"core_bench",...} line describing the run. Workload sizes are
+ * fixed (--quick divides them by ten), so two runs of the same build do the same work and
+ * their lines can be compared field by field.
+ */
+namespace bench
+{
+
+struct BenchConfig
+{
+    bool quick = false;
+    std::string filter;             // run only benchmarks whose name contains this
+    size_t repeat = 1;              // measurements per variant, each reported separately
+
+    // Workload size: full in a normal run, a tenth with --quick (at least 1).
+    [[nodiscard]] size_t Scale(size_t full) const noexcept
+    {
+        return quick ? (full / 10 > 0 ? full / 10 : 1) : full;
+    }
+};
+
+struct Summary
+{
+    double mean = 0;
+    double min = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+// Sorts samples in place.
+Summary Summarize(std::vector<double>& samples);
+
+struct BenchResult
+{
+    std::string bench;
+    std::string variant;
+    size_t iterations = 0;
+    std::string unit = "ns";
+    Summary summary;
+    std::vector<std::pair<std::string, double>> metrics;    // ops_per_sec, mb_per_sec, ...
+};
+
+class Reporter
+{
+public:
+    explicit Reporter(std::FILE* out) noexcept;
+
+    void Header(BenchConfig const& config);
+    void Result(BenchResult const& result);
+
+    // One line for a benchmark that could not run: {"bench":..,"variant":..,"error":..}.
+    void Error(std::string_view bench, std::string_view variant, std::string_view error);
+
+private:
+    void Emit(std::string_view line);
+
+    std::FILE* m_out;
+};
+
+[[nodiscard]] bool Selected(BenchConfig const& config, std::string_view bench);
+
+// Nanoseconds since start; samples are kept as doubles for Summarize().
+inline double ElapsedNs(const std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Suites; each writes its own results and cleans up what it created.
+void RunRegistryBenchmarks(BenchConfig const& config, Reporter& reporter);
+void RunThreadPoolBenchmarks(BenchConfig const& config, Reporter& reporter);
+void RunLoggerBenchmarks(BenchConfig const& config, Reporter& reporter);
+
+} // namespace bench
@@ -0,0 +1,246 @@
+// LoggerBench.cpp
+// Logger::log() rate under each OverflowPolicy, and FileLogger write bandwidth.
+#include "BenchHarness.h"
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include "loggin/Logger.h"
+#include "loggin/FileLogger.h"
+
+using namespace core::logging;
+
+namespace bench
+{
+
+namespace {
+
+    constexpr size_t kLoggerRounds = 3;
+
+    // Message of a typical registry operation record.
+    constexpr std::string_view kMessage = "Value written by core_bench: synthetic payload for throughput measurement";
+
+    class CountingSink final : public ILogSink
+    {
+    public:
+        void consume(const std::vector<LogRecord>& batch) override
+        {
+            m_records.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+
+        void flush() override
+        {
+        }
+
+        [[nodiscard]] size_t Records() const noexcept
+        {
+            return m_records.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<size_t> m_records{0};
+    };
+
+    const char* PolicyName(const OverflowPolicy policy) noexcept
+    {
+        switch (policy)
+        {
+            case OverflowPolicy::DropOldest: return "drop_oldest";
+            case OverflowPolicy::DropNewest: return "drop_newest";
+            case OverflowPolicy::Block: return "block";
+        }
+        return "unknown";
+    }
+
+    // Logs perProducer records from each of producers threads; returns the elapsed nanoseconds.
+    double LogFromThreads(Logger& logger, const size_t producers, const size_t perProducer)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(producers);
+            for (size_t p = 0; p < producers; ++p)
+            {
+                threads.emplace_back([&logger, perProducer]
+                {
+                    for (size_t i = 0; i < perProducer; ++i)
+                    {
+                        logger.log(LogLevel::Info, kMessage, "set_value", "HKEY_CURRENT_USER\\Software\\core_bench",
+                                   "Value0", "{\"data\":1}", "{\"data\":2}");
+                    }
+                });
+            }
+        }
+        return ElapsedNs(start);
+    }
+
+    void MeasureEnqueue(Reporter& reporter, BenchConfig const& config, const OverflowPolicy policy,
+                        const size_t producers)
+    {
+        const size_t records = config.Scale(500000);
+        const size_t perProducer = records / producers;
+        const size_t total = perProducer * producers;
+
+        for (size_t run = 0; run < config.repeat; ++run)
+        {
+            std::vector<double> samples;
+            size_t dropped = 0;
+            size_t delivered = 0;
+
+            for (size_t round = 0; round < kLoggerRounds; ++round)
+            {
+                Logger logger(MAX_LOGGING_QUEUE_SIZE, LoggingProfile::Medium, policy);
+                const auto sink = std::make_shared<CountingSink>();
+                logger.addSink(sink);
+                logger.start();
+
+                samples.push_back(LogFromThreads(logger, producers, perProducer) / static_cast<double>(total));
+
+                logger.flush();
+                dropped += logger.droppedCount();
+                delivered += sink->Records();
+                logger.shutdown(false);
+            }
+
+            BenchResult result;
+            result.bench = "logger.enqueue";
+            result.variant = std::string(PolicyName(policy)) + "/producers=" + std::to_string(producers);
+            result.iterations = kLoggerRounds;
+            result.unit = "ns_per_record";
+            result.summary = Summarize(samples);
+            result.metrics.emplace_back("records_per_round", static_cast<double>(total));
+            result.metrics.emplace_back("records_per_sec", result.summary.mean > 0 ? 1e9 / result.summary.mean : 0);
+            result.metrics.emplace_back("dropped_per_round", static_cast<double>(dropped) / kLoggerRounds);
+            result.metrics.emplace_back("delivered_per_round", static_cast<double>(delivered) / kLoggerRounds);
+            reporter.Result(result);
+        }
+    }
+
+    std::wstring ScratchDirectory()
+    {
+        wchar_t temp[MAX_PATH + 1] = {};
+        const DWORD length = GetTempPathW(MAX_PATH + 1, temp);
+        std::wstring directory(temp, length);
+        if (!directory.empty() && directory.back() != L'\\')
+        {
+            directory += L'\\';
+        }
+        return directory + L"core_bench-" + std::to_wstring(GetCurrentProcessId());
+    }
+
+    void RemoveScratchDirectory(std::wstring const& directory)
+    {
+        WIN32_FIND_DATAW data;
+        HANDLE find = FindFirstFileW((directory + L"\\*").c_str(), &data);
+        if (find != INVALID_HANDLE_VALUE)
+        {
+            do
+            {
+                if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+                {
+                    DeleteFileW((directory + L"\\" + data.cFileName).c_str());
+                }
+            } while (FindNextFileW(find, &data));
+            FindClose(find);
+        }
+        RemoveDirectoryW(directory.c_str());
+    }
+
+    ULONGLONG FileBytes(std::wstring const& path)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+        {
+            return 0;
+        }
+        return (static_cast<ULONGLONG>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    }
+
+    // Block policy, so every record reaches the file; bandwidth covers log() to flush().
+    void MeasureFileLogger(Reporter& reporter, BenchConfig const& config, const FileWriteMode mode,
+                           const char* variant)
+    {
+        const size_t records = config.Scale(500000);
+        const std::wstring directory = ScratchDirectory();
+        const std::wstring fileName = L"bench.log";
+
+        for (size_t run = 0; run < config.repeat; ++run)
+        {
+            std::vector<double> samples;
+            double bytes = 0;
+
+            for (size_t round = 0; round < kLoggerRounds; ++round)
+            {
+                FileLoggerOptions options;
+                options.maxFileBytes = 1ull << 40;     // no rotation during the measurement
+                options.writeMode = mode;
+
+                {
+                    Logger logger(MAX_LOGGING_QUEUE_SIZE, LoggingProfile::Medium, OverflowPolicy::Block);
+                    auto sink = std::make_shared<FileLogger>(directory, fileName, options);
+                    logger.addSink(sink);
+                    logger.start();
+
+                    const auto start = std::chrono::steady_clock::now();
+                    LogFromThreads(logger, 1, records);
+                    logger.flush();
+                    const double elapsed = ElapsedNs(start);
+
+                    const ULONGLONG written = FileBytes(directory + L"\\" + fileName);
+                    samples.push_back(elapsed);
+                    bytes += static_cast<double>(written);
+
+                    logger.shutdown(false);
+                    sink->close();
+                }
+                RemoveScratchDirectory(directory);
+            }
+
+            BenchResult result;
+            result.bench = "logger.file";
+            result.variant = variant;
+            result.iterations = kLoggerRounds;
+            result.summary = Summarize(samples);
+
+            const double meanBytes = bytes / kLoggerRounds;
+            result.metrics.emplace_back("records_per_round", static_cast<double>(records));
+            result.metrics.emplace_back("bytes_per_round", meanBytes);
+            result.metrics.emplace_back("mb_per_sec", result.summary.mean > 0
+                                        ? meanBytes / (1024.0 * 1024.0) / (result.summary.mean / 1e9) : 0);
+            reporter.Result(result);
+        }
+    }
+
+} // anonymous namespace
+
+void RunLoggerBenchmarks(BenchConfig const& config, Reporter& reporter)
+{
+    try
+    {
+        if (Selected(config, "logger.enqueue"))
+        {
+            const size_t producerCounts[] = {1, std::max<size_t>(2, std::thread::hardware_concurrency() / 2)};
+            for (const OverflowPolicy policy : {OverflowPolicy::DropOldest, OverflowPolicy::DropNewest, OverflowPolicy::Block})
+            {
+                for (const size_t producers : producerCounts)
+                {
+                    MeasureEnqueue(reporter, config, policy, producers);
+                }
+            }
+        }
+
+        if (Selected(config, "logger.file"))
+        {
+            MeasureFileLogger(reporter, config, FileWriteMode::Synchronous, "synchronous");
+            MeasureFileLogger(reporter, config, FileWriteMode::Overlapped, "overlapped");
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        reporter.Error("logger", "run", ex.what());
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,231 @@
+// RegistryBench.cpp
+// ListSubKeys / ListValues / ListSubKeysWithInfo through RegistryFacade on synthetic trees under
+// a scratch HKCU key. ListSubKeys and ListValues only reuse cached key handles, so their variants
+// are "handles-cold" / "handles-warm"; ListSubKeysWithInfo is answered from the listing cache,
+// its variants are "listing-cold" / "listing-warm".
+#include "BenchHarness.h"
+#include <windows.h>
+#include <exception>
+#include <string>
+#include "registry/RegistryFacade.h"
+
+using namespace core::registry;
+
+namespace bench
+{
+
+namespace {
+
+    constexpr size_t kValuesPerKey = 8;
+
+    struct ScratchTree
+    {
+        std::wstring root;      // HKCU-relative
+        std::wstring wide;      // root\wide: one key with many leaf children
+        std::wstring deep;      // root\deep: a chain of nested keys
+        size_t wideChildren = 0;
+        size_t depth = 0;
+
+        ~ScratchTree()
+        {
+            if (!root.empty())
+            {
+                RegDeleteTreeW(HKEY_CURRENT_USER, root.c_str());
+                RegDeleteKeyExW(HKEY_CURRENT_USER, root.c_str(), 0, 0);
+                // Fails while the parent has other children, which is what we want.
+                RegDeleteKeyExW(HKEY_CURRENT_USER, L"Software\\SP_COURSE_WORK", 0, 0);
+            }
+        }
+    };
+
+    void AddValues(WriteBatch& batch, std::wstring const& path, const size_t seed)
+    {
+        for (size_t v = 0; v < kValuesPerKey; ++v)
+        {
+            const std::wstring name = L"Value" + std::to_wstring(v);
+            if (v % 2 == 0)
+            {
+                batch.SetDword(HKEY_CURRENT_USER, path, name, static_cast<DWORD>(seed * kValuesPerKey + v));
+            }
+            else
+            {
+                batch.SetString(HKEY_CURRENT_USER, path, name, L"data-" + std::to_wstring(seed) + L"-" + std::to_wstring(v));
+            }
+        }
+    }
+
+    void BuildTree(ScratchTree& tree, BenchConfig const& config)
+    {
+        tree.root = L"Software\\SP_COURSE_WORK\\core_bench-" + std::to_wstring(GetCurrentProcessId());
+        tree.wide = tree.root + L"\\wide";
+        tree.deep = tree.root + L"\\deep";
+        tree.wideChildren = config.Scale(2000);
+        tree.depth = config.Scale(64);
+
+        WriteBatch batch;
+        batch.Reserve((tree.wideChildren + tree.depth + 1) * kValuesPerKey);
+
+        AddValues(batch, tree.wide, 0);
+        for (size_t i = 0; i < tree.wideChildren; ++i)
+        {
+            AddValues(batch, tree.wide + L"\\Key" + std::to_wstring(i), i + 1);
+        }
+
+        std::wstring path = tree.deep;
+        for (size_t level = 0; level < tree.depth; ++level)
+        {
+            path += L"\\L" + std::to_wstring(level);
+            AddValues(batch, path, level);
+        }
+
+        const WriteBatchResult result = ApplyWriteBatch(batch, WriteBatchOptions{});
+        if (!result.Succeeded())
+        {
+            throw RegException(result.firstError, "Cannot build the scratch registry tree");
+        }
+    }
+
+    template <typename Body>
+    void Measure(Reporter& reporter, BenchConfig const& config, RegistryFacade& facade,
+                 std::string const& bench, std::string const& shape, std::string const& cached, const bool cold,
+                 const size_t iterations, const double keysPerIteration, Body&& body)
+    {
+        for (size_t run = 0; run < config.repeat; ++run)
+        {
+            facade.ClearCache();
+            if (!cold)
+            {
+                body(); // fill the cache; not measured
+            }
+
+            std::vector<double> samples;
+            samples.reserve(iterations);
+            for (size_t i = 0; i < iterations; ++i)
+            {
+                if (cold)
+                {
+                    facade.ClearCache();
+                }
+                const auto start = std::chrono::steady_clock::now();
+                body();
+                samples.push_back(ElapsedNs(start));
+            }
+
+            BenchResult result;
+            result.bench = bench;
+            result.variant = shape + "/" + cached + (cold ? "-cold" : "-warm");
+            result.iterations = iterations;
+            result.summary = Summarize(samples);
+            result.metrics.emplace_back("keys_per_iteration", keysPerIteration);
+            result.metrics.emplace_back("keys_per_sec",
+                                        result.summary.mean > 0 ? keysPerIteration * 1e9 / result.summary.mean : 0);
+            reporter.Result(result);
+        }
+    }
+
+} // anonymous namespace
+
+void RunRegistryBenchmarks(BenchConfig const& config, Reporter& reporter)
+{
+    const bool listSubKeys = Selected(config, "registry.list_subkeys");
+    const bool listValues = Selected(config, "registry.list_values");
+    const bool listSubKeysInfo = Selected(config, "registry.list_subkeys_info");
+    if (!listSubKeys && !listValues && !listSubKeysInfo)
+    {
+        return;
+    }
+
+    ScratchTree tree;
+    try
+    {
+        BuildTree(tree, config);
+    }
+    catch (const std::exception& ex)
+    {
+        reporter.Error("registry", "setup", ex.what());
+        return;
+    }
+
+    RegistryFacade facade;
+    const size_t iterations = config.Scale(50);
+
+    std::vector<std::wstring> children;
+    children.reserve(tree.wideChildren);
+    for (size_t i = 0; i < tree.wideChildren; ++i)
+    {
+        children.push_back(tree.wide + L"\\Key" + std::to_wstring(i));
+    }
+
+    // Deep shape: one iteration lists every level of the chain.
+    std::vector<std::wstring> levels;
+    std::wstring path = tree.deep;
+    for (size_t level = 0; level < tree.depth; ++level)
+    {
+        path += L"\\L" + std::to_wstring(level);
+        levels.push_back(path);
+    }
+
+    try
+    {
+        for (const bool cold : {true, false})
+        {
+            if (listSubKeys)
+            {
+                Measure(reporter, config, facade, "registry.list_subkeys", "wide", "handles", cold, iterations, 1, [&]
+                {
+                    facade.ListSubKeys(HKEY_CURRENT_USER, tree.wide, KEY_READ, RegistryFacade::ListOptions{});
+                });
+                Measure(reporter, config, facade, "registry.list_subkeys", "deep", "handles", cold, iterations,
+                        static_cast<double>(levels.size()), [&]
+                {
+                    for (const std::wstring& level : levels)
+                    {
+                        facade.ListSubKeys(HKEY_CURRENT_USER, level, KEY_READ, RegistryFacade::ListOptions{});
+                    }
+                });
+            }
+
+            if (listValues)
+            {
+                Measure(reporter, config, facade, "registry.list_values", "wide", "handles", cold, iterations,
+                        static_cast<double>(children.size()), [&]
+                {
+                    for (const std::wstring& child : children)
+                    {
+                        facade.ListValues(HKEY_CURRENT_USER, child, KEY_READ, RegistryFacade::ListOptions{});
+                    }
+                });
+                Measure(reporter, config, facade, "registry.list_values", "deep", "handles", cold, iterations,
+                        static_cast<double>(levels.size()), [&]
+                {
+                    for (const std::wstring& level : levels)
+                    {
+                        facade.ListValues(HKEY_CURRENT_USER, level, KEY_READ, RegistryFacade::ListOptions{});
+                    }
+                });
+            }
+
+            if (listSubKeysInfo)
+            {
+                Measure(reporter, config, facade, "registry.list_subkeys_info", "wide", "listing", cold, iterations, 1, [&]
+                {
+                    facade.ListSubKeysWithInfo(HKEY_CURRENT_USER, tree.wide, KEY_READ, RegistryFacade::ListOptions{});
+                });
+                Measure(reporter, config, facade, "registry.list_subkeys_info", "deep", "listing", cold, iterations,
+                        static_cast<double>(levels.size()), [&]
+                {
+                    for (const std::wstring& level : levels)
+                    {
+                        facade.ListSubKeysWithInfo(HKEY_CURRENT_USER, level, KEY_READ, RegistryFacade::ListOptions{});
+                    }
+                });
+            }
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        reporter.Error("registry", "run", ex.what());
+    }
+}
+
+} // namespace bench
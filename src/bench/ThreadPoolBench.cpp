@@ -0,0 +1,166 @@
+// ThreadPoolBench.cpp
+// Task throughput and enqueue-to-run latency of StdThreadPool (both modes) and WinThreadPoolAdapter.
+#include "BenchHarness.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "StdThreadPool.h"
+#include "WinThreadPoolAdapter.h"
+
+namespace bench
+{
+
+namespace {
+
+    constexpr size_t kThroughputRounds = 5;
+
+    struct PoolVariant
+    {
+        const char* name;
+        std::function<std::unique_ptr<IThreadManager>()> make;
+    };
+
+    // Waits until counter reaches target; tasks notify on every increment that reaches it.
+    void WaitFor(std::atomic<size_t>& counter, const size_t target)
+    {
+        size_t seen = counter.load(std::memory_order_acquire);
+        while (seen < target)
+        {
+            counter.wait(seen, std::memory_order_acquire);
+            seen = counter.load(std::memory_order_acquire);
+        }
+    }
+
+    void MeasureThroughput(Reporter& reporter, BenchConfig const& config, PoolVariant const& variant,
+                           const size_t producers)
+    {
+        const size_t tasks = config.Scale(200000);
+        const size_t perProducer = tasks / producers;
+        const size_t total = perProducer * producers;
+
+        for (size_t run = 0; run < config.repeat; ++run)
+        {
+            std::unique_ptr<IThreadManager> pool = variant.make();
+            std::vector<double> samples;
+
+            for (size_t round = 0; round < kThroughputRounds; ++round)
+            {
+                std::atomic<size_t> done{0};
+                const auto start = std::chrono::steady_clock::now();
+
+                std::vector<std::jthread> threads;
+                threads.reserve(producers);
+                for (size_t p = 0; p < producers; ++p)
+                {
+                    threads.emplace_back([&pool, &done, perProducer, total]
+                    {
+                        for (size_t i = 0; i < perProducer; ++i)
+                        {
+                            pool->enqueue([&done, total]
+                            {
+                                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == total)
+                                {
+                                    done.notify_all();
+                                }
+                            });
+                        }
+                    });
+                }
+                threads.clear();
+                WaitFor(done, total);
+
+                samples.push_back(ElapsedNs(start) / static_cast<double>(total));
+            }
+            pool->shutdown(true);
+
+            BenchResult result;
+            result.bench = "threadpool.throughput";
+            result.variant = std::string(variant.name) + "/producers=" + std::to_string(producers);
+            result.iterations = kThroughputRounds;
+            result.unit = "ns_per_task";
+            result.summary = Summarize(samples);
+            result.metrics.emplace_back("tasks_per_round", static_cast<double>(total));
+            result.metrics.emplace_back("tasks_per_sec", result.summary.mean > 0 ? 1e9 / result.summary.mean : 0);
+            reporter.Result(result);
+        }
+    }
+
+    // One task in flight at a time: the time from enqueue() until the task starts running.
+    void MeasureLatency(Reporter& reporter, BenchConfig const& config, PoolVariant const& variant)
+    {
+        const size_t tasks = config.Scale(10000);
+
+        for (size_t run = 0; run < config.repeat; ++run)
+        {
+            std::unique_ptr<IThreadManager> pool = variant.make();
+            std::vector<double> samples(tasks);
+            std::atomic<size_t> done{0};
+
+            for (size_t i = 0; i < tasks; ++i)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                pool->enqueue([&samples, &done, start, i]
+                {
+                    samples[i] = ElapsedNs(start);
+                    done.fetch_add(1, std::memory_order_release);
+                    done.notify_all();
+                }, IThreadManager::TaskPriority::Interactive);
+                WaitFor(done, i + 1);
+            }
+            pool->shutdown(true);
+
+            BenchResult result;
+            result.bench = "threadpool.latency";
+            result.variant = variant.name;
+            result.iterations = tasks;
+            result.summary = Summarize(samples);
+            reporter.Result(result);
+        }
+    }
+
+} // anonymous namespace
+
+void RunThreadPoolBenchmarks(BenchConfig const& config, Reporter& reporter)
+{
+    const bool throughput = Selected(config, "threadpool.throughput");
+    const bool latency = Selected(config, "threadpool.latency");
+    if (!throughput && !latency)
+    {
+        return;
+    }
+
+    const PoolVariant variants[] = {
+        {"std/shared", [] { return std::make_unique<StdThreadPool>(0, SchedulingMode::SharedQueue); }},
+        {"std/stealing", [] { return std::make_unique<StdThreadPool>(0, SchedulingMode::WorkStealing); }},
+        {"win", [] { return std::make_unique<WinThreadPoolAdapter>(); }},
+    };
+
+    const size_t producerCounts[] = {1, std::max<size_t>(2, std::thread::hardware_concurrency() / 2)};
+
+    for (const PoolVariant& variant : variants)
+    {
+        try
+        {
+            if (throughput)
+            {
+                for (const size_t producers : producerCounts)
+                {
+                    MeasureThroughput(reporter, config, variant, producers);
+                }
+            }
+            if (latency)
+            {
+                MeasureLatency(reporter, config, variant);
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            reporter.Error("threadpool", variant.name, ex.what());
+        }
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,115 @@
+// core_bench.cpp
+// Reproducible benchmarks of core_lib: registry listing (cold / warm facade caches), thread pool
+// throughput and latency, Logger enqueue rate and FileLogger bandwidth. Results go out as
+// NDJSON (see BenchHarness.h), one line per measurement.
+//
+// Usage: core_bench [--quick] [--filter=<substring>] [--repeat=<n>] [--out=<file.ndjson>]
+//   --filter matches benchmark names: registry.list_subkeys, registry.list_values,
+//   registry.list_subkeys_info, threadpool.throughput, threadpool.latency, logger.enqueue, logger.file.
+//
+// The registry benchmarks create and delete HKCU\Software\SP_COURSE_WORK\core_bench-<pid> (and
+// the parent key, if nothing else is left in it); the FileLogger benchmark writes to
+// %TEMP%\core_bench-<pid>.
+#include <windows.h>
+#include <shellapi.h>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+
+#include "BenchHarness.h"
+
+static bool startsWith(const wchar_t* arg, const wchar_t* prefix, const wchar_t*& rest)
+{
+    const size_t length = std::wcslen(prefix);
+    if (std::wcsncmp(arg, prefix, length) != 0)
+    {
+        return false;
+    }
+    rest = arg + length;
+    return true;
+}
+
+static std::string narrow(const wchar_t* text)
+{
+    const int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+    std::string out(size > 0 ? static_cast<size_t>(size) : 1, '\0');
+    if (size > 0)
+    {
+        WideCharToMultiByte(CP_UTF8, 0, text, -1, out.data(), size, nullptr, nullptr);
+    }
+    out.pop_back(); // terminator
+    return out;
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    bench::BenchConfig config;
+    const wchar_t* outPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const wchar_t* value = nullptr;
+        if (std::wcscmp(argv[i], L"--quick") == 0)
+        {
+            config.quick = true;
+        }
+        else if (startsWith(argv[i], L"--filter=", value))
+        {
+            config.filter = narrow(value);
+        }
+        else if (startsWith(argv[i], L"--repeat=", value))
+        {
+            const unsigned long repeat = std::wcstoul(value, nullptr, 10);
+            config.repeat = repeat > 0 ? repeat : 1;
+        }
+        else if (startsWith(argv[i], L"--out=", value))
+        {
+            outPath = value;
+        }
+        else
+        {
+            std::fwprintf(stderr, L"usage: core_bench [--quick] [--filter=<substring>] [--repeat=<n>] [--out=<file.ndjson>]\n");
+            return 2;
+        }
+    }
+
+    std::FILE* out = stdout;
+    if (outPath != nullptr)
+    {
+        out = _wfopen(outPath, L"wb");
+        if (out == nullptr)
+        {
+            std::fwprintf(stderr, L"core_bench: cannot create %ls\n", outPath);
+            return 1;
+        }
+    }
+
+    bench::Reporter reporter(out);
+    reporter.Header(config);
+
+    bench::RunRegistryBenchmarks(config, reporter);
+    bench::RunThreadPoolBenchmarks(config, reporter);
+    bench::RunLoggerBenchmarks(config, reporter);
+
+    if (out != stdout)
+    {
+        std::fclose(out);
+    }
+    return 0;
+}
+
+#if defined(__MINGW32__)
+// MinGW links main() unless -municode is given.
+extern "C" int main()
+{
+    int argc = 0;
+    wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == nullptr)
+    {
+        return 1;
+    }
+    const int status = wmain(argc, argv);
+    LocalFree(argv);
+    return status;
+}
+#endif
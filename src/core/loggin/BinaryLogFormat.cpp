@@ -0,0 +1,770 @@
+// BinaryLogFormat.cpp
+#include "BinaryLogFormat.h"
+
+#include <compressapi.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace core::logging
+{
+
+namespace
+{
+
+constexpr std::uint32_t kContainerMagic = 0x585A4C52;   // "RLZX"
+constexpr std::uint16_t kContainerVersion = 1;
+
+// Bits of a record's field mask.
+constexpr std::uint32_t kMessage = 1u << 0;
+constexpr std::uint32_t kOperation = 1u << 1;
+constexpr std::uint32_t kKeyPath = 1u << 2;
+constexpr std::uint32_t kValueName = 1u << 3;
+constexpr std::uint32_t kBefore = 1u << 4;
+constexpr std::uint32_t kAfter = 1u << 5;
+constexpr std::uint32_t kSource = 1u << 6;
+constexpr std::uint32_t kSnapshotId = 1u << 7;
+constexpr std::uint32_t kMetadata = 1u << 8;
+constexpr std::uint32_t kRawTimestamp = 1u << 9;
+constexpr std::uint32_t kThreadId = 1u << 10;
+
+// ---------------------- primitives ----------------------
+
+void putU16(std::string& out, const std::uint16_t v)
+{
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>(v >> 8));
+}
+
+void putU32(std::string& out, const std::uint32_t v)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        out.push_back(static_cast<char>((v >> shift) & 0xFF));
+    }
+}
+
+void putVarint(std::string& out, std::uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void putString(std::string& out, const std::string_view s)
+{
+    putVarint(out, s.size());
+    out.append(s);
+}
+
+std::uint64_t zigzag(const std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(const std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+// Bounds-checked cursor over the file bytes; after the first failure every read fails.
+class Cursor
+{
+public:
+    Cursor(const std::string& data, std::size_t& offset) noexcept
+        : m_data(data), m_offset(offset)
+    {}
+
+    bool u8(std::uint8_t& v) noexcept
+    {
+        if (m_offset >= m_data.size())
+        {
+            return false;
+        }
+        v = static_cast<std::uint8_t>(m_data[m_offset++]);
+        return true;
+    }
+
+    bool u16(std::uint16_t& v) noexcept
+    {
+        std::uint8_t lo = 0;
+        std::uint8_t hi = 0;
+        if (!u8(lo) || !u8(hi))
+        {
+            return false;
+        }
+        v = static_cast<std::uint16_t>(lo | (hi << 8));
+        return true;
+    }
+
+    bool u32(std::uint32_t& v) noexcept
+    {
+        v = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            std::uint8_t b = 0;
+            if (!u8(b))
+            {
+                return false;
+            }
+            v |= static_cast<std::uint32_t>(b) << shift;
+        }
+        return true;
+    }
+
+    bool varint(std::uint64_t& v) noexcept
+    {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            std::uint8_t b = 0;
+            if (!u8(b))
+            {
+                return false;
+            }
+            v |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool view(std::string_view& s)
+    {
+        std::uint64_t length = 0;
+        if (!varint(length) || length > m_data.size() - m_offset)
+        {
+            return false;
+        }
+        s = std::string_view(m_data.data() + m_offset, static_cast<std::size_t>(length));
+        m_offset += static_cast<std::size_t>(length);
+        return true;
+    }
+
+    bool string(std::string& s)
+    {
+        std::string_view v;
+        if (!view(v))
+        {
+            return false;
+        }
+        s.assign(v);
+        return true;
+    }
+
+private:
+    const std::string& m_data;
+    std::size_t& m_offset;
+};
+
+// ---------------------- timestamps ----------------------
+// Logger writes "YYYY-MM-DDTHH:MM:SS.mmmZ"; such stamps are stored as epoch milliseconds.
+
+constexpr std::size_t kIsoLength = 24;
+
+std::int64_t daysFromCivil(std::int64_t y, const unsigned m, const unsigned d) noexcept
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const auto yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+void civilFromDays(std::int64_t z, int& y, unsigned& m, unsigned& d) noexcept
+{
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2));
+}
+
+void formatIsoMillis(const std::int64_t millis, char (&out)[kIsoLength])
+{
+    std::int64_t days = millis / 86400000;
+    std::int64_t rest = millis % 86400000;
+    if (rest < 0)
+    {
+        rest += 86400000;
+        --days;
+    }
+
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    civilFromDays(days, year, month, day);
+
+    const auto put = [&out](const std::size_t at, unsigned value, const int width)
+    {
+        for (int i = width - 1; i >= 0; --i)
+        {
+            out[at + static_cast<std::size_t>(i)] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    };
+
+    const auto ms = static_cast<unsigned>(rest);
+    put(0, static_cast<unsigned>(year), 4);
+    out[4] = '-';
+    put(5, month, 2);
+    out[7] = '-';
+    put(8, day, 2);
+    out[10] = 'T';
+    put(11, ms / 3600000, 2);
+    out[13] = ':';
+    put(14, ms / 60000 % 60, 2);
+    out[16] = ':';
+    put(17, ms / 1000 % 60, 2);
+    out[19] = '.';
+    put(20, ms % 1000, 3);
+    out[23] = 'Z';
+}
+
+// Succeeds only if formatting the result reproduces text exactly.
+bool parseIsoMillis(const std::string_view text, std::int64_t& millis)
+{
+    if (text.size() != kIsoLength)
+    {
+        return false;
+    }
+
+    const auto number = [&text](const std::size_t at, const int width, unsigned& value)
+    {
+        value = 0;
+        for (int i = 0; i < width; ++i)
+        {
+            const char c = text[at + static_cast<std::size_t>(i)];
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            value = value * 10 + static_cast<unsigned>(c - '0');
+        }
+        return true;
+    };
+
+    unsigned year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, ms = 0;
+    if (!number(0, 4, year) || !number(5, 2, month) || !number(8, 2, day) || !number(11, 2, hour) ||
+        !number(14, 2, minute) || !number(17, 2, second) || !number(20, 3, ms) ||
+        month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59)
+    {
+        return false;
+    }
+
+    millis = daysFromCivil(year, month, day) * 86400000 +
+             static_cast<std::int64_t>(hour) * 3600000 + minute * 60000 + second * 1000 + ms;
+
+    char check[kIsoLength];
+    formatIsoMillis(millis, check);
+    return std::string_view(check, kIsoLength) == text;
+}
+
+// ---------------------- files and compression ----------------------
+
+bool readWholeFile(std::wstring const& filePath, std::string& out)
+{
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    bool ok = false;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart >= 0 && size.QuadPart < 0x7FFFFFFF)
+    {
+        out.resize(static_cast<std::size_t>(size.QuadPart));
+        DWORD read = 0;
+        ok = out.empty() ||
+             (ReadFile(file, out.data(), static_cast<DWORD>(out.size()), &read, nullptr) && read == out.size());
+    }
+    CloseHandle(file);
+    return ok;
+}
+
+DWORD algorithmOf(const LogCompression compression) noexcept
+{
+    switch (compression)
+    {
+        case LogCompression::Xpress: return COMPRESS_ALGORITHM_XPRESS;
+        case LogCompression::XpressHuffman: return COMPRESS_ALGORITHM_XPRESS_HUFF;
+        case LogCompression::Lzms: return COMPRESS_ALGORITHM_LZMS;
+        case LogCompression::None: break;
+    }
+    return 0;
+}
+
+bool decompressContainer(const std::string& container, std::string& out)
+{
+    std::size_t offset = 0;
+    Cursor cursor(container, offset);
+
+    std::uint32_t magic = 0;
+    std::uint16_t version = 0;
+    std::uint16_t algorithm = 0;
+    if (!cursor.u32(magic) || magic != kContainerMagic || !cursor.u16(version) || version != kContainerVersion ||
+        !cursor.u16(algorithm))
+    {
+        return false;
+    }
+
+    DECOMPRESSOR_HANDLE decompressor = nullptr;
+    if (!CreateDecompressor(algorithm, nullptr, &decompressor))
+    {
+        return false;
+    }
+
+    out.clear();
+    bool ok = true;
+    while (ok && offset < container.size())
+    {
+        std::uint32_t rawSize = 0;
+        std::uint32_t packedSize = 0;
+        ok = cursor.u32(rawSize) && cursor.u32(packedSize) && rawSize <= kCompressionBlockBytes &&
+             packedSize <= container.size() - offset;
+        if (!ok)
+        {
+            break;
+        }
+
+        const std::size_t at = out.size();
+        out.resize(at + rawSize);
+        SIZE_T produced = 0;
+        ok = Decompress(decompressor, container.data() + offset, packedSize, out.data() + at, rawSize, &produced) &&
+             produced == rawSize;
+        offset += packedSize;
+    }
+
+    CloseDecompressor(decompressor);
+    return ok;
+}
+
+} // anonymous namespace
+
+// ---------------------- BinaryLogEncoder ----------------------
+
+void BinaryLogEncoder::beginFile(std::string& out)
+{
+    m_strings.clear();
+    m_ids.clear();
+    m_dictionaryBytes = 0;
+    m_previousMillis = 0;
+
+    putU32(out, kMagic);
+    putU16(out, kVersion);
+    putU16(out, 0);
+}
+
+void BinaryLogEncoder::appendReference(const std::string_view text, std::string& out, std::string& body)
+{
+    const auto it = m_ids.find(text);
+    if (it != m_ids.end())
+    {
+        putVarint(body, it->second);
+        return;
+    }
+
+    if (m_strings.size() >= kMaxDictionaryEntries || m_dictionaryBytes + text.size() > kMaxDictionaryBytes)
+    {
+        putVarint(body, 0);
+        putString(body, text);
+        return;
+    }
+
+    const std::string& stored = m_strings.emplace_back(text);
+    const auto id = static_cast<std::uint32_t>(m_strings.size());
+    m_ids.emplace(stored, id);
+    m_dictionaryBytes += stored.size();
+
+    out.push_back(static_cast<char>(kTagString));
+    putString(out, stored);
+    putVarint(body, id);
+}
+
+void BinaryLogEncoder::appendRecord(const LogRecord& record, std::string& out)
+{
+    std::string& body = m_body;
+    body.clear();
+
+    std::int64_t millis = 0;
+    const bool isoTimestamp = parseIsoMillis(record.timestamp, millis);
+
+    std::uint32_t mask = 0;
+    mask |= record.message.empty() ? 0 : kMessage;
+    mask |= record.operation.empty() ? 0 : kOperation;
+    mask |= record.key_path.empty() ? 0 : kKeyPath;
+    mask |= record.value_name.empty() ? 0 : kValueName;
+    mask |= record.before.empty() ? 0 : kBefore;
+    mask |= record.after.empty() ? 0 : kAfter;
+    mask |= record.source.empty() ? 0 : kSource;
+    mask |= record.snapshot_id.has_value() ? kSnapshotId : 0;
+    mask |= record.metadata.has_value() ? kMetadata : 0;
+    mask |= isoTimestamp ? 0 : kRawTimestamp;
+    mask |= record.tid.empty() ? 0 : kThreadId;
+
+    body.push_back(static_cast<char>(record.level));
+    putVarint(body, mask);
+
+    if (isoTimestamp)
+    {
+        putVarint(body, zigzag(millis - m_previousMillis));
+        m_previousMillis = millis;
+    }
+    else
+    {
+        putString(body, record.timestamp);
+    }
+
+    if (mask & kMessage) putString(body, record.message);
+    if (mask & kOperation) appendReference(record.operation, out, body);
+    if (mask & kKeyPath) appendReference(record.key_path, out, body);
+    if (mask & kValueName) appendReference(record.value_name, out, body);
+    if (mask & kBefore) putString(body, record.before);
+    if (mask & kAfter) putString(body, record.after);
+    if (mask & kSource) appendReference(record.source, out, body);
+    if (mask & kSnapshotId) putString(body, *record.snapshot_id);
+    if (mask & kMetadata) putString(body, *record.metadata);
+    if (mask & kThreadId) appendReference(record.tid, out, body);
+    putVarint(body, record.pid);
+
+    out.push_back(static_cast<char>(kTagRecord));
+    putString(out, body);
+}
+
+// ---------------------- BinaryLogReader ----------------------
+
+bool BinaryLogReader::open(std::wstring const& filePath)
+{
+    std::string data;
+    if (!readLogFileBytes(filePath, data))
+    {
+        m_failed = true;
+        return false;
+    }
+    return openBuffer(std::move(data));
+}
+
+bool BinaryLogReader::openBuffer(std::string data)
+{
+    m_data = std::move(data);
+    m_offset = 0;
+    m_failed = false;
+    m_dictionary.clear();
+    m_previousMillis = 0;
+    return readHeader();
+}
+
+bool BinaryLogReader::readHeader()
+{
+    Cursor cursor(m_data, m_offset);
+    std::uint32_t magic = 0;
+    std::uint16_t version = 0;
+    std::uint16_t flags = 0;
+    if (!cursor.u32(magic) || magic != BinaryLogEncoder::kMagic || !cursor.u16(version) ||
+        version != BinaryLogEncoder::kVersion || !cursor.u16(flags))
+    {
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogReader::next(LogRecord& record)
+{
+    if (m_failed)
+    {
+        return false;
+    }
+
+    Cursor cursor(m_data, m_offset);
+    while (m_offset < m_data.size())
+    {
+        std::uint8_t tag = 0;
+        std::string_view payload;
+        if (!cursor.u8(tag) || !cursor.view(payload))
+        {
+            m_failed = true;
+            return false;
+        }
+
+        if (tag == BinaryLogEncoder::kTagString)
+        {
+            m_dictionary.emplace_back(payload);
+            continue;
+        }
+        if (tag != BinaryLogEncoder::kTagRecord)
+        {
+            continue;   // unknown entry kinds are skipped by length
+        }
+
+        // Decode the body through a cursor of its own, bounded by the record length.
+        const std::size_t bodyEnd = m_offset;
+        std::size_t bodyOffset = bodyEnd - payload.size();
+        Cursor body(m_data, bodyOffset);
+
+        const auto reference = [this, &body](std::string& out)
+        {
+            std::uint64_t id = 0;
+            if (!body.varint(id))
+            {
+                return false;
+            }
+            if (id == 0)
+            {
+                return body.string(out);
+            }
+            if (id > m_dictionary.size())
+            {
+                return false;
+            }
+            out = m_dictionary[static_cast<std::size_t>(id - 1)];
+            return true;
+        };
+        const auto optionalString = [&body](const bool present, std::optional<std::string>& out)
+        {
+            if (!present)
+            {
+                out.reset();
+                return true;
+            }
+            return body.string(out.emplace());
+        };
+        const auto field = [&body](const bool present, std::string& out)
+        {
+            if (!present)
+            {
+                out.clear();
+                return true;
+            }
+            return body.string(out);
+        };
+        const auto refField = [&reference](const bool present, std::string& out)
+        {
+            if (!present)
+            {
+                out.clear();
+                return true;
+            }
+            return reference(out);
+        };
+
+        std::uint8_t level = 0;
+        std::uint64_t mask = 0;
+        bool ok = body.u8(level) && body.varint(mask);
+
+        if (ok && (mask & kRawTimestamp))
+        {
+            ok = body.string(record.timestamp);
+        }
+        else if (ok)
+        {
+            std::uint64_t delta = 0;
+            ok = body.varint(delta);
+            m_previousMillis += unzigzag(delta);
+            char text[kIsoLength];
+            formatIsoMillis(m_previousMillis, text);
+            record.timestamp.assign(text, kIsoLength);
+        }
+
+        std::uint64_t pid = 0;
+        ok = ok &&
+             field(mask & kMessage, record.message) &&
+             refField(mask & kOperation, record.operation) &&
+             refField(mask & kKeyPath, record.key_path) &&
+             refField(mask & kValueName, record.value_name) &&
+             field(mask & kBefore, record.before) &&
+             field(mask & kAfter, record.after) &&
+             refField(mask & kSource, record.source) &&
+             optionalString(mask & kSnapshotId, record.snapshot_id) &&
+             optionalString(mask & kMetadata, record.metadata) &&
+             refField(mask & kThreadId, record.tid) &&
+             body.varint(pid) &&
+             bodyOffset <= bodyEnd &&
+             level <= static_cast<std::uint8_t>(LogLevel::Critical);
+
+        if (!ok)
+        {
+            m_failed = true;
+            return false;
+        }
+
+        record.level = static_cast<LogLevel>(level);
+        record.pid = static_cast<ULONG>(pid);
+        return true;
+    }
+    return false;
+}
+
+bool BinaryLogReader::failed() const noexcept
+{
+    return m_failed;
+}
+
+// ---------------------- compression ----------------------
+
+bool compressLogFile(std::wstring const& sourcePath, std::wstring const& targetPath, const LogCompression compression)
+{
+    const DWORD algorithm = algorithmOf(compression);
+    std::string raw;
+    if (algorithm == 0 || !readWholeFile(sourcePath, raw))
+    {
+        return false;
+    }
+
+    COMPRESSOR_HANDLE compressor = nullptr;
+    if (!CreateCompressor(algorithm, nullptr, &compressor))
+    {
+        std::cerr << "compressLogFile: CreateCompressor failed, error=" << GetLastError() << "\n";
+        return false;
+    }
+
+    std::string container;
+    putU32(container, kContainerMagic);
+    putU16(container, kContainerVersion);
+    putU16(container, static_cast<std::uint16_t>(algorithm));
+
+    std::vector<char> packed;
+    bool ok = true;
+    for (std::size_t at = 0; ok && at < raw.size(); at += kCompressionBlockBytes)
+    {
+        const std::size_t rawSize = std::min(kCompressionBlockBytes, raw.size() - at);
+
+        // First call reports the size the block needs.
+        SIZE_T needed = 0;
+        if (!Compress(compressor, raw.data() + at, rawSize, nullptr, 0, &needed) &&
+            GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+        {
+            ok = false;
+            break;
+        }
+        packed.resize(needed);
+
+        SIZE_T packedSize = 0;
+        ok = Compress(compressor, raw.data() + at, rawSize, packed.data(), packed.size(), &packedSize) != FALSE;
+        if (ok)
+        {
+            putU32(container, static_cast<std::uint32_t>(rawSize));
+            putU32(container, static_cast<std::uint32_t>(packedSize));
+            container.append(packed.data(), packedSize);
+        }
+    }
+    CloseCompressor(compressor);
+
+    if (ok)
+    {
+        HANDLE file = CreateFileW(targetPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        DWORD written = 0;
+        ok = file != INVALID_HANDLE_VALUE &&
+             WriteFile(file, container.data(), static_cast<DWORD>(container.size()), &written, nullptr) &&
+             written == container.size();
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+    }
+
+    if (!ok)
+    {
+        DeleteFileW(targetPath.c_str());
+    }
+    return ok;
+}
+
+// ---------------------- RotatedFileCompressor ----------------------
+
+RotatedFileCompressor::RotatedFileCompressor(const LogCompression compression)
+    : m_compression(compression)
+{
+}
+
+RotatedFileCompressor::~RotatedFileCompressor()
+{
+    {
+        std::lock_guard lk(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void RotatedFileCompressor::enqueue(std::wstring sourcePath, std::wstring targetPath, std::function<void()> done)
+{
+    {
+        std::lock_guard lk(m_mutex);
+        m_jobs.push_back(Job{std::move(sourcePath), std::move(targetPath), std::move(done)});
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread([this] { run(); });
+        }
+    }
+    m_cv.notify_one();
+}
+
+void RotatedFileCompressor::run()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock lk(m_mutex);
+            m_cv.wait(lk, [this] { return !m_jobs.empty() || m_stopping; });
+            if (m_jobs.empty())
+            {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        if (compressLogFile(job.sourcePath, job.targetPath, m_compression))
+        {
+            DeleteFileW(job.sourcePath.c_str());
+        }
+        if (job.done)
+        {
+            job.done();
+        }
+    }
+}
+
+bool readLogFileBytes(std::wstring const& filePath, std::string& out)
+{
+    std::string data;
+    if (!readWholeFile(filePath, data))
+    {
+        return false;
+    }
+
+    std::uint32_t magic = 0;
+    if (data.size() >= sizeof(magic))
+    {
+        std::memcpy(&magic, data.data(), sizeof(magic));
+    }
+    if (magic == kContainerMagic)
+    {
+        return decompressContainer(data, out);
+    }
+
+    out = std::move(data);
+    return true;
+}
+
+} // namespace core::logging
@@ -0,0 +1,150 @@
+// BinaryLogFormat.h
+#pragma once
+
+#include <windows.h>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "Logger.h"
+
+/**
+ * Compact binary log format (".rlog") and its compressed container (".rlogz").
+ *
+ * A log file is a header (magic "RLOG", version) followed by entries, each a one-byte tag:
+ *  - kTagString: varint length + bytes. Defines the next dictionary id (ids start at 1).
+ *  - kTagRecord: varint length + record body.
+ *
+ * Record body: level byte, varint field mask, timestamp, fields in mask order, varint pid.
+ * The timestamp is a zigzag varint delta in milliseconds from the previous record of the
+ * file, or the raw string when it is not in the canonical ISO8601 form Logger writes.
+ * Repetitive fields (operation, key path, value name, source, thread id) are dictionary
+ * references, written as varint id, or 0 followed by the inline string once the per-file
+ * dictionary is full. Other fields are varint length + bytes.
+ *
+ * Dictionary definitions always precede the first record using them, so a file can be
+ * read front to back from any writer state, and every file starts an empty dictionary.
+ *
+ * The compressed container (magic "RLZX") holds the same bytes in independently
+ * compressed blocks of up to kCompressionBlockBytes, using the Windows Compression API.
+ */
+namespace core::logging
+{
+
+enum class LogCompression
+{
+    None,
+    Xpress,
+    XpressHuffman,
+    Lzms
+};
+
+class BinaryLogEncoder
+{
+public:
+    static constexpr std::uint32_t kMagic = 0x474F4C52;         // "RLOG"
+    static constexpr std::uint16_t kVersion = 1;
+    static constexpr std::uint8_t kTagString = 1;
+    static constexpr std::uint8_t kTagRecord = 2;
+
+    // Dictionary limits per file; past them repetitive fields are written inline.
+    static constexpr std::size_t kMaxDictionaryEntries = 64 * 1024;
+    static constexpr std::size_t kMaxDictionaryBytes = 8 * 1024 * 1024;
+
+    // Resets the dictionary and timestamp base and appends a file header to out.
+    void beginFile(std::string& out);
+
+    // Appends the record (and any dictionary definitions it needs) to out.
+    void appendRecord(const LogRecord& record, std::string& out);
+
+private:
+    void appendReference(std::string_view text, std::string& out, std::string& body);
+
+    std::deque<std::string> m_strings;          // owns the dictionary keys
+    std::unordered_map<std::string_view, std::uint32_t> m_ids;
+    std::size_t m_dictionaryBytes = 0;
+    std::int64_t m_previousMillis = 0;
+    std::string m_body;                         // scratch for the record being encoded
+};
+
+/**
+ * BinaryLogReader - decodes a ".rlog" file, or a compressed ".rlogz" container of one,
+ * back into LogRecord values.
+ */
+class BinaryLogReader
+{
+public:
+    // Reads the whole file (decompressing it if needed); false if unreadable or not a log.
+    bool open(std::wstring const& filePath);
+
+    // Takes the file bytes directly, as written by BinaryLogEncoder.
+    bool openBuffer(std::string data);
+
+    // Next record; false at the end or on corrupt input (see failed()).
+    bool next(LogRecord& record);
+
+    [[nodiscard]] bool failed() const noexcept;
+
+private:
+    bool readHeader();
+
+    std::string m_data;
+    std::size_t m_offset = 0;
+    bool m_failed = false;
+    std::deque<std::string> m_dictionary;       // index 0 is dictionary id 1
+    std::int64_t m_previousMillis = 0;
+};
+
+inline constexpr std::size_t kCompressionBlockBytes = 1024 * 1024;
+
+// Writes a compressed container of sourcePath to targetPath. False on any failure
+// (targetPath is then removed). LogCompression::None is rejected.
+bool compressLogFile(std::wstring const& sourcePath, std::wstring const& targetPath, LogCompression compression);
+
+/**
+ * RotatedFileCompressor - runs compressLogFile for rotated files on a thread of its own, so a
+ * sink's writer continues with its new file at once. A job packs source into target, deletes
+ * source if that worked (keeps it otherwise) and then runs its done callback, on the
+ * compressor thread. Jobs run in order; the thread starts with the first job, and the
+ * destructor finishes the queued jobs before it returns.
+ */
+class RotatedFileCompressor
+{
+public:
+    explicit RotatedFileCompressor(LogCompression compression);
+    ~RotatedFileCompressor();
+
+    RotatedFileCompressor(const RotatedFileCompressor&) = delete;
+    RotatedFileCompressor& operator=(const RotatedFileCompressor&) = delete;
+
+    void enqueue(std::wstring sourcePath, std::wstring targetPath, std::function<void()> done = {});
+
+private:
+    struct Job
+    {
+        std::wstring sourcePath;
+        std::wstring targetPath;
+        std::function<void()> done;
+    };
+
+    void run();
+
+    LogCompression m_compression;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;                     // guarded by m_mutex
+    bool m_stopping = false;                    // guarded by m_mutex
+    std::thread m_thread;
+};
+
+// Reads a file; a compressed container is decompressed transparently.
+bool readLogFileBytes(std::wstring const& filePath, std::string& out);
+
+} // namespace core::logging
@@ -0,0 +1,294 @@
+// BinaryLogSink.cpp
+#include "BinaryLogSink.h"
+
+#include <shlobj.h>
+#include <algorithm>
+#include <cwchar>
+#include <iostream>
+#include <utility>
+
+namespace core::logging
+{
+
+static std::wstring makeFilePath(std::wstring const& dirW, std::wstring const& nameW)
+{
+    std::wstring path = dirW;
+    if (!path.empty() && path.back() != L'\\' && path.back() != L'/')
+    {
+        path.push_back(L'\\');
+    }
+    path += nameW;
+    return path;
+}
+
+static ULONGLONG fileTimeValue(FILETIME const& time)
+{
+    return (static_cast<ULONGLONG>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+}
+
+BinaryLogSink::BinaryLogSink(std::wstring logDirectoryW,
+                             std::wstring baseFileName,
+                             BinaryLogSinkOptions const& options)
+    : m_logDirectoryW(std::move(logDirectoryW))
+    , m_baseFileName(std::move(baseFileName))
+    , m_options(options)
+{
+    m_filePathW = makeFilePath(m_logDirectoryW, m_baseFileName);
+    if (m_options.compression != LogCompression::None)
+    {
+        m_compressor = std::make_unique<RotatedFileCompressor>(m_options.compression);
+    }
+
+    const int result = SHCreateDirectoryExW(nullptr, m_logDirectoryW.c_str(), nullptr);
+    if (result != ERROR_SUCCESS && result != ERROR_ALREADY_EXISTS)
+    {
+        std::cerr << "BinaryLogSink: cannot create log directory, error=" << result << "\n";
+    }
+
+    m_lastWrite = std::chrono::steady_clock::now();
+    openLogFile();
+
+    if (m_options.flushIntervalMs > 0)
+    {
+        m_flushTimer = std::jthread([this](const std::stop_token& st) { flushTimerLoop(st); });
+    }
+}
+
+BinaryLogSink::~BinaryLogSink()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {}
+}
+
+BOOL BinaryLogSink::openLogFile()
+{
+    HANDLE file = CreateFileW(m_filePathW.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "BinaryLogSink: failed to open file, error=" << GetLastError() << "\n";
+        return FALSE;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        CloseHandle(file);
+        if (!moveAside(m_filePathW))
+        {
+            return FALSE;
+        }
+        file = CreateFileW(m_filePathW.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::cerr << "BinaryLogSink: failed to create file, error=" << GetLastError() << "\n";
+            return FALSE;
+        }
+    }
+
+    m_fileHandle = file;
+    m_currentFileBytes = 0;
+
+    // Records still buffered were encoded against the previous file's dictionary.
+    m_buffer.clear();
+    m_dropped.fetch_add(m_recordsBuffered, std::memory_order_relaxed);
+    m_recordsBuffered = 0;
+    m_encoder.beginFile(m_buffer);
+    return TRUE;
+}
+
+void BinaryLogSink::consume(const std::vector<LogRecord>& batch)
+{
+    std::lock_guard lk(m_mutex);
+    if (m_closed)
+    {
+        m_dropped.fetch_add(batch.size(), std::memory_order_relaxed);
+        return;
+    }
+    if (m_fileHandle == INVALID_HANDLE_VALUE && !openLogFile())
+    {
+        m_dropped.fetch_add(batch.size(), std::memory_order_relaxed);
+        return;
+    }
+
+    for (const LogRecord& record : batch)
+    {
+        m_encoder.appendRecord(record, m_buffer);
+    }
+    m_recordsBuffered += batch.size();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (m_buffer.size() >= m_options.flushThresholdBytes ||
+        now - m_lastWrite >= std::chrono::milliseconds(m_options.flushIntervalMs))
+    {
+        writeBuffer();
+    }
+}
+
+// Writes a buffer that consume() left behind when flushIntervalMs passes without another record.
+void BinaryLogSink::flushTimerLoop(std::stop_token const& stoken)
+{
+    const auto interval = std::chrono::milliseconds(m_options.flushIntervalMs);
+
+    std::unique_lock lk(m_mutex);
+    while (!m_closed && !stoken.stop_requested())
+    {
+        // With nothing to write, the next record may arrive at any time: check again an interval later.
+        const bool pending = !m_buffer.empty() && m_fileHandle != INVALID_HANDLE_VALUE;
+        const auto due = pending ? m_lastWrite + interval : std::chrono::steady_clock::now() + interval;
+        if (m_timerCv.wait_until(lk, stoken, due, [this] { return m_closed; }))
+        {
+            break;
+        }
+        if (!m_buffer.empty() && std::chrono::steady_clock::now() - m_lastWrite >= interval)
+        {
+            writeBuffer();
+        }
+    }
+}
+
+BOOL BinaryLogSink::writeBuffer()
+{
+    if (m_buffer.empty() || m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return TRUE;
+    }
+
+    DWORD written = 0;
+    const BOOL ok = m_buffer.size() < 0x7FFFFFFF &&
+                    WriteFile(m_fileHandle, m_buffer.data(), static_cast<DWORD>(m_buffer.size()), &written, nullptr) &&
+                    written == m_buffer.size();
+    m_lastWrite = std::chrono::steady_clock::now();
+
+    if (!ok)
+    {
+        // A partial record would make the rest of the file unreadable: start a new file.
+        std::cerr << "BinaryLogSink: write failed, error=" << GetLastError() << "\n";
+        CloseHandle(m_fileHandle);
+        m_fileHandle = INVALID_HANDLE_VALUE;
+        return openLogFile();
+    }
+
+    m_currentFileBytes += written;
+    m_buffer.clear();
+    m_recordsBuffered = 0;
+
+    if (m_currentFileBytes >= m_options.maxFileBytes)
+    {
+        return rotateFile();
+    }
+    return TRUE;
+}
+
+BOOL BinaryLogSink::moveAside(std::wstring const& path)
+{
+    SYSTEMTIME utc_time;
+    GetSystemTime(&utc_time);
+
+    wchar_t stamp[64];
+    std::swprintf(stamp, sizeof(stamp) / sizeof(stamp[0]), L".%04u-%02u-%02uT%02u-%02u-%02u.%03uZ.%llu",
+                  utc_time.wYear, utc_time.wMonth, utc_time.wDay, utc_time.wHour, utc_time.wMinute,
+                  utc_time.wSecond, utc_time.wMilliseconds, ++m_rotationSerial);
+
+    const std::wstring rotated = path + stamp + L".rlog";
+    if (!MoveFileW(path.c_str(), rotated.c_str()))
+    {
+        std::cerr << "BinaryLogSink: rotate failed, error=" << GetLastError() << "\n";
+        return FALSE;
+    }
+
+    if (m_compressor)
+    {
+        // Packed off the writing thread; old files are trimmed once the packed one is complete.
+        m_compressor->enqueue(rotated, rotated + L"z", [this] { cleanupOldFiles(); });
+    }
+    else
+    {
+        cleanupOldFiles();
+    }
+    return TRUE;
+}
+
+BOOL BinaryLogSink::rotateFile()
+{
+    if (m_fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_fileHandle);
+        m_fileHandle = INVALID_HANDLE_VALUE;
+    }
+    return openLogFile();
+}
+
+void BinaryLogSink::cleanupOldFiles() const
+{
+    if (m_options.rotateCount == 0) return;
+    const std::wstring search_pattern = m_filePathW + L".*";
+
+    WIN32_FIND_DATAW find_data;
+    HANDLE find_handle = FindFirstFileW(search_pattern.c_str(), &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE) return;
+
+    std::vector<std::pair<ULONGLONG, std::wstring>> rotated_files;
+    do
+    {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        rotated_files.emplace_back(fileTimeValue(find_data.ftLastWriteTime),
+                                   makeFilePath(m_logDirectoryW, find_data.cFileName));
+    } while (FindNextFileW(find_handle, &find_data));
+    FindClose(find_handle);
+
+    if (rotated_files.size() <= m_options.rotateCount) return;
+
+    std::sort(rotated_files.begin(), rotated_files.end());
+    for (size_t i = 0; i < rotated_files.size() - m_options.rotateCount; ++i)
+    {
+        DeleteFileW(rotated_files[i].second.c_str());
+    }
+}
+
+void BinaryLogSink::flush()
+{
+    std::lock_guard lk(m_mutex);
+    writeBuffer();
+}
+
+void BinaryLogSink::close()
+{
+    {
+        std::lock_guard lk(m_mutex);
+        if (m_closed)
+        {
+            return;
+        }
+        m_closed = true;
+
+        writeBuffer();
+        if (m_fileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_fileHandle);
+            m_fileHandle = INVALID_HANDLE_VALUE;
+        }
+
+        // Finishes the compression of files rotated before the close.
+        m_compressor.reset();
+    }
+
+    // Only the first close() gets here; the timer sees m_closed and returns.
+    m_timerCv.notify_all();
+    if (m_flushTimer.joinable())
+    {
+        m_flushTimer.join();
+    }
+}
+
+ULONGLONG BinaryLogSink::droppedCount() const
+{
+    return m_dropped.load();
+}
+
+} // namespace core::logging
@@ -0,0 +1,102 @@
+// BinaryLogSink.h
+#pragma once
+
+#include "Logger.h" // LogRecord, ILogSink
+#include "BinaryLogFormat.h"
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace core::logging
+{
+
+struct BinaryLogSinkOptions
+{
+    ULONGLONG maxFileBytes = 16ull * 1024 * 1024;
+    ULONGLONG rotateCount = 5;
+    ULONGLONG flushThresholdBytes = 64 * 1024;
+    ULONGLONG flushIntervalMs = 200;
+    LogCompression compression = LogCompression::XpressHuffman;   // applied to rotated files
+};
+
+/**
+ * BinaryLogSink
+ *
+ * ILogSink writing the compact binary format of BinaryLogFormat.h: length-prefixed
+ * records, a per-file dictionary for operation names, key paths and other repeated
+ * fields, and millisecond timestamp deltas. Convert files back with tools/binlog2ndjson.
+ *
+ * Behavior summary:
+ *  - consume(batch) encodes into an in-memory buffer, which is written with one WriteFile
+ *    once it holds flushThresholdBytes, or flushIntervalMs after the last write. A timer
+ *    thread makes the interval hold when no further record arrives (0 disables it).
+ *  - flush() writes whatever is buffered.
+ *  - At maxFileBytes the file is rotated to "<base>.<UTC time>.rlog" and, unless
+ *    compression is None, packed into "<...>.rlogz" (the .rlog is then deleted) on a
+ *    background thread; close() waits for it. rotateCount rotated files are kept.
+ *  - A non-empty file left by an earlier run is rotated away on open, since its
+ *    dictionary cannot be continued.
+ *
+ * Thread-safety:
+ *  - consume(), flush(), close() and the destructor are thread-safe; encoding and I/O
+ *    run under one mutex on the calling thread, or on the timer thread for interval flushes.
+ */
+class BinaryLogSink final : public ILogSink
+{
+public:
+    BinaryLogSink(std::wstring logDirectoryW,
+                  std::wstring baseFileName,
+                  BinaryLogSinkOptions const& options = {});
+
+    ~BinaryLogSink() override;
+
+    BinaryLogSink(const BinaryLogSink&) = delete;
+    BinaryLogSink& operator=(const BinaryLogSink&) = delete;
+
+    void consume(const std::vector<LogRecord>& batch) override;
+
+    void flush() override;
+
+    void close();
+
+    ULONGLONG droppedCount() const;
+
+private:
+    BOOL openLogFile();
+    BOOL writeBuffer();
+    BOOL rotateFile();
+    BOOL moveAside(std::wstring const& path);
+    void cleanupOldFiles() const;
+    void flushTimerLoop(std::stop_token const& stoken);
+
+    std::wstring m_logDirectoryW;
+    std::wstring m_baseFileName;
+    std::wstring m_filePathW;
+    BinaryLogSinkOptions m_options;
+
+    std::mutex m_mutex;
+    HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
+    BinaryLogEncoder m_encoder;
+    std::string m_buffer;               // encoded, not yet written
+    ULONGLONG m_recordsBuffered = 0;
+    ULONGLONG m_currentFileBytes = 0;
+    std::chrono::steady_clock::time_point m_lastWrite;
+    ULONGLONG m_rotationSerial = 0;
+    bool m_closed = false;
+    std::atomic<ULONGLONG> m_dropped{ 0 };
+
+    std::condition_variable_any m_timerCv;  // wakes the timer thread on close()
+    std::jthread m_flushTimer;
+
+    // Set unless compression is None. Last, so it finishes its jobs, which call
+    // cleanupOldFiles(), before the members they use are destroyed.
+    std::unique_ptr<RotatedFileCompressor> m_compressor;
+};
+
+} // namespace core::logging
@@ -0,0 +1,481 @@
+// DeferredFormat.cpp
+#include "DeferredFormat.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+
+namespace core::logging
+{
+
+namespace
+{
+
+struct DeferredArg
+{
+    DeferredArgType type{};
+    bool boolean = false;
+    char character = 0;
+    std::int64_t integer = 0;
+    std::uint64_t unsignedInteger = 0;
+    double floating = 0;
+    std::string_view text;              // String: UTF-8 bytes; WideString: UTF-16 code units
+};
+
+// Walks the packed arguments in order; asking for an earlier index rescans from the start.
+class DeferredArgReader
+{
+public:
+    explicit DeferredArgReader(const std::string_view packed) noexcept
+        : m_packed(packed)
+    {
+    }
+
+    bool get(const std::size_t index, DeferredArg& arg)
+    {
+        if (index < m_nextIndex)
+        {
+            m_offset = 0;
+            m_nextIndex = 0;
+        }
+        while (m_nextIndex <= index)
+        {
+            if (!readNext(arg))
+            {
+                return false;
+            }
+            ++m_nextIndex;
+        }
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool readValue(T& value)
+    {
+        if (m_packed.size() - m_offset < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, m_packed.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    bool readText(std::string_view& text, const std::size_t unitBytes)
+    {
+        std::uint32_t units = 0;
+        if (!readValue(units) || (m_packed.size() - m_offset) / unitBytes < units)
+        {
+            return false;
+        }
+        text = m_packed.substr(m_offset, units * unitBytes);
+        m_offset += units * unitBytes;
+        return true;
+    }
+
+    bool readNext(DeferredArg& arg)
+    {
+        if (m_offset >= m_packed.size())
+        {
+            return false;
+        }
+        arg.type = static_cast<DeferredArgType>(m_packed[m_offset++]);
+        switch (arg.type)
+        {
+            case DeferredArgType::Bool:       return readValue(arg.boolean);
+            case DeferredArgType::Char:       return readValue(arg.character);
+            case DeferredArgType::Int:        return readValue(arg.integer);
+            case DeferredArgType::UInt:       return readValue(arg.unsignedInteger);
+            case DeferredArgType::Double:     return readValue(arg.floating);
+            case DeferredArgType::String:     return readText(arg.text, 1);
+            case DeferredArgType::WideString: return readText(arg.text, sizeof(wchar_t));
+            case DeferredArgType::Pointer:    return readValue(arg.unsignedInteger);
+        }
+        return false;
+    }
+
+    std::string_view m_packed;
+    std::size_t m_offset = 0;
+    std::size_t m_nextIndex = 0;
+};
+
+struct FormatSpec
+{
+    char fill = ' ';
+    char align = 0;                     // '<', '>', '^' or 0 for the type's default
+    bool plus = false;
+    bool alternate = false;
+    bool zeroPad = false;
+    std::size_t width = 0;
+    int precision = -1;
+    char type = 0;
+};
+
+bool isAlign(const char c) noexcept
+{
+    return c == '<' || c == '>' || c == '^';
+}
+
+bool parseNumber(std::string_view& spec, std::size_t& value)
+{
+    const char* begin = spec.data();
+    const auto [end, ec] = std::from_chars(begin, begin + spec.size(), value);
+    if (ec != std::errc{} || end == begin)
+    {
+        return false;
+    }
+    spec.remove_prefix(static_cast<std::size_t>(end - begin));
+    return true;
+}
+
+bool parseSpec(std::string_view spec, FormatSpec& out)
+{
+    if (spec.size() >= 2 && isAlign(spec[1]))
+    {
+        out.fill = spec[0];
+        out.align = spec[1];
+        spec.remove_prefix(2);
+    }
+    else if (!spec.empty() && isAlign(spec[0]))
+    {
+        out.align = spec[0];
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() && (spec[0] == '+' || spec[0] == '-'))
+    {
+        out.plus = spec[0] == '+';
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() && spec[0] == '#')
+    {
+        out.alternate = true;
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() && spec[0] == '0')
+    {
+        out.zeroPad = true;
+        spec.remove_prefix(1);
+    }
+    if (!spec.empty() && spec[0] >= '1' && spec[0] <= '9' && !parseNumber(spec, out.width))
+    {
+        return false;
+    }
+    if (!spec.empty() && spec[0] == '.')
+    {
+        spec.remove_prefix(1);
+        std::size_t precision = 0;
+        if (!parseNumber(spec, precision) || precision > 100)
+        {
+            return false;
+        }
+        out.precision = static_cast<int>(precision);
+    }
+    if (!spec.empty())
+    {
+        out.type = spec[0];
+        spec.remove_prefix(1);
+    }
+    return spec.empty();
+}
+
+// Pads body (already holding sign/prefix + digits) to the spec's width.
+void appendPadded(std::string& out, const std::string_view body, const FormatSpec& spec,
+                  const bool numeric, const std::size_t prefixLength)
+{
+    if (body.size() >= spec.width)
+    {
+        out.append(body);
+        return;
+    }
+    const std::size_t padding = spec.width - body.size();
+
+    if (numeric && spec.zeroPad && spec.align == 0)
+    {
+        out.append(body.substr(0, prefixLength));
+        out.append(padding, '0');
+        out.append(body.substr(prefixLength));
+        return;
+    }
+
+    const char align = spec.align != 0 ? spec.align : (numeric ? '>' : '<');
+    const std::size_t before = align == '>' ? padding : (align == '^' ? padding / 2 : 0);
+    out.append(before, spec.fill);
+    out.append(body);
+    out.append(padding - before, spec.fill);
+}
+
+bool appendInteger(std::string& out, const bool negative, const std::uint64_t magnitude, const FormatSpec& spec)
+{
+    int base = 10;
+    const char* prefix = "";
+    switch (spec.type)
+    {
+        case 0: case 'd': break;
+        case 'x': base = 16; prefix = "0x"; break;
+        case 'X': base = 16; prefix = "0X"; break;
+        case 'b': base = 2;  prefix = "0b"; break;
+        case 'o': base = 8;  prefix = "0";  break;
+        case 'c':
+        {
+            if (negative || magnitude > 0x7F)
+            {
+                return false;
+            }
+            const char character = static_cast<char>(magnitude);
+            appendPadded(out, std::string_view(&character, 1), spec, false, 0);
+            return true;
+        }
+        default:
+            return false;
+    }
+
+    char body[96];
+    std::size_t length = 0;
+    if (negative)
+    {
+        body[length++] = '-';
+    }
+    else if (spec.plus)
+    {
+        body[length++] = '+';
+    }
+    if (spec.alternate)
+    {
+        for (const char* p = prefix; *p != '\0'; ++p)
+        {
+            body[length++] = *p;
+        }
+    }
+    const std::size_t prefixLength = length;
+
+    const auto result = std::to_chars(body + length, body + sizeof(body), magnitude, base);
+    if (spec.type == 'X')
+    {
+        std::transform(body + length, result.ptr, body + length,
+                       [](const char c) { return c >= 'a' && c <= 'f' ? static_cast<char>(c - 'a' + 'A') : c; });
+    }
+    length = static_cast<std::size_t>(result.ptr - body);
+
+    appendPadded(out, std::string_view(body, length), spec, true, prefixLength);
+    return true;
+}
+
+bool appendFloating(std::string& out, const double value, const FormatSpec& spec)
+{
+    std::chars_format format = std::chars_format::general;
+    bool upper = false;
+    switch (spec.type)
+    {
+        case 0:   break;
+        case 'f': format = std::chars_format::fixed; break;
+        case 'F': format = std::chars_format::fixed; upper = true; break;
+        case 'e': format = std::chars_format::scientific; break;
+        case 'E': format = std::chars_format::scientific; upper = true; break;
+        case 'g': break;
+        case 'G': upper = true; break;
+        default:  return false;
+    }
+
+    char body[160];
+    std::size_t length = 0;
+    if (spec.plus && !(value < 0))
+    {
+        body[length++] = '+';
+    }
+    const std::size_t prefixLength = value < 0 ? 1 : length;
+
+    std::to_chars_result result{};
+    if (spec.precision >= 0)
+    {
+        result = std::to_chars(body + length, body + sizeof(body), value, format, spec.precision);
+    }
+    else if (spec.type == 0)
+    {
+        result = std::to_chars(body + length, body + sizeof(body), value);
+    }
+    else
+    {
+        result = std::to_chars(body + length, body + sizeof(body), value, format, 6);
+    }
+    if (result.ec != std::errc{})
+    {
+        return false;
+    }
+    if (upper)
+    {
+        std::transform(body + length, result.ptr, body + length,
+                       [](const char c) { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c; });
+    }
+    length = static_cast<std::size_t>(result.ptr - body);
+
+    appendPadded(out, std::string_view(body, length), spec, true, prefixLength);
+    return true;
+}
+
+void appendUtf16AsUtf8(std::string& out, const std::string_view units)
+{
+    const auto* wide = reinterpret_cast<const wchar_t*>(units.data());
+    const int count = static_cast<int>(units.size() / sizeof(wchar_t));
+    if (count == 0)
+    {
+        return;
+    }
+    // The packed bytes may be unaligned for wchar_t; copy them out first.
+    std::wstring aligned(count, L'\0');
+    std::memcpy(aligned.data(), wide, units.size());
+
+    const int required = WideCharToMultiByte(CP_UTF8, 0, aligned.data(), count, nullptr, 0, nullptr, nullptr);
+    if (required <= 0)
+    {
+        return;
+    }
+    const std::size_t start = out.size();
+    out.resize(start + static_cast<std::size_t>(required));
+    WideCharToMultiByte(CP_UTF8, 0, aligned.data(), count, out.data() + start, required, nullptr, nullptr);
+}
+
+bool appendText(std::string& out, std::string_view text, const FormatSpec& spec)
+{
+    if (spec.type != 0 && spec.type != 's')
+    {
+        return false;
+    }
+    if (spec.precision >= 0)
+    {
+        text = text.substr(0, static_cast<std::size_t>(spec.precision));
+    }
+    appendPadded(out, text, spec, false, 0);
+    return true;
+}
+
+bool appendArg(std::string& out, const DeferredArg& arg, const FormatSpec& spec)
+{
+    switch (arg.type)
+    {
+        case DeferredArgType::Bool:
+            if (spec.type == 0 || spec.type == 's')
+            {
+                return appendText(out, arg.boolean ? "true" : "false", spec);
+            }
+            return appendInteger(out, false, arg.boolean ? 1 : 0, spec);
+
+        case DeferredArgType::Char:
+            if (spec.type == 0 || spec.type == 'c')
+            {
+                FormatSpec text = spec;
+                text.type = 0;
+                return appendText(out, std::string_view(&arg.character, 1), text);
+            }
+            return appendInteger(out, arg.character < 0,
+                                 static_cast<std::uint64_t>(arg.character < 0 ? -static_cast<int>(arg.character) : arg.character), spec);
+
+        case DeferredArgType::Int:
+        {
+            const bool negative = arg.integer < 0;
+            const std::uint64_t magnitude = negative ? 0 - static_cast<std::uint64_t>(arg.integer)
+                                                     : static_cast<std::uint64_t>(arg.integer);
+            return appendInteger(out, negative, magnitude, spec);
+        }
+
+        case DeferredArgType::UInt:
+            return appendInteger(out, false, arg.unsignedInteger, spec);
+
+        case DeferredArgType::Double:
+            return appendFloating(out, arg.floating, spec);
+
+        case DeferredArgType::String:
+            return appendText(out, arg.text, spec);
+
+        case DeferredArgType::WideString:
+        {
+            std::string utf8;
+            appendUtf16AsUtf8(utf8, arg.text);
+            return appendText(out, utf8, spec);
+        }
+
+        case DeferredArgType::Pointer:
+        {
+            if (spec.type != 0 && spec.type != 'p')
+            {
+                return false;
+            }
+            FormatSpec hex = spec;
+            hex.type = 'x';
+            hex.alternate = true;
+            return appendInteger(out, false, arg.unsignedInteger, hex);
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void renderDeferredFormat(const std::string_view format, const std::string_view packedArgs, std::string& out)
+{
+    DeferredArgReader reader(packedArgs);
+    std::size_t nextAuto = 0;
+    std::size_t i = 0;
+
+    while (i < format.size())
+    {
+        const char c = format[i];
+        if (c == '}')
+        {
+            out.push_back('}');
+            i += (i + 1 < format.size() && format[i + 1] == '}') ? 2 : 1;
+            continue;
+        }
+        if (c != '{')
+        {
+            const std::size_t next = format.find_first_of("{}", i);
+            const std::size_t end = next == std::string_view::npos ? format.size() : next;
+            out.append(format.substr(i, end - i));
+            i = end;
+            continue;
+        }
+        if (i + 1 < format.size() && format[i + 1] == '{')
+        {
+            out.push_back('{');
+            i += 2;
+            continue;
+        }
+
+        const std::size_t close = format.find('}', i + 1);
+        if (close == std::string_view::npos)
+        {
+            out.append(format.substr(i));
+            return;
+        }
+        const std::string_view field = format.substr(i, close + 1 - i);
+        std::string_view inner = format.substr(i + 1, close - i - 1);
+        i = close + 1;
+
+        std::size_t index = nextAuto;
+        if (!inner.empty() && inner[0] >= '0' && inner[0] <= '9')
+        {
+            if (!parseNumber(inner, index))
+            {
+                out.append(field);
+                continue;
+            }
+        }
+        else
+        {
+            ++nextAuto;
+        }
+
+        FormatSpec spec;
+        DeferredArg arg;
+        const bool specOk = inner.empty() || (inner[0] == ':' && parseSpec(inner.substr(1), spec));
+        const std::size_t rendered = out.size();
+        if (!specOk || !reader.get(index, arg) || !appendArg(out, arg, spec))
+        {
+            out.resize(rendered);
+            out.append(field);
+        }
+    }
+}
+
+} // namespace core::logging
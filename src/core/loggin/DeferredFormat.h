@@ -0,0 +1,146 @@
+// DeferredFormat.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Deferred log message formatting.
+ *
+ * Logger::logFormatted packs its arguments into a flat byte string (one type tag plus the
+ * raw value per argument; text is copied, wide text stays UTF-16) and the writer thread
+ * renders the message later. Producers pay only for copying the bytes, no formatting and,
+ * with a warm thread-local buffer, no allocation.
+ *
+ * Format syntax is a subset of std::format:
+ *   {} {0} {:spec} {1:spec}, "{{" and "}}" for literal braces
+ *   spec = [[fill]align][+][#][0][width][.precision][type]
+ *   align: < > ^      types: d x X o b c (integers), f F e E g G (floating), s, p
+ * Width and precision count bytes of the UTF-8 output. A field that cannot be rendered
+ * (bad spec, missing argument) is copied to the output verbatim.
+ */
+namespace core::logging
+{
+
+enum class DeferredArgType : std::uint8_t
+{
+    Bool = 1,
+    Char,
+    Int,            // int64
+    UInt,           // uint64
+    Double,
+    String,         // u32 byte length + UTF-8 bytes
+    WideString,     // u32 code unit count + UTF-16 code units
+    Pointer         // uint64
+};
+
+namespace detail
+{
+
+template <typename T>
+inline constexpr bool kAlwaysFalse = false;
+
+template <typename T>
+void appendDeferredValue(std::string& out, const DeferredArgType type, const T value)
+{
+    out.push_back(static_cast<char>(type));
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+inline void appendDeferredText(std::string& out, const DeferredArgType type, const void* data,
+                               const std::uint32_t units, const std::size_t unitBytes)
+{
+    out.push_back(static_cast<char>(type));
+    char length[sizeof(units)];
+    std::memcpy(length, &units, sizeof(units));
+    out.append(length, sizeof(units));
+    out.append(static_cast<const char*>(data), units * unitBytes);
+}
+
+} // namespace detail
+
+// Appends one packed argument to out. Unsupported types fail to compile.
+template <typename T>
+void appendDeferredArg(std::string& out, const T& value)
+{
+    using U = std::remove_cvref_t<T>;
+
+    if constexpr (std::is_same_v<U, bool>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Bool, value);
+    }
+    else if constexpr (std::is_same_v<U, char>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Char, value);
+    }
+    else if constexpr (std::is_same_v<U, wchar_t>)
+    {
+        detail::appendDeferredText(out, DeferredArgType::WideString, &value, 1, sizeof(wchar_t));
+    }
+    else if constexpr (std::is_enum_v<U>)
+    {
+        appendDeferredArg(out, static_cast<std::underlying_type_t<U>>(value));
+    }
+    else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Int, static_cast<std::int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<U>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::UInt, static_cast<std::uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<U>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Double, static_cast<double>(value));
+    }
+    else if constexpr (std::is_null_pointer_v<U>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Pointer, std::uint64_t{ 0 });
+    }
+    else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>)
+    {
+        appendDeferredArg(out, value != nullptr ? std::string_view(value) : std::string_view("(null)"));
+    }
+    else if constexpr (std::is_same_v<U, const wchar_t*> || std::is_same_v<U, wchar_t*>)
+    {
+        appendDeferredArg(out, value != nullptr ? std::wstring_view(value) : std::wstring_view(L"(null)"));
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        const std::string_view text = value;
+        detail::appendDeferredText(out, DeferredArgType::String, text.data(),
+                                   static_cast<std::uint32_t>(text.size()), 1);
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::wstring_view>)
+    {
+        const std::wstring_view text = value;
+        detail::appendDeferredText(out, DeferredArgType::WideString, text.data(),
+                                   static_cast<std::uint32_t>(text.size()), sizeof(wchar_t));
+    }
+    else if constexpr (std::is_pointer_v<U>)
+    {
+        detail::appendDeferredValue(out, DeferredArgType::Pointer,
+                                    static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+    }
+    else
+    {
+        static_assert(detail::kAlwaysFalse<T>, "unsupported deferred log argument type");
+    }
+}
+
+template <typename... Args>
+void packDeferredArgs(std::string& out, const Args&... args)
+{
+    (appendDeferredArg(out, args), ...);
+}
+
+// Renders format with the packed arguments, appending to out.
+void renderDeferredFormat(std::string_view format, std::string_view packedArgs, std::string& out);
+
+} // namespace core::logging
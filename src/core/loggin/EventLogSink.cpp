@@ -2,7 +2,7 @@
 #include "EventLogSink.h"
 
 #include <windows.h>
-#include <utility>
+#include <algorithm>
 #include <utility>
 #include <vector>
 #include <iostream>
@@ -57,16 +57,37 @@ WORD EventLogSink::mapLevelToEventType(LogLevel level)
     }
 }
 
+std::size_t EventLogSink::recordBytes(LogRecord const& record)
+{
+    std::size_t bytes = sizeof(PendingEvent) + record.timestamp.size() + record.message.size() +
+                        record.operation.size() + record.key_path.size() + record.value_name.size() +
+                        record.before.size() + record.after.size() + record.source.size() + record.tid.size();
+    if (record.snapshot_id.has_value()) bytes += record.snapshot_id->size();
+    if (record.metadata.has_value()) bytes += record.metadata->size();
+    return bytes;
+}
+
 // ---------- constructor / destructor ----------
-    EventLogSink::EventLogSink(std::wstring sourceNameW, IThreadManager* threadManager)
-        : m_sourceNameW(std::move(sourceNameW))
-        , m_hEventLog(nullptr)
-        , m_threadManager(threadManager)
-        , m_running(false)
-        , m_dropped(0ull)
-        , m_current_queue_memory(0)
-        , m_immediate_flush_requested(false)
+EventLogSink::EventLogSink(std::wstring sourceNameW, IThreadManager* threadManager)
+    : EventLogSink(std::move(sourceNameW), EventLogSinkOptions{}, threadManager)
 {
+}
+
+EventLogSink::EventLogSink(std::wstring sourceNameW, EventLogSinkOptions const& options, IThreadManager* threadManager)
+    : m_sourceNameW(std::move(sourceNameW))
+    , m_options(options)
+    , m_hEventLog(nullptr)
+    , m_threadManager(threadManager)
+    , m_running(false)
+    , m_dropped(0ull)
+    , m_current_queue_memory(0)
+    , m_immediate_flush_requested(false)
+{
+    m_options.burstEvents = std::max(1.0, m_options.burstEvents);
+    m_options.maxPendingEvents = std::max<std::size_t>(1u, m_options.maxPendingEvents);
+    m_tokens = m_options.burstEvents;
+    m_lastRefill = std::chrono::steady_clock::now();
+
     m_hEventLog = RegisterEventSourceW(nullptr, m_sourceNameW.c_str());
     if (m_hEventLog == nullptr) {
         const DWORD error = GetLastError();
@@ -104,108 +125,255 @@ void EventLogSink::consume(const std::vector<LogRecord>& batch)
         return;
     }
 
-    std::vector<std::wstring> prepared_batch;
-    prepared_batch.reserve(batch.size());
+    constexpr ULONGLONG MAX_QUEUE_MEMORY = 100 * 1024 * 1024;
+    const bool aggregate = m_options.mode == EventLogMode::Aggregated;
+    const auto now = std::chrono::steady_clock::now();
+    const auto due = aggregate ? now + std::chrono::milliseconds(m_options.aggregationWindowMs) : now;
 
-    ULONGLONG total_size = 0;
-    for (const LogRecord &record: batch)
+    bool wake_writer = false;
     {
-        std::string line = record.toNDJsonLine();
+        std::lock_guard lk(m_mutex);
+        std::string key;
 
-        if (line.size() > static_cast<size_t>(kMaxPayloadBytes))
+        for (const LogRecord &record: batch)
         {
-            std::string truncated = line.substr(0, static_cast<size_t>(kMaxPayloadBytes - 128u));
-            truncated.append("...[TRUNCATED]");
-            if (record.snapshot_id.has_value())
+            if (aggregate)
+            {
+                key.clear();
+                key.push_back(static_cast<char>('0' + static_cast<int>(record.level)));
+                key.append(record.operation);
+                key.push_back('\x1f');
+                key.append(record.key_path);
+
+                const auto open = m_openWindows.find(key);
+                if (open != m_openWindows.end() && open->second->due > now)
+                {
+                    ++open->second->count;
+                    open->second->lastTimestamp = record.timestamp;
+                    m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+
+            const std::size_t bytes = recordBytes(record);
+            while (!m_queue.empty() &&
+                   (m_queue.size() >= m_options.maxPendingEvents ||
+                    m_current_queue_memory + bytes > MAX_QUEUE_MEMORY))
+            {
+                m_dropped.fetch_add(m_queue.front().count, std::memory_order_relaxed);
+                m_unreported += m_queue.front().count;
+                popFront();
+            }
+
+            wake_writer = wake_writer || m_queue.empty();
+            PendingEvent& event = m_queue.emplace_back();
+            event.record = record;
+            event.due = due;
+            event.bytes = bytes;
+            m_current_queue_memory += bytes;
+            if (aggregate)
             {
-                truncated.append(" snap=");
-                truncated.append(record.snapshot_id.value());
+                event.aggregationKey = key;
+                m_openWindows[key] = &event;
             }
-            line = std::move(truncated);
         }
 
-        prepared_batch.push_back(utf8ToWide(line));
-        total_size += line.size();
+        if (wake_writer)
+        {
+            ++m_enqueueSerial;
+        }
     }
 
+    // Later events are never due before the queue front, so only an empty queue needs a wakeup.
+    if (wake_writer)
     {
-        std::lock_guard lk(m_mutex);
-
-        constexpr size_t MAX_QUEUE_SIZE = 10000;
-        constexpr ULONGLONG MAX_QUEUE_MEMORY = 100 * 1024 * 1024;
+        m_cv.notify_all();
+    }
+}
 
-        if (m_queue.size() + prepared_batch.size() > MAX_QUEUE_SIZE ||
-            m_current_queue_memory + total_size > MAX_QUEUE_MEMORY)
+void EventLogSink::popFront()
+{
+    PendingEvent& front = m_queue.front();
+    if (!front.aggregationKey.empty())
+    {
+        const auto open = m_openWindows.find(front.aggregationKey);
+        if (open != m_openWindows.end() && open->second == &front)
         {
-            while (!m_queue.empty() &&
-                   (m_queue.size() + prepared_batch.size() > MAX_QUEUE_SIZE ||
-                    m_current_queue_memory + total_size > MAX_QUEUE_MEMORY))
-            {
-                m_current_queue_memory -= m_queue.front().size() * sizeof(wchar_t);
-                m_queue.pop_front();
-                m_dropped.fetch_add(1, std::memory_order_relaxed);
-            }
+            m_openWindows.erase(open);
         }
+    }
+    m_current_queue_memory -= front.bytes;
+    m_queue.pop_front();
+}
 
-        for (std::wstring &message: prepared_batch)
-        {
-            m_queue.push_back(std::move(message));
-            m_current_queue_memory += message.size() * sizeof(wchar_t);
-        }
+void EventLogSink::closeAggregationWindows(std::chrono::steady_clock::time_point now)
+{
+    for (PendingEvent& event : m_queue)
+    {
+        event.due = std::min(event.due, now);
     }
+    m_openWindows.clear();
+}
 
-    m_cv.notify_one();
+void EventLogSink::refillTokens(std::chrono::steady_clock::time_point now)
+{
+    if (m_options.maxEventsPerSecond <= 0)
+    {
+        return;
+    }
+    const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_tokens = std::min(m_options.burstEvents, m_tokens + elapsed * m_options.maxEventsPerSecond);
+    m_lastRefill = now;
 }
 
-void EventLogSink::writerLoop(const std::stop_token& stoken)
+std::chrono::steady_clock::time_point EventLogSink::nextTokenTime(std::chrono::steady_clock::time_point now) const
 {
-    while (!stoken.stop_requested() || !m_queue.empty())
+    const double seconds = (1.0 - m_tokens) / m_options.maxEventsPerSecond;
+    return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                     std::chrono::duration<double>(std::max(seconds, 0.001)));
+}
+
+EventLogSink::DrainStep EventLogSink::drainOne(std::chrono::steady_clock::time_point& wakeAt)
+{
+    std::unique_lock lk(m_mutex);
+    const auto now = std::chrono::steady_clock::now();
+    const bool flushing = m_immediate_flush_requested.load();
+    if (flushing)
     {
-        bool immediate_flush = false;
-        std::vector<std::wstring> batch; {
-            std::unique_lock lk(m_mutex);
+        closeAggregationWindows(now);
+    }
 
-            if (m_immediate_flush_requested && m_queue.empty())
-            {
-                m_immediate_flush_requested = false;
-                m_cv.notify_all();
-                continue;
-            }
+    if (m_queue.empty())
+    {
+        if (m_unreported != 0)
+        {
+            const ULONGLONG unreported = std::exchange(m_unreported, 0);
+            lk.unlock();
+            reportUnsent(unreported);
+            return DrainStep::Sent;
+        }
+        if (flushing)
+        {
+            m_immediate_flush_requested = false;
+            lk.unlock();
+            m_cv.notify_all();
+        }
+        return DrainStep::Empty;
+    }
 
-            if (m_queue.empty())
+    if (m_queue.front().due > now)
+    {
+        wakeAt = m_queue.front().due;
+        return DrainStep::Waiting;
+    }
+
+    if (m_options.maxEventsPerSecond > 0)
+    {
+        refillTokens(now);
+        if (m_tokens < 1.0)
+        {
+            if (!flushing)
             {
-                m_cv.wait_for(lk, std::chrono::milliseconds(200), [this, &stoken]
-                {
-                    return !m_queue.empty() || stoken.stop_requested() || m_immediate_flush_requested;
-                });
+                wakeAt = nextTokenTime(now);
+                return DrainStep::Waiting;
             }
 
-            while (!m_queue.empty() && batch.size() < 64u)
+            // A flush does not wait for the bucket: what is left goes into the summary event.
+            while (!m_queue.empty())
             {
-                batch.push_back(std::move(m_queue.front()));
-                m_queue.pop_front();
-                m_current_queue_memory -= batch.back().size() * sizeof(wchar_t);
+                m_dropped.fetch_add(m_queue.front().count, std::memory_order_relaxed);
+                m_unreported += m_queue.front().count;
+                popFront();
             }
-
-            immediate_flush = m_immediate_flush_requested;
+            return DrainStep::Sent;
         }
+        m_tokens -= 1.0;
+    }
 
+    PendingEvent event = std::move(m_queue.front());
+    m_queue.front().aggregationKey = event.aggregationKey;     // popFront looks the window up by key
+    popFront();
+    const ULONGLONG unreported = std::exchange(m_unreported, 0);
+    lk.unlock();
+
+    sendEventWide(formatEvent(event), event.record.level);
+    if (unreported != 0)
+    {
+        reportUnsent(unreported);
+    }
+    return DrainStep::Sent;
+}
 
-        if (!batch.empty() || immediate_flush)
+void EventLogSink::writerLoop(const std::stop_token& stoken)
+{
+    while (true)
+    {
+        auto wake_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        const DrainStep step = drainOne(wake_at);
+        if (step == DrainStep::Sent)
         {
-            processBatch(batch);
+            continue;
+        }
 
-            if (immediate_flush)
+        std::unique_lock lk(m_mutex);
+        if (stoken.stop_requested())
+        {
+            if (step == DrainStep::Empty && m_queue.empty() && m_unreported == 0)
             {
-                std::lock_guard lk(m_mutex);
-                if (m_queue.empty())
-                {
-                    m_immediate_flush_requested = false;
-                    m_cv.notify_all();
-                }
+                break;
             }
+            // Drain the rest without waiting for windows or tokens.
+            m_immediate_flush_requested = true;
+            continue;
+        }
+
+        const ULONGLONG serial = m_enqueueSerial;
+        m_cv.wait_until(lk, wake_at, [this, &stoken, serial]
+        {
+            return m_enqueueSerial != serial || m_immediate_flush_requested || stoken.stop_requested();
+        });
+    }
+}
+
+std::wstring EventLogSink::formatEvent(PendingEvent const& event) const
+{
+    std::string line;
+    event.record.appendNDJsonLine(line);
+    if (!line.empty() && line.back() == '\n')
+    {
+        line.pop_back();
+    }
+
+    if (event.count > 1 && !line.empty() && line.back() == '}')
+    {
+        line.pop_back();
+        line.append(",\"count\":");
+        line.append(std::to_string(event.count));
+        line.append(",\"last_ts\":\"");
+        line.append(event.lastTimestamp);
+        line.append("\"}");
+    }
+
+    if (line.size() > static_cast<size_t>(kMaxPayloadBytes))
+    {
+        std::string truncated = line.substr(0, static_cast<size_t>(kMaxPayloadBytes - 128u));
+        truncated.append("...[TRUNCATED]");
+        if (event.record.snapshot_id.has_value())
+        {
+            truncated.append(" snap=");
+            truncated.append(event.record.snapshot_id.value());
         }
+        line = std::move(truncated);
     }
+
+    return utf8ToWide(line);
+}
+
+void EventLogSink::reportUnsent(ULONGLONG records)
+{
+    const std::wstring line = L"EventLogSink: " + std::to_wstring(records) +
+                              L" log records were not written to the Event Log (queue full or rate limited)";
+    sendEventWide(line, LogLevel::Warn);
 }
 
 // ---------- send single event with ReportEventW ----------
@@ -273,66 +441,39 @@ bool EventLogSink::sendEventWide(const std::wstring& wideLine, LogLevel level)
     return false;
 }
 
-void EventLogSink::processBatch(std::vector<std::wstring> const &batch)
-{
-
-}
-
 void EventLogSink::startThreadManagerTask()
 {
-    // Периодическая задача вместо вечного цикла
-    auto task = [this]() -> bool {
-        if (!m_running.load(std::memory_order_acquire)) {
-            return false; // Завершаем задачу
-        }
-
-        std::vector<std::wstring> batch;
-        bool immediate_flush = false;
-
+    // Runs one bounded drain pass per tick; FixedDelay keeps passes from overlapping.
+    m_recurringId = m_threadManager->scheduleRecurring(IThreadManager::RecurringMode::FixedDelay,
+                                                       std::chrono::milliseconds(100), [this]
+    {
+        std::lock_guard run(m_drainMutex);
+        if (!m_running.load(std::memory_order_acquire))
         {
-            std::lock_guard<std::mutex> lk(m_mutex);
-            if (m_queue.empty() && !m_immediate_flush_requested) {
-                return true; // Продолжаем, но нет работы
-            }
-
-            // Извлекаем batch
-            while (!m_queue.empty() && batch.size() < 64u) {
-                batch.push_back(std::move(m_queue.front()));
-                m_queue.pop_front();
-                m_current_queue_memory -= batch.back().size() * sizeof(wchar_t);
-            }
-
-            immediate_flush = m_immediate_flush_requested && m_queue.empty();
+            return;
         }
 
-        // Обрабатываем batch
-        if (!batch.empty() || immediate_flush) {
-            processBatch(batch);
-
-            if (immediate_flush) {
-                std::lock_guard<std::mutex> lk(m_mutex);
-                if (m_queue.empty()) {
-                    m_immediate_flush_requested = false;
-                    m_cv.notify_all();
-                }
-            }
+        auto wake_at = std::chrono::steady_clock::now();
+        while (drainOne(wake_at) == DrainStep::Sent)
+        {
         }
-
-        return true; // Продолжаем выполнение
-    };
-
-    // Предполагаем что ThreadManager поддерживает периодические задачи
-    m_threadManager->scheduleRecurring(std::chrono::milliseconds(100), task);
+    });
 }
 
 
 // ---------- flush ----------
 void EventLogSink::flush()
-{ {
+{
+    if (!m_running.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    {
         std::lock_guard lk(m_mutex);
         m_immediate_flush_requested = true;
     }
-    m_cv.notify_one();
+    m_cv.notify_all();
 
     std::unique_lock lk(m_mutex);
     const auto timeout = std::chrono::seconds(30);
@@ -358,16 +499,30 @@ EventLogSink::close()
     bool expected = true;
     if (!m_running.compare_exchange_strong(expected, false))
     {
+        return;
     }
 
-    m_cv.notify_all();
-
+    // Both consumers drain what is still pending before they stop.
     if (m_worker.joinable())
     {
         m_worker.request_stop();
+        {
+            std::lock_guard lk(m_mutex);
+        }
+        m_cv.notify_all();
+        m_worker.join();
     }
+    else if (m_threadManager != nullptr)
+    {
+        m_threadManager->cancelRecurring(m_recurringId);
 
-    flush();
+        std::lock_guard run(m_drainMutex);
+        m_immediate_flush_requested = true;
+        auto wake_at = std::chrono::steady_clock::now();
+        while (drainOne(wake_at) != DrainStep::Empty)
+        {
+        }
+    }
 
     if (m_hEventLog != nullptr)
     {
@@ -376,4 +531,14 @@ EventLogSink::close()
     }
 }
 
+ULONGLONG EventLogSink::droppedCount() const
+{
+    return m_dropped.load();
+}
+
+ULONGLONG EventLogSink::coalescedCount() const
+{
+    return m_coalesced.load();
+}
+
 } // namespace core::logging
@@ -13,7 +13,8 @@
 #include <condition_variable>
 #include <thread>
 #include <atomic>
-#include <sstream>
+#include <chrono>
+#include <unordered_map>
 
 /**
  * EventLogSink
@@ -26,9 +27,27 @@
  *   logger.addSink(sink);
  *
  *   // or provide a thread manager (non-owning). If provided, sink will use it
- *   // to submit a long-running writer task (this occupies a pool thread).
+ *   // to run a recurring drain task instead of a dedicated thread.
  *   EventLogSink sinkWithPool(L"MyAppSource", threadManagerPointer);
  *
+ *   // coalesce repeats and cap the Event Log at 20 events/sec
+ *   EventLogSinkOptions options;
+ *   options.mode = EventLogMode::Aggregated;
+ *   options.maxEventsPerSecond = 20;
+ *   auto limited = std::make_shared<EventLogSink>(L"MyAppSource", options);
+ *
+ * Behavior:
+ *  - consume() only moves records into a bounded pending queue; ReportEvent calls run on
+ *    the sink's own consumer, so a slow Event Log never holds up the Logger writer and the
+ *    other sinks. Past maxPendingEvents the oldest pending events are dropped.
+ *  - Aggregated mode merges records with the same level, operation and key path that arrive
+ *    within aggregationWindowMs of the first one into a single event: the first record plus
+ *    "count" and "last_ts".
+ *  - maxEventsPerSecond / burstEvents form a token bucket on ReportEvent calls. Pending
+ *    events wait for a token; records dropped by the queue bound or by a flush that runs out
+ *    of tokens are reported in one summary warning event.
+ *  - flush() closes every aggregation window and returns once the pending queue is empty.
+ *
  * Notes:
  *  - Event source registration should be done at install time. Creating a new
  *    source at runtime requires admin rights and proper message DLLs.
@@ -40,6 +59,21 @@
 namespace core::logging
 {
 
+enum class EventLogMode
+{
+    PerRecord,
+    Aggregated
+};
+
+struct EventLogSinkOptions
+{
+    EventLogMode mode = EventLogMode::PerRecord;
+    ULONGLONG aggregationWindowMs = 1000;   // Aggregated only
+    double maxEventsPerSecond = 0;          // 0 = unlimited
+    double burstEvents = 20;                // token bucket capacity
+    std::size_t maxPendingEvents = 10000;
+};
+
 class EventLogSink final : public ILogSink
 {
 public:
@@ -49,10 +83,12 @@ public:
      * Parameters:
      *   sourceNameW - UTF-16 event source name (e.g. L"MyCompany\\MyApp" or L"MyAppSource")
      *   threadManager - optional non-owning pointer to IThreadManager; if not null,
-     *                   the sink will submit a long-running writer task to it.
+     *                   the sink will schedule a recurring drain task on it.
      */
     explicit EventLogSink(std::wstring  sourceNameW, IThreadManager* threadManager = nullptr);
 
+    EventLogSink(std::wstring sourceNameW, EventLogSinkOptions const& options, IThreadManager* threadManager = nullptr);
+
     ~EventLogSink() override;
 
     void consume(std::vector<LogRecord> const& batch) override;
@@ -61,29 +97,72 @@ public:
 
     void close();
 
+    // Records never written: queue overflow, rate limiting on flush, or after close().
+    ULONGLONG droppedCount() const;
+
+    // Records folded into an earlier event by Aggregated mode.
+    ULONGLONG coalescedCount() const;
+
 private:
+    struct PendingEvent
+    {
+        LogRecord record;                                   // first record of the window
+        std::string lastTimestamp;
+        ULONGLONG count = 1;
+        std::chrono::steady_clock::time_point due;          // window end; send no earlier
+        std::string aggregationKey;                         // empty in PerRecord mode
+        std::size_t bytes = 0;
+    };
+
+    enum class DrainStep
+    {
+        Sent,       // made progress (sent or dropped); call again
+        Waiting,    // something is pending; nothing can go out before wakeAt
+        Empty
+    };
 
     void writerLoop(const std::stop_token &stoken);
 
+    // Sends at most one event. Must not be called concurrently.
+    DrainStep drainOne(std::chrono::steady_clock::time_point& wakeAt);
+
+    // Caller holds m_mutex.
+    void refillTokens(std::chrono::steady_clock::time_point now);
+    [[nodiscard]] std::chrono::steady_clock::time_point nextTokenTime(std::chrono::steady_clock::time_point now) const;
+    void closeAggregationWindows(std::chrono::steady_clock::time_point now);
+    void popFront();
+
+    std::wstring formatEvent(PendingEvent const& event) const;
+    void reportUnsent(ULONGLONG records);
     bool sendEventWide(std::wstring const& wideLine, LogLevel level);
-    void processBatch(std::vector<std::wstring> const& batch);
     static std::wstring utf8ToWide(std::string const& utf8);
+    static std::size_t recordBytes(LogRecord const& record);
 
     static WORD mapLevelToEventType(LogLevel level);
     void startThreadManagerTask();
 
     std::wstring m_sourceNameW;
+    EventLogSinkOptions m_options;
     HANDLE m_hEventLog;
 
-    std::deque<std::wstring> m_queue;
+    std::deque<PendingEvent> m_queue;                       // ordered by due
+    std::unordered_map<std::string, PendingEvent*> m_openWindows;
     std::mutex m_mutex;
     std::condition_variable m_cv;
+    ULONGLONG m_enqueueSerial{0};                           // bumped by consume(); wakes the writer
+
+    double m_tokens{0};
+    std::chrono::steady_clock::time_point m_lastRefill;
+    ULONGLONG m_unreported{0};                              // dropped records not yet summarized
 
     std::jthread m_worker;
     IThreadManager* m_threadManager;
+    IThreadManager::RecurringId m_recurringId{0};
+    std::mutex m_drainMutex;                                // serializes thread-manager runs with close()
     std::atomic<bool> m_running;
 
     std::atomic<unsigned long long> m_dropped;
+    std::atomic<unsigned long long> m_coalesced{0};
     ULONGLONG m_current_queue_memory{0};
     std::atomic<bool> m_immediate_flush_requested{false};
     static unsigned long const kMaxPayloadBytes;
@@ -1,8 +1,11 @@
 // FileLogger.cpp
 #include "FileLogger.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <sstream>
+#include <string_view>
 #include <iostream>
 #include <iomanip>
 #include <utility>
@@ -25,6 +28,27 @@ static std::wstring makeFilePath(std::wstring const& dirW, std::wstring const& n
     return path;
 }
 
+// Bytes of pending to write before the file must rotate: the lines that keep it below
+// maxBytes, or the first line alone if not even that fits. pending.size() means no rotation
+// is due within pending. Lines are never split between two files.
+static size_t bytesBeforeRotation(const std::string_view pending, const ULONGLONG fileBytes,
+                                  const ULONGLONG maxBytes)
+{
+    const ULONGLONG room = maxBytes > fileBytes ? maxBytes - fileBytes : 0;
+    if (pending.size() < room)
+    {
+        return pending.size();
+    }
+
+    const size_t lastFitting = pending.substr(0, static_cast<size_t>(room)).rfind('\n');
+    if (lastFitting != std::string_view::npos)
+    {
+        return lastFitting + 1;
+    }
+    const size_t firstLine = pending.find('\n');
+    return firstLine == std::string_view::npos ? pending.size() : firstLine + 1;
+}
+
 std::string FileLogger::toUtf8(const std::wstring& wstr)
 {
     if (wstr.empty())
@@ -71,22 +95,53 @@ FileLogger::FileLogger(std::wstring logDirectoryW,
                        const ULONGLONG flushIntervalMs,
                        const ULONGLONG flushThresholdBytes,
                        const BOOL fsyncOnFlush)
+    : FileLogger(std::move(logDirectoryW), std::move(baseFileName), FileLoggerOptions{
+          .maxFileBytes = maxFileBytes,
+          .rotateCount = rotateCount,
+          .flushIntervalMs = flushIntervalMs,
+          .flushThresholdBytes = flushThresholdBytes,
+          .durability = fsyncOnFlush ? DurabilityLevel::PeriodicFsync : DurabilityLevel::OsBuffered,
+          .fsyncIntervalMs = 1000,
+          .writeMode = FileWriteMode::Synchronous
+      })
+{
+}
+
+FileLogger::FileLogger(std::wstring logDirectoryW,
+                       std::wstring baseFileName,
+                       FileLoggerOptions const& options)
     : m_logDirectoryW(std::move(logDirectoryW))
     , m_baseFileName(std::move(baseFileName))
-    , m_maxFileBytes(maxFileBytes)
-    , m_rotateCount(rotateCount)
-    , m_flushIntervalMs(flushIntervalMs)
-    , m_flushThresholdBytes(flushThresholdBytes)
-    , m_fsyncOnFlush(fsyncOnFlush)
+    , m_maxFileBytes(options.maxFileBytes)
+    , m_rotateCount(options.rotateCount)
+    , m_flushIntervalMs(options.flushIntervalMs)
+    , m_flushThresholdBytes(options.flushThresholdBytes)
+    , m_durability(options.durability)
+    , m_fsyncIntervalMs(options.fsyncIntervalMs)
+    , m_writeMode(options.writeMode)
+    , m_compressRotated(options.compressRotated)
 {
+    if (m_compressRotated != LogCompression::None)
+    {
+        m_compressor = std::make_unique<RotatedFileCompressor>(m_compressRotated);
+    }
+
     const BOOL ok = ensureDirectoryExists();
     if (!ok)
     {
         std::cerr << "FileLogger: cannot create log directory\n";
     }
 
+    if (m_writeMode == FileWriteMode::Overlapped && !allocateAsyncBuffers())
+    {
+        std::cerr << "FileLogger: cannot allocate aligned buffers, using synchronous writes\n";
+        releaseAsyncBuffers();
+        m_writeMode = FileWriteMode::Synchronous;
+    }
+
     openLogFile();
 
+    m_lastSync = std::chrono::steady_clock::now();
     m_running.store(true);
     m_worker = std::jthread([this](const std::stop_token& st)
     {
@@ -130,14 +185,20 @@ BOOL FileLogger::openLogFile()
 
     const std::wstring file_path = makeFilePath(m_logDirectoryW, m_baseFileName);
 
+    // Overlapped mode reads the file's partial last sector back, so it needs read access too.
+    const bool overlapped = m_writeMode == FileWriteMode::Overlapped;
+    const DWORD access = overlapped ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_WRITE;
+    const DWORD flags = overlapped
+        ? (FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING)
+        : FILE_ATTRIBUTE_NORMAL;
 
     HANDLE file = CreateFileW(
         file_path.c_str(),
-        GENERIC_WRITE,
+        access,
         FILE_SHARE_READ,
         nullptr,
         OPEN_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
+        flags,
         nullptr
     );
 
@@ -152,6 +213,7 @@ BOOL FileLogger::openLogFile()
             return FALSE;
         }
 
+        // Also the fallback for volumes that refuse unbuffered I/O.
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         file = CreateFileW(file_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ,
                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
@@ -161,14 +223,13 @@ BOOL FileLogger::openLogFile()
             m_fileHandle = INVALID_HANDLE_VALUE;
             return FALSE;
         }
-    }
-
-    LARGE_INTEGER new_position;
-    new_position.QuadPart = 0;
 
-    if (!SetFilePointerEx(file, new_position, nullptr, FILE_END))
-    {
-        std::cerr << "FileLogger: warning - cannot seek to end, writing from beginning\n";
+        if (overlapped)
+        {
+            std::cerr << "FileLogger: unbuffered open failed, using synchronous writes\n";
+            releaseAsyncBuffers();
+            m_writeMode = FileWriteMode::Synchronous;
+        }
     }
 
     LARGE_INTEGER file_size;
@@ -181,12 +242,179 @@ BOOL FileLogger::openLogFile()
         m_currentFileBytes.store(0);
     }
 
+    if (m_writeMode == FileWriteMode::Overlapped)
+    {
+        if (!loadExistingTail(file, m_currentFileBytes.load()))
+        {
+            CloseHandle(file);
+            m_fileHandle = INVALID_HANDLE_VALUE;
+            return FALSE;
+        }
+    }
+    else
+    {
+        LARGE_INTEGER new_position;
+        new_position.QuadPart = 0;
+
+        if (!SetFilePointerEx(file, new_position, nullptr, FILE_END))
+        {
+            std::cerr << "FileLogger: warning - cannot seek to end, writing from beginning\n";
+        }
+    }
+
     m_fileHandle = file;
     m_currentFilePathW = file_path;
 
     return TRUE;
 }
 
+// ---------- Overlapped mode ----------
+BOOL FileLogger::allocateAsyncBuffers()
+{
+    const ULONGLONG wanted = std::max<ULONGLONG>(m_flushThresholdBytes * 2, 64 * 1024) + kSectorAlign;
+    m_asyncCapacity = static_cast<size_t>((wanted + kSectorAlign - 1) / kSectorAlign * kSectorAlign);
+
+    for (AsyncBuffer& buffer : m_async)
+    {
+        // VirtualAlloc returns page-aligned memory, which satisfies FILE_FLAG_NO_BUFFERING.
+        buffer.data = static_cast<char*>(VirtualAlloc(nullptr, m_asyncCapacity, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        buffer.overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (buffer.data == nullptr || buffer.overlapped.hEvent == nullptr)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+void FileLogger::releaseAsyncBuffers()
+{
+    for (AsyncBuffer& buffer : m_async)
+    {
+        if (buffer.data != nullptr)
+        {
+            VirtualFree(buffer.data, 0, MEM_RELEASE);
+            buffer.data = nullptr;
+        }
+        if (buffer.overlapped.hEvent != nullptr)
+        {
+            CloseHandle(buffer.overlapped.hEvent);
+            buffer.overlapped.hEvent = nullptr;
+        }
+        buffer.used = 0;
+        buffer.inFlight = false;
+    }
+}
+
+BOOL FileLogger::loadExistingTail(HANDLE file, const ULONGLONG fileSize)
+{
+    m_async[0].used = 0;
+    m_async[1].used = 0;
+    m_asyncCurrent = 0;
+    m_asyncOffset = fileSize / kSectorAlign * kSectorAlign;
+    m_asyncTrimmed = true;
+
+    const auto tail = static_cast<size_t>(fileSize - m_asyncOffset);
+    if (tail == 0)
+    {
+        return TRUE;
+    }
+
+    AsyncBuffer& buffer = m_async[m_asyncCurrent];
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(m_asyncOffset);
+    overlapped.OffsetHigh = static_cast<DWORD>(m_asyncOffset >> 32);
+    overlapped.hEvent = buffer.overlapped.hEvent;
+    ResetEvent(overlapped.hEvent);
+
+    DWORD read = 0;
+    const BOOL started = ReadFile(file, buffer.data, static_cast<DWORD>(kSectorAlign), nullptr, &overlapped) ||
+                         GetLastError() == ERROR_IO_PENDING;
+    if (!started || !GetOverlappedResult(file, &overlapped, &read, TRUE) || read < tail)
+    {
+        std::cerr << "FileLogger: cannot read the last sector back, error=" << GetLastError() << "\n";
+        return FALSE;
+    }
+
+    buffer.used = tail;
+    return TRUE;
+}
+
+BOOL FileLogger::waitAsyncBuffer(AsyncBuffer& buffer)
+{
+    if (!buffer.inFlight)
+    {
+        return TRUE;
+    }
+
+    DWORD transferred = 0;
+    buffer.inFlight = false;
+    return GetOverlappedResult(m_fileHandle, &buffer.overlapped, &transferred, TRUE);
+}
+
+BOOL FileLogger::submitAsyncBuffer()
+{
+    AsyncBuffer& current = m_async[m_asyncCurrent];
+    AsyncBuffer& other = m_async[m_asyncCurrent ^ 1];
+
+    // The two writes share current's first sector, so the previous one must land first.
+    if (!waitAsyncBuffer(other))
+    {
+        return FALSE;
+    }
+
+    const size_t padded = (current.used + kSectorAlign - 1) / kSectorAlign * kSectorAlign;
+    std::memset(current.data + current.used, 0, padded - current.used);
+
+    current.overlapped.Offset = static_cast<DWORD>(m_asyncOffset);
+    current.overlapped.OffsetHigh = static_cast<DWORD>(m_asyncOffset >> 32);
+    ResetEvent(current.overlapped.hEvent);
+
+    if (!WriteFile(m_fileHandle, current.data, static_cast<DWORD>(padded), nullptr, &current.overlapped) &&
+        GetLastError() != ERROR_IO_PENDING)
+    {
+        return FALSE;
+    }
+    current.inFlight = true;
+    m_asyncTrimmed = false;
+
+    // The partial last sector moves to the other buffer and is rewritten by the next write.
+    const size_t fullSectors = current.used / kSectorAlign * kSectorAlign;
+    const size_t tail = current.used - fullSectors;
+    std::memcpy(other.data, current.data + fullSectors, tail);
+    other.used = tail;
+
+    m_currentFileBytes.store(m_asyncOffset + current.used);
+    m_asyncOffset += fullSectors;
+    m_asyncCurrent ^= 1;
+    return TRUE;
+}
+
+BOOL FileLogger::trimToLogicalSize()
+{
+    if (m_asyncTrimmed)
+    {
+        return TRUE;
+    }
+
+    FILE_END_OF_FILE_INFO end_of_file;
+    end_of_file.EndOfFile.QuadPart = static_cast<LONGLONG>(m_currentFileBytes.load());
+    m_asyncTrimmed = SetFileInformationByHandle(m_fileHandle, FileEndOfFileInfo, &end_of_file, sizeof(end_of_file)) != FALSE;
+    return m_asyncTrimmed ? TRUE : FALSE;
+}
+
+BOOL FileLogger::completeAsyncWrites()
+{
+    if (m_writeMode != FileWriteMode::Overlapped || m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return TRUE;
+    }
+
+    const BOOL first = waitAsyncBuffer(m_async[0]);
+    const BOOL second = waitAsyncBuffer(m_async[1]);
+    return first && second && trimToLogicalSize();
+}
+
 void FileLogger::consume(const std::vector<LogRecord>& batch)
 {
     if (!m_running.load(std::memory_order_acquire))
@@ -195,109 +423,123 @@ void FileLogger::consume(const std::vector<LogRecord>& batch)
         return;
     }
 
-    std::vector<std::string> lines;
-    lines.reserve(batch.size());
-
-    ULONGLONG total_batch_size = 0;
+    m_batchBuffer.clear();
     for (const LogRecord &record: batch)
     {
-        std::string line = record.toNDJsonLine();
-        total_batch_size += line.size();
-        lines.push_back(std::move(line));
+        record.appendNDJsonLine(m_batchBuffer);
     }
     {
         std::lock_guard lk(m_mutex);
 
         const ULONGLONG threshold = m_flushThresholdBytes * 10;
-        const ULONGLONG current_size = m_currentQueueSize;
-
-        if (current_size + total_batch_size > threshold)
+        if (m_buffer.size() + m_batchBuffer.size() > threshold)
         {
-            const ULONGLONG need_to_free = (current_size + total_batch_size) - threshold;
-            ULONGLONG freed_size = 0;
-
-            while (!m_queue.empty() && freed_size < need_to_free)
-            {
-                freed_size += m_queue.front().size();
-                m_queue.pop_front();
-            }
-
-            const ULONGLONG dropped_count = (freed_size + total_batch_size - need_to_free) /
-                                            (lines.empty() ? 1 : lines[0].size());
-            m_dropped.fetch_add(dropped_count, std::memory_order_relaxed);
-            m_currentQueueSize -= freed_size;
+            dropOldestLines(m_buffer.size() + m_batchBuffer.size() - threshold);
         }
 
-        for (std::string &line: lines)
+        if (m_buffer.empty())
+        {
+            m_buffer.swap(m_batchBuffer);
+        }
+        else
         {
-            m_queue.push_back(std::move(line));
+            m_buffer.append(m_batchBuffer);
         }
-        m_currentQueueSize += total_batch_size;
     }
 
     m_cv.notify_one();
 }
 
+void FileLogger::dropOldestLines(const std::size_t bytes)
+{
+    std::size_t cut = 0;
+    ULONGLONG lines = 0;
+    while (cut < m_buffer.size() && cut < bytes)
+    {
+        const std::size_t newline = m_buffer.find('\n', cut);
+        cut = newline == std::string::npos ? m_buffer.size() : newline + 1;
+        ++lines;
+    }
+
+    m_buffer.erase(0, cut);
+    m_dropped.fetch_add(lines, std::memory_order_relaxed);
+}
+
 void FileLogger::writerLoop(const std::stop_token& stoken)
 {
     using namespace std::chrono_literals;
     const auto flushInterval = std::chrono::milliseconds(m_flushIntervalMs);
 
+    // Swapped with m_buffer, so both keep their capacity and steady-state writes allocate nothing.
     std::string local_buffer;
     local_buffer.reserve(m_flushThresholdBytes * 2);
 
-    while (!stoken.stop_requested() || !m_queue.empty())
+    for (;;)
     {
-        bool immediate_flush = false;
+        std::uint64_t flush_ticket = 0;
+        bool stopping = false;
         {
-            ULONGLONG extracted_size = 0;
             std::unique_lock lk(m_mutex);
 
-            if (m_immediate_flush_requested)
-            {
-                immediate_flush = true;
-                m_immediate_flush_requested = false;
-            }
-
-            if (m_queue.empty())
+            const auto has_work = [this, &stoken]
             {
-                m_cv.wait_for(lk, flushInterval, [this, &stoken]
-                {
-                    return !m_queue.empty() || stoken.stop_requested();
-                });
-            }
-
-            while (!m_queue.empty() && local_buffer.size() < m_flushThresholdBytes)
+                return m_buffer.size() >= m_flushThresholdBytes || stoken.stop_requested() ||
+                       m_flushRequested != m_flushCompleted;
+            };
+            if (!has_work())
             {
-                local_buffer.append(m_queue.front());
-                extracted_size += m_queue.front().size();
-                m_queue.pop_front();
+                m_cv.wait_for(lk, flushInterval, has_work);
             }
 
-            m_currentQueueSize -= extracted_size;
+            // Every flush() that got its ticket before this swap is covered by this pass.
+            flush_ticket = m_flushRequested;
+            local_buffer.swap(m_buffer);
+            stopping = stoken.stop_requested();
         }
 
-        if (!local_buffer.empty() || immediate_flush)
+        const bool idle = local_buffer.empty();
+        if (!idle)
         {
             const BOOL ok = writeBufferToDisk(local_buffer);
             if (!ok)
             {
-                const ULONGLONG approximate_records_lost = local_buffer.size() / 100;
-                m_dropped.fetch_add(approximate_records_lost, std::memory_order_relaxed);
+                const auto records_lost = static_cast<ULONGLONG>(
+                    std::count(local_buffer.begin(), local_buffer.end(), '\n'));
+                m_dropped.fetch_add(records_lost, std::memory_order_relaxed);
             }
             local_buffer.clear();
-            local_buffer.reserve(m_flushThresholdBytes * 2);
         }
-        else if (!stoken.stop_requested())
+
+        const bool barrier = flush_ticket != m_flushCompleted;
+        if (!syncAfterWrite(barrier))
         {
-            std::this_thread::yield();
+            std::cerr << "FileLogger: flush failed, error=" << GetLastError() << "\n";
+        }
+        if (idle)
+        {
+            completeAsyncWrites();
         }
-    }
 
-    if (!local_buffer.empty())
-    {
-        writeBufferToDisk(local_buffer);
+        if (barrier)
+        {
+            {
+                std::lock_guard lk(m_mutex);
+                m_flushCompleted = flush_ticket;
+            }
+            m_flushCv.notify_all();
+        }
+
+        if (stopping)
+        {
+            std::lock_guard lk(m_mutex);
+            if (m_buffer.empty())
+            {
+                break;
+            }
+        }
     }
+
+    completeAsyncWrites();
 }
 
 BOOL FileLogger::writeBufferToDisk(const std::string& buffer)
@@ -310,17 +552,33 @@ BOOL FileLogger::writeBufferToDisk(const std::string& buffer)
         }
     }
 
+    const BOOL ok = m_writeMode == FileWriteMode::Overlapped
+        ? writeBufferOverlapped(buffer)
+        : writeBufferSynchronous(buffer);
+    if (ok && !buffer.empty())
+    {
+        m_unsyncedWrites = true;
+    }
+    return ok;
+}
+
+BOOL FileLogger::writeBufferSynchronous(const std::string& buffer)
+{
+    // One WriteFile per file the buffer lands in; the loop only continues after a short
+    // write or a rotation.
     const char *data = buffer.data();
     size_t remaining = buffer.size();
-    constexpr DWORD kMaxSingleWrite = 64 * 1024;
+    constexpr size_t kMaxSingleWrite = 0x7FFFF000;
 
     while (remaining > 0)
     {
-        const DWORD to_write = std::min(remaining, static_cast<size_t>(kMaxSingleWrite));
+        const size_t before_rotation = bytesBeforeRotation(std::string_view(data, remaining),
+                                                           m_currentFileBytes.load(), m_maxFileBytes);
+        const DWORD to_write = static_cast<DWORD>(std::min(before_rotation, kMaxSingleWrite));
         DWORD written = 0;
 
         BOOL write_ok = WriteFile(m_fileHandle, data, to_write, &written, nullptr);
-        if (!write_ok || written != to_write)
+        if (!write_ok)
         {
             const DWORD error = GetLastError();
 
@@ -342,11 +600,19 @@ BOOL FileLogger::writeBufferToDisk(const std::string& buffer)
             }
         }
 
+        // A write that succeeds without progress would otherwise be retried forever.
+        if (written == 0)
+        {
+            std::cerr << "FileLogger: WriteFile wrote nothing\n";
+            return FALSE;
+        }
+
         data += written;
         remaining -= written;
 
         const ULONGLONG new_size = m_currentFileBytes.fetch_add(written) + written;
-        if (new_size >= m_maxFileBytes)
+        const bool rotation_due = written == before_rotation && before_rotation < remaining + written;
+        if (rotation_due || new_size >= m_maxFileBytes)
         {
             if (!rotateFile())
             {
@@ -355,46 +621,123 @@ BOOL FileLogger::writeBufferToDisk(const std::string& buffer)
         }
     }
 
-    return conditionalFlush();
+    return TRUE;
 }
 
-BOOL FileLogger::recoverFromWriteError(DWORD error)
+BOOL FileLogger::writeBufferOverlapped(const std::string& buffer)
 {
-    if (m_fileHandle != INVALID_HANDLE_VALUE) {
-        CloseHandle(m_fileHandle);
-        m_fileHandle = INVALID_HANDLE_VALUE;
+    const char *data = buffer.data();
+    size_t remaining = buffer.size();
+
+    while (remaining > 0)
+    {
+        AsyncBuffer& current = m_async[m_asyncCurrent];
+        const size_t before_rotation = bytesBeforeRotation(std::string_view(data, remaining),
+                                                           m_asyncOffset + current.used, m_maxFileBytes);
+        const size_t chunk = std::min(before_rotation, m_asyncCapacity - current.used);
+        std::memcpy(current.data + current.used, data, chunk);
+        current.used += chunk;
+        data += chunk;
+        remaining -= chunk;
+
+        if (!submitAsyncBuffer())
+        {
+            const DWORD error = GetLastError();
+            std::cerr << "FileLogger: overlapped write failed, error=" << error << "\n";
+            recoverFromWriteError(error);
+            return FALSE;
+        }
+
+        const bool rotation_due = chunk == before_rotation && remaining > 0;
+        if (rotation_due || m_currentFileBytes.load() >= m_maxFileBytes)
+        {
+            if (!rotateFile())
+            {
+                return FALSE;
+            }
+        }
     }
 
+    return TRUE;
+}
+
+BOOL FileLogger::recoverFromWriteError(DWORD error)
+{
+    std::cerr << "FileLogger: reopening log file after error=" << error << "\n";
+    closeFileHandle();
+
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
 
     return openLogFile();
 }
 
-BOOL FileLogger::conditionalFlush() const
+BOOL FileLogger::syncAfterWrite(const bool force)
 {
-    if (!m_fsyncOnFlush) return TRUE;
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return TRUE;
+    }
 
-    static std::chrono::steady_clock::time_point last_flush;
     const auto now = std::chrono::steady_clock::now();
+    bool sync = false;
+    switch (m_durability)
+    {
+        case DurabilityLevel::OsBuffered:
+            break;
+        case DurabilityLevel::PeriodicFsync:
+            sync = force || now - m_lastSync >= std::chrono::milliseconds(m_fsyncIntervalMs);
+            break;
+        case DurabilityLevel::PerBatchFsync:
+            sync = true;
+            break;
+    }
 
-    if (now - last_flush < std::chrono::seconds(1)) {
-        return TRUE;
+    if (!sync || !m_unsyncedWrites)
+    {
+        // A flush still waits for in-flight overlapped writes to reach the OS.
+        return force ? completeAsyncWrites() : TRUE;
     }
 
-    last_flush = now;
+    if (!completeAsyncWrites())
+    {
+        return FALSE;
+    }
+    m_lastSync = now;
+    m_unsyncedWrites = false;
     return FlushFileBuffers(m_fileHandle);
 }
 
+void FileLogger::closeFileHandle()
+{
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    if (m_writeMode == FileWriteMode::Overlapped)
+    {
+        // CloseHandle must not race an in-flight write into our buffers.
+        waitAsyncBuffer(m_async[0]);
+        waitAsyncBuffer(m_async[1]);
+        trimToLogicalSize();
+    }
+
+    std::lock_guard file_lk(m_file_mutex);
+    CloseHandle(m_fileHandle);
+    m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
 BOOL FileLogger::rotateFile()
 {
     if (m_fileHandle != INVALID_HANDLE_VALUE)
     {
-        if (m_fsyncOnFlush)
+        if (m_durability != DurabilityLevel::OsBuffered)
         {
+            completeAsyncWrites();
             FlushFileBuffers(m_fileHandle);
+            m_unsyncedWrites = false;
         }
-        CloseHandle(m_fileHandle);
-        m_fileHandle = INVALID_HANDLE_VALUE;
+        closeFileHandle();
     }
 
     SYSTEMTIME utc_time;
@@ -422,12 +765,13 @@ BOOL FileLogger::rotateFile()
     const std::wstring new_path = makeFilePath(m_logDirectoryW, new_name);
     BOOL success = FALSE;
 
-    success = MoveFileW(m_currentFilePathW.c_str(), new_path.c_str());
+    std::wstring rotated_path = new_path;
+    success = MoveFileW(m_currentFilePathW.c_str(), rotated_path.c_str());
 
     if (!success && GetLastError() == ERROR_ALREADY_EXISTS)
     {
-        const std::wstring unique_path = new_path + L".unique";
-        success = MoveFileW(m_currentFilePathW.c_str(), unique_path.c_str());
+        rotated_path = new_path + L".unique";
+        success = MoveFileW(m_currentFilePathW.c_str(), rotated_path.c_str());
 
     }
 
@@ -440,7 +784,15 @@ BOOL FileLogger::rotateFile()
         return openLogFile();
     }
 
-    cleanupOldFiles();
+    if (m_compressor)
+    {
+        // Packed off the writer thread; old files are trimmed once the packed one is complete.
+        m_compressor->enqueue(rotated_path, rotated_path + L"z", [this] { cleanupOldFiles(); });
+    }
+    else
+    {
+        cleanupOldFiles();
+    }
 
     m_currentFileBytes.store(0);
     return openLogFile();
@@ -503,41 +855,23 @@ ULONGLONG FileLogger::GetFileTimeValue(const std::wstring& path)
 
 void FileLogger::flush()
 {
-    std::atomic<bool> flush_in_progress{true}; {
-        std::lock_guard lk(m_mutex);
-        m_immediate_flush_requested = true;
+    std::unique_lock lk(m_mutex);
+    if (!m_running.load())
+    {
+        return;
     }
-    m_cv.notify_one(); {
-        std::mutex flush_mutex;
-        std::condition_variable flush_cv;
-        std::unique_lock lk(flush_mutex);
-        const bool completed = flush_cv.wait_for(lk, std::chrono::seconds(5), [this, &flush_in_progress]
-        {
-            std::lock_guard inner_lk(m_mutex);
-            return m_queue.empty() && m_buffer.empty() && !flush_in_progress.load();
-        });
 
-        if (!completed)
-        {
-            std::cerr << "FileLogger: flush timeout after 5 seconds\n";
-        }
-    }
+    const std::uint64_t ticket = ++m_flushRequested;
+    m_cv.notify_one();
 
-    if (m_fileHandle != INVALID_HANDLE_VALUE)
+    const bool completed = m_flushCv.wait_for(lk, std::chrono::seconds(5), [this, ticket]
     {
-        std::lock_guard file_lk(m_file_mutex);
-
-        BOOL flush_ok = TRUE;
-        if (m_fsyncOnFlush)
-        {
-            flush_ok = FlushFileBuffers(m_fileHandle);
-        }
+        return m_flushCompleted >= ticket || !m_running.load();
+    });
 
-        if (!flush_ok)
-        {
-            const DWORD error = GetLastError();
-            std::cerr << "FileLogger: flush failed, error=" << error << "\n";
-        }
+    if (!completed)
+    {
+        std::cerr << "FileLogger: flush timeout after 5 seconds\n";
     }
 }
 
@@ -550,10 +884,14 @@ void FileLogger::close()
     {
         return;
     }
+    m_flushCv.notify_all();
 
     if (m_worker.joinable())
     {
         m_worker.request_stop();
+        {
+            std::lock_guard lk(m_mutex);
+        }
         m_cv.notify_all();
 
         const auto timeout = std::chrono::seconds(10);
@@ -570,7 +908,7 @@ void FileLogger::close()
 
             std::this_thread::sleep_for(std::chrono::milliseconds(50)); {
                 std::lock_guard lk(m_mutex);
-                if (m_queue.empty())
+                if (m_buffer.empty())
                 {
                     if (m_worker.joinable())
                     {
@@ -584,13 +922,7 @@ void FileLogger::close()
 
     std::string final_data; {
         std::lock_guard lk(m_mutex);
-        for (std::string &line: m_queue)
-        {
-            final_data.append(line);
-        }
-        m_queue.clear();
-        final_data.append(m_buffer);
-        m_buffer.clear();
+        final_data.swap(m_buffer);
     }
 
     if (!final_data.empty())
@@ -598,18 +930,17 @@ void FileLogger::close()
         writeBufferToDisk(final_data);
     }
 
-    if (m_fileHandle != INVALID_HANDLE_VALUE)
-    {
-        std::lock_guard file_lk(m_file_mutex);
+    syncAfterWrite(true);
+    closeFileHandle();
+    releaseAsyncBuffers();
 
-        if (m_fsyncOnFlush)
-        {
-            FlushFileBuffers(m_fileHandle);
-        }
+    // Finishes the compression of files rotated before the close.
+    m_compressor.reset();
+}
 
-        CloseHandle(m_fileHandle);
-        m_fileHandle = INVALID_HANDLE_VALUE;
-    }
+FileWriteMode FileLogger::writeMode() const noexcept
+{
+    return m_writeMode;
 }
 
 ULONGLONG FileLogger::droppedCount() const
@@ -1,15 +1,17 @@
 #pragma once
 
 #include "Logger.h" // for LogRecord and ILogSink
+#include "BinaryLogFormat.h" // LogCompression, compressLogFile
 #include <windows.h> // WinAPI types and functions
 #include <string>
-#include <deque>
 #include <vector>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 
 /**
  * FileLogger
@@ -17,10 +19,32 @@
  * Implementation of ILogSink that writes NDJSON lines to a file on disk using WinAPI.
  *
  * Behavior summary:
- *  - consume(batch) enqueues NDJSON lines quickly (non-blocking unless internal queue full).
- *  - A dedicated writer thread flushes queued lines to disk periodically or when buffer threshold is reached.
- *  - Supports file rotation by size, optional FlushFileBuffers calls for durability,
- *    and graceful shutdown via flush().
+ *  - consume(batch) serializes the batch into one contiguous NDJSON buffer and appends it to
+ *    the pending bytes (non-blocking; the oldest pending lines are dropped past 10x the
+ *    flush threshold).
+ *  - A dedicated writer thread swaps the pending bytes out and writes them with a single
+ *    WriteFile, periodically or when the buffer threshold is reached.
+ *  - Supports file rotation by size, a configurable durability level, and graceful
+ *    shutdown via flush(). Rotated files can be compressed (compressRotated) on a
+ *    background thread, while the writer goes on with the new file; close() waits for
+ *    them. Read them back with readLogFileBytes or tools/binlog2ndjson.
+ *
+ * Write modes (FileWriteMode):
+ *  - Synchronous: buffered WriteFile on the writer thread.
+ *  - Overlapped: unbuffered overlapped writes from two sector-aligned buffers. The writer
+ *    fills one buffer while the other is in flight, so collecting the next batch overlaps
+ *    the disk write. The partial last sector is kept in memory and rewritten with the next
+ *    write; the padding is trimmed off the file's end whenever the writer goes idle,
+ *    flushes, syncs or rotates. Falls back to Synchronous if the volume refuses
+ *    unbuffered I/O.
+ *
+ * Durability (DurabilityLevel) decides when FlushFileBuffers runs:
+ *  - OsBuffered: never on its own; flush() only waits until the bytes reached the OS.
+ *  - PeriodicFsync: at most once per fsyncIntervalMs, and on flush().
+ *  - PerBatchFsync: after every write, and on flush().
+ *
+ * flush() uses group commit: callers that arrive while the writer is busy share the next
+ * write-and-sync pass instead of each forcing their own.
  *
  * Thread-safety:
  *  - consume(), flush(), and destructor are thread-safe.
@@ -32,11 +56,36 @@
  *  - rotateCount: number of rotated files to keep.
  *  - flushIntervalMs: maximum milliseconds between disk flushes.
  *  - flushThresholdBytes: flush when buffer reaches this many bytes.
- *  - fsyncOnFlush: if true call FlushFileBuffers after WriteFile.
+ *  - fsyncOnFlush: if true, PeriodicFsync with a one second interval; otherwise OsBuffered.
  */
 namespace core::logging
 {
 
+enum class DurabilityLevel
+{
+    OsBuffered,
+    PeriodicFsync,
+    PerBatchFsync
+};
+
+enum class FileWriteMode
+{
+    Synchronous,
+    Overlapped
+};
+
+struct FileLoggerOptions
+{
+    ULONGLONG maxFileBytes = 16ull * 1024 * 1024;
+    ULONGLONG rotateCount = 5;
+    ULONGLONG flushIntervalMs = 200;
+    ULONGLONG flushThresholdBytes = 64 * 1024;
+    DurabilityLevel durability = DurabilityLevel::OsBuffered;
+    ULONGLONG fsyncIntervalMs = 1000;       // PeriodicFsync only
+    FileWriteMode writeMode = FileWriteMode::Synchronous;
+    LogCompression compressRotated = LogCompression::None;  // rotated "x.log" becomes "x.logz"
+};
+
 class FileLogger final : public ILogSink
 {
 public:
@@ -48,6 +97,10 @@ public:
                ULONGLONG flushThresholdBytes,
                BOOL fsyncOnFlush);
 
+    FileLogger(std::wstring logDirectoryW,
+               std::wstring baseFileName,
+               FileLoggerOptions const& options);
+
     ~FileLogger() override;
 
     void consume(const std::vector<LogRecord>& batch) override;
@@ -58,14 +111,37 @@ public:
 
     ULONGLONG droppedCount() const;
 
+    // The mode actually in use (Overlapped may have fallen back to Synchronous).
+    FileWriteMode writeMode() const noexcept;
+
 private:
+    // One of the two sector-aligned buffers of the Overlapped mode.
+    struct AsyncBuffer
+    {
+        char* data = nullptr;
+        size_t used = 0;            // bytes written from data, padded to a sector on submit
+        OVERLAPPED overlapped{};
+        bool inFlight = false;
+    };
+
     void writerLoop(const std::stop_token &stoken);
 
     BOOL openLogFile();
 
     BOOL writeBufferToDisk(std::string const& buffer);
+    BOOL writeBufferSynchronous(std::string const& buffer);
+    BOOL writeBufferOverlapped(std::string const& buffer);
+
+    BOOL allocateAsyncBuffers();
+    void releaseAsyncBuffers();
+    BOOL loadExistingTail(HANDLE file, ULONGLONG fileSize);
+    BOOL submitAsyncBuffer();
+    BOOL completeAsyncWrites();
+    BOOL waitAsyncBuffer(AsyncBuffer& buffer);
+    BOOL trimToLogicalSize();
 
     BOOL rotateFile();
+    void closeFileHandle();
 
     BOOL ensureDirectoryExists() const;
 
@@ -75,7 +151,12 @@ private:
     static std::string toUtf8(std::wstring const& wstr);
 
     BOOL recoverFromWriteError(DWORD error);
-    BOOL conditionalFlush() const;
+
+    // Applies the durability level after a write; force makes any level but OsBuffered sync now.
+    BOOL syncAfterWrite(bool force);
+
+    // Drops whole lines from the front of m_buffer until at least bytes are freed. Caller holds m_mutex.
+    void dropOldestLines(std::size_t bytes);
 
     std::wstring m_logDirectoryW;
     std::wstring m_baseFileName;
@@ -83,24 +164,47 @@ private:
     ULONGLONG m_rotateCount;
     ULONGLONG m_flushIntervalMs;
     ULONGLONG m_flushThresholdBytes;
-    ULONGLONG m_currentQueueSize{0};
-    BOOL m_fsyncOnFlush;
+    DurabilityLevel m_durability;
+    ULONGLONG m_fsyncIntervalMs;
+    FileWriteMode m_writeMode;
+    LogCompression m_compressRotated;
 
     std::jthread m_worker;
     mutable std::mutex m_mutex;
     std::condition_variable m_cv;
-    std::deque<std::string> m_queue; 
-    std::string m_buffer; 
+    std::string m_buffer;           // pending NDJSON bytes, whole lines only; guarded by m_mutex
+    std::string m_batchBuffer;      // consume() scratch; consume is called by the Logger writer only
     HANDLE m_fileHandle{ INVALID_HANDLE_VALUE };
     std::atomic<ULONGLONG> m_dropped{ 0 };
     std::atomic<BOOL> m_running{ false };
     std::atomic<ULONGLONG> m_currentFileBytes{ 0 };
 
-    std::atomic<bool> m_immediate_flush_requested{false};
+    // Group commit: flush() takes a ticket; the writer completes every ticket issued before
+    // it swapped the pending bytes out. Guarded by m_mutex.
+    std::uint64_t m_flushRequested{ 0 };
+    std::uint64_t m_flushCompleted{ 0 };
+    std::condition_variable m_flushCv;
+
     std::mutex m_file_mutex;
 
     std::wstring m_currentFilePathW;
-    ULONGLONG m_rotationSerial{ 0 }; 
+    ULONGLONG m_rotationSerial{ 0 };
+
+    // Writer thread only.
+    std::chrono::steady_clock::time_point m_lastSync{};
+    bool m_unsyncedWrites = false;
+
+    // Overlapped mode, writer thread only.
+    static constexpr size_t kSectorAlign = 4096;    // a multiple of every common sector size
+    AsyncBuffer m_async[2];
+    int m_asyncCurrent = 0;         // buffer being filled
+    size_t m_asyncCapacity = 0;
+    ULONGLONG m_asyncOffset = 0;    // sector-aligned file offset of the current buffer's start
+    bool m_asyncTrimmed = true;     // file end matches m_currentFileBytes
+
+    // Set when compressRotated is not None. Last, so it finishes its jobs, which call
+    // cleanupOldFiles(), before the members they use are destroyed.
+    std::unique_ptr<RotatedFileCompressor> m_compressor;
 };
 
 } // namespace core::logging
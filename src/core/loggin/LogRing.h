@@ -0,0 +1,276 @@
+// LogRing.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace core::logging
+{
+
+/**
+ * LogRing - bounded lock-free queue of preallocated log record slots.
+ *
+ * Same slot-sequence scheme as BoundedMpmcQueue, but records are written into the slot in
+ * place instead of being moved in: the text fields are copied into a fixed inline buffer,
+ * and whatever does not fit goes to a per-slot spill string that keeps its capacity from
+ * lap to lap. After warm-up, pushing a record allocates nothing.
+ *
+ * Any thread may push. The logger's writer thread pops records; producers may also pop
+ * one to discard it (OverflowPolicy::DropOldest), so the consumer side is multi-consumer
+ * too.
+ *
+ * Capacity is rounded up to a power of two. All slots (256 bytes each) are allocated by the
+ * constructor; their inline buffers are left uninitialised, as they are only read back up
+ * to the lengths stored with them.
+ */
+class LogRing
+{
+public:
+    enum Field : std::uint8_t
+    {
+        Message,
+        Operation,
+        KeyPath,
+        ValueName,
+        Before,
+        After,
+        Source,
+        SnapshotId,
+        Metadata,
+        FormatArgs,         // packed arguments of a deferred message; Message is the format
+        kFieldCount
+    };
+
+    // A record as pushed, and as seen by tryConsume (views then point into the slot).
+    struct Entry
+    {
+        int level = 0;
+        std::chrono::system_clock::time_point time;
+        std::thread::id thread;
+        std::array<std::string_view, kFieldCount> fields{};
+        std::uint16_t presentMask = 0;      // bit per field; only SnapshotId/Metadata/FormatArgs may be absent
+
+        [[nodiscard]] bool has(const Field field) const noexcept
+        {
+            return (presentMask & (1u << field)) != 0;
+        }
+    };
+
+    static constexpr std::uint16_t kAllFields = (1u << kFieldCount) - 1;
+
+    explicit LogRing(std::size_t capacity)
+    {
+        std::size_t rounded = 2;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        m_mask = rounded - 1;
+        m_slots = std::make_unique_for_overwrite<Slot[]>(rounded);
+        for (std::size_t i = 0; i < rounded; ++i)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Returns false when the ring is full.
+    bool tryPush(const Entry& entry)
+    {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &m_slots[pos & m_mask];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->store(entry);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pops the oldest record and calls visit(const Entry&) on it before the slot is
+     * released; the entry's views are valid only during the call. Returns false when the
+     * ring is empty or the oldest slot is still being written.
+     */
+    template <typename Visitor>
+    bool tryConsume(Visitor&& visit)
+    {
+        std::size_t pos = 0;
+        Slot* slot = claimOldest(pos);
+        if (slot == nullptr)
+        {
+            return false;
+        }
+
+        Entry entry;
+        slot->load(entry);
+        visit(static_cast<const Entry&>(entry));
+        slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pops the oldest record without reading it.
+    bool tryDiscardOldest()
+    {
+        std::size_t pos = 0;
+        Slot* slot = claimOldest(pos);
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Records pushed (or being pushed) and not yet popped; approximate under concurrency.
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        const std::size_t tail = m_dequeuePos.load(std::memory_order_acquire);
+        const std::size_t head = m_enqueuePos.load(std::memory_order_acquire);
+        return head >= tail ? head - tail : 0;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+
+private:
+    // Sized so that a slot is 256 bytes on x64: four cache lines, none shared between slots.
+    static constexpr std::size_t kInlineBytes = 144;
+
+    struct alignas(64) Slot
+    {
+        std::atomic<std::size_t> sequence{ 0 };
+        std::chrono::system_clock::time_point time;
+        std::thread::id thread;
+        int level = 0;
+        std::uint16_t presentMask = 0;
+        std::uint16_t spilledMask = 0;      // fields stored in spill rather than inlineText
+        std::array<std::uint32_t, kFieldCount> lengths{};
+        std::string spill;
+        char inlineText[kInlineBytes];
+
+        void store(const Entry& entry)
+        {
+            time = entry.time;
+            thread = entry.thread;
+            level = entry.level;
+            presentMask = entry.presentMask;
+            spilledMask = 0;
+            spill.clear();
+
+            std::size_t used = 0;
+            for (std::uint8_t i = 0; i < kFieldCount; ++i)
+            {
+                const std::string_view text = entry.fields[i];
+                lengths[i] = static_cast<std::uint32_t>(text.size());
+                if (text.size() <= kInlineBytes - used)
+                {
+                    if (!text.empty())
+                    {
+                        std::memcpy(inlineText + used, text.data(), text.size());
+                    }
+                    used += text.size();
+                }
+                else
+                {
+                    spill.append(text);
+                    spilledMask = static_cast<std::uint16_t>(spilledMask | (1u << i));
+                }
+            }
+        }
+
+        void load(Entry& entry) const
+        {
+            entry.time = time;
+            entry.thread = thread;
+            entry.level = level;
+            entry.presentMask = presentMask;
+
+            std::size_t inlineOffset = 0;
+            std::size_t spillOffset = 0;
+            for (std::uint8_t i = 0; i < kFieldCount; ++i)
+            {
+                if ((spilledMask & (1u << i)) != 0)
+                {
+                    entry.fields[i] = std::string_view(spill.data() + spillOffset, lengths[i]);
+                    spillOffset += lengths[i];
+                }
+                else
+                {
+                    entry.fields[i] = std::string_view(inlineText + inlineOffset, lengths[i]);
+                    inlineOffset += lengths[i];
+                }
+            }
+        }
+    };
+
+    Slot* claimOldest(std::size_t& pos)
+    {
+        pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot* slot = &m_slots[pos & m_mask];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    return slot;
+                }
+            }
+            else if (diff < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask = 0;
+
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{ 0 };
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{ 0 };
+};
+
+} // namespace core::logging
@@ -1,173 +1,252 @@
 // Logger.cpp
 #include "Logger.h"
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
 #include <ctime>
+#include <deque>
+#include <future>
 #include <sstream>
 #include <iostream>
 #include <utility>
 
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define LOGGER_JSON_SSE2 1
+#endif
+
 namespace core::logging
 {
 
+namespace
+{
+
+inline bool needsJsonEscape(const unsigned char c) noexcept
+{
+    return c < 0x20 || c == '\\' || c == '\"';
+}
+
 /**
- * Escapes a string for safe inclusion in JSON by replacing control characters
- * and special characters with their JSON escape sequences.
- *
- * This function handles:
- * - Standard JSON escapes: quotation marks, backslashes, and common control characters
- * - Unicode escapes for other control characters (U+0000 to U+001F)
- * - Optimizes for the common case where no escaping is needed
- *
- * @param input The string view to be escaped
- * @return A properly escaped JSON string
+ * Returns the offset of the first byte at or after from that must be escaped
+ * (control characters, quotation mark, backslash), or input.size() if there is none.
+ * With SSE2 the common case - plain text - is scanned 16 bytes per step.
  */
-static std::string escapeJsonString(const std::string_view input)
+std::size_t findJsonEscape(const std::string_view input, std::size_t from) noexcept
 {
-    static constexpr unsigned char MAX_CONTROL_CHAR = 0x20;
-    static constexpr unsigned char HEX_DIGIT_MASK = 0x0F;
-    static constexpr size_t EXTRA_ESCAPE_CHARS = 5;
-    static constexpr size_t RESERVE_SAFETY_MARGIN = 16;
+#ifdef LOGGER_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i controlMax = _mm_set1_epi8(0x1F);
 
-    std::size_t escape_count = 0;
-    for (const unsigned char c: input)
+    for (; from + 16 <= input.size(); from += 16)
     {
-        if (c < MAX_CONTROL_CHAR || c == '\\' || c == '\"')
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + from));
+        // Unsigned c <= 0x1F  <=>  max(c, 0x1F) == 0x1F
+        const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, controlMax), controlMax);
+        const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(control, special));
+        if (mask != 0)
         {
-            escape_count++;
+#if defined(_MSC_VER)
+            unsigned long bit = 0;
+            _BitScanForward(&bit, static_cast<unsigned long>(mask));
+            return from + bit;
+#else
+            return from + static_cast<std::size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
         }
     }
+#endif
 
-    if (escape_count == 0)
+    for (; from < input.size(); ++from)
     {
-        return std::string(input);
+        if (needsJsonEscape(static_cast<unsigned char>(input[from])))
+        {
+            return from;
+        }
     }
+    return input.size();
+}
 
-    std::string result;
-    result.reserve(input.size() + escape_count * EXTRA_ESCAPE_CHARS + RESERVE_SAFETY_MARGIN);
+/**
+ * Appends input to out escaped for a JSON string: quotation marks, backslashes and
+ * control characters (U+0000 to U+001F) become escape sequences, runs of other bytes
+ * are appended as they are.
+ */
+void appendJsonEscaped(std::string& out, const std::string_view input)
+{
+    static constexpr unsigned char HEX_DIGIT_MASK = 0x0F;
 
-    for (const signed char c: input)
+    std::size_t start = 0;
+    while (start < input.size())
     {
+        const std::size_t pos = findJsonEscape(input, start);
+        out.append(input.data() + start, pos - start);
+        if (pos == input.size())
+        {
+            break;
+        }
+
+        const char c = input[pos];
         switch (c)
         {
-            case '\"': result += "\\\"";
+            case '\"': out += "\\\"";
                 break;
-            case '\\': result += "\\\\";
+            case '\\': out += "\\\\";
                 break;
-            case '\b': result += "\\b";
+            case '\b': out += "\\b";
                 break;
-            case '\f': result += "\\f";
+            case '\f': out += "\\f";
                 break;
-            case '\n': result += "\\n";
+            case '\n': out += "\\n";
                 break;
-            case '\r': result += "\\r";
+            case '\r': out += "\\r";
                 break;
-            case '\t': result += "\\t";
+            case '\t': out += "\\t";
                 break;
             default:
-                if (c < MAX_CONTROL_CHAR)
-                {
-                    constexpr char hexdigits[] = "0123456789abcdef";
-                    result += "\\u00";
-                    result += hexdigits[(c >> 4) & HEX_DIGIT_MASK];
-                    result += hexdigits[c & HEX_DIGIT_MASK];
-                }
-                else
-                {
-                    result += c;
-                }
+            {
+                constexpr char hexdigits[] = "0123456789abcdef";
+                const auto u = static_cast<unsigned char>(c);
+                const char escaped[] = { '\\', 'u', '0', '0', hexdigits[(u >> 4) & HEX_DIGIT_MASK], hexdigits[u & HEX_DIGIT_MASK] };
+                out.append(escaped, sizeof(escaped));
+            }
         }
+        start = pos + 1;
     }
+}
 
-    return result;
+// Appends `,"name":"value"` (name given with its leading comma and quotes).
+void appendStringField(std::string& out, const std::string_view prefix, const std::string_view value)
+{
+    out.append(prefix);
+    appendJsonEscaped(out, value);
+    out.push_back('\"');
 }
 
-// ---------------------- LogRecord::toNDJsonLine ----------------------
+template <typename Integer>
+void appendInteger(std::string& out, const Integer value)
+{
+    char digits[24];
+    const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+} // anonymous namespace
+
+// ---------------------- LogRecord serialization ----------------------
 /**
- * Converts a LogRecord to Newline Delimited JSON (NDJSON) format.
- *
- * NDJSON format has one JSON object per line, making it suitable for log files.
- * Only non-empty fields are included in the output.
+ * Appends the record to out as Newline Delimited JSON (NDJSON): one JSON object
+ * followed by a newline. Only non-empty fields are included in the output.
  *
- * @return A string containing the JSON representation of the log record followed by newline
+ * Nothing is allocated beyond growing out, so a buffer reused across batches settles
+ * at its high-water mark.
  */
-std::string LogRecord::toNDJsonLine() const
+void LogRecord::appendNDJsonLine(std::string& out) const
 {
-    std::ostringstream os;
-    os << "{";
+    appendStringField(out, R"({"@ts":")", timestamp);
 
-    os << R"("@ts":")" << escapeJsonString(timestamp) << "\"";
-    os << R"(,"lvl":")" << static_cast<int>(level) << "\"";
+    out.append(R"(,"lvl":")");
+    appendInteger(out, static_cast<int>(level));
+    out.push_back('\"');
 
     if (!message.empty())
     {
-        os << R"(,"msg":")" << escapeJsonString(message) << "\"";
+        appendStringField(out, R"(,"msg":")", message);
     }
     if (!operation.empty())
     {
-        os << R"(,"op":")" << escapeJsonString(operation) << "\"";
+        appendStringField(out, R"(,"op":")", operation);
     }
     if (!key_path.empty())
     {
-        os << R"(,"key":")" << escapeJsonString(key_path) << "\"";
+        appendStringField(out, R"(,"key":")", key_path);
     }
     if (!value_name.empty())
     {
-        os << R"(,"val":")" << escapeJsonString(value_name) << "\"";
+        appendStringField(out, R"(,"val":")", value_name);
     }
     if (!before.empty())
     {
-        os << R"(,"before":")" << escapeJsonString(before) << "\"";
+        appendStringField(out, R"(,"before":")", before);
     }
     if (!after.empty())
     {
-        os << R"(,"after":")" << escapeJsonString(after) << "\"";
+        appendStringField(out, R"(,"after":")", after);
     }
     if (snapshot_id.has_value())
     {
-        os << R"(,"snap":")" << escapeJsonString(snapshot_id.value()) << "\"";
+        appendStringField(out, R"(,"snap":")", snapshot_id.value());
     }
     if (metadata.has_value())
     {
-        os << R"(,"meta":")" << escapeJsonString(metadata.value()) << "\"";
+        appendStringField(out, R"(,"meta":")", metadata.value());
     }
     if (!source.empty())
     {
-        os << R"(,"src":")" << escapeJsonString(source) << "\"";
+        appendStringField(out, R"(,"src":")", source);
     }
 
-    os << ",\"pid\":" << pid;
-    os << R"(,"tid":")" << escapeJsonString(tid) << "\"";
+    out.append(R"(,"pid":)");
+    appendInteger(out, pid);
+    appendStringField(out, R"(,"tid":")", tid);
 
-    os << "}\n";
-    return os.str();
+    out.append("}\n");
+}
+
+std::string LogRecord::toNDJsonLine() const
+{
+    std::string line;
+    appendNDJsonLine(line);
+    return line;
 }
 
 // ---------------------- helpers ----------------------
-std::string Logger::currentIsoUtcTimestamp()
+void Logger::formatTimestamp(const std::chrono::system_clock::time_point time, std::string& out)
 {
-    using clock = std::chrono::system_clock;
-    const auto now = clock::now();
-    time_t secs = clock::to_time_t(now);
-    std::tm tm{};
+    using namespace std::chrono;
+    const auto sinceEpoch = duration_cast<milliseconds>(time.time_since_epoch());
+    std::int64_t second = duration_cast<seconds>(sinceEpoch).count();
+    int ms = static_cast<int>(sinceEpoch.count() - second * 1000);
+    if (ms < 0)
+    {
+        ms += 1000;
+        --second;
+    }
+
+    if (second != m_cachedSecond)
+    {
+        time_t secs = static_cast<time_t>(second);
+        std::tm tm{};
 
 #ifdef _WIN32
-    gmtime_s(&tm, &secs);
+        gmtime_s(&tm, &secs);
 #else
-    gmtime_r(&secs, &tm);
+        gmtime_r(&secs, &tm);
 #endif
 
-    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now.time_since_epoch()) % 1000;
-
-    char buffer[32];
-    std::snprintf(buffer, sizeof(buffer),
-                 "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
-                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
-                 tm.tm_hour, tm.tm_min, tm.tm_sec,
-                 static_cast<int>(ms.count()));
-
-    return {buffer};
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer),
+                     "%04d-%02d-%02dT%02d:%02d:%02d",
+                     tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                     tm.tm_hour, tm.tm_min, tm.tm_sec);
+        m_cachedSecondText = buffer;
+        m_cachedSecond = second;
+    }
+
+    const char millis[] = {
+        '.',
+        static_cast<char>('0' + ms / 100),
+        static_cast<char>('0' + ms / 10 % 10),
+        static_cast<char>('0' + ms % 10),
+        'Z'
+    };
+    out.assign(m_cachedSecondText);
+    out.append(millis, sizeof(millis));
 }
 
 std::string Logger::threadIdToString(std::thread::id id)
@@ -177,11 +256,200 @@ std::string Logger::threadIdToString(std::thread::id id)
     return os.str();
 }
 
+// ---------------------- sink channels ----------------------
+/**
+ * One sink's queue of shared batches and the thread that feeds them to consume().
+ * push() is called by the Logger writer only.
+ */
+class Logger::SinkChannel
+{
+public:
+    SinkChannel(std::shared_ptr<ILogSink> sink, SinkQueueOptions const& options)
+        : m_sink(std::move(sink))
+        , m_options(options)
+    {
+        m_options.maxQueuedBatches = std::max<std::size_t>(1, m_options.maxQueuedBatches);
+        m_worker = std::jthread([this](std::stop_token st)
+        {
+            run(std::move(st));
+        });
+    }
+
+    ~SinkChannel()
+    {
+        stop();
+    }
+
+    SinkChannel(const SinkChannel&) = delete;
+    SinkChannel& operator=(const SinkChannel&) = delete;
+
+    [[nodiscard]] const std::shared_ptr<ILogSink>& sink() const noexcept
+    {
+        return m_sink;
+    }
+
+    void push(LogBatch batch)
+    {
+        {
+            std::unique_lock lk(m_mutex);
+            if (m_stopping)
+            {
+                m_dropped += batch->size();
+                return;
+            }
+
+            if (m_queue.size() >= m_options.maxQueuedBatches)
+            {
+                switch (m_options.policy)
+                {
+                    case OverflowPolicy::Block:
+                        ++m_backpressureWaits;
+                        m_spaceCv.wait(lk, [this]
+                        {
+                            return m_queue.size() < m_options.maxQueuedBatches || m_stopping;
+                        });
+                        if (m_stopping)
+                        {
+                            m_dropped += batch->size();
+                            return;
+                        }
+                        break;
+
+                    case OverflowPolicy::DropNewest:
+                        m_dropped += batch->size();
+                        return;
+
+                    case OverflowPolicy::DropOldest:
+                        m_dropped += m_queue.front()->size();
+                        m_queue.pop_front();
+                        break;
+                }
+            }
+
+            m_queue.push_back(std::move(batch));
+            m_maxQueued = std::max(m_maxQueued, m_queue.size());
+        }
+        m_queueCv.notify_one();
+    }
+
+    // Returns once everything pushed so far was consumed.
+    void waitIdle()
+    {
+        std::unique_lock lk(m_mutex);
+        m_idleCv.wait(lk, [this]
+        {
+            return (m_queue.empty() && !m_consuming) || m_finished;
+        });
+    }
+
+    // Consumes what is queued, then joins the consumer. Idempotent.
+    void stop()
+    {
+        if (!m_worker.joinable())
+        {
+            return;
+        }
+        {
+            std::lock_guard lk(m_mutex);
+            m_stopping = true;
+        }
+        m_worker.request_stop();
+        m_queueCv.notify_all();
+        m_spaceCv.notify_all();
+        m_worker.join();
+    }
+
+    [[nodiscard]] SinkStats stats() const
+    {
+        std::lock_guard lk(m_mutex);
+        return SinkStats{
+            .sink = m_sink.get(),
+            .queued_batches = m_queue.size(),
+            .max_queued_batches = m_maxQueued,
+            .delivered_records = m_delivered,
+            .dropped_records = m_dropped,
+            .backpressure_waits = m_backpressureWaits
+        };
+    }
+
+private:
+    void run(const std::stop_token& stoken)
+    {
+        std::unique_lock lk(m_mutex);
+        while (true)
+        {
+            m_queueCv.wait(lk, [this, &stoken]
+            {
+                return !m_queue.empty() || stoken.stop_requested();
+            });
+            if (m_queue.empty())
+            {
+                break;
+            }
+
+            LogBatch batch = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_consuming = true;
+            lk.unlock();
+            m_spaceCv.notify_one();
+
+            try
+            {
+                m_sink->consume(*batch);
+            }
+            catch (const std::exception &ex)
+            {
+                std::cerr << "Logger sink exception: " << ex.what() << '\n';
+            }
+            catch (...)
+            {
+                std::cerr << "Logger sink unknown exception\n";
+            }
+
+            const std::size_t records = batch->size();
+            batch.reset();
+
+            lk.lock();
+            m_consuming = false;
+            m_delivered += records;
+            if (m_queue.empty())
+            {
+                m_idleCv.notify_all();
+            }
+        }
+
+        m_finished = true;
+        m_idleCv.notify_all();
+    }
+
+    std::shared_ptr<ILogSink> m_sink;
+    SinkQueueOptions m_options;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queueCv;      // consumer wake-up
+    std::condition_variable m_spaceCv;      // writer waiting under OverflowPolicy::Block
+    std::condition_variable m_idleCv;       // waitIdle()
+    std::deque<LogBatch> m_queue;
+    bool m_consuming = false;
+    bool m_stopping = false;
+    bool m_finished = false;
+
+    std::size_t m_maxQueued = 0;
+    std::size_t m_delivered = 0;
+    std::size_t m_dropped = 0;
+    std::size_t m_backpressureWaits = 0;
+
+    std::jthread m_worker;                  // last: joined before the members above go away
+};
+
 // ---------------------- Logger implementation ----------------------
 Logger::Logger(const std::size_t maxQueue, const LoggingProfile profile, const OverflowPolicy policy)
     : m_maxQueue(maxQueue)
     , m_profile(profile)
+    , m_minLevel(minLevelForProfile(profile))
     , m_policy(policy)
+    , m_ring(maxQueue)
+    , m_pid(::GetCurrentProcessId())
 {
 }
 
@@ -193,6 +461,13 @@ Logger::~Logger()
     }
     catch (...)
     {}
+
+    std::vector<std::shared_ptr<SinkChannel>> channels;
+    {
+        std::lock_guard lk(m_mutex);
+        channels.swap(m_sinks);
+    }
+    channels.clear();
 }
 
 void Logger::start()
@@ -225,6 +500,9 @@ void Logger::shutdown(bool flush)
     if (m_worker.joinable())
     {
         m_worker.request_stop();
+        {
+            std::lock_guard lk(m_mutex);
+        }
         m_cv.notify_all();
 
         if (m_worker.joinable())
@@ -242,6 +520,9 @@ void Logger::shutdown(bool flush)
         }
     }
 
+    // The writer handed its last batches to the sink queues; let the sinks catch up.
+    waitForSinkQueues();
+
     if (flush)
     {
         flushAllSinks();
@@ -249,6 +530,11 @@ void Logger::shutdown(bool flush)
 }
 
 void Logger::addSink(std::shared_ptr<ILogSink> sink)
+{
+    addSink(std::move(sink), SinkQueueOptions{ .policy = m_policy });
+}
+
+void Logger::addSink(std::shared_ptr<ILogSink> sink, SinkQueueOptions const& options)
 {
     if (!sink) {
         throw std::invalid_argument("Cannot add null sink");
@@ -256,9 +542,11 @@ void Logger::addSink(std::shared_ptr<ILogSink> sink)
 
     std::lock_guard lk(m_mutex);
 
-    const auto it = std::ranges::find(m_sinks, sink);
+    const auto it = std::ranges::find_if(m_sinks, [&sink](const std::shared_ptr<SinkChannel>& channel) {
+        return channel->sink() == sink;
+    });
     if (it == m_sinks.end()) {
-        m_sinks.push_back(std::move(sink));
+        m_sinks.push_back(std::make_shared<SinkChannel>(std::move(sink), options));
 
         m_cv.notify_one();
     }
@@ -269,249 +557,380 @@ void Logger::removeSink(const std::shared_ptr<ILogSink>& sink)
 {
     if (!sink) return;
 
-    std::unique_lock lk(m_mutex);
-
-    const auto it = std::ranges::find(m_sinks, sink);
-    if (it != m_sinks.end()) {
-        m_cv.wait(lk, [this] {
-            return active_batches.load(std::memory_order_acquire) == 0;
-        });
-
-        m_sinks.erase(it);
-    }
+    removeSinkIf([&sink](const std::shared_ptr<ILogSink>& candidate) {
+        return candidate == sink;
+    });
 }
 
 template<typename Predicate>
 void Logger::removeSinkIf(Predicate pred)
 {
-    std::unique_lock lk(m_mutex);
+    std::vector<std::shared_ptr<SinkChannel>> removed;
+    {
+        std::unique_lock lk(m_mutex);
 
-    m_cv.wait(lk, [this] {
-        return active_batches.load(std::memory_order_acquire) == 0;
-    });
+        m_drainedCv.wait(lk, [this] {
+            return active_batches.load(std::memory_order_acquire) == 0;
+        });
 
-    m_sinks.erase(std::remove_if(m_sinks.begin(), m_sinks.end(), pred), m_sinks.end());
+        const auto first = std::stable_partition(m_sinks.begin(), m_sinks.end(),
+            [&pred](const std::shared_ptr<SinkChannel>& channel) {
+                return !pred(channel->sink());
+            });
+        removed.assign(first, m_sinks.end());
+        m_sinks.erase(first, m_sinks.end());
+    }
+
+    // Outside the lock: the channels consume what is still queued before they stop.
+    for (const std::shared_ptr<SinkChannel>& channel : removed)
+    {
+        channel->stop();
+    }
 }
 
 void Logger::log(const LogLevel level,
-                 std::string message,
-                 std::string operation,
-                 std::string key_path,
-                 std::string value_name,
-                 std::string before,
-                 std::string after,
-                 std::string source,
-                 std::optional<std::string> snapshot_id,
-                 std::optional<std::string> metadata)
+                 const std::string_view message,
+                 const std::string_view operation,
+                 const std::string_view key_path,
+                 const std::string_view value_name,
+                 const std::string_view before,
+                 const std::string_view after,
+                 const std::string_view source,
+                 const std::optional<std::string_view> snapshot_id,
+                 const std::optional<std::string_view> metadata)
 {
     if (shouldSkipByProfile(level))
     {
         return;
     }
 
-    thread_local std::string cached_tid = threadIdToString(std::this_thread::get_id());
-    thread_local std::chrono::system_clock::time_point last_time_update;
-    thread_local std::string cached_timestamp;
-
-    const auto now = std::chrono::system_clock::now();
-    if (cached_timestamp.empty() ||
-        now - last_time_update > std::chrono::seconds(1))
-    {
-        cached_timestamp = currentIsoUtcTimestamp();
-        last_time_update = now;
-    }
-
-    LogRecord rec;
-    rec.timestamp = cached_timestamp;
-    rec.level = level;
-    rec.message = std::move(message);
-    rec.operation = std::move(operation);
-    rec.key_path = std::move(key_path);
-    rec.value_name = std::move(value_name);
-    rec.before = std::move(before);
-    rec.after = std::move(after);
-    rec.source = std::move(source);
-    rec.snapshot_id = std::move(snapshot_id);
-    rec.metadata = std::move(metadata);
-    rec.pid = ::GetCurrentProcessId();
-    rec.tid = cached_tid; {
-        std::unique_lock lk(m_mutex);
+    LogRing::Entry entry;
+    entry.level = static_cast<int>(level);
+    entry.time = std::chrono::system_clock::now();
+    entry.thread = std::this_thread::get_id();
+    entry.fields[LogRing::Message] = message;
+    entry.fields[LogRing::Operation] = operation;
+    entry.fields[LogRing::KeyPath] = key_path;
+    entry.fields[LogRing::ValueName] = value_name;
+    entry.fields[LogRing::Before] = before;
+    entry.fields[LogRing::After] = after;
+    entry.fields[LogRing::Source] = source;
+    entry.presentMask = LogRing::kAllFields & static_cast<std::uint16_t>(~(1u << LogRing::FormatArgs));
+    if (snapshot_id.has_value())
+    {
+        entry.fields[LogRing::SnapshotId] = *snapshot_id;
+    }
+    else
+    {
+        entry.presentMask &= static_cast<std::uint16_t>(~(1u << LogRing::SnapshotId));
+    }
+    if (metadata.has_value())
+    {
+        entry.fields[LogRing::Metadata] = *metadata;
+    }
+    else
+    {
+        entry.presentMask &= static_cast<std::uint16_t>(~(1u << LogRing::Metadata));
+    }
+
+    if (pushWithOverflowPolicy(entry))
+    {
+        wakeWriter();
+    }
+}
+
+bool Logger::shouldSkipByProfile(LogLevel level) const
+{
+    return !isEnabled(level);
+}
+
+int Logger::minLevelForProfile(const LoggingProfile profile) noexcept
+{
+    switch (profile)
+    {
+        case LoggingProfile::Weak:   return static_cast<int>(LogLevel::Error);
+        case LoggingProfile::Medium: return static_cast<int>(LogLevel::Info);
+        case LoggingProfile::Strong: return static_cast<int>(LogLevel::Trace);
+    }
+    return static_cast<int>(LogLevel::Trace);
+}
+
+std::string& Logger::deferredArgsBuffer()
+{
+    thread_local std::string buffer;
+    return buffer;
+}
+
+void Logger::logPacked(const LogLevel level,
+                       const std::string_view operation,
+                       const std::string_view key_path,
+                       const std::string_view format,
+                       const std::string_view packedArgs)
+{
+    LogRing::Entry entry;
+    entry.level = static_cast<int>(level);
+    entry.time = std::chrono::system_clock::now();
+    entry.thread = std::this_thread::get_id();
+    entry.fields[LogRing::Message] = format;
+    entry.fields[LogRing::Operation] = operation;
+    entry.fields[LogRing::KeyPath] = key_path;
+    entry.fields[LogRing::Source] = "ui";
+    entry.fields[LogRing::FormatArgs] = packedArgs;
+    entry.presentMask = LogRing::kAllFields &
+                        static_cast<std::uint16_t>(~((1u << LogRing::SnapshotId) | (1u << LogRing::Metadata)));
+
+    if (pushWithOverflowPolicy(entry))
+    {
+        wakeWriter();
+    }
+}
 
-        if (m_queue.size() >= m_maxQueue)
+bool Logger::pushWithOverflowPolicy(const LogRing::Entry& entry)
+{
+    // DropOldest evicts from the producer side. Eviction fails only while the oldest slot
+    // is still being written by another producer; after a few tries the new record is
+    // dropped instead, so log() never waits for another thread.
+    constexpr int kEvictAttempts = 4;
+    int evictAttempts = 0;
+
+    while (!m_ring.tryPush(entry))
+    {
+        switch (m_policy)
         {
-            handleOverflowPolicy(lk, rec);
-            return;
+            case OverflowPolicy::Block:
+                waitForRingSpace();
+                break;
+
+            case OverflowPolicy::DropNewest:
+                m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+
+            case OverflowPolicy::DropOldest:
+                if (m_ring.tryDiscardOldest())
+                {
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (++evictAttempts >= kEvictAttempts)
+                {
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
         }
+    }
+    return true;
+}
 
-        m_queue.emplace_back(std::move(rec));
-        m_atomicQueueSize.store(m_queue.size(), std::memory_order_relaxed);
+void Logger::waitForRingSpace()
+{
+    wakeWriter();
+
+    m_blockedProducers.fetch_add(1, std::memory_order_seq_cst);
+    const std::uint32_t epoch = m_drainEpoch.load(std::memory_order_seq_cst);
+    if (m_ring.size() >= m_ring.capacity())
+    {
+        m_drainEpoch.wait(epoch, std::memory_order_acquire);
     }
+    m_blockedProducers.fetch_sub(1, std::memory_order_relaxed);
+}
 
-    m_cv.notify_one();
+void Logger::wakeWriter()
+{
+    // Pairs with the fence in writerLoop: either the writer sees the new record before it
+    // parks, or this thread sees m_writerIdle and wakes it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_writerIdle.load(std::memory_order_relaxed))
+    {
+        {
+            std::lock_guard lk(m_mutex);
+        }
+        m_cv.notify_one();
+    }
 }
 
-bool Logger::shouldSkipByProfile(LogLevel level) const
+void Logger::toLogRecord(const LogRing::Entry& entry, LogRecord& rec)
+{
+    formatTimestamp(entry.time, rec.timestamp);
+    rec.level = static_cast<LogLevel>(entry.level);
+    if (entry.has(LogRing::FormatArgs))
+    {
+        rec.message.clear();
+        renderDeferredFormat(entry.fields[LogRing::Message], entry.fields[LogRing::FormatArgs], rec.message);
+    }
+    else
+    {
+        rec.message.assign(entry.fields[LogRing::Message]);
+    }
+    rec.operation.assign(entry.fields[LogRing::Operation]);
+    rec.key_path.assign(entry.fields[LogRing::KeyPath]);
+    rec.value_name.assign(entry.fields[LogRing::ValueName]);
+    rec.before.assign(entry.fields[LogRing::Before]);
+    rec.after.assign(entry.fields[LogRing::After]);
+    rec.source.assign(entry.fields[LogRing::Source]);
+    if (entry.has(LogRing::SnapshotId))
+    {
+        rec.snapshot_id.emplace(entry.fields[LogRing::SnapshotId]);
+    }
+    else
+    {
+        rec.snapshot_id.reset();
+    }
+    if (entry.has(LogRing::Metadata))
+    {
+        rec.metadata.emplace(entry.fields[LogRing::Metadata]);
+    }
+    else
+    {
+        rec.metadata.reset();
+    }
+    rec.pid = m_pid;
+
+    if (entry.thread != m_cachedThread || m_cachedThreadText.empty())
+    {
+        m_cachedThread = entry.thread;
+        m_cachedThreadText = threadIdToString(entry.thread);
+    }
+    rec.tid = m_cachedThreadText;
+}
+
+std::size_t Logger::drainRing(std::vector<LogRecord>& batch, const std::size_t maxCount)
 {
-    const int levelInt = static_cast<int>(level);
-    int minLevel = 0;
-    switch (m_profile)
+    batch.clear();
+    while (batch.size() < maxCount &&
+           m_ring.tryConsume([this, &batch](const LogRing::Entry& entry)
+           {
+               toLogRecord(entry, batch.emplace_back());
+           }))
     {
-        case LoggingProfile::Weak:   minLevel = static_cast<int>(LogLevel::Error);   break;
-        case LoggingProfile::Medium: minLevel = static_cast<int>(LogLevel::Info);    break;
-        case LoggingProfile::Strong: minLevel = static_cast<int>(LogLevel::Trace);   break;
     }
-    return levelInt < minLevel;
+    m_writtenCount.fetch_add(batch.size(), std::memory_order_relaxed);
+    return batch.size();
 }
 
-void Logger::handleOverflowPolicy(std::unique_lock<std::mutex>& lk, LogRecord& rec)
+void Logger::dispatchBatch(std::vector<LogRecord>& batch)
 {
-    switch (m_policy)
+    std::vector<std::shared_ptr<SinkChannel>> sinks_copy;
     {
-        case OverflowPolicy::Block:
-            m_cv.wait(lk, [this] { return m_queue.size() < m_maxQueue; });
-            m_queue.emplace_back(std::move(rec));
-            m_cv.notify_one();
-            break;
+        std::lock_guard lk(m_mutex);
+        sinks_copy = m_sinks;
+    }
 
-        case OverflowPolicy::DropNewest:
-            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
-            break;
+    const LogBatch shared = std::make_shared<const std::vector<LogRecord>>(std::move(batch));
+    batch.clear();
+    for (const std::shared_ptr<SinkChannel>& channel : sinks_copy)
+    {
+        channel->push(shared);
+    }
+}
 
-        case OverflowPolicy::DropOldest:
-            while (m_queue.size() >= m_maxQueue)
-            {
-                m_queue.pop_front();
-                m_droppedCount.fetch_add(1, std::memory_order_relaxed);
-            }
-            m_queue.emplace_back(std::move(rec));
-            m_cv.notify_one();
-            break;
+void Logger::notifyDrained()
+{
+    m_drainEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if (m_blockedProducers.load(std::memory_order_seq_cst) > 0)
+    {
+        m_drainEpoch.notify_all();
+    }
+
+    {
+        std::lock_guard lk(m_mutex);
     }
+    m_drainedCv.notify_all();
 }
 
 void Logger::writerLoop(std::stop_token stoken)
 {
     constexpr std::chrono::milliseconds kFlushInterval{200};
+    constexpr std::size_t kMaxBatch = 128;
+
+    std::vector<LogRecord> batch;
 
     while (!stoken.stop_requested())
     {
-        std::vector<LogRecord> batch;
-        std::vector<std::shared_ptr<ILogSink> > sinks_copy;
-
+        if (m_ring.empty())
         {
-            constexpr std::size_t kMaxBatch = 128;
-            std::unique_lock lk(m_mutex);
-
-            if (m_queue.empty())
+            m_writerIdle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
             {
+                std::unique_lock lk(m_mutex);
                 m_cv.wait_for(lk, kFlushInterval, [this, &stoken]()
                 {
-                    return !m_queue.empty() || stoken.stop_requested();
+                    return !m_ring.empty() || stoken.stop_requested();
                 });
             }
-
-            batch.reserve(std::min(kMaxBatch, m_queue.size()));
-            while (!m_queue.empty() && batch.size() < kMaxBatch)
-            {
-                batch.emplace_back(std::move(m_queue.front()));
-                m_queue.pop_front();
-            }
-            m_atomicQueueSize.store(m_queue.size(), std::memory_order_relaxed);
-            sinks_copy = m_sinks;
+            m_writerIdle.store(false, std::memory_order_relaxed);
         }
 
-        if (!batch.empty() && !sinks_copy.empty())
+        // Counted before draining, so flush() never sees an empty ring while records
+        // are in flight between the ring and the sinks.
+        active_batches.fetch_add(1, std::memory_order_acq_rel);
+        batch.reserve(kMaxBatch);
+        if (drainRing(batch, kMaxBatch) > 0)
         {
-            {
-                active_batches.fetch_add(1, std::memory_order_relaxed);
-            }
-            processBatchWithSinks(batch, sinks_copy);
-            {
-                active_batches.fetch_sub(1, std::memory_order_relaxed);
-                m_cv.notify_all();
-            }
+            dispatchBatch(batch);
         }
-
-        if (batch.empty())
+        else
         {
             std::this_thread::yield();
         }
+        active_batches.fetch_sub(1, std::memory_order_acq_rel);
+        notifyDrained();
     }
 
-    processRemainingRecords(stoken);
+    processRemainingRecords();
 }
 
-void Logger::processBatchWithSinks(const std::vector<LogRecord>& batch,
-                                   const std::vector<std::shared_ptr<ILogSink>>& sinks)
-{
-    for (const std::shared_ptr<ILogSink> &sink: sinks)
-    {
-        try
-        {
-            sink->consume(batch);
-        } catch (const std::exception &ex)
-        {
-            std::cerr << "Logger sink exception: " << ex.what() << '\n';
-        }
-        catch (...)
-        {
-            std::cerr << "Logger sink unknown exception\n";
-        }
-    }
-}
-
-void Logger::processRemainingRecords(const std::stop_token &stoken)
+void Logger::processRemainingRecords()
 {
     constexpr std::size_t kFinalBatchSize = 128;
     std::vector<LogRecord> final_batch;
-    final_batch.reserve(kFinalBatchSize);
 
-    while (!stoken.stop_requested())
+    active_batches.fetch_add(1, std::memory_order_acq_rel);
+    while (drainRing(final_batch, kFinalBatchSize) > 0)
     {
-        std::vector<std::shared_ptr<ILogSink> > sinks_copy;
-        {
-            std::lock_guard lk(m_mutex);
-            if (m_queue.empty()) break;
-
-            while (!m_queue.empty() && final_batch.size() < kFinalBatchSize)
-            {
-                final_batch.emplace_back(std::move(m_queue.front()));
-                m_queue.pop_front();
-            }
-            sinks_copy = m_sinks;
-        }
-
-        if (!final_batch.empty())
-        {
-            processBatchWithSinks(final_batch, sinks_copy);
-            final_batch.clear();
-        }
+        dispatchBatch(final_batch);
     }
+    active_batches.fetch_sub(1, std::memory_order_acq_rel);
+    notifyDrained();
 }
 
 void Logger::flush()
 {
     {
         std::unique_lock lk(m_mutex);
-        m_cv.wait(lk, [this] {
-            return m_queue.empty() && active_batches.load() == 0;
+        m_drainedCv.wait(lk, [this] {
+            return m_ring.empty() && active_batches.load() == 0;
         });
     }
 
+    waitForSinkQueues();
     flushAllSinks();
 }
 
+void Logger::waitForSinkQueues() const
+{
+    std::vector<std::shared_ptr<SinkChannel>> sinks_copy;
+    {
+        std::lock_guard lk(m_mutex);
+        sinks_copy = m_sinks;
+    }
+
+    for (const std::shared_ptr<SinkChannel>& channel : sinks_copy)
+    {
+        channel->waitIdle();
+    }
+}
+
 void Logger::flushAllSinks() const
 {
-    std::vector<std::shared_ptr<ILogSink>> sinks_copy;
+    std::vector<std::shared_ptr<SinkChannel>> sinks_copy;
     {
         std::lock_guard lk(m_mutex);
         sinks_copy = m_sinks;
     }
 
-    for (const std::shared_ptr<ILogSink>& sink : sinks_copy) {
+    for (const std::shared_ptr<SinkChannel>& channel : sinks_copy) {
         try {
-            sink->flush();
+            channel->sink()->flush();
         }
         catch (const std::exception& ex) {
             std::cerr << "Flush failed: " << ex.what() << '\n';
@@ -529,7 +948,7 @@ LoggingProfile Logger::profile() const noexcept
 
 std::size_t Logger::queueSize() const noexcept
 {
-    return m_atomicQueueSize.load(std::memory_order_relaxed);
+    return m_ring.size();
 }
 
 std::size_t Logger::droppedCount() const noexcept
@@ -537,14 +956,28 @@ std::size_t Logger::droppedCount() const noexcept
     return m_droppedCount.load(std::memory_order_relaxed);
 }
 
-LoggerStats Logger::getStats() const noexcept
+LoggerStats Logger::getStats() const
 {
-    return LoggerStats{
-        .queue_size = m_atomicQueueSize.load(std::memory_order_relaxed),
+    LoggerStats stats{
+        .queue_size = m_ring.size(),
+        .written_count = m_writtenCount.load(std::memory_order_relaxed),
         .dropped_count = m_droppedCount.load(std::memory_order_relaxed),
         .active_batches = active_batches.load(std::memory_order_relaxed),
-        .is_running = m_running.load(std::memory_order_relaxed)
+        .is_running = m_running.load(std::memory_order_relaxed),
+        .sinks = {}
     };
+
+    std::vector<std::shared_ptr<SinkChannel>> sinks_copy;
+    {
+        std::lock_guard lk(m_mutex);
+        sinks_copy = m_sinks;
+    }
+    stats.sinks.reserve(sinks_copy.size());
+    for (const std::shared_ptr<SinkChannel>& channel : sinks_copy)
+    {
+        stats.sinks.push_back(channel->stats());
+    }
+    return stats;
 }
 
 } // namespace core::logging
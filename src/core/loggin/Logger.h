@@ -4,28 +4,47 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
-#include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 #include "WinThreadPoolAdapter.h"
+#include "LogRing.h"
+#include "DeferredFormat.h"
 
 #define MAX_LOGGING_QUEUE_SIZE (64 * 1024)
+
+// Levels below this (0 = Trace ... 5 = Critical) are removed from the build by the LOG_* macros,
+// e.g. -DLOGGER_COMPILED_MIN_LEVEL=2 compiles out every LOG_TRACE and LOG_DEBUG call.
+#ifndef LOGGER_COMPILED_MIN_LEVEL
+#define LOGGER_COMPILED_MIN_LEVEL 0
+#endif
 /**
  * Core asynchronous logging subsystem.
  *
  * Design:
  *  - Produce structured LogRecord objects (serializable to NDJSON).
- *  - Logger accepts LogRecord via non-blocking enqueue; a background writer thread
- *    drains the queue and dispatches batches to registered sinks (ILogSink).
+ *  - Logger::log copies its fields into a preallocated slot of a lock-free ring (LogRing);
+ *    a background writer thread drains the ring, builds LogRecord batches and hands them
+ *    to registered sinks (ILogSink).
+ *  - Every sink has its own bounded queue of batches and its own consumer thread, so a
+ *    slow sink only delays itself. A batch is built once and shared by reference count
+ *    between the sink queues.
  *  - Sinks implement durable storage (FileLogger, EventLogSink, other).
  *
  * Important: Logger is designed to never block UI threads by default. The default
  * overflow policy is to drop oldest messages when the queue is full (keeping recent).
+ * Only OverflowPolicy::Block ever makes log() wait; the other policies take no lock.
+ *
+ * Front end for hot paths: the LOG_<LEVEL>(logger, message, ...) macros take the log()
+ * arguments, and LOG_<LEVEL>F(logger, operation, key_path, format, args...) the
+ * logFormatted() ones. A level below LOGGER_COMPILED_MIN_LEVEL compiles to nothing; otherwise
+ * the profile is checked before any argument is evaluated, so a disabled call costs one
+ * branch. logFormatted() renders its message on the writer thread (see DeferredFormat.h).
  */
 
 namespace core::logging
@@ -41,6 +60,13 @@ enum class LogLevel
     Critical
 };
 
+inline constexpr int kCompiledMinLevel = LOGGER_COMPILED_MIN_LEVEL;
+
+constexpr bool isLevelCompiledIn(const LogLevel level) noexcept
+{
+    return static_cast<int>(level) >= kCompiledMinLevel;
+}
+
 enum class LoggingProfile
 {
     Weak,
@@ -69,7 +95,8 @@ enum class OverflowPolicy
  *  - metadata: free-form JSON string (if available)
  *  - pid/tid: process and thread info (filled automatically)
  *
- * The LogRecord provides toNDJsonLine() to serialize as a single NDJSON line.
+ * The LogRecord provides toNDJsonLine() to serialize as a single NDJSON line, and
+ * appendNDJsonLine() to serialize into a caller-owned buffer without allocating.
  */
 struct LogRecord
 {
@@ -87,21 +114,48 @@ struct LogRecord
     ULONG pid = 0;
     std::string tid;
     [[nodiscard]] std::string toNDJsonLine() const;
+    void appendNDJsonLine(std::string& out) const;
+};
+
+/**
+ * SinkQueueOptions - per-sink queue between the Logger writer and the sink's consumer.
+ *
+ *  - maxQueuedBatches: batches (up to 128 records each) waiting for the sink.
+ *  - policy: what the writer does when the queue is full. Block makes the writer wait
+ *    (backpressure reaches log() through the ring); the drop policies discard batches.
+ */
+struct SinkQueueOptions
+{
+    std::size_t maxQueuedBatches = 64;
+    OverflowPolicy policy = OverflowPolicy::DropOldest;
+};
+
+struct SinkStats
+{
+    const void* sink;                   // identity of the ILogSink
+    std::size_t queued_batches;
+    std::size_t max_queued_batches;     // high-water mark
+    std::size_t delivered_records;
+    std::size_t dropped_records;
+    std::size_t backpressure_waits;     // times the writer waited for space (Block)
 };
 
 struct  LoggerStats
 {
     std::size_t queue_size;
+    std::size_t written_count;          // records taken from the ring and handed to the sinks
     std::size_t dropped_count;
     int active_batches;
     bool is_running;
+    std::vector<SinkStats> sinks;
 };
 
 /**
  * ILogSink - sink interface. Implement this for FileLogger, EventLogSink etc.
  *
  * Contract:
- *  - `consume` is called by the writer thread with a batch of LogRecord objects.
+ *  - `consume` is called by the sink's own consumer thread with a batch of LogRecord
+ *    objects, one batch at a time. The batch may be shared with other sinks.
  *  - Implementations must be exception-safe: throw nothing (the logger will catch).
  *  - flush() should block until all prior consume() calls are durable.
  */
@@ -129,10 +183,15 @@ public:
  *
  * Thread-safety:
  *  - log() and addSink()/removeSink() are thread-safe.
+ *  - log() copies the views it is given before returning.
+ *  - removeSink() returns after the sink consumed everything queued for it.
  */
 class Logger
 {
 public:
+    // maxQueue is the ring capacity in records, rounded up to a power of two. The ring is
+    // allocated up front at 256 bytes a slot, so the default of 64 K records commits 16 MB;
+    // pass a smaller bound where that matters.
     explicit Logger(std::size_t maxQueue = MAX_LOGGING_QUEUE_SIZE,
                     LoggingProfile profile = LoggingProfile::Medium,
                     OverflowPolicy policy = OverflowPolicy::DropOldest);
@@ -146,23 +205,43 @@ public:
 
     void shutdown(bool flush = true);
 
+    // The sink's queue uses the Logger's overflow policy.
     void addSink(std::shared_ptr<ILogSink> sink);
 
+    void addSink(std::shared_ptr<ILogSink> sink, SinkQueueOptions const& options);
+
     void removeSink(const std::shared_ptr<ILogSink> &sink);
 
     template<typename Predicate>
     void removeSinkIf(Predicate pred);
 
     void log(LogLevel level,
-        std::string message,
-        std::string operation = {},
-        std::string key_path = {},
-        std::string value_name = {},
-        std::string before = {},
-        std::string after = {},
-        std::string source = "ui",
-        std::optional<std::string> snapshot_id = std::nullopt,
-        std::optional<std::string> metadata = std::nullopt);
+        std::string_view message,
+        std::string_view operation = {},
+        std::string_view key_path = {},
+        std::string_view value_name = {},
+        std::string_view before = {},
+        std::string_view after = {},
+        std::string_view source = "ui",
+        std::optional<std::string_view> snapshot_id = std::nullopt,
+        std::optional<std::string_view> metadata = std::nullopt);
+
+    /**
+     * Deferred formatting: format and args (see DeferredFormat.h for the supported syntax and
+     * types) are copied as they are and the message is rendered on the writer thread.
+     */
+    template <typename... Args>
+    void logFormatted(LogLevel level,
+                      std::string_view operation,
+                      std::string_view key_path,
+                      std::string_view format,
+                      const Args&... args);
+
+    // True when the profile lets level through; what the LOG_* macros test first.
+    [[nodiscard]] bool isEnabled(const LogLevel level) const noexcept
+    {
+        return static_cast<int>(level) >= m_minLevel;
+    }
 
     void flush();
 
@@ -172,18 +251,39 @@ public:
 
     std::size_t droppedCount() const noexcept;
 
-    LoggerStats getStats() const noexcept;
+    LoggerStats getStats() const;
 
 private:
+    class SinkChannel;
+    using LogBatch = std::shared_ptr<const std::vector<LogRecord>>;
+
     void writerLoop(std::stop_token stoken);
 
     bool shouldSkipByProfile(LogLevel level) const;
-    void handleOverflowPolicy(std::unique_lock<std::mutex>& lk, LogRecord& rec);
+    static int minLevelForProfile(LoggingProfile profile) noexcept;
+    void logPacked(LogLevel level, std::string_view operation, std::string_view key_path,
+                   std::string_view format, std::string_view packedArgs);
+
+    // Producer-side scratch for logFormatted(): keeps its capacity per thread.
+    static std::string& deferredArgsBuffer();
+    bool pushWithOverflowPolicy(const LogRing::Entry& entry);
+    void waitForRingSpace();
+    void wakeWriter();
 
-    static void processBatchWithSinks(const std::vector<LogRecord>& batch, const std::vector<std::shared_ptr<ILogSink>>& sinks);
-    void processRemainingRecords(const std::stop_token &stoken);
+    // Moves up to maxCount records from the ring into batch (cleared first).
+    std::size_t drainRing(std::vector<LogRecord>& batch, std::size_t maxCount);
+    void toLogRecord(const LogRing::Entry& entry, LogRecord& rec);
+    // Shares the batch with every sink queue; batch is left empty.
+    void dispatchBatch(std::vector<LogRecord>& batch);
+    void notifyDrained();
 
-    static std::string currentIsoUtcTimestamp();
+    void processRemainingRecords();
+
+    // Waits until every sink consumed what was queued for it.
+    void waitForSinkQueues() const;
+
+    // ISO8601 UTC with milliseconds; the date/time part is cached per second.
+    void formatTimestamp(std::chrono::system_clock::time_point time, std::string& out);
 
     static std::string threadIdToString(std::thread::id id);
 
@@ -193,18 +293,91 @@ private:
 
     std::size_t m_maxQueue;
     LoggingProfile m_profile;
+    int m_minLevel;
     OverflowPolicy m_policy;
 
+    LogRing m_ring;
+
+    // m_mutex guards m_sinks and the two condition variables; producers never take it
+    // unless the writer is parked (m_writerIdle) and needs a wake-up.
     mutable std::mutex m_mutex;
-    std::condition_variable m_cv;
-    std::deque<LogRecord> m_queue;
-    std::vector<std::shared_ptr<ILogSink>> m_sinks;
+    std::condition_variable m_cv;           // writer wake-up
+    std::condition_variable m_drainedCv;    // flush()/removeSink() waiting for the writer
+    std::vector<std::shared_ptr<SinkChannel>> m_sinks;
     std::atomic<int> active_batches{0};
+    std::atomic<bool> m_writerIdle{ false };
+
+    // OverflowPolicy::Block: producers wait on m_drainEpoch, bumped by the writer per batch.
+    std::atomic<std::uint32_t> m_drainEpoch{ 0 };
+    std::atomic<int> m_blockedProducers{ 0 };
 
     std::jthread m_worker;
     std::atomic<bool> m_running{ false };
     std::atomic<std::size_t> m_droppedCount{ 0 };
-    std::atomic<std::size_t> m_atomicQueueSize{0};
+    std::atomic<std::size_t> m_writtenCount{ 0 };   // bumped per drained batch, not per log()
+
+    // Writer thread only: formatting caches for the records it builds.
+    std::int64_t m_cachedSecond = -1;
+    std::string m_cachedSecondText;         // "YYYY-MM-DDTHH:MM:SS"
+    std::thread::id m_cachedThread;
+    std::string m_cachedThreadText;
+    ULONG m_pid = 0;
 
 };
+
+template <typename... Args>
+void Logger::logFormatted(const LogLevel level,
+                          const std::string_view operation,
+                          const std::string_view key_path,
+                          const std::string_view format,
+                          const Args&... args)
+{
+    if (!isEnabled(level))
+    {
+        return;
+    }
+    std::string& packed = deferredArgsBuffer();
+    packed.clear();
+    packDeferredArgs(packed, args...);
+    logPacked(level, operation, key_path, format, packed);
+}
+
 } // namespace core::logging
+
+#define LOGGER_LOG_AT(logger, level, ...)                                             \
+    do                                                                                \
+    {                                                                                 \
+        if constexpr (::core::logging::isLevelCompiledIn(level))                      \
+        {                                                                             \
+            if ((logger).isEnabled(level))                                            \
+            {                                                                         \
+                (logger).log((level), __VA_ARGS__);                                   \
+            }                                                                         \
+        }                                                                             \
+    } while (false)
+
+#define LOGGER_LOGF_AT(logger, level, ...)                                            \
+    do                                                                                \
+    {                                                                                 \
+        if constexpr (::core::logging::isLevelCompiledIn(level))                      \
+        {                                                                             \
+            if ((logger).isEnabled(level))                                            \
+            {                                                                         \
+                (logger).logFormatted((level), __VA_ARGS__);                          \
+            }                                                                         \
+        }                                                                             \
+    } while (false)
+
+#define LOG_TRACE(logger, ...)    LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(logger, ...)    LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(logger, ...)     LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(logger, ...)     LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(logger, ...)    LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Error, __VA_ARGS__)
+#define LOG_CRITICAL(logger, ...) LOGGER_LOG_AT(logger, ::core::logging::LogLevel::Critical, __VA_ARGS__)
+
+#define LOG_TRACEF(logger, ...)    LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUGF(logger, ...)    LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFOF(logger, ...)     LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNF(logger, ...)     LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERRORF(logger, ...)    LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Error, __VA_ARGS__)
+#define LOG_CRITICALF(logger, ...) LOGGER_LOGF_AT(logger, ::core::logging::LogLevel::Critical, __VA_ARGS__)
@@ -0,0 +1,138 @@
+// LatencyHistogram.cpp
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace core::metrics
+{
+
+namespace {
+
+    constexpr std::uint64_t kSubBucketCount = std::uint64_t{1} << LatencyHistogram::kSubBucketBits;
+    constexpr std::uint64_t kSubBucketMask = kSubBucketCount - 1;
+    constexpr std::uint64_t kMaxTrackable = (std::uint64_t{1} << LatencyHistogram::kMaxValueBits) - 1;
+
+    // Upper bound of the bucket holding the sample of rank ceil(fraction * total).
+    std::uint64_t ValueAtFraction(const std::array<std::uint64_t, LatencyHistogram::kBucketCount>& counts,
+                                  const std::uint64_t total, const double fraction)
+    {
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        rank = std::clamp<std::uint64_t>(rank, 1, total);
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts.size(); ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return LatencyHistogram::BucketUpperBound(i);
+            }
+        }
+        return LatencyHistogram::BucketUpperBound(counts.size() - 1);
+    }
+
+} // anonymous namespace
+
+std::size_t LatencyHistogram::BucketIndex(std::uint64_t nanoseconds) noexcept
+{
+    nanoseconds = std::min(nanoseconds, kMaxTrackable);
+    if (nanoseconds < kSubBucketCount)
+    {
+        return static_cast<std::size_t>(nanoseconds);
+    }
+
+    // The top kSubBucketBits + 1 bits: the leading one selects the group, the rest the bucket in it.
+    const unsigned msb = static_cast<unsigned>(std::bit_width(nanoseconds)) - 1;
+    const unsigned shift = msb - kSubBucketBits;
+    const std::uint64_t group = shift + 1;
+    return static_cast<std::size_t>((group << kSubBucketBits) + ((nanoseconds >> shift) & kSubBucketMask));
+}
+
+std::uint64_t LatencyHistogram::BucketUpperBound(const std::size_t index) noexcept
+{
+    if (index < kSubBucketCount)
+    {
+        return index;
+    }
+
+    const unsigned shift = static_cast<unsigned>(index >> kSubBucketBits) - 1;
+    const std::uint64_t lower = (kSubBucketCount + (index & kSubBucketMask)) << shift;
+    return lower + (std::uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::Record(const std::uint64_t nanoseconds) noexcept
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    m_buckets[BucketIndex(nanoseconds)].fetch_add(1, relaxed);
+    m_sumNs.fetch_add(nanoseconds, relaxed);
+
+    std::uint64_t current = m_minNs.load(relaxed);
+    while (nanoseconds < current && !m_minNs.compare_exchange_weak(current, nanoseconds, relaxed))
+    {
+    }
+    current = m_maxNs.load(relaxed);
+    while (nanoseconds > current && !m_maxNs.compare_exchange_weak(current, nanoseconds, relaxed))
+    {
+    }
+}
+
+LatencySummary LatencyHistogram::Summary() const
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    std::array<std::uint64_t, kBucketCount> counts{};
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i)
+    {
+        counts[i] = m_buckets[i].load(relaxed);
+        total += counts[i];
+    }
+
+    LatencySummary summary;
+    if (total == 0)
+    {
+        return summary;
+    }
+
+    summary.count = total;
+    summary.minNs = m_minNs.load(relaxed);
+    summary.maxNs = std::max(m_maxNs.load(relaxed), summary.minNs);
+    summary.meanNs = static_cast<double>(m_sumNs.load(relaxed)) / static_cast<double>(total);
+
+    const auto percentile = [&](const double fraction) {
+        return std::clamp(ValueAtFraction(counts, total, fraction), summary.minNs, summary.maxNs);
+    };
+    summary.p50Ns = percentile(0.50);
+    summary.p90Ns = percentile(0.90);
+    summary.p99Ns = percentile(0.99);
+    summary.p999Ns = percentile(0.999);
+    return summary;
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (std::atomic<std::uint64_t>& bucket : m_buckets)
+    {
+        bucket.store(0, relaxed);
+    }
+    m_sumNs.store(0, relaxed);
+    m_minNs.store(UINT64_MAX, relaxed);
+    m_maxNs.store(0, relaxed);
+}
+
+void LatencyHistogram::CopyFrom(const LatencyHistogram& other) noexcept
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (std::size_t i = 0; i < kBucketCount; ++i)
+    {
+        m_buckets[i].store(other.m_buckets[i].load(relaxed), relaxed);
+    }
+    m_sumNs.store(other.m_sumNs.load(relaxed), relaxed);
+    m_minNs.store(other.m_minNs.load(relaxed), relaxed);
+    m_maxNs.store(other.m_maxNs.load(relaxed), relaxed);
+}
+
+} // namespace core::metrics
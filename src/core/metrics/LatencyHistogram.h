@@ -0,0 +1,92 @@
+// LatencyHistogram.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace core::metrics
+{
+
+/**
+ * LatencySummary - point-in-time view of a LatencyHistogram, all values in nanoseconds.
+ *
+ * count, minNs, maxNs and meanNs are exact. The percentiles are the upper bound of the
+ * bucket holding that rank (clamped to [minNs, maxNs]), so they overstate by at most one
+ * bucket width: about 3% of the value (see LatencyHistogram).
+ */
+struct LatencySummary
+{
+    std::uint64_t count = 0;
+    std::uint64_t minNs = 0;
+    std::uint64_t maxNs = 0;
+    double meanNs = 0;
+    std::uint64_t p50Ns = 0;
+    std::uint64_t p90Ns = 0;
+    std::uint64_t p99Ns = 0;
+    std::uint64_t p999Ns = 0;
+};
+
+/**
+ * LatencyHistogram - fixed-size, lock-free log-linear histogram of durations (HDR style).
+ *
+ * Values below 2^kSubBucketBits ns get one bucket each; above that every power of two is
+ * split into 2^kSubBucketBits equal buckets, so the relative resolution is 1/32 everywhere
+ * from 1 ns up to 2^kMaxValueBits ns (about 18 minutes). Longer values land in the top
+ * bucket; maxNs still reports them exactly.
+ *
+ * Record() is a relaxed fetch_add on the bucket and on the running sum plus a load of
+ * min and max (a CAS only when one of them moves); it never allocates or locks, so it
+ * can sit on hot paths. Summary() reads the buckets without stopping writers: a record
+ * that races with it may be counted in the buckets but not yet in the sum.
+ */
+class LatencyHistogram
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr unsigned kMaxValueBits = 40;
+    static constexpr std::size_t kBucketCount =
+        static_cast<std::size_t>(kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(std::uint64_t nanoseconds) noexcept;
+
+    void Record(const Clock::duration duration) noexcept
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        Record(ns > 0 ? static_cast<std::uint64_t>(ns) : 0);
+    }
+
+    void RecordSince(const Clock::time_point start) noexcept
+    {
+        Record(Clock::now() - start);
+    }
+
+    [[nodiscard]] LatencySummary Summary() const;
+
+    void Reset() noexcept;
+
+    // Relaxed copy of other's counters; used when the owner is moved.
+    void CopyFrom(const LatencyHistogram& other) noexcept;
+
+    [[nodiscard]] static std::size_t BucketIndex(std::uint64_t nanoseconds) noexcept;
+
+    // Largest value that falls into bucket index.
+    [[nodiscard]] static std::uint64_t BucketUpperBound(std::size_t index) noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> m_buckets{};
+    alignas(64) std::atomic<std::uint64_t> m_sumNs{0};
+    std::atomic<std::uint64_t> m_minNs{UINT64_MAX};
+    std::atomic<std::uint64_t> m_maxNs{0};
+};
+
+} // namespace core::metrics
@@ -0,0 +1,321 @@
+// RuntimeMetrics.cpp
+#include "RuntimeMetrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace core::metrics
+{
+
+using registry::RegistryFacade;
+
+namespace {
+
+    void AppendNumber(std::string& out, const char* name, const std::uint64_t value)
+    {
+        out += '"';
+        out += name;
+        out += "\":";
+        out += std::to_string(value);
+    }
+
+    void AppendNumber(std::string& out, const char* name, const double value)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        out += '"';
+        out += name;
+        out += "\":";
+        out += buffer;
+    }
+
+    void AppendLatency(std::string& out, const char* name, LatencySummary const& latency)
+    {
+        out += '"';
+        out += name;
+        out += "\":{";
+        AppendNumber(out, "count", latency.count);
+        out += ',';
+        AppendNumber(out, "min_ns", latency.minNs);
+        out += ',';
+        AppendNumber(out, "mean_ns", latency.meanNs);
+        out += ',';
+        AppendNumber(out, "p50_ns", latency.p50Ns);
+        out += ',';
+        AppendNumber(out, "p90_ns", latency.p90Ns);
+        out += ',';
+        AppendNumber(out, "p99_ns", latency.p99Ns);
+        out += ',';
+        AppendNumber(out, "p999_ns", latency.p999Ns);
+        out += ',';
+        AppendNumber(out, "max_ns", latency.maxNs);
+        out += '}';
+    }
+
+    void AppendRegistry(std::string& out, RegistryFacade::PerformanceStats const& stats)
+    {
+        out += "\"registry\":{";
+        AppendNumber(out, "cache_hits", std::uint64_t{stats.cacheHits});
+        out += ',';
+        AppendNumber(out, "cache_misses", std::uint64_t{stats.cacheMisses});
+        out += ',';
+        AppendNumber(out, "keys_opened", std::uint64_t{stats.keysOpened});
+        out += ',';
+        AppendNumber(out, "values_read", std::uint64_t{stats.valuesRead});
+        out += ',';
+        AppendNumber(out, "values_written", std::uint64_t{stats.valuesWritten});
+        out += ',';
+        AppendNumber(out, "total_operation_ns", static_cast<std::uint64_t>(stats.totalOperationTime.count()));
+
+        out += ",\"latency\":{";
+        for (size_t i = 0; i < RegistryFacade::kOperationKindCount; ++i)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            AppendLatency(out, RegistryFacade::OperationName(static_cast<RegistryFacade::OperationKind>(i)),
+                          stats.latency[i]);
+        }
+
+        // Hives never looked up are left out.
+        out += "},\"cache_by_hive\":{";
+        bool first = true;
+        for (size_t i = 0; i < RegistryFacade::kHiveCount; ++i)
+        {
+            RegistryFacade::HiveCacheStats const& hive = stats.cacheByHive[i];
+            if (hive.hits + hive.misses == 0)
+            {
+                continue;
+            }
+            if (!first)
+            {
+                out += ',';
+            }
+            first = false;
+            out += '"';
+            out += RegistryFacade::HiveName(static_cast<RegistryFacade::Hive>(i));
+            out += "\":{";
+            AppendNumber(out, "hits", std::uint64_t{hive.hits});
+            out += ',';
+            AppendNumber(out, "misses", std::uint64_t{hive.misses});
+            out += ',';
+            AppendNumber(out, "hit_ratio", hive.HitRatio());
+            out += '}';
+        }
+        out += "}}";
+    }
+
+    void AppendThreadPool(std::string& out, IThreadManager::Stats const& stats)
+    {
+        out += "\"thread_pool\":{";
+        AppendNumber(out, "queued_tasks", std::uint64_t{stats.queuedTasks});
+        out += ',';
+        AppendLatency(out, "wait", stats.waitTime);
+        out += '}';
+    }
+
+    void AppendLogger(std::string& out, logging::LoggerStats const& stats, LoggerRates const& rates)
+    {
+        out += "\"logger\":{";
+        AppendNumber(out, "queue_size", std::uint64_t{stats.queue_size});
+        out += ',';
+        AppendNumber(out, "written", std::uint64_t{stats.written_count});
+        out += ',';
+        AppendNumber(out, "dropped", std::uint64_t{stats.dropped_count});
+        out += ',';
+        AppendNumber(out, "written_per_sec", rates.writtenPerSecond);
+        out += ',';
+        AppendNumber(out, "dropped_per_sec", rates.droppedPerSecond);
+        out += ',';
+        AppendNumber(out, "drop_ratio", rates.dropRatio);
+        out += ",\"sinks\":[";
+        for (size_t i = 0; i < stats.sinks.size(); ++i)
+        {
+            logging::SinkStats const& sink = stats.sinks[i];
+            out += i > 0 ? ",{" : "{";
+            AppendNumber(out, "queued_batches", std::uint64_t{sink.queued_batches});
+            out += ',';
+            AppendNumber(out, "delivered", std::uint64_t{sink.delivered_records});
+            out += ',';
+            AppendNumber(out, "dropped", std::uint64_t{sink.dropped_records});
+            out += ',';
+            AppendNumber(out, "backpressure_waits", std::uint64_t{sink.backpressure_waits});
+            out += '}';
+        }
+        out += "]}";
+    }
+
+} // anonymous namespace
+
+LoggerRates ComputeLoggerRates(logging::LoggerStats const& current,
+                               logging::LoggerStats const* previous,
+                               const std::chrono::steady_clock::duration interval)
+{
+    std::size_t written = current.written_count;
+    std::size_t dropped = current.dropped_count;
+    if (previous != nullptr)
+    {
+        written -= std::min(written, previous->written_count);
+        dropped -= std::min(dropped, previous->dropped_count);
+    }
+
+    LoggerRates rates;
+    if (written + dropped > 0)
+    {
+        rates.dropRatio = static_cast<double>(dropped) / static_cast<double>(written + dropped);
+    }
+
+    const double seconds = std::chrono::duration<double>(interval).count();
+    if (previous != nullptr && seconds > 0)
+    {
+        rates.writtenPerSecond = static_cast<double>(written) / seconds;
+        rates.droppedPerSecond = static_cast<double>(dropped) / seconds;
+    }
+    return rates;
+}
+
+std::string ToJson(MetricsSnapshot const& current, MetricsSnapshot const* previous)
+{
+    std::string out;
+    out.reserve(2048);
+    out += '{';
+
+    const std::chrono::steady_clock::duration interval =
+        previous != nullptr ? current.taken - previous->taken : std::chrono::steady_clock::duration::zero();
+    if (previous != nullptr)
+    {
+        AppendNumber(out, "interval_ms", static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(interval).count()));
+    }
+
+    const auto separate = [&out] {
+        if (out.size() > 1)
+        {
+            out += ',';
+        }
+    };
+
+    if (current.registry)
+    {
+        separate();
+        AppendRegistry(out, *current.registry);
+    }
+    if (current.threadPool)
+    {
+        separate();
+        AppendThreadPool(out, *current.threadPool);
+    }
+    if (current.logger)
+    {
+        const logging::LoggerStats* before =
+            previous != nullptr && previous->logger ? &*previous->logger : nullptr;
+        separate();
+        AppendLogger(out, *current.logger, ComputeLoggerRates(*current.logger, before, interval));
+    }
+
+    out += '}';
+    return out;
+}
+
+struct RuntimeMetrics::DumpState
+{
+    std::mutex mutex;
+    bool active = true;
+    Sources sources;
+    logging::Logger* logger = nullptr;
+    std::optional<MetricsSnapshot> previous;
+};
+
+RuntimeMetrics::RuntimeMetrics(Sources sources)
+    : m_sources(sources)
+{
+}
+
+RuntimeMetrics::~RuntimeMetrics()
+{
+    StopPeriodicDump();
+}
+
+MetricsSnapshot RuntimeMetrics::Collect(Sources const& sources)
+{
+    MetricsSnapshot snapshot;
+    snapshot.taken = std::chrono::steady_clock::now();
+    if (sources.registry != nullptr)
+    {
+        snapshot.registry = sources.registry->GetStats();
+    }
+    if (sources.threadPool != nullptr)
+    {
+        snapshot.threadPool = sources.threadPool->stats();
+    }
+    if (sources.logger != nullptr)
+    {
+        snapshot.logger = sources.logger->getStats();
+    }
+    return snapshot;
+}
+
+MetricsSnapshot RuntimeMetrics::Snapshot() const
+{
+    return Collect(m_sources);
+}
+
+void RuntimeMetrics::StartPeriodicDump(IThreadManager& scheduler, logging::Logger& logger,
+                                       const std::chrono::milliseconds interval)
+{
+    if (interval.count() <= 0)
+    {
+        throw std::invalid_argument("metrics dump interval must be positive");
+    }
+
+    StopPeriodicDump();
+
+    auto state = std::make_shared<DumpState>();
+    state->sources = m_sources;
+    state->logger = &logger;
+
+    m_dumpId = scheduler.scheduleRecurring(IThreadManager::RecurringMode::FixedDelay, interval, [state]
+    {
+        std::lock_guard lock(state->mutex);
+        if (!state->active)
+        {
+            return;
+        }
+
+        MetricsSnapshot current = Collect(state->sources);
+        const std::string json = ToJson(current, state->previous ? &*state->previous : nullptr);
+        state->previous = std::move(current);
+        state->logger->log(logging::LogLevel::Info, "runtime metrics", "metrics",
+                           {}, {}, {}, {}, "ui", std::nullopt, json);
+    });
+    m_scheduler = &scheduler;
+    m_dump = std::move(state);
+}
+
+void RuntimeMetrics::StopPeriodicDump()
+{
+    if (!m_dump)
+    {
+        return;
+    }
+
+    m_scheduler->cancelRecurring(m_dumpId);
+    {
+        // Waits for a dump in progress; runs still queued see active == false.
+        std::lock_guard lock(m_dump->mutex);
+        m_dump->active = false;
+    }
+    m_dump.reset();
+    m_scheduler = nullptr;
+    m_dumpId = 0;
+}
+
+bool RuntimeMetrics::IsDumping() const noexcept
+{
+    return m_dump != nullptr;
+}
+
+} // namespace core::metrics
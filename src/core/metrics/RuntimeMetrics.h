@@ -0,0 +1,105 @@
+// RuntimeMetrics.h
+#pragma once
+
+#include "LatencyHistogram.h"
+#include "../registry/RegistryFacade.h"
+#include "../loggin/Logger.h"
+#include "IThreadManager.h"
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace core::metrics
+{
+
+/**
+ * MetricsSnapshot - the counters of every attached source at one moment.
+ *
+ * The counters are cumulative (since the source started or its last ResetStats()); rates
+ * are derived from two snapshots, see LoggerRates and ToJson().
+ */
+struct MetricsSnapshot
+{
+    std::chrono::steady_clock::time_point taken;
+    std::optional<registry::RegistryFacade::PerformanceStats> registry;
+    std::optional<IThreadManager::Stats> threadPool;
+    std::optional<logging::LoggerStats> logger;
+};
+
+/**
+ * LoggerRates - logger throughput between two snapshots. Without a previous snapshot the
+ * ratio is over the logger's lifetime and the per-second rates are zero.
+ *  - dropRatio: dropped / (written + dropped) records.
+ */
+struct LoggerRates
+{
+    double writtenPerSecond = 0;
+    double droppedPerSecond = 0;
+    double dropRatio = 0;
+};
+
+[[nodiscard]] LoggerRates ComputeLoggerRates(logging::LoggerStats const& current,
+                                             logging::LoggerStats const* previous,
+                                             std::chrono::steady_clock::duration interval);
+
+/**
+ * One-line JSON object: "registry" (counters, per-operation latency, cache hit ratio per
+ * hive), "thread_pool" (queue depth, task wait time) and "logger" (queue, drops, rates),
+ * each present only if the snapshot has it. Latencies are in nanoseconds. With previous,
+ * "interval_ms" and the logger rates cover the time between the two snapshots.
+ */
+[[nodiscard]] std::string ToJson(MetricsSnapshot const& current, MetricsSnapshot const* previous = nullptr);
+
+/**
+ * RuntimeMetrics - collects MetricsSnapshot from the facade, thread pool and logger, and
+ * can log one as NDJSON at a fixed interval.
+ *
+ * The sources are optional and non-owning. Snapshot() only reads their lock-free stats
+ * and may be called from any thread. StartPeriodicDump() logs ToJson() of a fresh snapshot
+ * (rates relative to the previous dump) as the metadata of an Info record with operation
+ * "metrics", on a FixedDelay recurring task of scheduler. The sources, logger and scheduler
+ * must outlive the dump: call StopPeriodicDump() (or destroy this object) first.
+ */
+class RuntimeMetrics
+{
+public:
+    struct Sources
+    {
+        registry::RegistryFacade const* registry = nullptr;
+        IThreadManager const* threadPool = nullptr;
+        logging::Logger const* logger = nullptr;
+    };
+
+    explicit RuntimeMetrics(Sources sources);
+
+    ~RuntimeMetrics();
+
+    RuntimeMetrics(const RuntimeMetrics&) = delete;
+    RuntimeMetrics& operator=(const RuntimeMetrics&) = delete;
+
+    [[nodiscard]] MetricsSnapshot Snapshot() const;
+
+    // Replaces a running dump. Throws std::invalid_argument for a zero interval.
+    void StartPeriodicDump(IThreadManager& scheduler, logging::Logger& logger, std::chrono::milliseconds interval);
+
+    // Returns once no dump is running and none will start.
+    void StopPeriodicDump();
+
+    [[nodiscard]] bool IsDumping() const noexcept;
+
+    [[nodiscard]] Sources const& GetSources() const noexcept { return m_sources; }
+
+private:
+    struct DumpState;
+
+    static MetricsSnapshot Collect(Sources const& sources);
+
+    Sources m_sources;
+    IThreadManager* m_scheduler = nullptr;
+    IThreadManager::RecurringId m_dumpId = 0;
+    // Shared with the recurring task, which may still be queued after cancelRecurring().
+    std::shared_ptr<DumpState> m_dump;
+};
+
+} // namespace core::metrics
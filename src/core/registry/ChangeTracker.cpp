@@ -0,0 +1,538 @@
+// ChangeTracker.cpp
+#include "ChangeTracker.h"
+#include "RegistryCache.h"
+#include "RegistryHelpers.h"
+#include "../loggin/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace core::registry
+{
+
+namespace {
+
+    constexpr REGSAM kViewMask = KEY_WOW64_32KEY | KEY_WOW64_64KEY;
+
+    std::wstring JoinPath(std::wstring const& base, std::wstring_view relative)
+    {
+        if (base.empty())
+        {
+            return std::wstring(relative);
+        }
+        if (relative.empty())
+        {
+            return base;
+        }
+        std::wstring path;
+        path.reserve(base.size() + 1 + relative.size());
+        path.append(base).append(1, L'\\').append(relative);
+        return path;
+    }
+
+    bool SameTime(FILETIME const& a, FILETIME const& b) noexcept
+    {
+        return a.dwLowDateTime == b.dwLowDateTime && a.dwHighDateTime == b.dwHighDateTime;
+    }
+
+    std::uint64_t ToTicks(FILETIME const& time) noexcept
+    {
+        return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    }
+
+    std::uint64_t HashData(const unsigned char* data, const size_t size) noexcept
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    FILETIME QueryLastWriteTime(RegistryKey const& key)
+    {
+        FILETIME lastWriteTime = {};
+        const LSTATUS status = RegQueryInfoKeyW(key.Handle(), nullptr, nullptr, nullptr, nullptr, nullptr,
+                                                nullptr, nullptr, nullptr, nullptr, nullptr, &lastWriteTime);
+        if (status != ERROR_SUCCESS)
+        {
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+        return lastWriteTime;
+    }
+
+    const char* TypeName(const DWORD type) noexcept
+    {
+        switch (type)
+        {
+            case REG_NONE: return "REG_NONE";
+            case REG_SZ: return "REG_SZ";
+            case REG_EXPAND_SZ: return "REG_EXPAND_SZ";
+            case REG_BINARY: return "REG_BINARY";
+            case REG_DWORD: return "REG_DWORD";
+            case REG_DWORD_BIG_ENDIAN: return "REG_DWORD_BIG_ENDIAN";
+            case REG_LINK: return "REG_LINK";
+            case REG_MULTI_SZ: return "REG_MULTI_SZ";
+            case REG_QWORD: return "REG_QWORD";
+            default: return nullptr;
+        }
+    }
+
+    std::string KeyJson(FILETIME const& lastWriteTime, const size_t subKeys, const size_t values)
+    {
+        std::string json = "{\"lastWriteTime\":";
+        json += std::to_string(ToTicks(lastWriteTime));
+        json += ",\"subKeys\":";
+        json += std::to_string(subKeys);
+        json += ",\"values\":";
+        json += std::to_string(values);
+        json += '}';
+        return json;
+    }
+
+    std::string UnreadableKeyJson(FILETIME const& lastWriteTime)
+    {
+        return "{\"lastWriteTime\":" + std::to_string(ToTicks(lastWriteTime)) + ",\"readable\":false}";
+    }
+
+    std::string ValueJson(const DWORD type, const std::uint32_t size, const std::uint64_t hash)
+    {
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+
+        std::string json = "{\"type\":";
+        if (const char* name = TypeName(type))
+        {
+            json.append(1, '"').append(name).append(1, '"');
+        }
+        else
+        {
+            json += std::to_string(type);
+        }
+        json += ",\"size\":";
+        json += std::to_string(size);
+        json += ",\"hash\":\"";
+        json += hex;
+        json += "\"}";
+        return json;
+    }
+
+    std::string ToUtf8(std::wstring_view text)
+    {
+        if (text.empty())
+        {
+            return {};
+        }
+        const int size = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                             nullptr, 0, nullptr, nullptr);
+        std::string out(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+        if (size > 0)
+        {
+            WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                out.data(), size, nullptr, nullptr);
+        }
+        return out;
+    }
+
+    const wchar_t* HiveName(HKEY root) noexcept
+    {
+        if (root == HKEY_CLASSES_ROOT) return L"HKEY_CLASSES_ROOT";
+        if (root == HKEY_CURRENT_USER) return L"HKEY_CURRENT_USER";
+        if (root == HKEY_LOCAL_MACHINE) return L"HKEY_LOCAL_MACHINE";
+        if (root == HKEY_USERS) return L"HKEY_USERS";
+        if (root == HKEY_CURRENT_CONFIG) return L"HKEY_CURRENT_CONFIG";
+        return L"HKEY_UNKNOWN";
+    }
+
+    const char* OperationName(const SnapshotChange change) noexcept
+    {
+        switch (change)
+        {
+            case SnapshotChange::KeyAdded: return "key_added";
+            case SnapshotChange::KeyRemoved: return "key_removed";
+            case SnapshotChange::ValueAdded: return "value_added";
+            case SnapshotChange::ValueRemoved: return "value_removed";
+            case SnapshotChange::ValueChanged: return "value_changed";
+        }
+        return "registry_change";
+    }
+
+    const char* ChangeMessage(const SnapshotChange change) noexcept
+    {
+        switch (change)
+        {
+            case SnapshotChange::KeyAdded: return "Registry key added";
+            case SnapshotChange::KeyRemoved: return "Registry key removed";
+            case SnapshotChange::ValueAdded: return "Registry value added";
+            case SnapshotChange::ValueRemoved: return "Registry value removed";
+            case SnapshotChange::ValueChanged: return "Registry value changed";
+        }
+        return "Registry change";
+    }
+
+} // anonymous namespace
+
+ChangeTracker::ChangeTracker(HKEY root, std::wstring subKeyPath, ChangeTrackerOptions options)
+    : m_root(root)
+    , m_subKeyPath(std::move(subKeyPath))
+    , m_sam(KEY_READ | (options.samView & kViewMask))
+{
+}
+
+ChangeScanResult ChangeTracker::Scan(std::stop_token stop)
+{
+    m_keys.clear();
+    return Walk(nullptr, stop);
+}
+
+ChangeScanResult ChangeTracker::Rescan(TrackedChangeVisitor const& visit, std::stop_token stop)
+{
+    return Walk(HasBaseline() ? &visit : nullptr, stop);
+}
+
+void ChangeTracker::Reset() noexcept
+{
+    m_keys.clear();
+}
+
+void ChangeTracker::EraseSubtree(std::wstring const& path)
+{
+    std::vector<std::wstring> pending;
+    pending.push_back(path);
+
+    while (!pending.empty())
+    {
+        const std::wstring current = std::move(pending.back());
+        pending.pop_back();
+
+        const auto it = m_keys.find(FoldRegistryName(current));
+        if (it == m_keys.end())
+        {
+            continue;
+        }
+        for (const std::wstring& child : it->second.children)
+        {
+            pending.push_back(JoinPath(current, child));
+        }
+        m_keys.erase(it);
+    }
+}
+
+ChangeScanResult ChangeTracker::Walk(TrackedChangeVisitor const* visit, std::stop_token const& stop)
+{
+    ChangeScanResult result;
+
+    struct Pending
+    {
+        std::wstring path;              // relative to the tracked key
+        FILETIME lastWriteTime = {};    // from the parent's enumeration
+        bool timeKnown = false;
+        Visit visit = Visit::Record;
+    };
+
+    std::vector<Pending> pending;
+    pending.push_back(Pending{std::wstring(), FILETIME{}, false, visit != nullptr ? Visit::Compare : Visit::Record});
+
+    // Changes of one key are applied only after the visitor accepted all of them, so a key
+    // whose report was cut short keeps its old state and is reported again next time.
+    std::vector<TrackedChange> changes;
+    std::vector<std::wstring> removedChildren;
+    std::vector<Pending> nextKeys;
+
+    while (!pending.empty())
+    {
+        if (stop.stop_requested())
+        {
+            result.cancelled = true;
+            break;
+        }
+
+        Pending item = std::move(pending.back());
+        pending.pop_back();
+        ++result.keysVisited;
+
+        const std::wstring folded = FoldRegistryName(item.path);
+        const auto found = m_keys.find(folded);
+        const KeyState* previous = found != m_keys.end() ? &found->second : nullptr;
+
+        Visit mode = item.visit;
+        if (mode == Visit::Compare && (previous == nullptr || !previous->readable))
+        {
+            mode = Visit::Record;   // nothing to compare against
+        }
+
+        const std::wstring fullPath = JoinPath(m_subKeyPath, item.path);
+        RegistryKey key;
+        SubKeyList children;
+        KeySnapshot values;
+        bool unchanged = false;
+        try
+        {
+            auto openKey = [&]
+            {
+                key = fullPath.empty() ? RegistryKey(m_root, false) : RegistryKey::Open(m_root, fullPath, m_sam);
+                ++result.keysOpened;
+            };
+
+            if (!item.timeKnown)
+            {
+                openKey();
+                item.lastWriteTime = QueryLastWriteTime(key);
+            }
+
+            unchanged = mode == Visit::Compare && SameTime(previous->lastWriteTime, item.lastWriteTime);
+            if (unchanged && previous->children.empty())
+            {
+                continue;   // unchanged leaf: not even opened
+            }
+
+            if (!key.IsValid())
+            {
+                openKey();
+            }
+            children = EnumerateSubKeyNames(key);
+            if (!unchanged)
+            {
+                values = ReadKeySnapshot(key);
+            }
+        }
+        catch (const RegException& ex)
+        {
+            if (item.path.empty())
+            {
+                throw;
+            }
+            // Deleted since its parent was enumerated: the parent's next rescan reports it.
+            if (ex.code() == ERROR_FILE_NOT_FOUND)
+            {
+                continue;
+            }
+
+            ++result.keysFailed;
+            if (result.firstError == ERROR_SUCCESS)
+            {
+                result.firstError = ex.code();
+            }
+            if (mode == Visit::Added && visit != nullptr)
+            {
+                TrackedChange change{SnapshotChange::KeyAdded, item.path, {}, {}, UnreadableKeyJson(item.lastWriteTime)};
+                ++result.changes;
+                if (!(*visit)(change))
+                {
+                    result.cancelled = true;
+                    break;
+                }
+            }
+            if (previous == nullptr)
+            {
+                KeyState state;
+                state.lastWriteTime = item.lastWriteTime;
+                state.readable = false;
+                m_keys.emplace(folded, std::move(state));
+            }
+            continue;
+        }
+
+        // Unchanged key: its values and children are as recorded; only the children's own
+        // times need checking, and the enumeration just returned them.
+        if (unchanged)
+        {
+            for (size_t c = 0; c < children.Size(); ++c)
+            {
+                pending.push_back(Pending{JoinPath(item.path, children.Name(c)), children.LastWriteTime(c),
+                                          true, Visit::Compare});
+            }
+            continue;
+        }
+
+        ++result.keysRead;
+
+        KeyState state;
+        state.lastWriteTime = values.LastWriteTime();
+
+        std::vector<std::pair<std::wstring, size_t>> valueOrder;
+        valueOrder.reserve(values.Size());
+        for (size_t v = 0; v < values.Size(); ++v)
+        {
+            valueOrder.emplace_back(FoldRegistryName(values.Value(v).name), v);
+        }
+        std::sort(valueOrder.begin(), valueOrder.end());
+
+        state.values.reserve(valueOrder.size());
+        for (const auto& [name, v] : valueOrder)
+        {
+            const RegValueView value = values.Value(v);
+            state.values.push_back(ValueState{std::wstring(value.name), value.type,
+                                              static_cast<std::uint32_t>(value.size),
+                                              HashData(value.data, value.size)});
+        }
+
+        std::vector<std::pair<std::wstring, size_t>> childOrder;
+        childOrder.reserve(children.Size());
+        for (size_t c = 0; c < children.Size(); ++c)
+        {
+            childOrder.emplace_back(FoldRegistryName(children.Name(c)), c);
+        }
+        std::sort(childOrder.begin(), childOrder.end());
+
+        state.children.reserve(childOrder.size());
+        for (const auto& [name, c] : childOrder)
+        {
+            state.children.emplace_back(children.Name(c));
+        }
+
+        changes.clear();
+        removedChildren.clear();
+        nextKeys.clear();
+
+        auto queueChild = [&](const size_t c, const Visit childVisit)
+        {
+            nextKeys.push_back(Pending{JoinPath(item.path, children.Name(c)), children.LastWriteTime(c),
+                                       true, childVisit});
+        };
+
+        if (mode == Visit::Added)
+        {
+            changes.push_back(TrackedChange{SnapshotChange::KeyAdded, item.path, {}, {},
+                                            KeyJson(state.lastWriteTime, state.children.size(), state.values.size())});
+        }
+
+        if (mode != Visit::Compare)
+        {
+            for (const auto& [name, c] : childOrder)
+            {
+                queueChild(c, Visit::Record);
+            }
+        }
+        else
+        {
+            // Both value lists are sorted by folded name: one merge pass.
+            size_t a = 0;
+            size_t b = 0;
+            std::wstring beforeName;
+            const std::vector<ValueState>& oldValues = previous->values;
+            while (a < oldValues.size() || b < state.values.size())
+            {
+                if (a < oldValues.size())
+                {
+                    beforeName = FoldRegistryName(oldValues[a].name);
+                }
+                const int order = a == oldValues.size() ? 1
+                                : b == state.values.size() ? -1
+                                : beforeName.compare(valueOrder[b].first);
+
+                if (order < 0)
+                {
+                    const ValueState& old = oldValues[a++];
+                    changes.push_back(TrackedChange{SnapshotChange::ValueRemoved, item.path, old.name,
+                                                    ValueJson(old.type, old.size, old.hash), {}});
+                }
+                else if (order > 0)
+                {
+                    const ValueState& now = state.values[b++];
+                    changes.push_back(TrackedChange{SnapshotChange::ValueAdded, item.path, now.name, {},
+                                                    ValueJson(now.type, now.size, now.hash)});
+                }
+                else
+                {
+                    const ValueState& old = oldValues[a++];
+                    const ValueState& now = state.values[b++];
+                    if (old.type != now.type || old.size != now.size || old.hash != now.hash)
+                    {
+                        changes.push_back(TrackedChange{SnapshotChange::ValueChanged, item.path, now.name,
+                                                        ValueJson(old.type, old.size, old.hash),
+                                                        ValueJson(now.type, now.size, now.hash)});
+                    }
+                }
+            }
+
+            a = 0;
+            b = 0;
+            const std::vector<std::wstring>& oldChildren = previous->children;
+            while (a < oldChildren.size() || b < childOrder.size())
+            {
+                if (a < oldChildren.size())
+                {
+                    beforeName = FoldRegistryName(oldChildren[a]);
+                }
+                const int order = a == oldChildren.size() ? 1
+                                : b == childOrder.size() ? -1
+                                : beforeName.compare(childOrder[b].first);
+
+                if (order < 0)
+                {
+                    std::wstring childPath = JoinPath(item.path, oldChildren[a++]);
+                    const auto old = m_keys.find(FoldRegistryName(childPath));
+                    std::string before;
+                    if (old != m_keys.end())
+                    {
+                        before = old->second.readable
+                            ? KeyJson(old->second.lastWriteTime, old->second.children.size(), old->second.values.size())
+                            : UnreadableKeyJson(old->second.lastWriteTime);
+                    }
+                    changes.push_back(TrackedChange{SnapshotChange::KeyRemoved, childPath, {}, std::move(before), {}});
+                    removedChildren.push_back(std::move(childPath));
+                }
+                else
+                {
+                    // Added children report themselves once they have been read.
+                    queueChild(childOrder[b++].second, order > 0 ? Visit::Added : Visit::Compare);
+                    if (order == 0)
+                    {
+                        ++a;
+                    }
+                }
+            }
+        }
+
+        bool accepted = true;
+        for (const TrackedChange& change : changes)
+        {
+            ++result.changes;
+            if (!(*visit)(change))
+            {
+                accepted = false;
+                break;
+            }
+        }
+        if (!accepted)
+        {
+            result.cancelled = true;
+            break;
+        }
+
+        for (const std::wstring& path : removedChildren)
+        {
+            EraseSubtree(path);
+        }
+        m_keys.insert_or_assign(folded, std::move(state));
+        for (Pending& next : nextKeys)
+        {
+            pending.push_back(std::move(next));
+        }
+    }
+
+    return result;
+}
+
+void ChangeTracker::LogChange(core::logging::Logger& logger, TrackedChange const& change) const
+{
+    std::wstring keyPath = HiveName(m_root);
+    const std::wstring relative = JoinPath(m_subKeyPath, change.path);
+    if (!relative.empty())
+    {
+        keyPath.append(1, L'\\').append(relative);
+    }
+
+    logger.log(core::logging::LogLevel::Info,
+               ChangeMessage(change.change),
+               OperationName(change.change),
+               ToUtf8(keyPath),
+               ToUtf8(change.valueName),
+               change.before,
+               change.after,
+               "external");
+}
+
+} // namespace core::registry
@@ -0,0 +1,134 @@
+// ChangeTracker.h
+#pragma once
+
+#include <windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RegistrySnapshot.h"   // SnapshotChange
+
+namespace core::logging
+{
+    class Logger;
+}
+
+namespace core::registry
+{
+
+// One change found by ChangeTracker::Rescan().
+struct TrackedChange
+{
+    SnapshotChange change = SnapshotChange::KeyAdded;
+    std::wstring path;          // key path relative to the tracked key
+    std::wstring valueName;     // value changes only
+
+    // JSON objects in the form LogRecord::before/after expect; empty on the side that does not
+    // exist (before of an addition, after of a removal). Keys:
+    //   {"lastWriteTime":<FILETIME ticks>,"subKeys":<n>,"values":<n>}
+    // values (data is not kept, only its FNV-1a hash):
+    //   {"type":"REG_SZ","size":<bytes>,"hash":"<16 hex digits>"}
+    std::string before;
+    std::string after;
+};
+
+// Return false to stop the rescan; the keys not visited yet keep their recorded state.
+using TrackedChangeVisitor = std::function<bool(TrackedChange const& change)>;
+
+struct ChangeTrackerOptions
+{
+    // Only KEY_WOW64_32KEY / KEY_WOW64_64KEY are used; they are applied to every open.
+    REGSAM samView = 0;
+};
+
+struct ChangeScanResult
+{
+    size_t keysVisited = 0;     // keys whose state was checked
+    size_t keysOpened = 0;
+    size_t keysRead = 0;        // keys whose values were read again (changed or new)
+    size_t keysFailed = 0;      // could not be opened or read; their recorded state is kept
+    size_t changes = 0;         // entries passed to the visitor
+    LSTATUS firstError = ERROR_SUCCESS;
+    bool cancelled = false;
+};
+
+/**
+ * ChangeTracker - finds what changed below root\subKeyPath since the previous scan without
+ * reading the whole subtree again.
+ *
+ * Per key it records the last-write time, the sorted child names and per value its type,
+ * size and a hash of the data. Writing a value, or creating or deleting a child, updates a
+ * key's last-write time, and RegEnumKeyExW returns every child's time with its name. A rescan
+ * therefore enumerates each key with children once and never opens an unchanged leaf key;
+ * values and child lists are only read again for keys whose time moved. Changes below a key
+ * do not move the key's own time, which is why unchanged parents are still enumerated.
+ *
+ * An added or removed key is reported once, not per descendant. Not thread-safe: one scan
+ * at a time.
+ */
+class ChangeTracker
+{
+public:
+    ChangeTracker(HKEY root, std::wstring subKeyPath, ChangeTrackerOptions options = ChangeTrackerOptions{});
+
+    // Records the current state as the baseline; nothing is reported. Throws RegException if
+    // the tracked key cannot be opened.
+    ChangeScanResult Scan(std::stop_token stop = {});
+
+    // Reports the changes since the last scan and records the new state. Without a baseline
+    // this is Scan(). Throws RegException if the tracked key cannot be opened.
+    ChangeScanResult Rescan(TrackedChangeVisitor const& visit, std::stop_token stop = {});
+
+    // Logs change with operation "key_added", "value_changed", ..., the full key path and the
+    // before/after JSON of the change.
+    void LogChange(core::logging::Logger& logger, TrackedChange const& change) const;
+
+    [[nodiscard]] HKEY Root() const noexcept { return m_root; }
+    [[nodiscard]] std::wstring const& SubKeyPath() const noexcept { return m_subKeyPath; }
+    [[nodiscard]] bool HasBaseline() const noexcept { return !m_keys.empty(); }
+    [[nodiscard]] size_t KeyCount() const noexcept { return m_keys.size(); }
+
+    void Reset() noexcept;
+
+private:
+    struct ValueState
+    {
+        std::wstring name;
+        DWORD type = REG_NONE;
+        std::uint32_t size = 0;
+        std::uint64_t hash = 0;
+    };
+
+    struct KeyState
+    {
+        FILETIME lastWriteTime = {};
+        bool readable = true;
+        std::vector<ValueState> values;         // sorted by folded name
+        std::vector<std::wstring> children;     // sorted by folded name
+    };
+
+    // How a queued key is handled.
+    enum class Visit
+    {
+        Compare,        // report changes against its recorded state
+        Added,          // new below a changed parent: report it once, record its subtree
+        Record          // record silently (baseline, or below an added key)
+    };
+
+    ChangeScanResult Walk(TrackedChangeVisitor const* visit, std::stop_token const& stop);
+
+    // Drops the recorded state of path and of everything below it.
+    void EraseSubtree(std::wstring const& path);
+
+    HKEY m_root;
+    std::wstring m_subKeyPath;
+    REGSAM m_sam;
+
+    // Recorded state by folded relative path ("" for the tracked key itself).
+    std::unordered_map<std::wstring, KeyState> m_keys;
+};
+
+} // namespace core::registry
@@ -0,0 +1,404 @@
+// RegistryCache.cpp
+#include "RegistryCache.h"
+#include <algorithm>
+
+namespace core::registry
+{
+
+std::wstring FoldRegistryName(const std::wstring_view name)
+{
+    std::wstring folded(name);
+
+    bool ascii = true;
+    for (wchar_t& c : folded)
+    {
+        if (c >= L'a' && c <= L'z')
+        {
+            c = static_cast<wchar_t>(c - (L'a' - L'A'));
+        }
+        else if (c > 0x7F)
+        {
+            ascii = false;
+            break;
+        }
+    }
+
+    if (ascii || folded.empty())
+    {
+        return folded;
+    }
+
+    folded.assign(name);
+    const int written = LCMapStringEx(LOCALE_NAME_INVARIANT,
+                                      LCMAP_UPPERCASE,
+                                      name.data(),
+                                      static_cast<int>(name.size()),
+                                      folded.data(),
+                                      static_cast<int>(folded.size()),
+                                      nullptr, nullptr, 0);
+    if (written <= 0)
+    {
+        // Fall back to the unfolded name; lookups stay correct, just case-sensitive.
+        folded.assign(name);
+    }
+    else
+    {
+        folded.resize(static_cast<std::size_t>(written));
+    }
+
+    return folded;
+}
+
+std::size_t RegistryCacheStore::ShardIndex(HKEY root, const std::wstring& foldedPath) noexcept
+{
+    std::size_t h = std::hash<std::wstring_view>{}(foldedPath);
+    h ^= std::hash<const void*>{}(root) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h % kShardCount;
+}
+
+std::size_t RegistryCacheStore::ShardLimit(const std::size_t maxEntries) noexcept
+{
+    return (maxEntries + kShardCount - 1) / kShardCount;
+}
+
+RegistryCacheStore::Clock::time_point RegistryCacheStore::ExpiryFor(const Clock::time_point now,
+                                                                    const Clock::duration ttl,
+                                                                    const WatchTicket& ticket) noexcept
+{
+    // Checked under the shard lock: the watcher clears the flag before it invalidates,
+    // so either this insert sees the cleared flag or the invalidation sees the entry.
+    if (ticket && ticket->load(std::memory_order_acquire))
+    {
+        return Clock::time_point::max();
+    }
+    return now + ttl;
+}
+
+RegistryCacheStore::Shard& RegistryCacheStore::ShardFor(const CacheKeyId& id) const noexcept
+{
+    return m_shards[ShardIndex(id.root, id.path)];
+}
+
+KeyLease RegistryCacheStore::FindKey(const CacheKeyId& id, const Clock::time_point now) const
+{
+    const Shard& shard = ShardFor(id);
+    std::shared_lock lock(shard.mutex);
+
+    const auto* entry = shard.keys.Probe(id, now);
+    return entry != nullptr ? entry->value : nullptr;
+}
+
+void RegistryCacheStore::InsertKey(CacheKeyId id, KeyLease key, const Clock::time_point now,
+                                   const Clock::duration ttl, const WatchTicket& ticket,
+                                   const std::size_t maxEntries)
+{
+    Shard& shard = ShardFor(id);
+    std::unique_lock lock(shard.mutex);
+
+    shard.keys.Insert(std::move(id), std::move(key), now, ExpiryFor(now, ttl, ticket));
+    EnforceShardLimit(shard, ShardLimit(maxEntries), now);
+}
+
+CachedValue::CachedValue(const DWORD type, const std::span<const unsigned char> data)
+    : CachedValue(type, data, nullptr)
+{
+}
+
+CachedValue::CachedValue(const DWORD type, const std::span<const unsigned char> data,
+                         std::shared_ptr<const void> arena)
+    : m_type(type)
+    , m_size(static_cast<std::uint32_t>(data.size()))
+{
+    if (data.size() <= kInlineSize)
+    {
+        std::copy(data.begin(), data.end(), m_inline.begin());
+    }
+    else if (arena == nullptr)
+    {
+        m_owned.assign(data.begin(), data.end());
+    }
+    else
+    {
+        m_arena = std::move(arena);
+        m_shared = data.data();
+    }
+}
+
+std::span<const unsigned char> CachedValue::Data() const noexcept
+{
+    if (m_size <= kInlineSize)
+    {
+        return {m_inline.data(), m_size};
+    }
+    return {m_arena != nullptr ? m_shared : m_owned.data(), m_size};
+}
+
+std::optional<CachedValue> RegistryCacheStore::FindValue(const CacheKeyId& id, const Clock::time_point now) const
+{
+    const Shard& shard = ShardFor(id);
+    std::shared_lock lock(shard.mutex);
+
+    const auto* entry = shard.values.Probe(id, now);
+    if (entry == nullptr)
+    {
+        return std::nullopt;
+    }
+    return entry->value;
+}
+
+void RegistryCacheStore::InsertValue(CacheKeyId id, CachedValue value, const Clock::time_point now,
+                                     const Clock::duration ttl, const WatchTicket& ticket,
+                                     const std::size_t maxEntries)
+{
+    Shard& shard = ShardFor(id);
+    std::unique_lock lock(shard.mutex);
+
+    shard.values.Insert(std::move(id), std::move(value), now, ExpiryFor(now, ttl, ticket));
+    EnforceShardLimit(shard, ShardLimit(maxEntries), now);
+}
+
+std::vector<std::optional<CachedValue>> RegistryCacheStore::FindValues(const std::vector<CacheKeyId>& ids,
+                                                                       const Clock::time_point now) const
+{
+    std::vector<std::optional<CachedValue>> found(ids.size());
+    if (ids.empty())
+    {
+        return found;
+    }
+
+    const Shard& shard = ShardFor(ids.front());
+    std::shared_lock lock(shard.mutex);
+
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        if (const auto* entry = shard.values.Probe(ids[i], now))
+        {
+            found[i] = entry->value;
+        }
+    }
+    return found;
+}
+
+void RegistryCacheStore::InsertValues(std::vector<std::pair<CacheKeyId, CachedValue>> values,
+                                      const Clock::time_point now, const Clock::duration ttl,
+                                      const WatchTicket& ticket, const std::size_t maxEntries)
+{
+    if (values.empty())
+    {
+        return;
+    }
+
+    Shard& shard = ShardFor(values.front().first);
+    std::unique_lock lock(shard.mutex);
+
+    const Clock::time_point expiry = ExpiryFor(now, ttl, ticket);
+    for (auto& [id, value] : values)
+    {
+        shard.values.Insert(std::move(id), std::move(value), now, expiry);
+    }
+    EnforceShardLimit(shard, ShardLimit(maxEntries), now);
+}
+
+SubKeyListing RegistryCacheStore::FindSubKeys(const CacheKeyId& id, const Clock::time_point now) const
+{
+    const Shard& shard = ShardFor(id);
+    std::shared_lock lock(shard.mutex);
+
+    const auto* entry = shard.lists.Probe(id, now);
+    return entry != nullptr ? entry->value : nullptr;
+}
+
+void RegistryCacheStore::InsertSubKeys(CacheKeyId id, SubKeyListing listing, const Clock::time_point now,
+                                       const Clock::duration ttl, const WatchTicket& ticket,
+                                       const std::size_t maxEntries)
+{
+    Shard& shard = ShardFor(id);
+    std::unique_lock lock(shard.mutex);
+
+    shard.lists.Insert(std::move(id), std::move(listing), now, ExpiryFor(now, ttl, ticket));
+    EnforceShardLimit(shard, ShardLimit(maxEntries), now);
+}
+
+void RegistryCacheStore::InvalidateKeys(HKEY root, const std::wstring& foldedPath)
+{
+    const auto matches = [&](const LruCache<KeyLease>::Entry& cached) {
+        return cached.id.root == root &&
+               (foldedPath.empty() || cached.id.path == foldedPath);
+    };
+
+    const auto listMatches = [&](const LruCache<SubKeyListing>::Entry& cached) {
+        return cached.id.root == root &&
+               (foldedPath.empty() || cached.id.path == foldedPath);
+    };
+
+    if (!foldedPath.empty())
+    {
+        Shard& shard = m_shards[ShardIndex(root, foldedPath)];
+        std::unique_lock lock(shard.mutex);
+        shard.keys.EraseIf(matches);
+        shard.lists.EraseIf(listMatches);
+        return;
+    }
+
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.keys.EraseIf(matches);
+        shard.lists.EraseIf(listMatches);
+    }
+}
+
+void RegistryCacheStore::InvalidateValues(HKEY root, const std::wstring& foldedPath, const std::wstring& foldedValueName)
+{
+    const auto matches = [&](const LruCache<CachedValue>::Entry& cached) {
+        const bool matchesRoot = cached.id.root == root;
+        const bool matchesPath = foldedPath.empty() || cached.id.path == foldedPath;
+        const bool matchesValue = foldedValueName.empty() || cached.id.valueName == foldedValueName;
+        return matchesRoot && matchesPath && matchesValue;
+    };
+
+    if (!foldedPath.empty())
+    {
+        Shard& shard = m_shards[ShardIndex(root, foldedPath)];
+        std::unique_lock lock(shard.mutex);
+        shard.values.EraseIf(matches);
+        return;
+    }
+
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.values.EraseIf(matches);
+    }
+}
+
+void RegistryCacheStore::InvalidatePath(HKEY root, const std::wstring& foldedPath, const bool subtree)
+{
+    if (!subtree)
+    {
+        Shard& shard = m_shards[ShardIndex(root, foldedPath)];
+        std::unique_lock lock(shard.mutex);
+        shard.keys.EraseIf([&](const LruCache<KeyLease>::Entry& cached) {
+            return cached.id.root == root && cached.id.path == foldedPath;
+        });
+        shard.values.EraseIf([&](const LruCache<CachedValue>::Entry& cached) {
+            return cached.id.root == root && cached.id.path == foldedPath;
+        });
+        shard.lists.EraseIf([&](const LruCache<SubKeyListing>::Entry& cached) {
+            return cached.id.root == root && cached.id.path == foldedPath;
+        });
+        return;
+    }
+
+    // Subkeys hash to arbitrary shards, so a subtree sweep visits all of them.
+    const auto underPath = [&](const CacheKeyId& id) {
+        if (id.root != root || id.path.compare(0, foldedPath.size(), foldedPath) != 0)
+        {
+            return false;
+        }
+        return foldedPath.empty() || id.path.size() == foldedPath.size() ||
+               id.path[foldedPath.size()] == L'\\';
+    };
+
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.keys.EraseIf([&](const LruCache<KeyLease>::Entry& cached) { return underPath(cached.id); });
+        shard.values.EraseIf([&](const LruCache<CachedValue>::Entry& cached) { return underPath(cached.id); });
+        shard.lists.EraseIf([&](const LruCache<SubKeyListing>::Entry& cached) { return underPath(cached.id); });
+    }
+}
+
+void RegistryCacheStore::Clear()
+{
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.keys.Clear();
+        shard.values.Clear();
+        shard.lists.Clear();
+    }
+}
+
+void RegistryCacheStore::ClearKeys()
+{
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.keys.Clear();
+        shard.lists.Clear();
+    }
+}
+
+void RegistryCacheStore::ClearValues()
+{
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.values.Clear();
+    }
+}
+
+void RegistryCacheStore::CleanupExpired(const Clock::time_point now)
+{
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.keys.EraseIf([&](const LruCache<KeyLease>::Entry& cached) {
+            return cached.expiryTime <= now;
+        });
+        shard.values.EraseIf([&](const LruCache<CachedValue>::Entry& cached) {
+            return cached.expiryTime <= now;
+        });
+        shard.lists.EraseIf([&](const LruCache<SubKeyListing>::Entry& cached) {
+            return cached.expiryTime <= now;
+        });
+    }
+}
+
+void RegistryCacheStore::EnforceLimit(const std::size_t maxEntries, const Clock::time_point now)
+{
+    const std::size_t limit = ShardLimit(maxEntries);
+    for (Shard& shard : m_shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        EnforceShardLimit(shard, limit, now);
+    }
+}
+
+void RegistryCacheStore::EnforceShardLimit(Shard& shard, const std::size_t limit, const Clock::time_point now)
+{
+    while (shard.Size() > limit)
+    {
+        // Evict from whichever cache holds the least recently used candidate.
+        const auto keysOldest = shard.keys.OldestAccess();
+        const auto valuesOldest = shard.values.OldestAccess();
+        const auto listsOldest = shard.lists.OldestAccess();
+
+        if (keysOldest <= valuesOldest && keysOldest <= listsOldest)
+        {
+            shard.keys.EvictOne(now);
+        }
+        else if (valuesOldest <= listsOldest)
+        {
+            shard.values.EvictOne(now);
+        }
+        else
+        {
+            shard.lists.EvictOne(now);
+        }
+    }
+}
+
+std::size_t RegistryCacheStore::Size() const
+{
+    std::size_t total = 0;
+    for (const Shard& shard : m_shards)
+    {
+        std::shared_lock lock(shard.mutex);
+        total += shard.Size();
+    }
+    return total;
+}
+
+} // namespace core::registry
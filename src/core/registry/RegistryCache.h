@@ -0,0 +1,360 @@
+// RegistryCache.h
+#pragma once
+
+#include <windows.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "RegistryHelpers.h"
+
+namespace core::registry
+{
+
+/**
+ * Registry key and value names are case-insensitive, so cache identities are
+ * built from an upper-cased copy of the path. ASCII is folded inline; anything
+ * else goes through LCMapStringEx with the invariant locale.
+ */
+std::wstring FoldRegistryName(std::wstring_view name);
+
+/**
+ * CacheKeyId - identity of a cached key handle or value.
+ *
+ * path and valueName are stored already folded (see FoldRegistryName).
+ * Key handle entries leave valueName empty.
+ */
+struct CacheKeyId
+{
+    HKEY root = nullptr;
+    std::wstring path;
+    std::wstring valueName;
+    REGSAM sam = 0;
+
+    bool operator==(const CacheKeyId& other) const noexcept
+    {
+        return root == other.root &&
+               sam == other.sam &&
+               path == other.path &&
+               valueName == other.valueName;
+    }
+};
+
+struct CacheKeyIdHash
+{
+    std::size_t operator()(const CacheKeyId& id) const noexcept
+    {
+        std::size_t h = std::hash<std::wstring_view>{}(id.path);
+        h ^= std::hash<std::wstring_view>{}(id.valueName) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h ^= std::hash<const void*>{}(id.root) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        h ^= std::hash<REGSAM>{}(id.sam) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+/**
+ * LruCache - hash-indexed cache with an approximate LRU list.
+ *
+ * Entries live in a std::list ordered by insertion/refresh recency; the
+ * unordered_map indexes list nodes by CacheKeyId. Insert and eviction are O(1),
+ * list nodes never move in memory, so index iterators stay valid.
+ *
+ * Probe() is const and safe to call concurrently under a shared lock: a hit
+ * only updates the entry's atomic access fields and sets its "referenced" bit.
+ * Eviction gives referenced tail entries a second chance (CLOCK-style) instead
+ * of reordering the list on every read, so readers never need exclusive access.
+ *
+ * Expiry is lazy: Probe() treats an expired entry as a miss, the following
+ * Insert() replaces it, and expired tail entries are reclaimed first.
+ *
+ * Writers (Insert/Erase/Evict) must be serialized by the owner.
+ */
+template <typename Value>
+class LruCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        Entry(CacheKeyId entryId, Value entryValue, const Clock::time_point now, const Clock::time_point expiry)
+            : id(std::move(entryId))
+            , value(std::move(entryValue))
+            , expiryTime(expiry)
+            , lastAccess(now.time_since_epoch().count())
+        {
+        }
+
+        CacheKeyId id;
+        Value value;
+        Clock::time_point expiryTime;
+        mutable std::atomic<Clock::rep> lastAccess;
+        mutable std::atomic<bool> referenced{ false };
+        mutable std::atomic<std::size_t> accessCount{ 1 };
+    };
+
+    // Returns the live entry for id or nullptr. Does not reorder the list.
+    const Entry* Probe(const CacheKeyId& id, const Clock::time_point now) const
+    {
+        const auto it = m_index.find(id);
+        if (it == m_index.end())
+        {
+            return nullptr;
+        }
+
+        const Entry& entry = *it->second;
+        if (entry.expiryTime <= now)
+        {
+            return nullptr;
+        }
+
+        entry.lastAccess.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+        entry.referenced.store(true, std::memory_order_relaxed);
+        entry.accessCount.fetch_add(1, std::memory_order_relaxed);
+        return &entry;
+    }
+
+    // Inserts or replaces the entry for id and makes it the most recent one.
+    void Insert(CacheKeyId id, Value value, const Clock::time_point now, const Clock::time_point expiryTime)
+    {
+        const auto it = m_index.find(id);
+        if (it != m_index.end())
+        {
+            Entry& entry = *it->second;
+            entry.value = std::move(value);
+            entry.expiryTime = expiryTime;
+            entry.lastAccess.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            entry.referenced.store(false, std::memory_order_relaxed);
+            entry.accessCount.store(1, std::memory_order_relaxed);
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return;
+        }
+
+        m_entries.emplace_front(std::move(id), std::move(value), now, expiryTime);
+        m_index.emplace(m_entries.front().id, m_entries.begin());
+    }
+
+    bool Erase(const CacheKeyId& id)
+    {
+        const auto it = m_index.find(id);
+        if (it == m_index.end())
+        {
+            return false;
+        }
+        m_entries.erase(it->second);
+        m_index.erase(it);
+        return true;
+    }
+
+    // Linear sweep; used for prefix/wildcard invalidation, never on the read path.
+    template <typename Predicate>
+    std::size_t EraseIf(Predicate pred)
+    {
+        std::size_t removed = 0;
+        for (auto it = m_entries.begin(); it != m_entries.end();)
+        {
+            if (pred(static_cast<const Entry&>(*it)))
+            {
+                m_index.erase(it->id);
+                it = m_entries.erase(it);
+                ++removed;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    // Last access of the eviction candidate; Clock::rep max when empty.
+    [[nodiscard]] Clock::rep OldestAccess() const noexcept
+    {
+        if (m_entries.empty())
+        {
+            return std::numeric_limits<Clock::rep>::max();
+        }
+        return m_entries.back().lastAccess.load(std::memory_order_relaxed);
+    }
+
+    // Evicts one entry. Referenced, unexpired tail entries get one second chance.
+    void EvictOne(const Clock::time_point now)
+    {
+        const std::size_t size = m_entries.size();
+        for (std::size_t scanned = 0; scanned < size; ++scanned)
+        {
+            Entry& tail = m_entries.back();
+            if (tail.expiryTime <= now || !tail.referenced.exchange(false, std::memory_order_relaxed))
+            {
+                break;
+            }
+            m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+        }
+
+        if (!m_entries.empty())
+        {
+            m_index.erase(m_entries.back().id);
+            m_entries.pop_back();
+        }
+    }
+
+    void Clear() noexcept
+    {
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    [[nodiscard]] std::size_t Size() const noexcept
+    {
+        return m_entries.size();
+    }
+
+private:
+    std::list<Entry> m_entries;
+    std::unordered_map<CacheKeyId, typename std::list<Entry>::iterator, CacheKeyIdHash> m_index;
+};
+
+using KeyLease = std::shared_ptr<const RegistryKey>;
+
+// Set while a change notification is armed on the key an entry was read from
+// (see RegistryWatcher). Empty when the key is not watched.
+using WatchTicket = std::shared_ptr<const std::atomic<bool>>;
+
+/**
+ * CachedValue - type and bytes of one cached value.
+ *
+ * Up to kInlineSize bytes (DWORD, QWORD, short strings) are stored in the value itself. Larger
+ * data is either copied into an owned buffer or, when the owner of the bytes is passed, left
+ * where it is: all values cached from one KeySnapshot then share its arena by reference count.
+ * Data() is 8-byte aligned if the shared bytes are.
+ */
+class CachedValue
+{
+public:
+    static constexpr std::size_t kInlineSize = 16;
+
+    CachedValue() = default;
+
+    // Copies data.
+    CachedValue(DWORD type, std::span<const unsigned char> data);
+
+    // Refers to data, which arena must keep alive; data that fits inline is copied instead.
+    CachedValue(DWORD type, std::span<const unsigned char> data, std::shared_ptr<const void> arena);
+
+    [[nodiscard]] DWORD Type() const noexcept { return m_type; }
+    [[nodiscard]] std::span<const unsigned char> Data() const noexcept;
+    [[nodiscard]] bool SharesArena() const noexcept { return m_arena != nullptr; }
+
+private:
+    DWORD m_type = 0;
+    std::uint32_t m_size = 0;
+    alignas(8) std::array<unsigned char, kInlineSize> m_inline = {};
+    std::vector<unsigned char> m_owned;
+    std::shared_ptr<const void> m_arena;
+    const unsigned char* m_shared = nullptr;
+};
+
+// Complete, immutable child listing of one key; shared between the cache and readers.
+using SubKeyListing = std::shared_ptr<const std::vector<SubKeyInfo>>;
+
+/**
+ * RegistryCacheStore - sharded key-handle, value and subkey-listing cache used by RegistryFacade.
+ *
+ * Entries are spread over a fixed number of shards by hash of (root, folded path),
+ * so a key's handle and all of its values live in the same shard and path-scoped
+ * invalidation touches a single shard. Each shard has its own std::shared_mutex:
+ * lookups take it shared, inserts/evictions/invalidation take it exclusive.
+ *
+ * The size limit is split evenly across shards.
+ *
+ * Inserts take a TTL and an optional WatchTicket. If the ticket is still armed
+ * when the shard lock is held, the entry never expires and is only dropped by
+ * InvalidatePath() or eviction; otherwise it expires after the TTL.
+ */
+class RegistryCacheStore
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kShardCount = 16;
+
+    RegistryCacheStore() = default;
+
+    RegistryCacheStore(const RegistryCacheStore&) = delete;
+    RegistryCacheStore& operator=(const RegistryCacheStore&) = delete;
+
+    KeyLease FindKey(const CacheKeyId& id, Clock::time_point now) const;
+    void InsertKey(CacheKeyId id, KeyLease key, Clock::time_point now,
+                   Clock::duration ttl, const WatchTicket& ticket, std::size_t maxEntries);
+
+    std::optional<CachedValue> FindValue(const CacheKeyId& id, Clock::time_point now) const;
+    void InsertValue(CacheKeyId id, CachedValue value, Clock::time_point now,
+                     Clock::duration ttl, const WatchTicket& ticket, std::size_t maxEntries);
+
+    // Batch forms for values of one key: every id must share root and path, so the whole
+    // batch is served under a single lock of that key's shard.
+    std::vector<std::optional<CachedValue>> FindValues(const std::vector<CacheKeyId>& ids, Clock::time_point now) const;
+    void InsertValues(std::vector<std::pair<CacheKeyId, CachedValue>> values, Clock::time_point now,
+                      Clock::duration ttl, const WatchTicket& ticket, std::size_t maxEntries);
+
+    SubKeyListing FindSubKeys(const CacheKeyId& id, Clock::time_point now) const;
+    void InsertSubKeys(CacheKeyId id, SubKeyListing listing, Clock::time_point now,
+                       Clock::duration ttl, const WatchTicket& ticket, std::size_t maxEntries);
+
+    // Empty foldedPath matches every path under root; empty foldedValueName matches every value.
+    // InvalidateKeys also drops the subkey listings of the matched keys.
+    void InvalidateKeys(HKEY root, const std::wstring& foldedPath);
+    void InvalidateValues(HKEY root, const std::wstring& foldedPath, const std::wstring& foldedValueName);
+
+    // Drops key handles and values of foldedPath; with subtree, also of every path below it.
+    void InvalidatePath(HKEY root, const std::wstring& foldedPath, bool subtree);
+
+    void Clear();
+    void ClearKeys();
+    void ClearValues();
+
+    void CleanupExpired(Clock::time_point now);
+    void EnforceLimit(std::size_t maxEntries, Clock::time_point now);
+
+    [[nodiscard]] std::size_t Size() const;
+
+private:
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        LruCache<KeyLease> keys;
+        LruCache<CachedValue> values;
+        LruCache<SubKeyListing> lists;
+
+        [[nodiscard]] std::size_t Size() const noexcept
+        {
+            return keys.Size() + values.Size() + lists.Size();
+        }
+    };
+
+    static std::size_t ShardIndex(HKEY root, const std::wstring& foldedPath) noexcept;
+    static std::size_t ShardLimit(std::size_t maxEntries) noexcept;
+    static void EnforceShardLimit(Shard& shard, std::size_t limit, Clock::time_point now);
+    static Clock::time_point ExpiryFor(Clock::time_point now, Clock::duration ttl, const WatchTicket& ticket) noexcept;
+
+    Shard& ShardFor(const CacheKeyId& id) const noexcept;
+
+    mutable std::array<Shard, kShardCount> m_shards;
+};
+
+} // namespace core::registry
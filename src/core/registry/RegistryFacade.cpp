@@ -5,14 +5,11 @@
 #include <sstream>
 #include <iomanip>
 #include <thread>
+#include <unordered_set>
 
 namespace core::registry
 {
 
-// Константы
-constexpr size_t MAX_CACHE_CLEANUP_ITERATIONS = 1000;
-constexpr auto DEFAULT_CLEANUP_INTERVAL = std::chrono::seconds(30);
-
 namespace {
 
     std::wstring SamToString(REGSAM sam) {
@@ -45,14 +42,39 @@ namespace {
 // Конструкторы и деструкторы
 RegistryFacade::RegistryFacade() noexcept
     : m_cacheConfig{}
+    , m_cache(std::make_unique<RegistryCacheStore>())
 {
 }
 
 RegistryFacade::RegistryFacade(CacheConfig cacheConfig) noexcept
     : m_cacheConfig(cacheConfig)
+    , m_cache(std::make_unique<RegistryCacheStore>())
+{
+}
+
+RegistryFacade::RegistryFacade(CacheConfig cacheConfig, WatchConfig watchConfig) noexcept
+    : m_cacheConfig(cacheConfig)
+    , m_cache(std::make_unique<RegistryCacheStore>())
+    , m_watchConfig(watchConfig)
+    , m_watcher(MakeWatcher(watchConfig, m_cache.get()))
 {
 }
 
+std::unique_ptr<RegistryWatcher> RegistryFacade::MakeWatcher(const WatchConfig& config, RegistryCacheStore* cache)
+{
+    if (!config.enabled || cache == nullptr) {
+        return nullptr;
+    }
+
+    // The store is heap-allocated and outlives the watcher, so the raw pointer
+    // stays valid across moves of the facade.
+    return std::make_unique<RegistryWatcher>(
+        config.notifyFilter, config.watchSubtree, config.maxWatches,
+        [cache](HKEY root, const std::wstring& foldedPath, const bool subtree) {
+            cache->InvalidatePath(root, foldedPath, subtree);
+        });
+}
+
 RegistryFacade::~RegistryFacade() noexcept
 {
     ClearCache();
@@ -60,34 +82,50 @@ RegistryFacade::~RegistryFacade() noexcept
 
 RegistryFacade::RegistryFacade(RegistryFacade&& other) noexcept
 {
-    std::lock_guard lock1(m_configMutex);
-    std::lock_guard lock2(m_cacheMutex);
-    std::lock_guard lock3(m_statsMutex);
+    std::lock_guard lock(other.m_configMutex);
 
     m_cacheConfig = other.m_cacheConfig;
-    m_keyCache = std::move(other.m_keyCache);
-    m_valueCache = std::move(other.m_valueCache);
-    m_stats = other.m_stats;
+    m_cache = std::move(other.m_cache);
+    m_watchConfig = other.m_watchConfig;
+    m_watcher = std::move(other.m_watcher);
+    MoveStats(other);
 }
 
 RegistryFacade& RegistryFacade::operator=(RegistryFacade&& other) noexcept
 {
     if (this != &other) {
-        std::lock(m_configMutex, m_cacheMutex, m_statsMutex);
-        std::lock_guard lock1(m_configMutex, std::adopt_lock);
-        std::lock_guard lock2(m_cacheMutex, std::adopt_lock);
-        std::lock_guard lock3(m_statsMutex, std::adopt_lock);
+        std::scoped_lock lock(m_configMutex, other.m_configMutex);
 
         ClearCache();
+        m_watcher.reset();
 
         m_cacheConfig = other.m_cacheConfig;
-        m_keyCache = std::move(other.m_keyCache);
-        m_valueCache = std::move(other.m_valueCache);
-        m_stats = other.m_stats;
+        m_cache = std::move(other.m_cache);
+        m_watchConfig = other.m_watchConfig;
+        m_watcher = std::move(other.m_watcher);
+        MoveStats(other);
     }
     return *this;
 }
 
+void RegistryFacade::MoveStats(const RegistryFacade& other) noexcept
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (size_t i = 0; i < kHiveCount; ++i)
+    {
+        m_stats.cacheByHive[i].hits.store(other.m_stats.cacheByHive[i].hits.load(relaxed), relaxed);
+        m_stats.cacheByHive[i].misses.store(other.m_stats.cacheByHive[i].misses.load(relaxed), relaxed);
+    }
+    m_stats.keysOpened.store(other.m_stats.keysOpened.load(relaxed), relaxed);
+    m_stats.valuesRead.store(other.m_stats.valuesRead.load(relaxed), relaxed);
+    m_stats.valuesWritten.store(other.m_stats.valuesWritten.load(relaxed), relaxed);
+    m_stats.totalOperationTimeNs.store(other.m_stats.totalOperationTimeNs.load(relaxed), relaxed);
+    for (size_t i = 0; i < kOperationKindCount; ++i)
+    {
+        m_stats.latency[i].CopyFrom(other.m_stats.latency[i]);
+    }
+}
+
 void RegistryFacade::ValidateRootKey(HKEY root)
 {
     static const HKEY validRoots[] = {
@@ -129,27 +167,31 @@ void RegistryFacade::ValidateSamDesired(REGSAM sam, bool forWrite)
 
 void RegistryFacade::ClearCache() const
 {
-    std::lock_guard lock(m_cacheMutex);
-    m_keyCache.clear();
-    m_valueCache.clear();
+    if (m_watcher) {
+        m_watcher->DisarmAll();
+    }
+    if (m_cache) {
+        m_cache->Clear();
+    }
 }
 
 void RegistryFacade::ClearKeyCache() const
 {
-    std::lock_guard lock(m_cacheMutex);
-    m_keyCache.clear();
+    if (m_cache) {
+        m_cache->ClearKeys();
+    }
 }
 
 void RegistryFacade::ClearValueCache() const
 {
-    std::lock_guard lock(m_cacheMutex);
-    m_valueCache.clear();
+    if (m_cache) {
+        m_cache->ClearValues();
+    }
 }
 
 size_t RegistryFacade::GetCacheSize() const
 {
-    std::lock_guard lock(m_cacheMutex);
-    return m_keyCache.size() + m_valueCache.size();
+    return m_cache ? m_cache->Size() : 0;
 }
 
 RegistryFacade::CacheConfig RegistryFacade::GetCacheConfig() const
@@ -164,272 +206,341 @@ void RegistryFacade::SetCacheConfig(CacheConfig config)
     m_cacheConfig = config;
 
     // Применяем новые ограничения размера
-    std::lock_guard cacheLock(m_cacheMutex);
-    EnforceCacheSizeLimits();
+    if (m_cache) {
+        CleanupExpiredCache();
+        m_cache->EnforceLimit(m_cacheConfig.maxCacheSize, std::chrono::steady_clock::now());
+    }
+}
+
+RegistryFacade::WatchConfig RegistryFacade::GetWatchConfig() const
+{
+    std::lock_guard lock(m_configMutex);
+    return m_watchConfig;
 }
 
 // Статистика
+const char* RegistryFacade::OperationName(const OperationKind kind) noexcept
+{
+    switch (kind)
+    {
+        case OperationKind::Open: return "open";
+        case OperationKind::Enumerate: return "enumerate";
+        case OperationKind::Read: return "read";
+        case OperationKind::Write: return "write";
+        case OperationKind::Tree: return "tree";
+    }
+    return "unknown";
+}
+
+const char* RegistryFacade::HiveName(const Hive hive) noexcept
+{
+    switch (hive)
+    {
+        case Hive::ClassesRoot: return "HKEY_CLASSES_ROOT";
+        case Hive::CurrentUser: return "HKEY_CURRENT_USER";
+        case Hive::LocalMachine: return "HKEY_LOCAL_MACHINE";
+        case Hive::Users: return "HKEY_USERS";
+        case Hive::CurrentConfig: return "HKEY_CURRENT_CONFIG";
+        case Hive::Other: return "other";
+    }
+    return "unknown";
+}
+
+RegistryFacade::Hive RegistryFacade::HiveOf(HKEY root) noexcept
+{
+    if (root == HKEY_CLASSES_ROOT) return Hive::ClassesRoot;
+    if (root == HKEY_CURRENT_USER) return Hive::CurrentUser;
+    if (root == HKEY_LOCAL_MACHINE) return Hive::LocalMachine;
+    if (root == HKEY_USERS) return Hive::Users;
+    if (root == HKEY_CURRENT_CONFIG) return Hive::CurrentConfig;
+    return Hive::Other;
+}
+
 RegistryFacade::PerformanceStats RegistryFacade::GetStats() const
 {
-    std::lock_guard lock(m_statsMutex);
-    return m_stats;
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    PerformanceStats stats;
+    for (size_t i = 0; i < kHiveCount; ++i)
+    {
+        HiveCacheStats& hive = stats.cacheByHive[i];
+        hive.hits = m_stats.cacheByHive[i].hits.load(relaxed);
+        hive.misses = m_stats.cacheByHive[i].misses.load(relaxed);
+        stats.cacheHits += hive.hits;
+        stats.cacheMisses += hive.misses;
+    }
+    stats.keysOpened = m_stats.keysOpened.load(relaxed);
+    stats.valuesRead = m_stats.valuesRead.load(relaxed);
+    stats.valuesWritten = m_stats.valuesWritten.load(relaxed);
+    stats.totalOperationTime = std::chrono::nanoseconds(m_stats.totalOperationTimeNs.load(relaxed));
+    for (size_t i = 0; i < kOperationKindCount; ++i)
+    {
+        stats.latency[i] = m_stats.latency[i].Summary();
+    }
+    return stats;
 }
 
 void RegistryFacade::ResetStats() const
 {
-    std::lock_guard lock(m_statsMutex);
-    m_stats = PerformanceStats{};
+    constexpr auto relaxed = std::memory_order_relaxed;
+    for (HiveCounters& hive : m_stats.cacheByHive)
+    {
+        hive.hits.store(0, relaxed);
+        hive.misses.store(0, relaxed);
+    }
+    m_stats.keysOpened.store(0, relaxed);
+    m_stats.valuesRead.store(0, relaxed);
+    m_stats.valuesWritten.store(0, relaxed);
+    m_stats.totalOperationTimeNs.store(0, relaxed);
+    for (core::metrics::LatencyHistogram& histogram : m_stats.latency)
+    {
+        histogram.Reset();
+    }
 }
 
-void RegistryFacade::RecordCacheHit(bool hit) const
+void RegistryFacade::RecordCacheHit(HKEY root, bool hit) const
 {
-    std::lock_guard lock(m_statsMutex);
+    HiveCounters& hive = m_stats.cacheByHive[static_cast<size_t>(HiveOf(root))];
     if (hit)
     {
-        m_stats.cacheHits++;
+        hive.hits.fetch_add(1, std::memory_order_relaxed);
     } else
     {
-        m_stats.cacheMisses++;
+        hive.misses.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
 void RegistryFacade::RecordKeyOpened() const
 {
-    std::lock_guard lock(m_statsMutex);
-    m_stats.keysOpened++;
+    m_stats.keysOpened.fetch_add(1, std::memory_order_relaxed);
 }
 
 void RegistryFacade::RecordValueRead() const
 {
-    std::lock_guard lock(m_statsMutex);
-    m_stats.valuesRead++;
+    m_stats.valuesRead.fetch_add(1, std::memory_order_relaxed);
 }
 
-void RegistryFacade::RecordValueWritten() const
+void RegistryFacade::RecordCacheHits(HKEY root, const size_t hits, const size_t misses) const
+{
+    HiveCounters& hive = m_stats.cacheByHive[static_cast<size_t>(HiveOf(root))];
+    if (hits > 0)
+    {
+        hive.hits.fetch_add(hits, std::memory_order_relaxed);
+    }
+    if (misses > 0)
+    {
+        hive.misses.fetch_add(misses, std::memory_order_relaxed);
+    }
+}
+
+void RegistryFacade::RecordValuesRead(const size_t count) const
 {
-    std::lock_guard lock(m_statsMutex);
-    m_stats.valuesWritten++;
+    m_stats.valuesRead.fetch_add(count, std::memory_order_relaxed);
 }
 
-void RegistryFacade::RecordOperationTime(std::chrono::milliseconds duration) const
+void RegistryFacade::RecordValueWritten() const
 {
-    std::lock_guard lock(m_statsMutex);
-    m_stats.totalOperationTime += duration;
+    m_stats.valuesWritten.fetch_add(1, std::memory_order_relaxed);
 }
 
-std::optional<RegistryFacade::CachedKey> RegistryFacade::FindCachedKey(HKEY root, const std::wstring& subKeyPath, REGSAM sam) const
+void RegistryFacade::RecordOperationTime(const OperationKind kind,
+                                         const std::chrono::steady_clock::time_point startTime) const
 {
-    if (!m_cacheConfig.enabled) {
-        return std::nullopt;
-    }
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - startTime;
+    m_stats.totalOperationTimeNs.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    m_stats.latency[static_cast<size_t>(kind)].Record(elapsed);
+}
 
-    std::lock_guard lock(m_cacheMutex);
-    CleanupExpiredCache();
+CacheKeyId RegistryFacade::MakeKeyId(HKEY root, const std::wstring& subKeyPath, const REGSAM sam)
+{
+    return CacheKeyId{root, FoldRegistryName(subKeyPath), std::wstring(), sam};
+}
 
-    const auto now = std::chrono::steady_clock::now();
-    const auto it = std::ranges::find_if(m_keyCache,
-                                         [&](const CachedKey& cached) {
-                                             return cached.root == root &&
-                                                    cached.subKeyPath == subKeyPath &&
-                                                    cached.sam == sam &&
-                                                    cached.expiryTime > now;
-                                         });
+CacheKeyId RegistryFacade::MakeValueId(HKEY root, const std::wstring& subKeyPath,
+                                       const std::wstring& valueName, const REGSAM sam)
+{
+    return CacheKeyId{root, FoldRegistryName(subKeyPath), FoldRegistryName(valueName), sam};
+}
 
-    if (it != m_keyCache.end()) {
-        it->lastAccess = now;
-        it->accessCount++;
-        std::optional cached = std::move(*it);
-        return cached;
+RegistryFacade::KeyLease RegistryFacade::FindCachedKey(HKEY root, const std::wstring& subKeyPath, REGSAM sam) const
+{
+    if (!m_cacheConfig.enabled || !m_cache) {
+        return nullptr;
     }
 
-    return std::nullopt;
+    // Hand out another lease; the entry keeps its own reference and stays usable.
+    return m_cache->FindKey(MakeKeyId(root, subKeyPath, sam), std::chrono::steady_clock::now());
 }
 
-void RegistryFacade::CacheKey(HKEY root, const std::wstring& subKeyPath, REGSAM sam, RegistryKey key) const
+void RegistryFacade::CacheKey(HKEY root, const std::wstring& subKeyPath, REGSAM sam, KeyLease key,
+                              const WatchTicket& ticket) const
 {
-    if (!m_cacheConfig.enabled || subKeyPath.empty() || (sam & KEY_WRITE)) {
+    if (!m_cacheConfig.enabled || !m_cache || subKeyPath.empty() || (sam & KEY_WRITE) || !key) {
         return;
     }
 
-    std::lock_guard lock(m_cacheMutex);
-
-    std::erase_if(m_keyCache,
-                  [&](const CachedKey& cached) {
-                      return cached.root == root &&
-                             cached.subKeyPath == subKeyPath &&
-                             cached.sam == sam;
-                  });
-
     const auto now = std::chrono::steady_clock::now();
-    CachedKey newEntry{
-        root, subKeyPath, sam, std::move(key),
-        now, now + m_cacheConfig.keyCacheTTL, 1
-    };
-
-    m_keyCache.push_back(std::move(newEntry));
-    EnforceCacheSizeLimits();
+    m_cache->InsertKey(MakeKeyId(root, subKeyPath, sam), std::move(key),
+                       now, m_cacheConfig.keyCacheTTL, ticket, m_cacheConfig.maxCacheSize);
 }
 
-std::optional<RegistryFacade::CachedValue>
+std::optional<CachedValue>
 RegistryFacade::FindCachedValue(HKEY root, const std::wstring& subKeyPath,
                                const std::wstring& valueName, REGSAM sam) const
 {
-    if (!m_cacheConfig.enabled) {
+    if (!m_cacheConfig.enabled || !m_cache) {
         return std::nullopt;
     }
 
-    std::lock_guard lock(m_cacheMutex);
-    CleanupExpiredCache();
-
-    auto now = std::chrono::steady_clock::now();
-    auto it = std::find_if(m_valueCache.begin(), m_valueCache.end(),
-        [&](const CachedValue& cached) {
-            return cached.root == root &&
-                   cached.subKeyPath == subKeyPath &&
-                   cached.valueName == valueName &&
-                   cached.sam == sam &&
-                   cached.expiryTime > now;
-        });
-
-    if (it != m_valueCache.end()) {
-        it->lastAccess = now;
-        it->accessCount++;
-        return *it;
-    }
-
-    return std::nullopt;
+    return m_cache->FindValue(MakeValueId(root, subKeyPath, valueName, sam), std::chrono::steady_clock::now());
 }
 
 void RegistryFacade::CacheValue(HKEY root, const std::wstring& subKeyPath,
                                const std::wstring& valueName, REGSAM sam,
-                               const std::vector<unsigned char>& data, const DWORD type) const
+                               const std::vector<unsigned char>& data, const DWORD type,
+                               const WatchTicket& ticket) const
 {
-    if (!m_cacheConfig.enabled) {
+    if (!m_cacheConfig.enabled || !m_cache) {
         return;
     }
 
-    std::lock_guard lock(m_cacheMutex);
-
-    m_valueCache.erase(std::remove_if(m_valueCache.begin(), m_valueCache.end(),
-        [&](const CachedValue& cached) {
-            return cached.root == root &&
-                   cached.subKeyPath == subKeyPath &&
-                   cached.valueName == valueName &&
-                   cached.sam == sam;
-        }), m_valueCache.end());
-
     const auto now = std::chrono::steady_clock::now();
-    CachedValue newEntry{
-        root, subKeyPath, valueName, sam, data, type,
-        now, now + m_cacheConfig.valueCacheTTL, 1
-    };
-
-    m_valueCache.push_back(std::move(newEntry));
-    EnforceCacheSizeLimits();
+    m_cache->InsertValue(MakeValueId(root, subKeyPath, valueName, sam), CachedValue(type, data),
+                         now, m_cacheConfig.valueCacheTTL, ticket, m_cacheConfig.maxCacheSize);
 }
 
-void RegistryFacade::InvalidateKeyCache(HKEY root, const std::wstring& subKeyPath) const
+std::vector<std::optional<CachedValue>>
+RegistryFacade::FindCachedValues(HKEY root, const std::wstring& subKeyPath,
+                                 const std::vector<std::wstring>& valueNames, const REGSAM sam) const
 {
-    std::lock_guard lock(m_cacheMutex);
+    if (!m_cacheConfig.enabled || !m_cache) {
+        return std::vector<std::optional<CachedValue>>(valueNames.size());
+    }
+
+    const std::wstring folded = FoldRegistryName(subKeyPath);
+    std::vector<CacheKeyId> ids;
+    ids.reserve(valueNames.size());
+    for (const std::wstring& name : valueNames) {
+        ids.push_back(CacheKeyId{root, folded, FoldRegistryName(name), sam});
+    }
 
-    m_keyCache.erase(std::ranges::remove_if(m_keyCache,
-                                            [&](const CachedKey& cached) {
-                                                return cached.root == root &&
-                                                       (subKeyPath.empty() || cached.subKeyPath == subKeyPath);
-                                            }).begin(), m_keyCache.end());
+    return m_cache->FindValues(ids, std::chrono::steady_clock::now());
 }
 
-void RegistryFacade::InvalidateValueCache(HKEY root, const std::wstring& subKeyPath, const std::wstring& valueName)
+void RegistryFacade::CacheValues(HKEY root, const std::wstring& subKeyPath, const REGSAM sam,
+                                 std::vector<std::pair<std::wstring, CachedValue>> values,
+                                 const WatchTicket& ticket) const
 {
-    std::lock_guard lock(m_cacheMutex);
+    if (!m_cacheConfig.enabled || !m_cache || values.empty()) {
+        return;
+    }
+
+    const std::wstring folded = FoldRegistryName(subKeyPath);
+    std::vector<std::pair<CacheKeyId, CachedValue>> entries;
+    entries.reserve(values.size());
+    for (auto& [name, value] : values) {
+        entries.emplace_back(CacheKeyId{root, folded, FoldRegistryName(name), sam}, std::move(value));
+    }
 
-    std::erase_if(m_valueCache,
-                  [&](const CachedValue& cached) {
-                      const bool matchesRoot = cached.root == root;
-                      const bool matchesPath = subKeyPath.empty() || cached.subKeyPath == subKeyPath;
-                      const bool matchesValue = valueName.empty() || cached.valueName == valueName;
-                      return matchesRoot && matchesPath && matchesValue;
-                  });
+    const auto now = std::chrono::steady_clock::now();
+    m_cache->InsertValues(std::move(entries), now, m_cacheConfig.valueCacheTTL, ticket, m_cacheConfig.maxCacheSize);
 }
 
-void RegistryFacade::CleanupExpiredCache() const
+WatchTicket RegistryFacade::ArmWatch(HKEY root, const std::wstring& subKeyPath) const
 {
-    const auto now = std::chrono::steady_clock::now();
+    if (!m_watcher || !m_cacheConfig.enabled) {
+        return {};
+    }
+    return m_watcher->Arm(root, subKeyPath);
+}
 
-    std::erase_if(m_keyCache,
-                  [&](const CachedKey& cached) {
-                      return cached.expiryTime <= now;
-                  });
+SubKeyListing RegistryFacade::FindCachedSubKeys(HKEY root, const std::wstring& subKeyPath, REGSAM sam) const
+{
+    if (!m_cacheConfig.enabled || !m_cache) {
+        return nullptr;
+    }
 
-    std::erase_if(m_valueCache,
-                  [&](const CachedValue& cached) {
-                      return cached.expiryTime <= now;
-                  });
+    return m_cache->FindSubKeys(MakeKeyId(root, subKeyPath, sam), std::chrono::steady_clock::now());
 }
 
-void RegistryFacade::EnforceCacheSizeLimits() const
+void RegistryFacade::CacheSubKeys(HKEY root, const std::wstring& subKeyPath, REGSAM sam,
+                                  SubKeyListing listing, const WatchTicket& ticket) const
 {
-    const size_t totalSize = m_keyCache.size() + m_valueCache.size();
-    if (totalSize <= m_cacheConfig.maxCacheSize)
-    {
+    if (!m_cacheConfig.enabled || !m_cache || !listing) {
         return;
     }
 
-    auto now = std::chrono::steady_clock::now();
-    struct CacheItem
-    {
-        enum Type { Key, Value };
+    // The per-child counts change when grandchildren change, which a non-subtree watch on
+    // this key does not report; such listings keep the TTL.
+    const WatchTicket& effective = m_watchConfig.watchSubtree ? ticket : WatchTicket{};
 
-        Type type;
-        std::chrono::steady_clock::time_point lastAccess;
-        size_t index;
-    };
+    const auto now = std::chrono::steady_clock::now();
+    m_cache->InsertSubKeys(MakeKeyId(root, subKeyPath, sam), std::move(listing),
+                           now, m_cacheConfig.keyCacheTTL, effective, m_cacheConfig.maxCacheSize);
+}
 
-    std::vector<CacheItem> allItems;
+void RegistryFacade::InvalidateKeyCache(HKEY root, const std::wstring& subKeyPath) const
+{
+    if (!m_cache) {
+        return;
+    }
+    m_cache->InvalidateKeys(root, FoldRegistryName(subKeyPath));
+}
 
-    for (size_t i = 0; i < m_keyCache.size(); ++i)
-    {
-        allItems.push_back({CacheItem::Key, m_keyCache[i].lastAccess, i});
+void RegistryFacade::InvalidateSubtreeCache(HKEY root, const std::wstring& subKeyPath) const
+{
+    if (!m_cache) {
+        return;
     }
+    const std::wstring folded = FoldRegistryName(subKeyPath);
+    m_cache->InvalidatePath(root, folded, true);
 
-    for (size_t i = 0; i < m_valueCache.size(); ++i)
-    {
-        allItems.push_back({CacheItem::Value, m_valueCache[i].lastAccess, i});
+    const size_t separator = folded.rfind(L'\\');
+    m_cache->InvalidatePath(root, separator == std::wstring::npos ? std::wstring() : folded.substr(0, separator), false);
+}
+
+void RegistryFacade::InvalidateValueCache(HKEY root, const std::wstring& subKeyPath, const std::wstring& valueName)
+{
+    if (!m_cache) {
+        return;
     }
+    m_cache->InvalidateValues(root, FoldRegistryName(subKeyPath), FoldRegistryName(valueName));
+}
 
-    std::ranges::sort(allItems,
-                      [](const CacheItem &a, const CacheItem &b)
-                      {
-                          return a.lastAccess < b.lastAccess;
-                      });
+void RegistryFacade::InvalidateWrittenKeys(WriteBatch const& batch) const
+{
+    if (!m_cache) {
+        return;
+    }
 
-    const size_t itemsToRemove = totalSize - m_cacheConfig.maxCacheSize;
-    for (size_t i = 0; i < itemsToRemove && i < allItems.size(); ++i)
-    {
-        const auto &item = allItems[i];
-        if (item.type == CacheItem::Key)
-        {
-            if (item.index < m_keyCache.size())
-            {
-                m_keyCache[item.index] = std::move(m_keyCache.back());
-                m_keyCache.pop_back();
-            }
-        } else
-        {
-            if (item.index < m_valueCache.size())
-            {
-                m_valueCache[item.index] = std::move(m_valueCache.back());
-                m_valueCache.pop_back();
-            }
+    std::unordered_set<CacheKeyId, CacheKeyIdHash> seen;
+    for (const WriteBatch::Operation& op : batch.Operations()) {
+        CacheKeyId id{op.root, FoldRegistryName(op.path), std::wstring(), 0};
+        if (!seen.insert(id).second) {
+            continue;
         }
+
+        // The parent's listing carries this key's value count and, for new keys, its name.
+        m_cache->InvalidatePath(id.root, id.path, false);
+        const size_t separator = id.path.rfind(L'\\');
+        m_cache->InvalidatePath(id.root, separator == std::wstring::npos ? std::wstring() : id.path.substr(0, separator), false);
+    }
+}
+
+// Full sweep; expiry is otherwise handled lazily by the cache probes and eviction.
+void RegistryFacade::CleanupExpiredCache() const
+{
+    if (m_cache) {
+        m_cache->CleanupExpired(std::chrono::steady_clock::now());
     }
 }
 
-RegistryKey RegistryFacade::OpenKeyInternal(HKEY root,
-                                           std::wstring const& subKeyPath,
-                                           const REGSAM sam,
-                                           const bool createIfMissing,
-                                           const bool forceRefresh) const
+RegistryFacade::KeyLease RegistryFacade::OpenKeyInternal(HKEY root,
+                                                         std::wstring const& subKeyPath,
+                                                         const REGSAM sam,
+                                                         const bool createIfMissing,
+                                                         const bool forceRefresh,
+                                                         const bool countLookup) const
 {
     auto startTime = std::chrono::steady_clock::now();
 
@@ -438,29 +549,35 @@ RegistryKey RegistryFacade::OpenKeyInternal(HKEY root,
 
     if (!forceRefresh && m_cacheConfig.enabled && !createIfMissing)
     {
-        std::optional<CachedKey> cached = FindCachedKey(root, subKeyPath, sam);
+        KeyLease cached = FindCachedKey(root, subKeyPath, sam);
         if (cached)
         {
-            RecordCacheHit(true);
-            RecordKeyOpened();
-            RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - startTime));
-            return std::move(cached->key);
+            if (countLookup)
+            {
+                RecordCacheHit(root, true);
+            }
+            RecordOperationTime(OperationKind::Open, startTime);
+            return cached;
         }
     }
 
-    RecordCacheHit(false);
+    if (countLookup)
+    {
+        RecordCacheHit(root, false);
+    }
+
+    const bool cacheable = m_cacheConfig.enabled && !createIfMissing && !subKeyPath.empty() && !(sam & KEY_WRITE);
+    const WatchTicket ticket = cacheable ? ArmWatch(root, subKeyPath) : WatchTicket{};
 
-    RegistryKey key = OpenKeyUncached(root, subKeyPath, sam, createIfMissing);
+    auto key = std::make_shared<const RegistryKey>(OpenKeyUncached(root, subKeyPath, sam, createIfMissing));
 
-    if (m_cacheConfig.enabled && !createIfMissing && !subKeyPath.empty() && !(sam & KEY_WRITE))
+    if (cacheable)
     {
-        CacheKey(root, subKeyPath, sam, std::move(key));
+        CacheKey(root, subKeyPath, sam, key, ticket);
     }
 
     RecordKeyOpened();
-    RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startTime));
+    RecordOperationTime(OperationKind::Open, startTime);
 
     return key;
 }
@@ -495,69 +612,175 @@ RegistryFacade::ListSubKeys(HKEY root, std::wstring const& subKeyPath, REGSAM sa
 {
     auto startTime = std::chrono::steady_clock::now();
 
-    RegistryKey key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
-    std::vector<std::wstring> result = EnumerateSubKeys(key);
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
 
-    if (options.offset > 0 || options.maxItems > 0) {
-        if (options.offset >= result.size()) {
-            result.clear();
-        } else {
-            // Assume: std::vector<std::wstring> result; auto startIt = result.begin() + options.offset;
-            auto startIt = result.begin();
-            std::advance(startIt, static_cast<std::ptrdiff_t>(options.offset));
-
-            std::vector<std::wstring>::iterator endIt;
-            if (options.maxItems > 0)
-            {
-                size_t remaining = 0;
-                if (result.size() > options.offset)
-                {
-                    remaining = result.size() - options.offset;
-                }
-                size_t take = (options.maxItems < remaining ? options.maxItems : remaining);
-                endIt = startIt;
-                std::advance(endIt, static_cast<std::ptrdiff_t>(take));
-            }
-            else
-            {
-                endIt = result.end();
-            }
+    std::vector<std::wstring> result;
+    if (options.offset == 0 && options.maxItems == 0) {
+        result = EnumerateSubKeys(*key);
+    } else {
+        // Only the requested page is materialized.
+        if (options.maxItems > 0) {
+            result.reserve(options.maxItems);
         }
+        registry::ForEachSubKey(*key, options.offset, options.maxItems,
+            [&result](const std::wstring_view name, const FILETIME&) {
+                result.emplace_back(name);
+                return true;
+            });
     }
 
-    RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startTime));
+    RecordOperationTime(OperationKind::Enumerate, startTime);
 
     return result;
 }
 
-std::vector<RegValueRecord>
+KeySnapshot
 RegistryFacade::ListValues(HKEY root, std::wstring const& subKeyPath, REGSAM sam, ListOptions options)
 {
     auto startTime = std::chrono::steady_clock::now();
 
-    RegistryKey key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
-    std::vector<RegValueRecord> result = EnumerateValues(key);
-
-    // Применяем пагинацию
-    if (options.offset > 0 || options.maxItems > 0) {
-        if (options.offset >= result.size()) {
-            result.clear();
-        } else {
-            auto startIt = result.begin() + options.offset;
-            auto endIt = options.maxItems > 0 ?
-                startIt + std::min(options.maxItems, result.size() - options.offset) :
-                result.end();
-            result = std::vector<RegValueRecord>(startIt, endIt);
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
+
+    // Names and data of the whole page share one arena; nothing is copied per value.
+    KeySnapshot result = registry::ReadKeySnapshot(*key, options.offset, options.maxItems);
+
+    RecordOperationTime(OperationKind::Enumerate, startTime);
+
+    return result;
+}
+
+std::vector<SubKeyInfo> RegistryFacade::QuerySubKeyPage(RegistryKey const& key, const size_t offset,
+                                                        const size_t maxItems)
+{
+    std::vector<SubKeyInfo> result;
+    if (maxItems > 0) {
+        result.reserve(maxItems);
+    }
+
+    registry::ForEachSubKey(key, offset, maxItems,
+        [&result](const std::wstring_view name, const FILETIME& lastWriteTime) {
+            SubKeyInfo info;
+            info.name.assign(name);
+            info.lastWriteTime = lastWriteTime;
+            result.push_back(std::move(info));
+            return true;
+        });
+
+    for (SubKeyInfo& info : result) {
+        QuerySubKeyInfo(key, info);
+    }
+    return result;
+}
+
+std::vector<SubKeyInfo>
+RegistryFacade::ListSubKeysWithInfo(HKEY root, std::wstring const& subKeyPath, REGSAM sam, ListOptions options)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    const auto slice = [&options](const std::vector<SubKeyInfo>& all) {
+        if (options.offset >= all.size()) {
+            return std::vector<SubKeyInfo>();
+        }
+        const size_t remaining = all.size() - options.offset;
+        const size_t take = options.maxItems > 0 ? std::min(options.maxItems, remaining) : remaining;
+        const auto first = all.begin() + static_cast<std::ptrdiff_t>(options.offset);
+        return std::vector<SubKeyInfo>(first, first + static_cast<std::ptrdiff_t>(take));
+    };
+
+    if (!options.forceRefresh) {
+        const SubKeyListing cached = FindCachedSubKeys(root, subKeyPath, sam);
+        if (cached) {
+            RecordCacheHit(root, true);
+            RecordOperationTime(OperationKind::Enumerate, startTime);
+            return slice(*cached);
         }
+        RecordCacheHit(root, false);
     }
 
-    RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startTime));
+    const bool cacheable = m_cacheConfig.enabled && !(sam & KEY_WRITE);
+    const WatchTicket ticket = cacheable ? ArmWatch(root, subKeyPath) : WatchTicket{};
+
+    // The listing probe above is this call's lookup; a forced refresh counts the key's instead.
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh, options.forceRefresh);
+    std::vector<SubKeyInfo> result = QuerySubKeyPage(*key, options.offset, options.maxItems);
+
+    // Only a listing known to be complete can answer later pages.
+    const bool complete = options.offset == 0 && (options.maxItems == 0 || result.size() < options.maxItems);
+    if (cacheable && complete) {
+        CacheSubKeys(root, subKeyPath, sam, std::make_shared<const std::vector<SubKeyInfo>>(result), ticket);
+    }
+
+    RecordOperationTime(OperationKind::Enumerate, startTime);
 
     return result;
 }
 
+size_t RegistryFacade::PrefetchSubKeyListings(HKEY root, std::wstring const& subKeyPath, REGSAM sam,
+                                              std::vector<SubKeyInfo> const& children,
+                                              const size_t maxChildSubKeys, const size_t maxKeysQueried,
+                                              const std::stop_token stop)
+{
+    if (!m_cacheConfig.enabled) {
+        return 0;
+    }
+
+    size_t budget = maxKeysQueried;
+    size_t cached = 0;
+
+    for (const SubKeyInfo& child : children) {
+        if (stop.stop_requested()) {
+            break;
+        }
+        if (!child.hasInfo || child.subKeyCount == 0 || child.subKeyCount > maxChildSubKeys) {
+            continue;
+        }
+        if (child.subKeyCount > budget) {
+            break;
+        }
+
+        const std::wstring childPath = subKeyPath.empty() ? child.name : subKeyPath + L"\\" + child.name;
+        if (FindCachedSubKeys(root, childPath, sam)) {
+            continue;
+        }
+
+        try {
+            ListSubKeysWithInfo(root, childPath, sam, ListOptions{});
+            budget -= child.subKeyCount;
+            ++cached;
+        } catch (const RegException&) {
+            // Best effort: an inaccessible child is simply not prefetched.
+        }
+    }
+
+    return cached;
+}
+
+size_t RegistryFacade::ForEachSubKey(HKEY root, std::wstring const& subKeyPath, REGSAM sam,
+                                     ListOptions options, SubKeyVisitor const& visit)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
+    const size_t visited = registry::ForEachSubKey(*key, options.offset, options.maxItems, visit);
+
+    RecordOperationTime(OperationKind::Enumerate, startTime);
+
+    return visited;
+}
+
+size_t RegistryFacade::ForEachValue(HKEY root, std::wstring const& subKeyPath, REGSAM sam,
+                                    ListOptions options, ValueVisitor const& visit)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, options.forceRefresh);
+    const size_t visited = registry::ForEachValue(*key, options.offset, options.maxItems, visit);
+
+    RecordOperationTime(OperationKind::Enumerate, startTime);
+
+    return visited;
+}
+
 // Чтение значений с кэшированием
 std::wstring RegistryFacade::GetStringValue(HKEY root,
     std::wstring const& subKeyPath,
@@ -569,35 +792,298 @@ std::wstring RegistryFacade::GetStringValue(HKEY root,
     if (options.cacheResult && m_cacheConfig.enabled)
     {
         const std::optional<CachedValue> cached = FindCachedValue(root, subKeyPath, valueName, sam);
-        if (cached && cached->type == REG_SZ)
+        if (cached && (cached->Type() == REG_SZ || cached->Type() == REG_EXPAND_SZ))
         {
-            RecordCacheHit(true);
+            RecordCacheHit(root, true);
             RecordValueRead();
-            RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now() - startTime));
+            RecordOperationTime(OperationKind::Read, startTime);
 
-            const auto *strData = reinterpret_cast<const wchar_t *>(cached->data.data());
-            size_t len = (cached->data.size() / sizeof(wchar_t)) - 1; // Без null-terminator
-            return {strData, len};
+            return StringFromValueData(cached->Type(), cached->Data());
         }
     }
 
-    RecordCacheHit(false);
+    RecordCacheHit(root, false);
 
-    const RegistryKey key = OpenKeyInternal(root, subKeyPath, sam, false);
-    std::wstring result = ReadStringValue(key, valueName);
+    // Armed before the read so a change racing with it still invalidates the entry.
+    const WatchTicket ticket = options.cacheResult ? ArmWatch(root, subKeyPath) : WatchTicket{};
 
-    if (options.cacheResult && m_cacheConfig.enabled && !result.empty())
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, false, false);
+    ValueReadResult value = QueryValue(*key, valueName);
+    if (!value.Found())
     {
-        std::vector<unsigned char> data((result.size() + 1) * sizeof(wchar_t));
-        memcpy(data.data(), result.c_str(), data.size());
-        CacheValue(root, subKeyPath, valueName, sam, data, REG_SZ);
+        throw RegException(value.status, FormatWinErrorMessage(value.status));
+    }
+    std::wstring result = StringFromValueData(value.type, value.data);
+
+    // The raw bytes under their stored type, as ReadValues and ReadKeySnapshot cache them.
+    if (options.cacheResult && m_cacheConfig.enabled)
+    {
+        CacheValue(root, subKeyPath, valueName, sam, value.data, value.type, ticket);
     }
 
     RecordValueRead();
-    RecordOperationTime(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - startTime));
+    RecordOperationTime(OperationKind::Read, startTime);
+
+    return result;
+}
+std::vector<ValueReadResult> RegistryFacade::ReadValues(HKEY root,
+                                                        std::wstring const& subKeyPath,
+                                                        std::vector<std::wstring> const& names,
+                                                        const REGSAM sam,
+                                                        const bool cacheResult) const
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    const bool useCache = cacheResult && m_cacheConfig.enabled;
+
+    std::vector<ValueReadResult> results(names.size());
+    std::vector<std::wstring> missingNames;
+    std::vector<size_t> missingSlots;
+
+    if (useCache)
+    {
+        std::vector<std::optional<CachedValue>> cached = FindCachedValues(root, subKeyPath, names, sam);
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            if (cached[i])
+            {
+                const std::span<const unsigned char> bytes = cached[i]->Data();
+                results[i] = ValueReadResult{names[i], ERROR_SUCCESS, cached[i]->Type(),
+                                             std::vector<unsigned char>(bytes.begin(), bytes.end())};
+            }
+            else
+            {
+                missingNames.push_back(names[i]);
+                missingSlots.push_back(i);
+            }
+        }
+    }
+    else
+    {
+        missingNames = names;
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            missingSlots.push_back(i);
+        }
+    }
+
+    RecordCacheHits(root, names.size() - missingNames.size(), missingNames.size());
+
+    if (!missingNames.empty())
+    {
+        // Armed before the read so a change racing with it still invalidates the entries.
+        const WatchTicket ticket = useCache ? ArmWatch(root, subKeyPath) : WatchTicket{};
+
+        // The value probes were counted above, one per name.
+        const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false, false, false);
+        std::vector<ValueReadResult> fetched = QueryMultipleValues(*key, missingNames);
+
+        std::vector<std::pair<std::wstring, CachedValue>> toCache;
+        for (size_t i = 0; i < fetched.size(); ++i)
+        {
+            if (useCache && fetched[i].Found())
+            {
+                toCache.emplace_back(fetched[i].name, CachedValue(fetched[i].type, fetched[i].data));
+            }
+            results[missingSlots[i]] = std::move(fetched[i]);
+        }
+        CacheValues(root, subKeyPath, sam, std::move(toCache), ticket);
+    }
+
+    RecordValuesRead(names.size());
+    RecordOperationTime(OperationKind::Read, startTime);
+
+    return results;
+}
+
+KeySnapshot RegistryFacade::ReadKeySnapshot(HKEY root,
+                                            std::wstring const& subKeyPath,
+                                            const REGSAM sam,
+                                            const bool cacheResult) const
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const bool useCache = cacheResult && m_cacheConfig.enabled;
+    const WatchTicket ticket = useCache ? ArmWatch(root, subKeyPath) : WatchTicket{};
+
+    const KeyLease key = OpenKeyInternal(root, subKeyPath, sam, false);
+    KeySnapshot snapshot = registry::ReadKeySnapshot(*key);
+
+    // A key with more values than its shard can hold would only churn the cache. The
+    // entries keep the snapshot's arena alive instead of copying their bytes.
+    if (useCache && snapshot.Size() <= m_cacheConfig.maxCacheSize / RegistryCacheStore::kShardCount)
+    {
+        const std::shared_ptr<const void> arena = snapshot.Arena();
+        std::vector<std::pair<std::wstring, CachedValue>> toCache;
+        toCache.reserve(snapshot.Size());
+        for (size_t i = 0; i < snapshot.Size(); ++i)
+        {
+            const RegValueView value = snapshot.Value(i);
+            toCache.emplace_back(std::wstring(value.name), CachedValue(value.type, value.Bytes(), arena));
+        }
+        CacheValues(root, subKeyPath, sam, std::move(toCache), ticket);
+    }
+
+    RecordValuesRead(snapshot.Size());
+    RecordOperationTime(OperationKind::Read, startTime);
+
+    return snapshot;
+}
+
+WriteBatchResult RegistryFacade::ApplyWriteBatch(WriteBatch const& batch, WriteBatchOptions const& options)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (const WriteBatch::Operation& op : batch.Operations())
+    {
+        ValidateRootKey(op.root);
+    }
+
+    struct Invalidate {
+        const RegistryFacade& facade;
+        WriteBatch const& batch;
+        ~Invalidate() { facade.InvalidateWrittenKeys(batch); }
+    } invalidate{*this, batch};
+
+    WriteBatchResult result = registry::ApplyWriteBatch(batch, options);
+
+    m_stats.keysOpened.fetch_add(result.keysOpened, std::memory_order_relaxed);
+    m_stats.valuesWritten.fetch_add(result.valuesWritten + result.valuesDeleted, std::memory_order_relaxed);
+    RecordOperationTime(OperationKind::Write, startTime);
 
     return result;
 }
+
+bool RegistryFacade::CopyKey(HKEY sourceRoot,
+                             std::wstring const& sourcePath,
+                             HKEY targetRoot,
+                             std::wstring const& targetPath,
+                             const REGSAM sam)
+{
+    TreeCopyOptions options;
+    options.samView = sam;
+    return CopyKeyTree(sourceRoot, sourcePath, targetRoot, targetPath, options).Succeeded();
+}
+
+bool RegistryFacade::MoveKey(HKEY sourceRoot,
+                             std::wstring const& sourcePath,
+                             HKEY targetRoot,
+                             std::wstring const& targetPath,
+                             const REGSAM sam)
+{
+    TreeCopyOptions options;
+    options.samView = sam;
+    return MoveKeyTree(sourceRoot, sourcePath, targetRoot, targetPath, options).Succeeded();
+}
+
+TreeCopyResult RegistryFacade::CopyKeyTree(HKEY sourceRoot,
+                                           std::wstring const& sourcePath,
+                                           HKEY targetRoot,
+                                           std::wstring const& targetPath,
+                                           TreeCopyOptions const& options)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    ValidateRootKey(sourceRoot);
+    ValidateRootKey(targetRoot);
+
+    // Dropped even if the copy throws half-way: part of the target may already exist.
+    struct Invalidate {
+        const RegistryFacade& facade;
+        HKEY root;
+        const std::wstring& path;
+        ~Invalidate() { facade.InvalidateSubtreeCache(root, path); }
+    } invalidate{*this, targetRoot, targetPath};
+
+    TreeCopyResult result = CopyRegistryTree(sourceRoot, sourcePath, targetRoot, targetPath, options);
+
+    m_stats.valuesWritten.fetch_add(result.valuesCopied, std::memory_order_relaxed);
+    RecordOperationTime(OperationKind::Tree, startTime);
+
+    return result;
+}
+
+TreeCopyResult RegistryFacade::MoveKeyTree(HKEY sourceRoot,
+                                           std::wstring const& sourcePath,
+                                           HKEY targetRoot,
+                                           std::wstring const& targetPath,
+                                           TreeCopyOptions const& options)
+{
+    TreeCopyResult result = CopyKeyTree(sourceRoot, sourcePath, targetRoot, targetPath, options);
+    if (!result.Succeeded())
+    {
+        return result;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    try
+    {
+        DeleteRegistryTree(sourceRoot, sourcePath, options.samView);
+    }
+    catch (const RegException &)
+    {
+        InvalidateSubtreeCache(sourceRoot, sourcePath);
+        throw;
+    }
+    InvalidateSubtreeCache(sourceRoot, sourcePath);
+
+    RecordOperationTime(OperationKind::Tree, startTime);
+
+    return result;
+}
+
+void RegistryFacade::ExportKey(HKEY root,
+                               std::wstring const& subKeyPath,
+                               std::wstring const& filePath,
+                               const DWORD format)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    ValidateRootKey(root);
+    ExportRegistryTree(root, subKeyPath, filePath, format);
+
+    RecordOperationTime(OperationKind::Tree, startTime);
+}
+
+SnapshotCaptureResult RegistryFacade::CaptureSnapshot(HKEY root,
+                                                     std::wstring const& subKeyPath,
+                                                     std::wstring const& filePath,
+                                                     SnapshotCaptureOptions const& options)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+
+    ValidateRootKey(root);
+    SnapshotCaptureResult result = CaptureRegistrySnapshot(root, subKeyPath, filePath, options);
+
+    m_stats.keysOpened.fetch_add(result.keysCaptured, std::memory_order_relaxed);
+    RecordValuesRead(result.valuesCaptured);
+    RecordOperationTime(OperationKind::Tree, startTime);
+
+    return result;
+}
+
+std::shared_ptr<const RegistrySnapshot> RegistryFacade::OpenSnapshot(std::wstring const& filePath) const
+{
+    return RegistrySnapshot::Open(filePath);
+}
+
+std::vector<SubKeyInfo> RegistryFacade::ListSubKeysWithInfo(RegistrySnapshot const& snapshot,
+                                                            std::wstring const& subKeyPath,
+                                                            ListOptions options) const
+{
+    return snapshot.ListSubKeysWithInfo(subKeyPath, options.offset, options.maxItems);
+}
+
+size_t RegistryFacade::ForEachSubKey(RegistrySnapshot const& snapshot, std::wstring const& subKeyPath,
+                                     ListOptions options, SubKeyVisitor const& visit) const
+{
+    return snapshot.ForEachSubKey(subKeyPath, options.offset, options.maxItems, visit);
+}
+
+size_t RegistryFacade::ForEachValue(RegistrySnapshot const& snapshot, std::wstring const& subKeyPath,
+                                    ListOptions options, ValueVisitor const& visit) const
+{
+    return snapshot.ForEachValue(subKeyPath, options.offset, options.maxItems, visit);
+}
+
 } // namespace core::registry
\ No newline at end of file
@@ -1,13 +1,22 @@
 // RegistryFacade.h
 #pragma once
 
-#include "RegistryHelpers.h" // contains RegistryKey, RegValueRecord, helpers
+#include "RegistryHelpers.h" // contains RegistryKey, KeySnapshot, helpers
+#include "RegistryCache.h"
+#include "RegistryWatcher.h"
+#include "RegistryTreeCopier.h"
+#include "RegistryWriteBatch.h"
+#include "RegistrySnapshot.h"
+#include "../metrics/LatencyHistogram.h"
+#include <array>
 #include <string>
 #include <vector>
 #include <optional>
 #include <chrono>
 #include <mutex>
 #include <memory>
+#include <atomic>
+#include <stop_token>
 
 namespace core::registry
 {
@@ -15,6 +24,10 @@ namespace core::registry
 class RegistryFacade
 {
 public:
+    // Shared, ref-counted view of an open key. The handle stays open while the
+    // cache entry or any caller still holds a lease, so hot keys are opened once.
+    using KeyLease = registry::KeyLease;
+
     struct ListOptions {
         size_t maxItems = 0;
         size_t offset = 0;
@@ -37,15 +50,18 @@ public:
         bool enabled = true;
     };
 
+    // When enabled, cached keys get a change notification armed and their entries
+    // stay cached until the key changes; the TTLs above only apply to unwatched keys.
     struct WatchConfig {
         bool enabled = false;
         DWORD notifyFilter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
         bool watchSubtree = false;
-        std::chrono::milliseconds pollInterval = std::chrono::milliseconds(1000);
+        size_t maxWatches = 512;
     };
 
     RegistryFacade() noexcept;
     explicit RegistryFacade(CacheConfig cacheConfig) noexcept;
+    RegistryFacade(CacheConfig cacheConfig, WatchConfig watchConfig) noexcept;
     ~RegistryFacade() noexcept;
 
     RegistryFacade(const RegistryFacade&) = delete;
@@ -59,10 +75,49 @@ public:
                                          REGSAM sam,
                                          ListOptions options);
 
-    std::vector<RegValueRecord> ListValues(HKEY root,
-                                          std::wstring const& subKeyPath,
-                                          REGSAM sam,
-                                          ListOptions options);
+    // The requested page of values in one arena (see registry::ReadKeySnapshot); not cached.
+    KeySnapshot ListValues(HKEY root,
+                           std::wstring const& subKeyPath,
+                           REGSAM sam,
+                           ListOptions options);
+
+    /**
+     * Lists children together with their own subkey/value counts (one RegQueryInfoKeyW per
+     * child), so callers can tell leaf keys apart without expanding them. Complete listings
+     * are cached; a cached listing answers any page without touching the registry.
+     */
+    std::vector<SubKeyInfo> ListSubKeysWithInfo(HKEY root,
+                                                std::wstring const& subKeyPath,
+                                                REGSAM sam,
+                                                ListOptions options);
+
+    /**
+     * Speculatively caches the listings of 'children' of subKeyPath (as returned by
+     * ListSubKeysWithInfo) so their expansion is answered from memory. Children with more
+     * than maxChildSubKeys subkeys are skipped; stops after maxKeysQueried child queries or
+     * when stop is requested. Returns the number of listings cached.
+     */
+    size_t PrefetchSubKeyListings(HKEY root,
+                                  std::wstring const& subKeyPath,
+                                  REGSAM sam,
+                                  std::vector<SubKeyInfo> const& children,
+                                  size_t maxChildSubKeys,
+                                  size_t maxKeysQueried,
+                                  std::stop_token stop = {});
+
+    // Streaming variants: honour options.offset/maxItems without building the full
+    // list. The visitor may return false to stop; returns the number of entries visited.
+    size_t ForEachSubKey(HKEY root,
+                         std::wstring const& subKeyPath,
+                         REGSAM sam,
+                         ListOptions options,
+                         SubKeyVisitor const& visit);
+
+    size_t ForEachValue(HKEY root,
+                        std::wstring const& subKeyPath,
+                        REGSAM sam,
+                        ListOptions options,
+                        ValueVisitor const& visit);
 
     std::wstring GetStringValue(HKEY root,
                                std::wstring const& subKeyPath,
@@ -88,6 +143,28 @@ public:
                                              REGSAM sam,
                                              GetValueOptions options);
 
+    /**
+     * Reads several values of one key. Cached values are answered under one shard lock, the
+     * rest with a single key open and one RegQueryMultipleValuesW call, and what was read is
+     * cached in one batch. Results follow the order of names; a missing value comes back
+     * with status ERROR_FILE_NOT_FOUND rather than as an exception.
+     */
+    std::vector<ValueReadResult> ReadValues(HKEY root,
+                                            std::wstring const& subKeyPath,
+                                            std::vector<std::wstring> const& names,
+                                            REGSAM sam = KEY_READ,
+                                            bool cacheResult = true) const;
+
+    /**
+     * Every value of the key plus its last-write time from one enumeration pass (see
+     * registry::ReadKeySnapshot). Always reads the registry; the values are then cached in
+     * one batch so following GetStringValue/ReadValues calls hit.
+     */
+    KeySnapshot ReadKeySnapshot(HKEY root,
+                                std::wstring const& subKeyPath,
+                                REGSAM sam = KEY_READ,
+                                bool cacheResult = true) const;
+
     void SetStringValue(HKEY root,
                        std::wstring const& subKeyPath,
                        std::wstring const& valueName,
@@ -113,6 +190,15 @@ public:
                        std::vector<unsigned char> const& data,
                        REGSAM sam = KEY_WRITE);
 
+    /**
+     * Applies batch (see registry::ApplyWriteBatch): one write handle per key, operations in
+     * order, optionally inside one kernel transaction. The cached handles, values and parent
+     * listings of every key the batch touches are dropped once, after the whole batch, even
+     * if applying it throws.
+     */
+    WriteBatchResult ApplyWriteBatch(WriteBatch const& batch,
+                                     WriteBatchOptions const& options = WriteBatchOptions{});
+
     void CreateKey(HKEY root,
                   std::wstring const& subKeyPath,
                   REGSAM sam = KEY_READ | KEY_WRITE);
@@ -142,6 +228,59 @@ public:
                 std::wstring const& targetPath,
                 REGSAM sam = KEY_READ | KEY_WRITE);
 
+    /**
+     * Whole-subtree copy (see CopyRegistryTree). CopyKey/MoveKey use the native single-call
+     * path; these overloads take a thread manager, progress and a stop token. The source is
+     * only deleted by a move when every key was copied. Cached entries under the target (and
+     * the moved source) are dropped.
+     */
+    TreeCopyResult CopyKeyTree(HKEY sourceRoot,
+                               std::wstring const& sourcePath,
+                               HKEY targetRoot,
+                               std::wstring const& targetPath,
+                               TreeCopyOptions const& options);
+
+    TreeCopyResult MoveKeyTree(HKEY sourceRoot,
+                               std::wstring const& sourcePath,
+                               HKEY targetRoot,
+                               std::wstring const& targetPath,
+                               TreeCopyOptions const& options);
+
+    // Saves the subtree to a hive file with RegSaveKeyExW. Blocking; run it on the pool.
+    void ExportKey(HKEY root,
+                   std::wstring const& subKeyPath,
+                   std::wstring const& filePath,
+                   DWORD format = REG_LATEST_FORMAT);
+
+    /**
+     * Captures the subtree into a RegistrySnapshot file (see CaptureRegistrySnapshot). Unlike
+     * ExportKey this needs no backup privilege and the file can be browsed and diffed without
+     * loading it into the registry. Blocking; run it on the pool.
+     */
+    SnapshotCaptureResult CaptureSnapshot(HKEY root,
+                                          std::wstring const& subKeyPath,
+                                          std::wstring const& filePath,
+                                          SnapshotCaptureOptions const& options = SnapshotCaptureOptions{});
+
+    // Maps a snapshot file read-only; the result can be shared between threads.
+    std::shared_ptr<const RegistrySnapshot> OpenSnapshot(std::wstring const& filePath) const;
+
+    // Snapshot-backed forms of the browsing calls: same paging contract, no registry access,
+    // no caching. subKeyPath is relative to the key the snapshot was captured from.
+    std::vector<SubKeyInfo> ListSubKeysWithInfo(RegistrySnapshot const& snapshot,
+                                                std::wstring const& subKeyPath,
+                                                ListOptions options) const;
+
+    size_t ForEachSubKey(RegistrySnapshot const& snapshot,
+                         std::wstring const& subKeyPath,
+                         ListOptions options,
+                         SubKeyVisitor const& visit) const;
+
+    size_t ForEachValue(RegistrySnapshot const& snapshot,
+                        std::wstring const& subKeyPath,
+                        ListOptions options,
+                        ValueVisitor const& visit) const;
+
     std::wstring GetKeyInfo(HKEY root,
                            std::wstring const& subKeyPath,
                            REGSAM sam = KEY_READ);
@@ -152,6 +291,32 @@ public:
     size_t GetCacheSize() const;
     CacheConfig GetCacheConfig() const;
     void SetCacheConfig(CacheConfig config);
+    WatchConfig GetWatchConfig() const;
+
+    /**
+     * Latency classes of the public calls. Open covers every key lookup, including the ones
+     * the other calls make internally, so an Enumerate or Read sample contains its Open.
+     * Tree is the whole-subtree calls: CopyKeyTree, MoveKeyTree, ExportKey, CaptureSnapshot.
+     */
+    enum class OperationKind { Open, Enumerate, Read, Write, Tree };
+    static constexpr size_t kOperationKindCount = 5;
+
+    // Cache lookups are counted per predefined root; Other is any key handle the caller opened.
+    // A call counts one lookup (ReadValues one per name), whichever cache answered it.
+    enum class Hive { ClassesRoot, CurrentUser, LocalMachine, Users, CurrentConfig, Other };
+    static constexpr size_t kHiveCount = 6;
+
+    static const char* OperationName(OperationKind kind) noexcept;
+    static const char* HiveName(Hive hive) noexcept;
+
+    struct HiveCacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        [[nodiscard]] double HitRatio() const noexcept
+        {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+        }
+    };
 
     struct PerformanceStats {
         size_t cacheHits = 0;
@@ -159,59 +324,61 @@ public:
         size_t keysOpened = 0;
         size_t valuesRead = 0;
         size_t valuesWritten = 0;
-        std::chrono::milliseconds totalOperationTime{0};
+        std::chrono::nanoseconds totalOperationTime{0};
+        // Indexed by OperationKind and Hive.
+        std::array<core::metrics::LatencySummary, kOperationKindCount> latency{};
+        std::array<HiveCacheStats, kHiveCount> cacheByHive{};
     };
 
     PerformanceStats GetStats() const;
     void ResetStats() const;
 
 private:
-    struct CachedKey {
-        HKEY root;
-        std::wstring subKeyPath;
-        REGSAM sam;
-        RegistryKey key;
-        std::chrono::steady_clock::time_point lastAccess;
-        std::chrono::steady_clock::time_point expiryTime;
-        size_t accessCount = 0;
+    struct alignas(64) HiveCounters {
+        std::atomic<size_t> hits{0};
+        std::atomic<size_t> misses{0};
     };
 
-    struct CachedValue {
-        HKEY root;
-        std::wstring subKeyPath;
-        std::wstring valueName;
-        REGSAM sam;
-        std::vector<unsigned char> data;
-        DWORD type = 0;
-        std::chrono::steady_clock::time_point lastAccess;
-        std::chrono::steady_clock::time_point expiryTime;
-        size_t accessCount = 0;
+    // Lock-free counters; GetStats() aggregates them into a PerformanceStats snapshot.
+    struct AtomicStats {
+        std::array<HiveCounters, kHiveCount> cacheByHive;
+        alignas(64) std::atomic<size_t> keysOpened{0};
+        alignas(64) std::atomic<size_t> valuesRead{0};
+        alignas(64) std::atomic<size_t> valuesWritten{0};
+        alignas(64) std::atomic<long long> totalOperationTimeNs{0};
+        std::array<core::metrics::LatencyHistogram, kOperationKindCount> latency;
     };
 
     CacheConfig m_cacheConfig;
     mutable std::mutex m_configMutex;
 
-    mutable std::vector<CachedKey> m_keyCache;
-    mutable std::vector<CachedValue> m_valueCache;
-    mutable std::mutex m_cacheMutex;
+    // Sharded, reader-writer locked cache; heap-allocated so the facade stays movable.
+    std::unique_ptr<RegistryCacheStore> m_cache;
 
-    mutable PerformanceStats m_stats;
-    mutable std::mutex m_statsMutex;
+    // Declared after m_cache: its callbacks invalidate m_cache, so it must go first.
+    WatchConfig m_watchConfig;
+    std::unique_ptr<RegistryWatcher> m_watcher;
 
-    RegistryKey OpenKeyInternal(HKEY root,
-                               std::wstring const& subKeyPath,
-                               REGSAM sam,
-                               bool createIfMissing,
-                               bool forceRefresh = false) const;
+    mutable AtomicStats m_stats;
+
+    // countLookup: false when the calling operation has already counted its own cache
+    // lookup (a listing or value probe), so that each public call counts once.
+    KeyLease OpenKeyInternal(HKEY root,
+                             std::wstring const& subKeyPath,
+                             REGSAM sam,
+                             bool createIfMissing,
+                             bool forceRefresh = false,
+                             bool countLookup = true) const;
 
-    std::optional<CachedKey> FindCachedKey(HKEY root,
-                                          const std::wstring& subKeyPath,
-                                          REGSAM sam) const;
+    KeyLease FindCachedKey(HKEY root,
+                           const std::wstring& subKeyPath,
+                           REGSAM sam) const;
 
     void CacheKey(HKEY root,
                  const std::wstring& subKeyPath,
                  REGSAM sam,
-                 RegistryKey key) const;
+                 KeyLease key,
+                 const WatchTicket& ticket) const;
 
     std::optional<CachedValue> FindCachedValue(HKEY root,
                                               const std::wstring& subKeyPath,
@@ -223,23 +390,65 @@ private:
                    const std::wstring& valueName,
                    REGSAM sam,
                    const std::vector<unsigned char>& data,
-                   DWORD type) const;
+                   DWORD type,
+                   const WatchTicket& ticket) const;
+
+    // Batch forms for values of one key; one fold of the path and one shard lock per call.
+    std::vector<std::optional<CachedValue>> FindCachedValues(HKEY root,
+                                                             const std::wstring& subKeyPath,
+                                                             const std::vector<std::wstring>& valueNames,
+                                                             REGSAM sam) const;
+
+    void CacheValues(HKEY root,
+                     const std::wstring& subKeyPath,
+                     REGSAM sam,
+                     std::vector<std::pair<std::wstring, CachedValue>> values,
+                     const WatchTicket& ticket) const;
+
+    // Arms a change notification for the key before its data is read; empty if unwatched.
+    WatchTicket ArmWatch(HKEY root, const std::wstring& subKeyPath) const;
+
+    static std::unique_ptr<RegistryWatcher> MakeWatcher(const WatchConfig& config, RegistryCacheStore* cache);
+
+    SubKeyListing FindCachedSubKeys(HKEY root, const std::wstring& subKeyPath, REGSAM sam) const;
+
+    void CacheSubKeys(HKEY root,
+                      const std::wstring& subKeyPath,
+                      REGSAM sam,
+                      SubKeyListing listing,
+                      const WatchTicket& ticket) const;
+
+    // Enumerates [offset, offset + maxItems) of key's children and queries each of them.
+    static std::vector<SubKeyInfo> QuerySubKeyPage(RegistryKey const& key, size_t offset, size_t maxItems);
 
     void InvalidateKeyCache(HKEY root, const std::wstring& subKeyPath) const;
+    // Drops everything cached at or below subKeyPath, and the parent's listing.
+    void InvalidateSubtreeCache(HKEY root, const std::wstring& subKeyPath) const;
     void InvalidateValueCache(HKEY root, const std::wstring& subKeyPath, const std::wstring& valueName = L"");
+    // Drops the entries of each distinct key written by batch and of its parent's listing.
+    void InvalidateWrittenKeys(WriteBatch const& batch) const;
 
     void CleanupExpiredCache() const;
-    void EnforceCacheSizeLimits() const;
+
+    static CacheKeyId MakeKeyId(HKEY root, const std::wstring& subKeyPath, REGSAM sam);
+    static CacheKeyId MakeValueId(HKEY root, const std::wstring& subKeyPath,
+                                  const std::wstring& valueName, REGSAM sam);
 
     static void ValidateRootKey(HKEY root);
 
     static void ValidateSamDesired(REGSAM sam, bool forWrite);
 
-    void RecordCacheHit(bool hit) const;
+    static Hive HiveOf(HKEY root) noexcept;
+
+    void RecordCacheHit(HKEY root, bool hit) const;
     void RecordKeyOpened() const;
     void RecordValueRead() const;
+    void RecordCacheHits(HKEY root, size_t hits, size_t misses) const;
+    void RecordValuesRead(size_t count) const;
     void RecordValueWritten() const;
-    void RecordOperationTime(std::chrono::milliseconds duration) const;
+    // Adds the time since startTime to the total and to kind's histogram.
+    void RecordOperationTime(OperationKind kind, std::chrono::steady_clock::time_point startTime) const;
+    void MoveStats(const RegistryFacade& other) noexcept;
 
     static RegistryKey OpenKeyUncached(HKEY root,
                                        std::wstring const& subKeyPath,
@@ -1,5 +1,6 @@
 // RegistryHelpers.cpp
 #include "RegistryHelpers.h"
+#include <algorithm>
 #include <vector>
 #include <limits>
 #include <memory>
@@ -257,78 +258,461 @@ void SetBinaryValue(RegistryKey const& key, std::wstring const& valueName, std::
     }
 }
 
-std::vector<std::wstring> EnumerateSubKeys(RegistryKey const& key)
+SubKeyList EnumerateSubKeyNames(RegistryKey const& key)
 {
     if (!key.IsValid())
     {
         throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
     }
 
-    std::vector<std::wstring> result;
+    DWORD subKeyCount = 0;
+    DWORD maxSubKeyLen = 0;
 
-    constexpr DWORD INITIAL_BUFFER_SIZE = 256;
-    constexpr size_t MAX_ITERATION_COUNT = 10000;
-    std::vector<wchar_t> nameBuffer(INITIAL_BUFFER_SIZE);
+    LSTATUS status = RegQueryInfoKeyW(key.Handle(),
+                                     nullptr, nullptr, nullptr,
+                                     &subKeyCount,
+                                     &maxSubKeyLen,
+                                     nullptr, nullptr, nullptr, nullptr,
+                                     nullptr, nullptr);
+    if (status != ERROR_SUCCESS)
+    {
+        throw RegException(status, FormatWinErrorMessage(status));
+    }
+
+    // Names are usually far shorter than the longest one, so the arena is reserved
+    // from an average estimate and only the tail is kept maxSubKeyLen + 1 wide.
+    constexpr DWORD AVERAGE_NAME_ESTIMATE = 24;
+    constexpr int MAX_GROW_RETRIES = 8;
 
+    SubKeyList result;
+    result.m_entries.reserve(subKeyCount);
+    result.m_names.reserve(static_cast<size_t>(subKeyCount) * std::min(maxSubKeyLen, AVERAGE_NAME_ESTIMATE) +
+                           maxSubKeyLen + 1);
+
+    size_t used = 0;
     DWORD index = 0;
-    DWORD safetyCounter = 0;
-    bool bufferResized = false;
-    bool isAllDataRead = false;
+    int growRetries = 0;
 
-    while(safetyCounter < MAX_ITERATION_COUNT && !isAllDataRead)
+    for (;;)
     {
-        DWORD nameLen = nameBuffer.size();
+        result.m_names.resize(used + maxSubKeyLen + 1);
+
+        DWORD nameLen = maxSubKeyLen + 1;
         FILETIME lastWriteTime = {};
 
-        const LSTATUS status = RegEnumKeyExW(key.Handle(),
-                                             index,
-                                             nameBuffer.data(),
-                                             &nameLen,
-                                             nullptr,
-                                             nullptr,
-                                             nullptr,
-                                             &lastWriteTime);
+        status = RegEnumKeyExW(key.Handle(),
+                               index,
+                               result.m_names.data() + used,
+                               &nameLen,
+                               nullptr,
+                               nullptr,
+                               nullptr,
+                               &lastWriteTime);
 
         if (status == ERROR_SUCCESS)
         {
-            result.emplace_back(nameBuffer.data(), nameLen);
+            result.m_entries.push_back(SubKeyList::Entry{
+                static_cast<std::uint32_t>(used),
+                static_cast<std::uint32_t>(nameLen),
+                lastWriteTime
+            });
+            used += nameLen;
             ++index;
-            bufferResized = false;
+            growRetries = 0;
         }
         else if (status == ERROR_MORE_DATA)
         {
-            nameBuffer.resize(nameLen + 1);
-            bufferResized = true;
+            // A longer name was added after RegQueryInfoKeyW; refresh the bound.
+            if (++growRetries > MAX_GROW_RETRIES)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+
+            DWORD refreshedMax = 0;
+            status = RegQueryInfoKeyW(key.Handle(),
+                                      nullptr, nullptr, nullptr, nullptr,
+                                      &refreshedMax,
+                                      nullptr, nullptr, nullptr, nullptr,
+                                      nullptr, nullptr);
+            if (status != ERROR_SUCCESS)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+            maxSubKeyLen = std::max({refreshedMax, nameLen, maxSubKeyLen + 1});
         }
         else if (status == ERROR_NO_MORE_ITEMS)
         {
-            isAllDataRead = true;
+            break;
         }
         else
         {
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+    }
+
+    result.m_names.resize(used);
+    return result;
+}
+
+std::vector<std::wstring> EnumerateSubKeys(RegistryKey const& key)
+{
+    const SubKeyList names = EnumerateSubKeyNames(key);
+
+    std::vector<std::wstring> result;
+    result.reserve(names.Size());
+    for (size_t i = 0; i < names.Size(); ++i)
+    {
+        result.emplace_back(names.Name(i));
+    }
+    return result;
+}
+
+size_t ForEachSubKey(RegistryKey const& key, const size_t offset, const size_t maxItems, SubKeyVisitor const& visit)
+{
+    if (!key.IsValid())
+    {
+        throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
+    }
+
+    DWORD maxSubKeyLen = 0;
+    LSTATUS status = RegQueryInfoKeyW(key.Handle(),
+                                     nullptr, nullptr, nullptr, nullptr,
+                                     &maxSubKeyLen,
+                                     nullptr, nullptr, nullptr, nullptr,
+                                     nullptr, nullptr);
+    if (status != ERROR_SUCCESS)
+    {
+        throw RegException(status, FormatWinErrorMessage(status));
+    }
+
+    constexpr int MAX_GROW_RETRIES = 8;
+    std::vector<wchar_t> nameBuffer(maxSubKeyLen + 1);
+
+    size_t visited = 0;
+    DWORD index = static_cast<DWORD>(offset);
+    int growRetries = 0;
+
+    while (maxItems == 0 || visited < maxItems)
+    {
+        DWORD nameLen = static_cast<DWORD>(nameBuffer.size());
+        FILETIME lastWriteTime = {};
+
+        status = RegEnumKeyExW(key.Handle(),
+                               index,
+                               nameBuffer.data(),
+                               &nameLen,
+                               nullptr,
+                               nullptr,
+                               nullptr,
+                               &lastWriteTime);
+
+        if (status == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+
+        if (status == ERROR_MORE_DATA)
+        {
+            // A longer name appeared after RegQueryInfoKeyW; grow and retry this index.
+            if (++growRetries > MAX_GROW_RETRIES)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+            nameBuffer.resize(nameBuffer.size() * 2);
+            continue;
+        }
+
+        if (status != ERROR_SUCCESS)
+        {
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+
+        growRetries = 0;
+        ++index;
+        ++visited;
+
+        if (!visit(std::wstring_view(nameBuffer.data(), nameLen), lastWriteTime))
+        {
+            break;
+        }
+    }
+
+    return visited;
+}
+
+size_t ForEachValue(RegistryKey const& key, const size_t offset, const size_t maxItems, ValueVisitor const& visit)
+{
+    if (!key.IsValid())
+    {
+        throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
+    }
+
+    DWORD maxValueNameLen = 0;
+    DWORD maxValueDataLen = 0;
+    LSTATUS status = RegQueryInfoKeyW(key.Handle(),
+                                     nullptr, nullptr, nullptr,
+                                     nullptr, nullptr, nullptr, nullptr,
+                                     &maxValueNameLen,
+                                     &maxValueDataLen,
+                                     nullptr, nullptr);
+    if (status != ERROR_SUCCESS)
+    {
+        throw RegException(status, FormatWinErrorMessage(status));
+    }
+
+    constexpr int MAX_GROW_RETRIES = 8;
+    std::vector<wchar_t> nameBuffer(maxValueNameLen + 2);
+    std::vector<BYTE> dataBuffer(maxValueDataLen > 0 ? maxValueDataLen : 1);
+
+    size_t visited = 0;
+    DWORD index = static_cast<DWORD>(offset);
+    int growRetries = 0;
+
+    while (maxItems == 0 || visited < maxItems)
+    {
+        DWORD nameLen = static_cast<DWORD>(nameBuffer.size());
+        DWORD type = 0;
+        DWORD dataSize = static_cast<DWORD>(dataBuffer.size());
+
+        status = RegEnumValueW(key.Handle(),
+                               index,
+                               nameBuffer.data(),
+                               &nameLen,
+                               nullptr,
+                               &type,
+                               dataBuffer.data(),
+                               &dataSize);
+
+        if (status == ERROR_NO_MORE_ITEMS)
+        {
+            break;
+        }
+
+        if (status == ERROR_MORE_DATA)
+        {
+            // The value grew after RegQueryInfoKeyW; refresh both bounds and retry this index.
+            if (++growRetries > MAX_GROW_RETRIES)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+
+            status = RegQueryInfoKeyW(key.Handle(),
+                                      nullptr, nullptr, nullptr,
+                                      nullptr, nullptr, nullptr, nullptr,
+                                      &maxValueNameLen,
+                                      &maxValueDataLen,
+                                      nullptr, nullptr);
+            if (status != ERROR_SUCCESS)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+            nameBuffer.resize(std::max<size_t>(nameBuffer.size(), maxValueNameLen + 2));
+            dataBuffer.resize(std::max<size_t>({dataBuffer.size(), maxValueDataLen, dataSize}));
+            continue;
+        }
 
+        if (status != ERROR_SUCCESS)
+        {
             throw RegException(status, FormatWinErrorMessage(status));
         }
 
-        if (bufferResized && safetyCounter > 1000)
+        growRetries = 0;
+        ++index;
+        ++visited;
+
+        const RegValueView view{
+            std::wstring_view(nameBuffer.data(), nameLen),
+            type,
+            dataBuffer.data(),
+            dataSize
+        };
+        if (!visit(view))
+        {
+            break;
+        }
+    }
+
+    return visited;
+}
+
+// Reads one value with RegQueryValueExW; the status goes into the result instead of a throw.
+static void QuerySingleValue(HKEY key, ValueReadResult& result)
+{
+    constexpr size_t INITIAL_VALUE_BYTES = 256;
+    constexpr int MAX_GROW_RETRIES = 8;
+
+    result.data.resize(INITIAL_VALUE_BYTES);
+    for (int attempt = 0;; ++attempt)
+    {
+        DWORD size = static_cast<DWORD>(result.data.size());
+        const LSTATUS status = RegQueryValueExW(key,
+                                                result.name.empty() ? nullptr : result.name.c_str(),
+                                                nullptr,
+                                                &result.type,
+                                                result.data.data(),
+                                                &size);
+
+        if (status == ERROR_MORE_DATA && attempt < MAX_GROW_RETRIES)
+        {
+            result.data.resize(std::max<size_t>(size, result.data.size() * 2));
+            continue;
+        }
+
+        result.status = status;
+        if (status == ERROR_SUCCESS)
+        {
+            result.data.resize(size);
+        }
+        else
+        {
+            result.type = REG_NONE;
+            result.data.clear();
+        }
+        return;
+    }
+}
+
+std::vector<ValueReadResult> QueryMultipleValues(RegistryKey const& key, std::vector<std::wstring> const& names)
+{
+    if (!key.IsValid())
+    {
+        throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
+    }
+
+    std::vector<ValueReadResult> results(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        results[i].name = names[i];
+    }
+    if (names.empty())
+    {
+        return results;
+    }
+
+    DWORD maxValueDataLen = 0;
+    LSTATUS status = RegQueryInfoKeyW(key.Handle(),
+                                     nullptr, nullptr, nullptr,
+                                     nullptr, nullptr, nullptr, nullptr,
+                                     nullptr,
+                                     &maxValueDataLen,
+                                     nullptr, nullptr);
+    if (status != ERROR_SUCCESS)
+    {
+        throw RegException(status, FormatWinErrorMessage(status));
+    }
+
+    // ve_valuename is only read; the cast satisfies the LPWSTR in VALENTW.
+    std::vector<VALENTW> entries(names.size());
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        entries[i].ve_valuename = const_cast<LPWSTR>(names[i].c_str());
+    }
+
+    // maxValueDataLen bounds every value, but one large value should not make the whole
+    // request reserve count * max; ERROR_MORE_DATA reports the exact total anyway.
+    constexpr size_t INITIAL_BUFFER_LIMIT = 64 * 1024;
+    constexpr int MAX_GROW_RETRIES = 8;
+    const size_t initialBytes = std::min(names.size() * maxValueDataLen, INITIAL_BUFFER_LIMIT);
+    std::vector<wchar_t> buffer(initialBytes / sizeof(wchar_t) + 1);
+
+    for (int attempt = 0;; ++attempt)
+    {
+        DWORD totalSize = static_cast<DWORD>(buffer.size() * sizeof(wchar_t));
+        status = RegQueryMultipleValuesW(key.Handle(),
+                                         entries.data(),
+                                         static_cast<DWORD>(entries.size()),
+                                         buffer.data(),
+                                         &totalSize);
+
+        if (status == ERROR_MORE_DATA && attempt < MAX_GROW_RETRIES)
+        {
+            // Values may grow between calls; never retry with the same size.
+            buffer.resize(std::max(buffer.size() + 1, totalSize / sizeof(wchar_t) + 1));
+            continue;
+        }
+        break;
+    }
+
+    if (status == ERROR_SUCCESS)
+    {
+        for (size_t i = 0; i < entries.size(); ++i)
         {
-            throw RegException(ERROR_INTERNAL_ERROR,
-                              "Too many buffer resizes during subkey enumeration");
+            const auto* value = reinterpret_cast<const unsigned char*>(entries[i].ve_valueptr);
+            results[i].status = ERROR_SUCCESS;
+            results[i].type = entries[i].ve_type;
+            results[i].data.assign(value, value + entries[i].ve_valuelen);
         }
-        safetyCounter++;
+        return results;
+    }
+
+    // The call fails as a whole (ERROR_CANT_ACCESS for a missing value, ERROR_TRANSFER_TOO_LONG
+    // past 1 MB of data), so fall back to one query per value to get per-value statuses.
+    for (ValueReadResult& result : results)
+    {
+        QuerySingleValue(key.Handle(), result);
+    }
+    return results;
+}
+
+ValueReadResult QueryValue(RegistryKey const& key, std::wstring const& name)
+{
+    if (!key.IsValid())
+    {
+        throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
     }
 
-    result.shrink_to_fit();
+    ValueReadResult result;
+    result.name = name;
+    QuerySingleValue(key.Handle(), result);
     return result;
 }
 
-std::vector<RegValueRecord> EnumerateValues(RegistryKey const& key)
+std::wstring StringFromValueData(const DWORD type, const std::span<const unsigned char> data)
+{
+    if (type != REG_SZ && type != REG_EXPAND_SZ)
+    {
+        throw RegException(ERROR_UNSUPPORTED_TYPE, FormatWinErrorMessage(ERROR_UNSUPPORTED_TYPE));
+    }
+
+    const auto *chars = reinterpret_cast<const wchar_t *>(data.data());
+    size_t length = data.size() / sizeof(wchar_t);
+    if (length > 0 && chars[length - 1] == L'\0')
+    {
+        --length;
+    }
+    std::wstring text(chars, length);
+
+    if (type == REG_SZ || text.empty())
+    {
+        return text;
+    }
+
+    // Same result as RegGetValueW without RRF_NOEXPAND; the first call only sizes the output.
+    const DWORD needed = ExpandEnvironmentStringsW(text.c_str(), nullptr, 0);
+    if (needed == 0)
+    {
+        const DWORD error = GetLastError();
+        throw RegException(error, FormatWinErrorMessage(error));
+    }
+    std::wstring expanded(needed, L'\0');
+    const DWORD written = ExpandEnvironmentStringsW(text.c_str(), expanded.data(), needed);
+    if (written == 0 || written > needed)
+    {
+        const DWORD error = GetLastError();
+        throw RegException(error, FormatWinErrorMessage(error));
+    }
+    expanded.resize(written - 1);
+    return expanded;
+}
+
+KeySnapshot ReadKeySnapshot(RegistryKey const& key, const size_t offset, const size_t maxItems)
 {
     if (!key.IsValid())
     {
         throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
     }
 
+    auto storage = std::make_shared<KeySnapshot::Storage>();
     DWORD valueCount = 0;
     DWORD maxValueNameLen = 0;
     DWORD maxValueDataLen = 0;
@@ -339,64 +723,144 @@ std::vector<RegValueRecord> EnumerateValues(RegistryKey const& key)
                                      &valueCount,
                                      &maxValueNameLen,
                                      &maxValueDataLen,
-                                     nullptr, nullptr);
+                                     nullptr,
+                                     &storage->lastWriteTime);
     if (status != ERROR_SUCCESS)
     {
         throw RegException(status, FormatWinErrorMessage(status));
     }
 
-    std::vector<RegValueRecord> result;
-    result.reserve(valueCount);
+    // As in EnumerateSubKeyNames: reserve from an average estimate and keep only the
+    // tail of each arena as wide as the largest name / value. Values are read into the tail
+    // of the data arena; small ones are then moved into their entry and the space reused.
+    constexpr DWORD AVERAGE_NAME_ESTIMATE = 24;
+    constexpr DWORD AVERAGE_DATA_ESTIMATE = 64;
+    constexpr int MAX_GROW_RETRIES = 8;
 
-    std::vector<wchar_t> nameBuffer(maxValueNameLen + 2);
-    std::vector<BYTE> dataBuffer(maxValueDataLen > 0 ? maxValueDataLen : 1);
+    constexpr size_t DATA_ALIGNMENT = 8;
 
-    for (DWORD index = 0; index < valueCount; ++index)
+    size_t expected = valueCount > offset ? valueCount - offset : 0;
+    if (maxItems > 0)
     {
-        DWORD nameLen = nameBuffer.size();
+        expected = std::min(expected, maxItems);
+    }
+
+    storage->entries.reserve(expected);
+    storage->names.reserve(expected * std::min(maxValueNameLen, AVERAGE_NAME_ESTIMATE) + maxValueNameLen + 1);
+    storage->data.reserve(expected * std::min(maxValueDataLen, AVERAGE_DATA_ESTIMATE) +
+                          maxValueDataLen + DATA_ALIGNMENT);
+
+    size_t namesUsed = 0;
+    size_t dataUsed = 0;
+    auto index = static_cast<DWORD>(offset);
+    int growRetries = 0;
+
+    while (maxItems == 0 || storage->entries.size() < maxItems)
+    {
+        // One spare byte keeps lpData non-null, so a value that appeared after
+        // RegQueryInfoKeyW reports ERROR_MORE_DATA instead of a bare size.
+        storage->names.resize(namesUsed + maxValueNameLen + 1);
+        storage->data.resize(dataUsed + maxValueDataLen + 1);
+
+        DWORD nameLen = maxValueNameLen + 1;
         DWORD type = 0;
-        DWORD dataSize = dataBuffer.size();
-
-        LSTATUS enumStatus = RegEnumValueW(key.Handle(),
-                                          index,
-                                          nameBuffer.data(),
-                                          &nameLen,
-                                          nullptr,
-                                          &type,
-                                          dataBuffer.data(),
-                                          &dataSize);
-
-        if (enumStatus == ERROR_MORE_DATA)
+        DWORD dataSize = maxValueDataLen + 1;
+
+        status = RegEnumValueW(key.Handle(),
+                               index,
+                               storage->names.data() + namesUsed,
+                               &nameLen,
+                               nullptr,
+                               &type,
+                               storage->data.data() + dataUsed,
+                               &dataSize);
+
+        if (status == ERROR_SUCCESS)
         {
-            dataBuffer.resize(dataSize);
-            dataSize = static_cast<DWORD>(dataBuffer.size());
-
-            enumStatus = RegEnumValueW(key.Handle(),
-                                      index,
-                                      nameBuffer.data(),
-                                      &nameLen,
-                                      nullptr,
-                                      &type,
-                                      dataBuffer.data(),
-                                      &dataSize);
+            KeySnapshot::Entry& entry = storage->entries.emplace_back();
+            entry.nameOffset = static_cast<std::uint32_t>(namesUsed);
+            entry.nameLength = static_cast<std::uint32_t>(nameLen);
+            entry.dataSize = static_cast<std::uint32_t>(dataSize);
+            entry.type = type;
+            if (dataSize <= KeySnapshot::kInlineDataSize)
+            {
+                std::copy_n(storage->data.data() + dataUsed, dataSize, entry.inlineData);
+            }
+            else
+            {
+                entry.dataOffset = static_cast<std::uint32_t>(dataUsed);
+                dataUsed = (dataUsed + dataSize + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+            }
+            namesUsed += nameLen;
+            ++index;
+            growRetries = 0;
         }
+        else if (status == ERROR_MORE_DATA)
+        {
+            // A longer name or value was written after RegQueryInfoKeyW; refresh the bounds.
+            if (++growRetries > MAX_GROW_RETRIES)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
 
-        if (enumStatus == ERROR_NO_MORE_ITEMS)
+            DWORD refreshedNameLen = 0;
+            DWORD refreshedDataLen = 0;
+            status = RegQueryInfoKeyW(key.Handle(),
+                                      nullptr, nullptr, nullptr,
+                                      nullptr, nullptr, nullptr, nullptr,
+                                      &refreshedNameLen,
+                                      &refreshedDataLen,
+                                      nullptr, nullptr);
+            if (status != ERROR_SUCCESS)
+            {
+                throw RegException(status, FormatWinErrorMessage(status));
+            }
+            maxValueNameLen = std::max({refreshedNameLen, maxValueNameLen + 1});
+            maxValueDataLen = std::max({refreshedDataLen, dataSize, maxValueDataLen + 1});
+        }
+        else if (status == ERROR_NO_MORE_ITEMS)
+        {
             break;
-
-        if (enumStatus != ERROR_SUCCESS)
+        }
+        else
         {
-            throw RegException(enumStatus, FormatWinErrorMessage(enumStatus));
+            throw RegException(status, FormatWinErrorMessage(status));
         }
+    }
 
-        result.emplace_back(RegValueRecord{
-            std::wstring(nameBuffer.data(), nameLen),
-            type,
-            std::vector(dataBuffer.begin(), dataBuffer.begin() + dataSize)
-        });
+    storage->names.resize(namesUsed);
+    storage->data.resize(dataUsed);
+
+    KeySnapshot snapshot;
+    snapshot.m_arena = std::move(storage);
+    return snapshot;
+}
+
+bool QuerySubKeyInfo(RegistryKey const& parent, SubKeyInfo& info)
+{
+    if (!parent.IsValid())
+    {
+        throw RegException(ERROR_INVALID_HANDLE, "Invalid registry key handle");
     }
 
-    return result;
+    HKEY child = nullptr;
+    LSTATUS status = RegOpenKeyExW(parent.Handle(), info.name.c_str(), 0, KEY_QUERY_VALUE, &child);
+    if (status != ERROR_SUCCESS)
+    {
+        return false;
+    }
+
+    status = RegQueryInfoKeyW(child,
+                              nullptr, nullptr, nullptr,
+                              &info.subKeyCount,
+                              nullptr, nullptr,
+                              &info.valueCount,
+                              nullptr, nullptr, nullptr,
+                              &info.lastWriteTime);
+    RegCloseKey(child);
+
+    info.hasInfo = (status == ERROR_SUCCESS);
+    return info.hasInfo;
 }
 
     void DeleteValue(RegistryKey const& key, std::wstring const& valueName)
@@ -527,7 +991,8 @@ HANDLE CreateRegistryChangeEvent(RegistryKey const& key,   const bool watchSubtr
     constexpr DWORD validFilters = REG_NOTIFY_CHANGE_NAME |
                                    REG_NOTIFY_CHANGE_ATTRIBUTES |
                                    REG_NOTIFY_CHANGE_LAST_SET |
-                                   REG_NOTIFY_CHANGE_SECURITY;
+                                   REG_NOTIFY_CHANGE_SECURITY |
+                                   REG_NOTIFY_THREAD_AGNOSTIC; // lets a pool thread own the watch
 
     if ((notifyFilter & ~validFilters) != 0)
     {
@@ -2,17 +2,26 @@
 #pragma once
 
 #include <windows.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "RegistryKey.h"
 
 namespace core::registry
 {
-struct RegValueRecord
+
+// A child key together with its own counts, as shown by tree views.
+struct SubKeyInfo
 {
     std::wstring name;
-    DWORD type;
-    std::vector<unsigned char> data;
+    DWORD subKeyCount = 0;
+    DWORD valueCount = 0;
+    FILETIME lastWriteTime = {};
+    bool hasInfo = false;        // false if the child could not be opened for query
 };
 
 std::wstring ReadStringValue(RegistryKey const& key, std::wstring const& valueName);
@@ -31,9 +40,173 @@ void SetQwordValue(RegistryKey const& key, std::wstring const& valueName, unsign
 
 void SetBinaryValue(RegistryKey const& key, std::wstring const& valueName, std::vector<unsigned char> const& data);
 
+/**
+ * SubKeyList - names of a key's children packed into one contiguous arena.
+ *
+ * Produced by EnumerateSubKeyNames(). Name(i) views point into the arena and stay
+ * valid for the lifetime of the list (they are not null-terminated).
+ */
+class SubKeyList
+{
+public:
+    struct Entry
+    {
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        FILETIME lastWriteTime = {};
+    };
+
+    [[nodiscard]] std::size_t Size() const noexcept { return m_entries.size(); }
+    [[nodiscard]] bool Empty() const noexcept { return m_entries.empty(); }
+
+    [[nodiscard]] std::wstring_view Name(std::size_t index) const noexcept
+    {
+        const Entry& entry = m_entries[index];
+        return {m_names.data() + entry.offset, entry.length};
+    }
+
+    [[nodiscard]] FILETIME LastWriteTime(std::size_t index) const noexcept
+    {
+        return m_entries[index].lastWriteTime;
+    }
+
+private:
+    friend SubKeyList EnumerateSubKeyNames(RegistryKey const& key);
+
+    std::vector<wchar_t> m_names;
+    std::vector<Entry> m_entries;
+};
+
+// Single pass sized by RegQueryInfoKeyW; no per-child allocations.
+SubKeyList EnumerateSubKeyNames(RegistryKey const& key);
+
 std::vector<std::wstring>EnumerateSubKeys(RegistryKey const& key);
 
-std::vector<RegValueRecord>EnumerateValues(RegistryKey const& key);
+// Borrowed view of one value; name and data are only valid during the visitor call.
+struct RegValueView
+{
+    std::wstring_view name;
+    DWORD type = 0;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    [[nodiscard]] std::span<const unsigned char> Bytes() const noexcept { return {data, size}; }
+};
+
+// One requested value of a QueryMultipleValues() call, in request order.
+struct ValueReadResult
+{
+    std::wstring name;
+    LSTATUS status = ERROR_FILE_NOT_FOUND;      // ERROR_SUCCESS when the value was read
+    DWORD type = REG_NONE;
+    std::vector<unsigned char> data;
+
+    [[nodiscard]] bool Found() const noexcept { return status == ERROR_SUCCESS; }
+};
+
+/**
+ * Reads the named values of key with one RegQueryMultipleValuesW call. If that call
+ * fails as a whole (a value is missing, or the data exceeds its 1 MB limit) the values
+ * are read one by one and each result carries its own status. Never throws for a
+ * missing value; throws RegException for an invalid key.
+ */
+std::vector<ValueReadResult> QueryMultipleValues(RegistryKey const& key, std::vector<std::wstring> const& names);
+
+// One value read with RegQueryValueExW: the stored type and raw bytes, or the status if missing.
+// Throws RegException only for an invalid key.
+ValueReadResult QueryValue(RegistryKey const& key, std::wstring const& name);
+
+/**
+ * Text of raw REG_SZ / REG_EXPAND_SZ data as ReadStringValue returns it: one trailing
+ * terminator dropped and REG_EXPAND_SZ expanded. Throws RegException(ERROR_UNSUPPORTED_TYPE)
+ * for any other type.
+ */
+std::wstring StringFromValueData(DWORD type, std::span<const unsigned char> data);
+
+/**
+ * KeySnapshot - the values of a key (all of them, or one page) plus its last-write time.
+ *
+ * Produced by ReadKeySnapshot(). Names and data are packed into one shared arena sized from
+ * RegQueryInfoKeyW; data of up to kInlineDataSize bytes (REG_DWORD, REG_QWORD) is kept in
+ * the entry itself. Value(i) views stay valid while any copy of the snapshot, or any holder
+ * of Arena(), is alive. Copies share the arena; nothing is modified after ReadKeySnapshot().
+ */
+class KeySnapshot
+{
+public:
+    static constexpr std::size_t kInlineDataSize = 8;
+
+    struct Entry
+    {
+        std::uint32_t nameOffset = 0;
+        std::uint32_t nameLength = 0;
+        std::uint32_t dataOffset = 0;           // into the data arena; unused for inline data
+        std::uint32_t dataSize = 0;
+        DWORD type = REG_NONE;
+        alignas(8) unsigned char inlineData[kInlineDataSize] = {};
+    };
+
+    [[nodiscard]] std::size_t Size() const noexcept { return m_arena ? m_arena->entries.size() : 0; }
+    [[nodiscard]] bool Empty() const noexcept { return Size() == 0; }
+    [[nodiscard]] FILETIME LastWriteTime() const noexcept { return m_arena ? m_arena->lastWriteTime : FILETIME{}; }
+
+    [[nodiscard]] std::wstring_view Name(std::size_t index) const noexcept
+    {
+        const Entry& entry = m_arena->entries[index];
+        return {m_arena->names.data() + entry.nameOffset, entry.nameLength};
+    }
+
+    // Data is 8-byte aligned, whether inline or in the arena.
+    [[nodiscard]] std::span<const unsigned char> Data(std::size_t index) const noexcept
+    {
+        const Entry& entry = m_arena->entries[index];
+        return {entry.dataSize <= kInlineDataSize ? entry.inlineData : m_arena->data.data() + entry.dataOffset,
+                entry.dataSize};
+    }
+
+    [[nodiscard]] RegValueView Value(std::size_t index) const noexcept
+    {
+        const std::span<const unsigned char> data = Data(index);
+        return RegValueView{Name(index), m_arena->entries[index].type, data.data(), data.size()};
+    }
+
+    // Owner of every Value(i) name and data pointer; lets caches keep the bytes without copying.
+    [[nodiscard]] std::shared_ptr<const void> Arena() const noexcept { return m_arena; }
+
+private:
+    friend KeySnapshot ReadKeySnapshot(RegistryKey const& key, size_t offset, size_t maxItems);
+
+    struct Storage
+    {
+        std::vector<wchar_t> names;
+        std::vector<unsigned char> data;
+        std::vector<Entry> entries;
+        FILETIME lastWriteTime = {};
+    };
+
+    std::shared_ptr<const Storage> m_arena;
+};
+
+// Single pass sized by RegQueryInfoKeyW, which also supplies the last-write time. Starts at
+// value index 'offset' and keeps at most 'maxItems' values (0 = no limit).
+KeySnapshot ReadKeySnapshot(RegistryKey const& key, size_t offset = 0, size_t maxItems = 0);
+
+// Visitors return false to stop the enumeration early.
+using SubKeyVisitor = std::function<bool(std::wstring_view name, FILETIME const& lastWriteTime)>;
+using ValueVisitor = std::function<bool(RegValueView const& value)>;
+
+/**
+ * Streaming enumeration: starts at index 'offset', yields at most 'maxItems'
+ * entries (0 = no limit) one at a time from a single reused buffer.
+ * Returns the number of entries passed to the visitor.
+ */
+size_t ForEachSubKey(RegistryKey const& key, size_t offset, size_t maxItems, SubKeyVisitor const& visit);
+
+size_t ForEachValue(RegistryKey const& key, size_t offset, size_t maxItems, ValueVisitor const& visit);
+
+// Opens parent\info.name with KEY_QUERY_VALUE and fills its counts. Returns false (and leaves
+// hasInfo unset) if the child cannot be opened, e.g. for lack of access.
+bool QuerySubKeyInfo(RegistryKey const& parent, SubKeyInfo& info);
 
 void DeleteValue(RegistryKey const& key, std::wstring const& valueName);
 
@@ -0,0 +1,608 @@
+// RegistrySearch.cpp
+#include "RegistrySearch.h"
+#include "RegistryCache.h"
+#include "RegistryHelpers.h"
+#include "SearchIndex.h"
+#include "TreeWalkQueue.h"
+#include "Utf16Matcher.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace core::registry
+{
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr REGSAM kViewMask = KEY_WOW64_32KEY | KEY_WOW64_64KEY;
+
+    struct SearchItem
+    {
+        HKEY root = nullptr;
+        std::wstring path;
+        FILETIME lastWriteTime = {};
+        bool timeKnown = false;                         // from the parent's enumeration
+        SearchIndex::NodeId node = SearchIndex::kNoNode;
+        std::shared_ptr<const std::wstring> parentName; // kernel name of the parent, if known
+    };
+
+    bool IsStringType(const DWORD type) noexcept
+    {
+        return type == REG_SZ || type == REG_EXPAND_SZ || type == REG_MULTI_SZ;
+    }
+
+    // String data without its terminating null(s).
+    std::wstring_view DataText(const unsigned char* data, const size_t size) noexcept
+    {
+        std::wstring_view text(reinterpret_cast<const wchar_t*>(data), size / sizeof(wchar_t));
+        while (!text.empty() && text.back() == L'\0')
+        {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    bool QueryValueText(RegistryKey const& key, std::wstring const& name, std::wstring& text)
+    {
+        std::vector<unsigned char> buffer(4096);
+        for (;;)
+        {
+            DWORD type = 0;
+            auto size = static_cast<DWORD>(buffer.size());
+            const LSTATUS status = RegQueryValueExW(key.Handle(), name.c_str(), nullptr, &type, buffer.data(), &size);
+            if (status == ERROR_MORE_DATA)
+            {
+                buffer.resize(size);
+                continue;
+            }
+            if (status != ERROR_SUCCESS || !IsStringType(type))
+            {
+                return false;
+            }
+            text.assign(DataText(buffer.data(), size));
+            return true;
+        }
+    }
+
+    // Kernel object name of an open key (\REGISTRY\MACHINE\SYSTEM\ControlSet001), which is
+    // where the key really lives once symbolic links and redirection are resolved. NtQueryKey
+    // is the only way to get it; empty if ntdll does not export it or the call fails.
+    std::wstring KernelKeyName(HKEY key)
+    {
+        using NtQueryKeyFn = LONG(NTAPI*)(HANDLE, int, PVOID, ULONG, PULONG);
+        constexpr int kKeyNameInformation = 3;
+        static const auto ntQueryKey = reinterpret_cast<NtQueryKeyFn>(
+            reinterpret_cast<void*>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryKey")));
+        if (ntQueryKey == nullptr)
+        {
+            return {};
+        }
+
+        // KEY_NAME_INFORMATION: a ULONG byte length followed by the (unterminated) name.
+        std::vector<ULONG> buffer(256);
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            ULONG needed = 0;
+            const auto bytes = static_cast<ULONG>(buffer.size() * sizeof(ULONG));
+            if (ntQueryKey(key, kKeyNameInformation, buffer.data(), bytes, &needed) >= 0)
+            {
+                const auto* name = reinterpret_cast<const wchar_t*>(buffer.data() + 1);
+                return std::wstring(name, std::min<ULONG>(buffer[0], bytes - sizeof(ULONG)) / sizeof(wchar_t));
+            }
+            if (needed <= bytes)
+            {
+                break;
+            }
+            buffer.resize(needed / sizeof(ULONG) + 1);
+        }
+        return {};
+    }
+
+    std::wstring ScopeKernelName(HKEY root, std::wstring const& path, const REGSAM samView)
+    {
+        if (!path.empty())
+        {
+            HKEY key = nullptr;
+            if (RegOpenKeyExW(root, path.c_str(), 0, KEY_READ | samView, &key) != ERROR_SUCCESS)
+            {
+                return {};
+            }
+            std::wstring name = KernelKeyName(key);
+            RegCloseKey(key);
+            return name;
+        }
+
+        if (root == HKEY_LOCAL_MACHINE)
+        {
+            return L"\\REGISTRY\\MACHINE";
+        }
+        if (root == HKEY_USERS)
+        {
+            return L"\\REGISTRY\\USER";
+        }
+        if (root == HKEY_CURRENT_USER)
+        {
+            HKEY key = nullptr;
+            if (RegOpenCurrentUser(KEY_READ, &key) != ERROR_SUCCESS)
+            {
+                return {};
+            }
+            std::wstring name = KernelKeyName(key);
+            RegCloseKey(key);
+            return name;
+        }
+        return {}; // HKEY_CLASSES_ROOT is a merged view, HKEY_CURRENT_CONFIG a link
+    }
+
+    bool EqualsIgnoreCase(std::wstring_view a, std::wstring_view b) noexcept
+    {
+        return a.size() == b.size() &&
+               (a.empty() || CompareStringOrdinal(a.data(), static_cast<int>(a.size()),
+                                                  b.data(), static_cast<int>(b.size()), TRUE) == CSTR_EQUAL);
+    }
+
+    // True if name is ancestor itself or a key below it.
+    bool IsAtOrBelow(std::wstring_view name, std::wstring_view ancestor) noexcept
+    {
+        return !ancestor.empty() && name.size() >= ancestor.size() &&
+               EqualsIgnoreCase(name.substr(0, ancestor.size()), ancestor) &&
+               (name.size() == ancestor.size() || name[ancestor.size()] == L'\\');
+    }
+
+    bool IsSymbolicLink(HKEY root, std::wstring const& path, const REGSAM samView)
+    {
+        HKEY link = nullptr;
+        if (RegOpenKeyExW(root, path.c_str(), REG_OPTION_OPEN_LINK, KEY_QUERY_VALUE | samView, &link) != ERROR_SUCCESS)
+        {
+            return false;
+        }
+        DWORD type = 0;
+        const LSTATUS status = RegQueryValueExW(link, L"SymbolicLinkValue", nullptr, &type, nullptr, nullptr);
+        RegCloseKey(link);
+        return status == ERROR_SUCCESS && type == REG_LINK;
+    }
+
+    SearchIndex::NodeId IndexNodeFor(SearchIndex* index, HKEY root, std::wstring const& path)
+    {
+        if (index == nullptr)
+        {
+            return SearchIndex::kNoNode;
+        }
+
+        SearchIndex::NodeId node = index->RootNode(root);
+        size_t begin = 0;
+        while (node != SearchIndex::kNoNode && begin < path.size())
+        {
+            size_t end = path.find(L'\\', begin);
+            if (end == std::wstring::npos)
+            {
+                end = path.size();
+            }
+            if (end > begin)
+            {
+                node = index->ChildNode(node, std::wstring_view(path).substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        return node;
+    }
+
+    struct SearchState
+    {
+        SearchQuery const& query;
+        SearchOptions const& options;
+        SearchHitSink const& sink;
+        Utf16Matcher matcher;
+        REGSAM samView = 0;
+
+        TreeWalkQueue<SearchItem> queue;
+
+        // Kernel names of the scopes, and of the link targets already walked (folded).
+        std::vector<std::wstring> scopeNames;
+        std::mutex linksMutex;
+        std::unordered_set<std::wstring> linkTargets;
+
+        std::mutex sinkMutex;
+        size_t delivered = 0;       // guarded by sinkMutex
+
+        // query, options and sink belong to the caller; walkers may only touch them between
+        // Enter() and Leave(), and Close() waits for that before SearchRegistry returns.
+        std::mutex walkersMutex;
+        std::condition_variable walkersCv;
+        size_t walkers = 0;
+        bool closed = false;
+
+        std::atomic<size_t> keysScanned{ 0 };
+        std::atomic<size_t> keysFromIndex{ 0 };
+        std::atomic<size_t> valuesScanned{ 0 };
+        std::atomic<size_t> hits{ 0 };
+        std::atomic<size_t> keysFailed{ 0 };
+        std::atomic<size_t> linksSkipped{ 0 };
+
+        SearchState(SearchQuery const& q, SearchOptions const& o, SearchHitSink const& s)
+            : query(q)
+            , options(o)
+            , sink(s)
+            , matcher(q.pattern, q.caseSensitive)
+            , samView(o.samView & kViewMask)
+        {
+        }
+
+        bool Enter()
+        {
+            std::lock_guard lock(walkersMutex);
+            if (closed)
+            {
+                return false;
+            }
+            ++walkers;
+            return true;
+        }
+
+        void Leave()
+        {
+            {
+                std::lock_guard lock(walkersMutex);
+                --walkers;
+            }
+            walkersCv.notify_all();
+        }
+
+        void Close()
+        {
+            std::unique_lock lock(walkersMutex);
+            closed = true;
+            walkersCv.wait(lock, [this] { return walkers == 0; });
+        }
+
+        // A key reached through a symbolic link is walked only if its target lies outside
+        // every scope, and then only through the first link that reaches it.
+        bool ClaimLinkTarget(std::wstring const& target)
+        {
+            for (std::wstring const& scope : scopeNames)
+            {
+                if (IsAtOrBelow(target, scope))
+                {
+                    return false;
+                }
+            }
+            std::lock_guard lock(linksMutex);
+            return linkTargets.insert(FoldRegistryName(target)).second;
+        }
+
+        [[nodiscard]] bool ShouldStop() const noexcept
+        {
+            return options.stop.stop_requested() ||
+                   (options.maxHits != 0 && hits.load(std::memory_order_relaxed) >= options.maxHits);
+        }
+
+        // Hands a walker's hits to the sink, trimmed so that no more than maxHits are delivered.
+        void Deliver(std::vector<SearchHit>& batch)
+        {
+            if (batch.empty())
+            {
+                return;
+            }
+
+            std::lock_guard lock(sinkMutex);
+            if (options.maxHits != 0)
+            {
+                const size_t room = options.maxHits > delivered ? options.maxHits - delivered : 0;
+                if (batch.size() > room)
+                {
+                    batch.resize(room);
+                }
+            }
+            delivered += batch.size();
+            if (!batch.empty() && sink)
+            {
+                sink(batch);
+            }
+            batch.clear();
+        }
+    };
+
+    // Per-walker hit buffer, see SearchOptions::batchSize / flushInterval.
+    class HitBuffer
+    {
+    public:
+        explicit HitBuffer(SearchState& state)
+            : m_state(state)
+        {}
+
+        void Add(HKEY root, std::wstring const& keyPath, std::wstring_view valueName, const SearchHitKind kind)
+        {
+            if (m_hits.empty())
+            {
+                m_oldest = Clock::now();
+            }
+            m_hits.push_back(SearchHit{ root, keyPath, std::wstring(valueName), kind });
+            m_state.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void FlushIfDue()
+        {
+            if (!m_hits.empty() &&
+                (m_hits.size() >= m_state.options.batchSize || Clock::now() - m_oldest >= m_state.options.flushInterval))
+            {
+                m_state.Deliver(m_hits);
+            }
+        }
+
+        void Flush()
+        {
+            m_state.Deliver(m_hits);
+        }
+
+    private:
+        SearchState& m_state;
+        std::vector<SearchHit> m_hits;
+        Clock::time_point m_oldest;
+    };
+
+    // Returns true if the key's values were answered by the index.
+    bool MatchValuesFromIndex(SearchState& state, SearchItem const& item, RegistryKey const& key, HitBuffer& hits)
+    {
+        SearchQuery const& query = state.query;
+        std::vector<std::wstring> reread; // read from the registry after the index lock is released
+        size_t visited = 0;
+
+        const bool answered = state.options.index->VisitValues(item.node, item.lastWriteTime,
+            [&](SearchIndex::ValueEntry const& value) {
+                ++visited;
+                if (query.matchValueNames && state.matcher.Find(value.name))
+                {
+                    hits.Add(item.root, item.path, value.name, SearchHitKind::ValueName);
+                }
+                else if (query.matchData && IsStringType(value.type))
+                {
+                    if (state.matcher.Find(value.text))
+                    {
+                        hits.Add(item.root, item.path, value.name, SearchHitKind::ValueData);
+                    }
+                    else if (!value.textComplete)
+                    {
+                        reread.push_back(value.name);
+                    }
+                }
+            });
+        if (!answered)
+        {
+            return false;
+        }
+
+        std::wstring text;
+        for (std::wstring const& name : reread)
+        {
+            if (QueryValueText(key, name, text) && state.matcher.Find(text))
+            {
+                hits.Add(item.root, item.path, name, SearchHitKind::ValueData);
+            }
+        }
+
+        state.valuesScanned.fetch_add(visited, std::memory_order_relaxed);
+        state.keysFromIndex.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void MatchValuesFromRegistry(SearchState& state, SearchItem const& item, RegistryKey const& key, HitBuffer& hits)
+    {
+        SearchQuery const& query = state.query;
+        SearchIndex* index = state.options.index;
+        const bool record = index != nullptr && item.node != SearchIndex::kNoNode && item.timeKnown;
+
+        std::vector<SearchIndex::ValueEntry> entries;
+        const size_t visited = ForEachValue(key, 0, 0, [&](RegValueView const& value) {
+            const bool isString = IsStringType(value.type);
+            const std::wstring_view text = isString ? DataText(value.data, value.size) : std::wstring_view();
+
+            if (query.matchValueNames && state.matcher.Find(value.name))
+            {
+                hits.Add(item.root, item.path, value.name, SearchHitKind::ValueName);
+            }
+            else if (query.matchData && isString && state.matcher.Find(text))
+            {
+                hits.Add(item.root, item.path, value.name, SearchHitKind::ValueData);
+            }
+
+            if (record)
+            {
+                SearchIndex::ValueEntry entry;
+                entry.name.assign(value.name);
+                entry.type = value.type;
+                entry.textComplete = text.size() <= SearchIndex::kMaxIndexedText;
+                entry.text.assign(text.substr(0, SearchIndex::kMaxIndexedText));
+                entries.push_back(std::move(entry));
+            }
+            return !state.ShouldStop();
+        });
+
+        if (record && !state.ShouldStop())
+        {
+            index->Update(item.node, item.lastWriteTime, std::move(entries));
+        }
+
+        state.valuesScanned.fetch_add(visited, std::memory_order_relaxed);
+        state.keysScanned.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void ScanKey(SearchState& state, SearchItem& item, HitBuffer& hits, std::vector<SearchItem>& children)
+    {
+        SearchQuery const& query = state.query;
+        SearchIndex* index = state.options.index;
+
+        const RegistryKey key = item.path.empty() ? RegistryKey(item.root, false)
+                                                  : RegistryKey::Open(item.root, item.path, KEY_READ | state.samView);
+
+        // A child whose kernel name is not its parent's plus its own is a symbolic link
+        // (CurrentControlSet, HKCU\Software\Classes) or redirected by WOW64; only the
+        // former would repeat hits that the walk finds elsewhere.
+        std::wstring kernelName = item.path.empty() ? ScopeKernelName(item.root, item.path, state.samView)
+                                                    : KernelKeyName(key.Handle());
+        if (item.parentName && !kernelName.empty())
+        {
+            std::wstring_view parentName = *item.parentName;
+            std::wstring_view ownName = std::wstring_view(item.path).substr(item.path.rfind(L'\\') + 1);
+            const bool direct = kernelName.size() == parentName.size() + 1 + ownName.size() &&
+                                kernelName[parentName.size()] == L'\\' &&
+                                EqualsIgnoreCase(std::wstring_view(kernelName).substr(0, parentName.size()), parentName) &&
+                                EqualsIgnoreCase(std::wstring_view(kernelName).substr(parentName.size() + 1), ownName);
+            if (!direct && IsSymbolicLink(item.root, item.path, state.samView) && !state.ClaimLinkTarget(kernelName))
+            {
+                state.linksSkipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        if (!item.timeKnown && index != nullptr)
+        {
+            item.timeKnown = RegQueryInfoKeyW(key.Handle(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                                              nullptr, nullptr, nullptr, nullptr, &item.lastWriteTime) == ERROR_SUCCESS;
+        }
+
+        if (query.matchValueNames || query.matchData)
+        {
+            const bool fromIndex = index != nullptr && item.timeKnown && MatchValuesFromIndex(state, item, key, hits);
+            if (!fromIndex)
+            {
+                MatchValuesFromRegistry(state, item, key, hits);
+            }
+        }
+
+        const SubKeyList subKeys = EnumerateSubKeyNames(key);
+        const auto childParentName = kernelName.empty() || subKeys.Size() == 0
+                                         ? std::shared_ptr<const std::wstring>()
+                                         : std::make_shared<const std::wstring>(std::move(kernelName));
+        children.reserve(subKeys.Size());
+        for (size_t i = 0; i < subKeys.Size(); ++i)
+        {
+            const std::wstring_view name = subKeys.Name(i);
+
+            SearchItem child;
+            child.root = item.root;
+            child.path.reserve(item.path.size() + 1 + name.size());
+            if (!item.path.empty())
+            {
+                child.path.append(item.path).append(1, L'\\');
+            }
+            child.path.append(name);
+            child.lastWriteTime = subKeys.LastWriteTime(i);
+            child.timeKnown = true;
+            child.node = index != nullptr ? index->ChildNode(item.node, name) : SearchIndex::kNoNode;
+            child.parentName = childParentName;
+
+            if (query.matchKeyNames && state.matcher.Find(name))
+            {
+                hits.Add(child.root, child.path, std::wstring_view(), SearchHitKind::KeyName);
+            }
+            children.push_back(std::move(child));
+        }
+    }
+
+    void RunWalker(SearchState& state)
+    {
+        if (!state.Enter())
+        {
+            return; // started after the search was over
+        }
+
+        HitBuffer hits(state);
+        SearchItem item;
+        while (state.queue.Take(item))
+        {
+            std::vector<SearchItem> children;
+            try
+            {
+                ScanKey(state, item, hits, children);
+            }
+            catch (const std::exception&)
+            {
+                state.keysFailed.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (state.ShouldStop())
+            {
+                state.queue.Stop();
+            }
+            state.queue.Finish(children);
+
+            hits.FlushIfDue();
+        }
+        hits.Flush();
+
+        state.Leave();
+    }
+
+} // anonymous namespace
+
+SearchStats SearchRegistry(SearchQuery const& query, SearchOptions const& options, SearchHitSink const& sink)
+{
+    SearchStats stats;
+    if (query.pattern.empty())
+    {
+        return stats;
+    }
+
+    std::vector<std::pair<HKEY, std::wstring>> scopes = query.scopes;
+    if (scopes.empty())
+    {
+        scopes = { { HKEY_CURRENT_USER, std::wstring() }, { HKEY_LOCAL_MACHINE, std::wstring() } };
+    }
+
+    auto state = std::make_shared<SearchState>(query, options, sink);
+
+    std::vector<SearchItem> roots;
+    roots.reserve(scopes.size());
+    for (auto& [root, path] : scopes)
+    {
+        std::wstring scopeName = ScopeKernelName(root, path, state->samView);
+        if (!scopeName.empty())
+        {
+            state->scopeNames.push_back(std::move(scopeName));
+        }
+
+        SearchItem item;
+        item.root = root;
+        item.path = path;
+        item.node = IndexNodeFor(options.index, root, path);
+        roots.push_back(std::move(item));
+    }
+    state->queue.Seed(roots);
+
+    // Late helpers find the search closed and return; nobody waits for them to be scheduled.
+    // The state is shared because they may start after this call returned.
+    const size_t helpers = options.threadManager != nullptr ? std::max<size_t>(options.maxConcurrency, 1) - 1 : 0;
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        try
+        {
+            options.threadManager->enqueue([state]() { RunWalker(*state); }, options.priority);
+        }
+        catch (const std::exception&)
+        {
+            break; // pool is shutting down; the caller walks alone
+        }
+    }
+
+    RunWalker(*state);
+    state->Close();
+
+    stats.keysScanned = state->keysScanned.load(std::memory_order_relaxed);
+    stats.keysFromIndex = state->keysFromIndex.load(std::memory_order_relaxed);
+    stats.valuesScanned = state->valuesScanned.load(std::memory_order_relaxed);
+    stats.keysFailed = state->keysFailed.load(std::memory_order_relaxed);
+    stats.linksSkipped = state->linksSkipped.load(std::memory_order_relaxed);
+    stats.cancelled = options.stop.stop_requested();
+    {
+        std::lock_guard lock(state->sinkMutex);
+        stats.hits = state->delivered;
+    }
+    return stats;
+}
+
+} // namespace core::registry
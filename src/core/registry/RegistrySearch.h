@@ -0,0 +1,98 @@
+// RegistrySearch.h
+#pragma once
+
+#include <windows.h>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <utility>
+#include <vector>
+#include "IThreadManager.h"
+
+namespace core::registry
+{
+
+class SearchIndex;
+
+struct SearchQuery
+{
+    std::wstring pattern;           // literal substring
+    bool matchKeyNames = true;
+    bool matchValueNames = true;
+    bool matchData = true;          // data of REG_SZ, REG_EXPAND_SZ and REG_MULTI_SZ values
+    bool caseSensitive = false;
+
+    // Subtrees to search. Empty means HKEY_CURRENT_USER and HKEY_LOCAL_MACHINE; the other
+    // predefined roots are views of these two (or of HKEY_USERS) and would repeat their hits.
+    std::vector<std::pair<HKEY, std::wstring>> scopes;
+};
+
+enum class SearchHitKind
+{
+    KeyName,
+    ValueName,
+    ValueData
+};
+
+struct SearchHit
+{
+    HKEY root = nullptr;
+    std::wstring keyPath;           // the matching key, or the key holding the matching value
+    std::wstring valueName;         // empty for KeyName hits
+    SearchHitKind kind = SearchHitKind::KeyName;
+};
+
+// Receives hits in batches, never from two threads at once; it may move the hits out.
+using SearchHitSink = std::function<void(std::vector<SearchHit>& hits)>;
+
+struct SearchOptions
+{
+    // Pool used for helper walkers; with nullptr the search runs on the calling thread only.
+    IThreadManager* threadManager = nullptr;
+    IThreadManager::TaskPriority priority = IThreadManager::TaskPriority::Background;
+    size_t maxConcurrency = 4;      // walkers, the calling thread included
+
+    // A walker hands its hits to the sink once it holds batchSize of them, or flushInterval
+    // after the oldest one was found, whichever comes first.
+    size_t batchSize = 64;
+    std::chrono::milliseconds flushInterval{ 50 };
+
+    size_t maxHits = 0;             // stop after this many hits; 0 = no limit
+    REGSAM samView = 0;             // KEY_WOW64_32KEY / KEY_WOW64_64KEY
+    std::stop_token stop;
+
+    // Optional; unchanged keys are answered from it and scanned keys are recorded in it.
+    SearchIndex* index = nullptr;
+};
+
+struct SearchStats
+{
+    size_t keysScanned = 0;         // keys whose values were read from the registry
+    size_t keysFromIndex = 0;       // keys whose values came from the index
+    size_t valuesScanned = 0;
+    size_t hits = 0;
+    size_t keysFailed = 0;          // keys that could not be opened or enumerated
+    size_t linksSkipped = 0;        // symbolic links not followed, their target being searched anyway
+    bool cancelled = false;
+};
+
+/**
+ * SearchRegistry - finds key names, value names and string data containing query.pattern.
+ *
+ * The scopes are walked by the calling thread and up to maxConcurrency - 1 pool tasks sharing
+ * a queue of pending keys, so the hives are split across the pool key by key. Each key's
+ * children come from one EnumerateSubKeyNames pass, which also yields their last-write times
+ * for the index check. Matching uses Utf16Matcher.
+ *
+ * Registry symbolic links (HKLM\SYSTEM\CurrentControlSet) are not followed when their
+ * target is inside a scope, so each key is reported once, under its real path; a target
+ * outside every scope (HKCU\Software\Classes) is walked through the first link to it.
+ *
+ * Returns once every walker is done, after the last hits were passed to the sink. Keys that
+ * cannot be read (access denied, deleted meanwhile) are counted and skipped.
+ */
+SearchStats SearchRegistry(SearchQuery const& query, SearchOptions const& options, SearchHitSink const& sink);
+
+} // namespace core::registry
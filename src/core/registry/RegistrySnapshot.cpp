@@ -0,0 +1,790 @@
+// RegistrySnapshot.cpp
+#include "RegistrySnapshot.h"
+#include "RegistryCache.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace core::registry
+{
+
+namespace detail
+{
+
+struct SnapshotKeyRecord
+{
+    std::uint32_t name;
+    std::uint32_t foldedName;
+    std::uint32_t parent;
+    std::uint32_t firstChild;
+    std::uint32_t childCount;
+    std::uint32_t firstValue;
+    std::uint32_t valueCount;
+    std::uint32_t flags;
+    std::uint64_t lastWriteTime;
+};
+
+struct SnapshotValueRecord
+{
+    std::uint32_t name;
+    std::uint32_t foldedName;
+    std::uint32_t type;
+    std::uint32_t dataSize;
+    std::uint64_t dataOffset;
+};
+
+struct SnapshotStringRecord
+{
+    std::uint32_t offset;           // code units into the string data
+    std::uint32_t length;
+};
+
+} // namespace detail
+
+namespace {
+
+    const HKEY kRoots[] = {
+        HKEY_CLASSES_ROOT, HKEY_CURRENT_USER, HKEY_LOCAL_MACHINE,
+        HKEY_USERS, HKEY_CURRENT_CONFIG
+    };
+    constexpr std::uint32_t kRootCount = sizeof(kRoots) / sizeof(kRoots[0]);
+    constexpr std::uint32_t kNoHive = 0xFFFFFFFFu;
+
+    constexpr std::uint32_t kMagic = 0x504E5352; // "RSNP"
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::uint32_t kKeyUnreadable = 0x1;
+    constexpr REGSAM kViewMask = KEY_WOW64_32KEY | KEY_WOW64_64KEY;
+
+    struct FileHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t keyCount;
+        std::uint32_t valueCount;
+        std::uint32_t stringCount;
+        std::uint32_t sourceHive;           // index into kRoots, kNoHive if not predefined
+        std::uint32_t sourcePath;           // string id
+        std::uint32_t charSize;             // sizeof(wchar_t) of the writer
+        std::uint64_t capturedAt;
+        std::uint64_t keysOffset;
+        std::uint64_t valuesOffset;
+        std::uint64_t stringsOffset;
+        std::uint64_t textOffset;
+        std::uint64_t textUnits;
+        std::uint64_t dataOffset;
+        std::uint64_t dataBytes;
+        std::uint64_t fileBytes;
+    };
+
+    ULONGLONG ToTicks(FILETIME const& time) noexcept
+    {
+        return (static_cast<ULONGLONG>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    }
+
+    FILETIME FromTicks(const std::uint64_t ticks) noexcept
+    {
+        FILETIME time;
+        time.dwLowDateTime = static_cast<DWORD>(ticks & 0xFFFFFFFFu);
+        time.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+        return time;
+    }
+
+    std::uint64_t AlignUp(const std::uint64_t value) noexcept
+    {
+        return (value + 7) & ~static_cast<std::uint64_t>(7);
+    }
+
+    std::wstring JoinPath(std::wstring const& base, std::wstring_view relative)
+    {
+        if (base.empty())
+        {
+            return std::wstring(relative);
+        }
+        std::wstring path = base;
+        path += L'\\';
+        path.append(relative);
+        return path;
+    }
+
+    template <typename Visit>
+    void ForEachComponent(std::wstring_view path, Visit&& visit)
+    {
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            const size_t end = std::min(path.find(L'\\', start), path.size());
+            if (end > start && !visit(path.substr(start, end - start)))
+            {
+                return;
+            }
+            start = end + 1;
+        }
+    }
+
+    // In-memory form of a snapshot file while it is being captured.
+    class SnapshotBuilder
+    {
+    public:
+        using Key = detail::SnapshotKeyRecord;
+        using Value = detail::SnapshotValueRecord;
+
+        std::uint32_t Intern(std::wstring_view text)
+        {
+            std::wstring key(text);
+            const auto it = m_stringIds.find(key);
+            if (it != m_stringIds.end())
+            {
+                return it->second;
+            }
+
+            const auto id = static_cast<std::uint32_t>(m_strings.size());
+            m_strings.push_back({static_cast<std::uint32_t>(m_text.size()), static_cast<std::uint32_t>(text.size())});
+            m_text.insert(m_text.end(), text.begin(), text.end());
+            m_stringIds.emplace(std::move(key), id);
+            return id;
+        }
+
+        // Identical data (defaults, flags, common paths) is stored once.
+        std::uint64_t AddData(const unsigned char* data, const size_t size)
+        {
+            std::string key(reinterpret_cast<const char*>(data), size);
+            const auto it = m_dataOffsets.find(key);
+            if (it != m_dataOffsets.end())
+            {
+                return it->second;
+            }
+
+            const std::uint64_t offset = m_data.size();
+            m_data.insert(m_data.end(), data, data + size);
+            m_dataOffsets.emplace(std::move(key), offset);
+            return offset;
+        }
+
+        std::vector<Key> keys;
+        std::vector<Value> values;
+
+        std::vector<unsigned char> Serialize(const std::uint32_t sourceHive, const std::uint32_t sourcePath,
+                                             const std::uint64_t capturedAt) const
+        {
+            FileHeader header{};
+            header.magic = kMagic;
+            header.version = kVersion;
+            header.keyCount = static_cast<std::uint32_t>(keys.size());
+            header.valueCount = static_cast<std::uint32_t>(values.size());
+            header.stringCount = static_cast<std::uint32_t>(m_strings.size());
+            header.sourceHive = sourceHive;
+            header.sourcePath = sourcePath;
+            header.charSize = sizeof(wchar_t);
+            header.capturedAt = capturedAt;
+            header.keysOffset = AlignUp(sizeof(FileHeader));
+            header.valuesOffset = AlignUp(header.keysOffset + keys.size() * sizeof(Key));
+            header.stringsOffset = AlignUp(header.valuesOffset + values.size() * sizeof(Value));
+            header.textOffset = AlignUp(header.stringsOffset + m_strings.size() * sizeof(detail::SnapshotStringRecord));
+            header.textUnits = m_text.size();
+            header.dataOffset = AlignUp(header.textOffset + m_text.size() * sizeof(wchar_t));
+            header.dataBytes = m_data.size();
+            header.fileBytes = header.dataOffset + m_data.size();
+
+            std::vector<unsigned char> file(static_cast<size_t>(header.fileBytes));
+            Put(file, 0, &header, sizeof(header));
+            Put(file, header.keysOffset, keys.data(), keys.size() * sizeof(Key));
+            Put(file, header.valuesOffset, values.data(), values.size() * sizeof(Value));
+            Put(file, header.stringsOffset, m_strings.data(), m_strings.size() * sizeof(detail::SnapshotStringRecord));
+            Put(file, header.textOffset, m_text.data(), m_text.size() * sizeof(wchar_t));
+            Put(file, header.dataOffset, m_data.data(), m_data.size());
+            return file;
+        }
+
+    private:
+        static void Put(std::vector<unsigned char>& file, const std::uint64_t offset, const void* data, const size_t size)
+        {
+            if (size > 0)
+            {
+                std::memcpy(file.data() + offset, data, size);
+            }
+        }
+
+        std::vector<detail::SnapshotStringRecord> m_strings;
+        std::vector<wchar_t> m_text;
+        std::vector<unsigned char> m_data;
+        std::unordered_map<std::wstring, std::uint32_t> m_stringIds;
+        std::unordered_map<std::string, std::uint64_t> m_dataOffsets;
+    };
+
+    bool WriteSnapshotFile(std::wstring const& filePath, std::vector<unsigned char> const& data, LSTATUS& error)
+    {
+        const std::wstring tempPath = filePath + L".tmp";
+        HANDLE file = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            error = static_cast<LSTATUS>(GetLastError());
+            return false;
+        }
+
+        constexpr size_t kChunkBytes = 16u << 20;
+        bool ok = true;
+        for (size_t offset = 0; ok && offset < data.size();)
+        {
+            const auto chunk = static_cast<DWORD>(std::min(kChunkBytes, data.size() - offset));
+            DWORD written = 0;
+            ok = WriteFile(file, data.data() + offset, chunk, &written, nullptr) && written == chunk;
+            offset += chunk;
+        }
+        if (!ok)
+        {
+            error = static_cast<LSTATUS>(GetLastError());
+        }
+        CloseHandle(file);
+
+        if (ok && !MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            error = static_cast<LSTATUS>(GetLastError());
+            ok = false;
+        }
+        if (!ok)
+        {
+            DeleteFileW(tempPath.c_str());
+        }
+        return ok;
+    }
+
+} // anonymous namespace
+
+SnapshotCaptureResult CaptureRegistrySnapshot(HKEY root,
+                                              std::wstring const& subKeyPath,
+                                              std::wstring const& filePath,
+                                              SnapshotCaptureOptions const& options)
+{
+    SnapshotCaptureResult result;
+    const REGSAM sam = KEY_READ | (options.samView & kViewMask);
+
+    SnapshotBuilder builder;
+    const std::uint32_t emptyName = builder.Intern(L"");
+    SnapshotBuilder::Key rootRecord{};
+    rootRecord.name = emptyName;
+    rootRecord.foldedName = emptyName;
+    rootRecord.parent = RegistrySnapshot::kNoKey;
+    builder.keys.push_back(rootRecord);
+
+    // Full paths of keys still to be read, indexed like builder.keys; released once read.
+    std::vector<std::wstring> paths;
+    paths.push_back(subKeyPath);
+
+    // Breadth-first: when key i is read its children are appended as one run, so the
+    // children of every key end up contiguous.
+    for (size_t index = 0; index < builder.keys.size(); ++index)
+    {
+        if (options.stop.stop_requested())
+        {
+            result.cancelled = true;
+            return result;
+        }
+
+        const std::wstring path = std::move(paths[index]);
+        paths[index] = std::wstring();
+
+        RegistryKey key;
+        KeySnapshot values;
+        SubKeyList children;
+        try
+        {
+            key = path.empty() ? RegistryKey(root, false) : RegistryKey::Open(root, path, sam);
+            values = ReadKeySnapshot(key);
+            children = EnumerateSubKeyNames(key);
+        }
+        catch (const RegException& ex)
+        {
+            if (index == 0)
+            {
+                throw;
+            }
+            builder.keys[index].flags |= kKeyUnreadable;
+            ++result.keysFailed;
+            if (result.firstError == ERROR_SUCCESS)
+            {
+                result.firstError = ex.code();
+            }
+            continue;
+        }
+
+        // Values sorted by folded name, so lookups and diffs can binary search / merge.
+        std::vector<std::pair<std::wstring, size_t>> valueOrder;
+        valueOrder.reserve(values.Size());
+        for (size_t v = 0; v < values.Size(); ++v)
+        {
+            valueOrder.emplace_back(FoldRegistryName(values.Value(v).name), v);
+        }
+        std::sort(valueOrder.begin(), valueOrder.end());
+
+        SnapshotBuilder::Key& record = builder.keys[index];
+        record.lastWriteTime = ToTicks(values.LastWriteTime());
+        record.firstValue = static_cast<std::uint32_t>(builder.values.size());
+        record.valueCount = static_cast<std::uint32_t>(valueOrder.size());
+
+        for (const auto& [folded, v] : valueOrder)
+        {
+            const RegValueView value = values.Value(v);
+            SnapshotBuilder::Value entry{};
+            entry.name = builder.Intern(value.name);
+            entry.foldedName = builder.Intern(folded);
+            entry.type = value.type;
+            entry.dataSize = static_cast<std::uint32_t>(value.size);
+            entry.dataOffset = builder.AddData(value.data, value.size);
+            builder.values.push_back(entry);
+        }
+
+        std::vector<std::pair<std::wstring, size_t>> childOrder;
+        childOrder.reserve(children.Size());
+        for (size_t c = 0; c < children.Size(); ++c)
+        {
+            childOrder.emplace_back(FoldRegistryName(children.Name(c)), c);
+        }
+        std::sort(childOrder.begin(), childOrder.end());
+
+        // 'record' is not used past this point: the pushes below may reallocate keys.
+        builder.keys[index].firstChild = static_cast<std::uint32_t>(builder.keys.size());
+        builder.keys[index].childCount = static_cast<std::uint32_t>(childOrder.size());
+
+        for (const auto& [folded, c] : childOrder)
+        {
+            SnapshotBuilder::Key child{};
+            child.name = builder.Intern(children.Name(c));
+            child.foldedName = builder.Intern(folded);
+            child.parent = static_cast<std::uint32_t>(index);
+            builder.keys.push_back(child);
+            paths.push_back(JoinPath(path, children.Name(c)));
+        }
+    }
+
+    std::uint32_t hive = 0;
+    while (hive < kRootCount && kRoots[hive] != root)
+    {
+        ++hive;
+    }
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+
+    const std::uint32_t sourcePath = builder.Intern(subKeyPath);
+    const std::vector<unsigned char> file = builder.Serialize(hive < kRootCount ? hive : kNoHive,
+                                                              sourcePath, ToTicks(now));
+
+    LSTATUS error = ERROR_SUCCESS;
+    if (!WriteSnapshotFile(filePath, file, error))
+    {
+        throw RegException(error, FormatWinErrorMessage(error));
+    }
+
+    result.keysCaptured = builder.keys.size() - result.keysFailed;
+    result.valuesCaptured = builder.values.size();
+    result.fileBytes = file.size();
+    return result;
+}
+
+std::shared_ptr<const RegistrySnapshot> RegistrySnapshot::Open(std::wstring const& filePath)
+{
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        const auto error = static_cast<LSTATUS>(GetLastError());
+        throw RegException(error, FormatWinErrorMessage(error));
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)))
+    {
+        CloseHandle(file);
+        throw RegException(ERROR_BAD_FORMAT, "Not a registry snapshot file");
+    }
+
+    // The view keeps the mapping alive; neither handle is needed once it exists.
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto mapError = static_cast<LSTATUS>(GetLastError());
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        throw RegException(mapError, FormatWinErrorMessage(mapError));
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    const auto viewError = static_cast<LSTATUS>(GetLastError());
+    CloseHandle(mapping);
+    if (view == nullptr)
+    {
+        throw RegException(viewError, FormatWinErrorMessage(viewError));
+    }
+
+    std::shared_ptr<RegistrySnapshot> snapshot(new RegistrySnapshot());
+    snapshot->m_view = static_cast<const unsigned char*>(view);
+    snapshot->m_size = static_cast<std::size_t>(size.QuadPart);
+
+    if (!snapshot->Validate())
+    {
+        throw RegException(ERROR_BAD_FORMAT, "Damaged or incompatible registry snapshot file");
+    }
+    return snapshot;
+}
+
+RegistrySnapshot::~RegistrySnapshot()
+{
+    if (m_view != nullptr)
+    {
+        UnmapViewOfFile(m_view);
+    }
+}
+
+bool RegistrySnapshot::Validate() noexcept
+{
+    FileHeader header;
+    std::memcpy(&header, m_view, sizeof(header));
+
+    const auto sectionFits = [this](const std::uint64_t offset, const std::uint64_t count, const std::uint64_t size) {
+        return offset % 8 == 0 && offset <= m_size && count <= (m_size - offset) / size;
+    };
+
+    if (header.magic != kMagic || header.version != kVersion || header.charSize != sizeof(wchar_t) ||
+        header.fileBytes != m_size || header.keyCount == 0 ||
+        (header.sourceHive >= kRootCount && header.sourceHive != kNoHive) ||
+        !sectionFits(header.keysOffset, header.keyCount, sizeof(KeyRecord)) ||
+        !sectionFits(header.valuesOffset, header.valueCount, sizeof(ValueRecord)) ||
+        !sectionFits(header.stringsOffset, header.stringCount, sizeof(StringRecord)) ||
+        !sectionFits(header.textOffset, header.textUnits, sizeof(wchar_t)) ||
+        !sectionFits(header.dataOffset, header.dataBytes, 1) ||
+        header.sourcePath >= header.stringCount)
+    {
+        return false;
+    }
+
+    m_keys = reinterpret_cast<const KeyRecord*>(m_view + header.keysOffset);
+    m_values = reinterpret_cast<const ValueRecord*>(m_view + header.valuesOffset);
+    m_strings = reinterpret_cast<const StringRecord*>(m_view + header.stringsOffset);
+    m_text = reinterpret_cast<const wchar_t*>(m_view + header.textOffset);
+    m_data = m_view + header.dataOffset;
+    m_keyCount = header.keyCount;
+    m_valueCount = header.valueCount;
+    m_stringCount = header.stringCount;
+    m_textUnits = header.textUnits;
+    m_dataBytes = header.dataBytes;
+    m_sourceRoot = header.sourceHive < kRootCount ? kRoots[header.sourceHive] : nullptr;
+    m_sourcePath = header.sourcePath;
+    m_capturedAt = header.capturedAt;
+
+    for (std::uint32_t i = 0; i < m_stringCount; ++i)
+    {
+        const StringRecord& text = m_strings[i];
+        if (text.offset > m_textUnits || text.length > m_textUnits - text.offset)
+        {
+            return false;
+        }
+    }
+
+    // Children always follow their parent (breadth-first order), so walks terminate.
+    for (KeyId i = 0; i < m_keyCount; ++i)
+    {
+        const KeyRecord& key = m_keys[i];
+        if (key.name >= m_stringCount || key.foldedName >= m_stringCount ||
+            (i == kRootKey ? key.parent != kNoKey : key.parent >= i) ||
+            (key.childCount > 0 && (key.firstChild <= i || key.firstChild > m_keyCount ||
+                                    key.childCount > m_keyCount - key.firstChild)) ||
+            key.firstValue > m_valueCount || key.valueCount > m_valueCount - key.firstValue)
+        {
+            return false;
+        }
+    }
+
+    for (std::uint32_t i = 0; i < m_valueCount; ++i)
+    {
+        const ValueRecord& value = m_values[i];
+        if (value.name >= m_stringCount || value.foldedName >= m_stringCount ||
+            value.dataOffset > m_dataBytes || value.dataSize > m_dataBytes - value.dataOffset)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::wstring_view RegistrySnapshot::String(const std::uint32_t id) const noexcept
+{
+    const StringRecord& text = m_strings[id];
+    return {m_text + text.offset, text.length};
+}
+
+HKEY RegistrySnapshot::SourceRoot() const noexcept
+{
+    return m_sourceRoot;
+}
+
+std::wstring_view RegistrySnapshot::SourcePath() const noexcept
+{
+    return String(m_sourcePath);
+}
+
+FILETIME RegistrySnapshot::CapturedAt() const noexcept
+{
+    return FromTicks(m_capturedAt);
+}
+
+std::size_t RegistrySnapshot::KeyCount() const noexcept
+{
+    return m_keyCount;
+}
+
+std::size_t RegistrySnapshot::ValueCount() const noexcept
+{
+    return m_valueCount;
+}
+
+RegistrySnapshot::KeyView RegistrySnapshot::Key(const KeyId key) const noexcept
+{
+    const KeyRecord& record = m_keys[key];
+    return KeyView{
+        String(record.name),
+        record.parent,
+        record.childCount,
+        record.valueCount,
+        FromTicks(record.lastWriteTime),
+        (record.flags & kKeyUnreadable) == 0
+    };
+}
+
+RegistrySnapshot::KeyId RegistrySnapshot::SubKey(const KeyId key, const std::size_t index) const noexcept
+{
+    return m_keys[key].firstChild + static_cast<KeyId>(index);
+}
+
+RegValueView RegistrySnapshot::Value(const KeyId key, const std::size_t index) const noexcept
+{
+    const ValueRecord& value = m_values[m_keys[key].firstValue + index];
+    return RegValueView{String(value.name), value.type, m_data + value.dataOffset, value.dataSize};
+}
+
+RegistrySnapshot::KeyId RegistrySnapshot::FindSubKey(const KeyId key, const std::wstring_view name) const
+{
+    const std::wstring folded = FoldRegistryName(name);
+    const KeyRecord& parent = m_keys[key];
+
+    const KeyRecord* first = m_keys + parent.firstChild;
+    const KeyRecord* last = first + parent.childCount;
+    const KeyRecord* found = std::lower_bound(first, last, std::wstring_view(folded),
+        [this](const KeyRecord& child, const std::wstring_view target) { return String(child.foldedName) < target; });
+
+    if (found == last || String(found->foldedName) != folded)
+    {
+        return kNoKey;
+    }
+    return static_cast<KeyId>(found - m_keys);
+}
+
+RegistrySnapshot::KeyId RegistrySnapshot::FindKey(const std::wstring_view relativePath) const
+{
+    KeyId key = kRootKey;
+    ForEachComponent(relativePath, [&](const std::wstring_view component) {
+        key = FindSubKey(key, component);
+        return key != kNoKey;
+    });
+    return key;
+}
+
+bool RegistrySnapshot::FindValue(const KeyId key, const std::wstring_view name, RegValueView& value) const
+{
+    const std::wstring folded = FoldRegistryName(name);
+    const KeyRecord& record = m_keys[key];
+
+    const ValueRecord* first = m_values + record.firstValue;
+    const ValueRecord* last = first + record.valueCount;
+    const ValueRecord* found = std::lower_bound(first, last, std::wstring_view(folded),
+        [this](const ValueRecord& entry, const std::wstring_view target) { return String(entry.foldedName) < target; });
+
+    if (found == last || String(found->foldedName) != folded)
+    {
+        return false;
+    }
+    value = Value(key, static_cast<std::size_t>(found - first));
+    return true;
+}
+
+RegistrySnapshot::KeyId RegistrySnapshot::RequireKey(const std::wstring_view relativePath) const
+{
+    const KeyId key = FindKey(relativePath);
+    if (key == kNoKey)
+    {
+        throw RegException(ERROR_FILE_NOT_FOUND, FormatWinErrorMessage(ERROR_FILE_NOT_FOUND));
+    }
+    return key;
+}
+
+size_t RegistrySnapshot::ForEachSubKey(const std::wstring_view relativePath, const size_t offset,
+                                       const size_t maxItems, SubKeyVisitor const& visit) const
+{
+    const KeyRecord& parent = m_keys[RequireKey(relativePath)];
+
+    size_t visited = 0;
+    for (size_t i = offset; i < parent.childCount && (maxItems == 0 || visited < maxItems); ++i)
+    {
+        const KeyRecord& child = m_keys[parent.firstChild + i];
+        ++visited;
+        if (!visit(String(child.name), FromTicks(child.lastWriteTime)))
+        {
+            break;
+        }
+    }
+    return visited;
+}
+
+size_t RegistrySnapshot::ForEachValue(const std::wstring_view relativePath, const size_t offset,
+                                      const size_t maxItems, ValueVisitor const& visit) const
+{
+    const KeyId key = RequireKey(relativePath);
+    const KeyRecord& record = m_keys[key];
+
+    size_t visited = 0;
+    for (size_t i = offset; i < record.valueCount && (maxItems == 0 || visited < maxItems); ++i)
+    {
+        ++visited;
+        if (!visit(Value(key, i)))
+        {
+            break;
+        }
+    }
+    return visited;
+}
+
+std::vector<SubKeyInfo> RegistrySnapshot::ListSubKeysWithInfo(const std::wstring_view relativePath,
+                                                              const size_t offset, const size_t maxItems) const
+{
+    const KeyRecord& parent = m_keys[RequireKey(relativePath)];
+
+    std::vector<SubKeyInfo> children;
+    if (offset >= parent.childCount)
+    {
+        return children;
+    }
+
+    const size_t count = maxItems == 0 ? parent.childCount - offset
+                                       : std::min<size_t>(maxItems, parent.childCount - offset);
+    children.reserve(count);
+    for (size_t i = offset; i < offset + count; ++i)
+    {
+        const KeyView child = Key(parent.firstChild + static_cast<KeyId>(i));
+        children.push_back(SubKeyInfo{std::wstring(child.name), child.subKeyCount, child.valueCount,
+                                      child.lastWriteTime, child.readable});
+    }
+    return children;
+}
+
+size_t DiffSnapshots(RegistrySnapshot const& before,
+                     RegistrySnapshot const& after,
+                     SnapshotDiffOptions const& options,
+                     SnapshotDiffVisitor const& visit)
+{
+    using KeyId = RegistrySnapshot::KeyId;
+
+    struct Pair
+    {
+        KeyId before;
+        KeyId after;
+        std::wstring path;
+    };
+
+    size_t reported = 0;
+    bool stopped = false;
+    const auto report = [&](const SnapshotChange change, std::wstring path, std::wstring_view valueName) {
+        ++reported;
+        stopped = !visit(SnapshotDiffEntry{change, std::move(path), std::wstring(valueName)});
+        return !stopped;
+    };
+
+    // Depth-first over the keys present in both; each key record is visited once.
+    std::vector<Pair> stack;
+    stack.push_back(Pair{RegistrySnapshot::kRootKey, RegistrySnapshot::kRootKey, std::wstring()});
+
+    std::vector<Pair> common;
+    while (!stack.empty() && !stopped)
+    {
+        const Pair current = std::move(stack.back());
+        stack.pop_back();
+
+        const auto& a = before.m_keys[current.before];
+        const auto& b = after.m_keys[current.after];
+
+        if (!options.trustLastWriteTime || a.lastWriteTime != b.lastWriteTime || a.valueCount != b.valueCount)
+        {
+            std::uint32_t i = 0;
+            std::uint32_t j = 0;
+            while ((i < a.valueCount || j < b.valueCount) && !stopped)
+            {
+                const auto* va = i < a.valueCount ? &before.m_values[a.firstValue + i] : nullptr;
+                const auto* vb = j < b.valueCount ? &after.m_values[b.firstValue + j] : nullptr;
+                const int order = va == nullptr ? 1
+                                : vb == nullptr ? -1
+                                : before.String(va->foldedName).compare(after.String(vb->foldedName));
+
+                if (order < 0)
+                {
+                    report(SnapshotChange::ValueRemoved, current.path, before.String(va->name));
+                    ++i;
+                }
+                else if (order > 0)
+                {
+                    report(SnapshotChange::ValueAdded, current.path, after.String(vb->name));
+                    ++j;
+                }
+                else
+                {
+                    if (va->type != vb->type || va->dataSize != vb->dataSize ||
+                        (va->dataSize > 0 && std::memcmp(before.m_data + va->dataOffset,
+                                                         after.m_data + vb->dataOffset, va->dataSize) != 0))
+                    {
+                        report(SnapshotChange::ValueChanged, current.path, after.String(vb->name));
+                    }
+                    ++i;
+                    ++j;
+                }
+            }
+        }
+
+        common.clear();
+        std::uint32_t i = 0;
+        std::uint32_t j = 0;
+        while ((i < a.childCount || j < b.childCount) && !stopped)
+        {
+            const KeyId ka = a.firstChild + i;
+            const KeyId kb = b.firstChild + j;
+            const int order = i >= a.childCount ? 1
+                            : j >= b.childCount ? -1
+                            : before.String(before.m_keys[ka].foldedName).compare(after.String(after.m_keys[kb].foldedName));
+
+            if (order < 0)
+            {
+                report(SnapshotChange::KeyRemoved, JoinPath(current.path, before.String(before.m_keys[ka].name)), {});
+                ++i;
+            }
+            else if (order > 0)
+            {
+                report(SnapshotChange::KeyAdded, JoinPath(current.path, after.String(after.m_keys[kb].name)), {});
+                ++j;
+            }
+            else
+            {
+                common.push_back(Pair{ka, kb, JoinPath(current.path, after.String(after.m_keys[kb].name))});
+                ++i;
+                ++j;
+            }
+        }
+
+        // Reversed so that children are reported in name order.
+        for (auto it = common.rbegin(); it != common.rend(); ++it)
+        {
+            stack.push_back(std::move(*it));
+        }
+    }
+
+    return reported;
+}
+
+} // namespace core::registry
@@ -0,0 +1,197 @@
+// RegistrySnapshot.h
+#pragma once
+
+#include <windows.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RegistryHelpers.h"
+
+namespace core::registry
+{
+
+namespace detail
+{
+    // On-disk records; defined in RegistrySnapshot.cpp.
+    struct SnapshotKeyRecord;
+    struct SnapshotValueRecord;
+    struct SnapshotStringRecord;
+}
+
+struct SnapshotCaptureOptions
+{
+    // Only KEY_WOW64_32KEY / KEY_WOW64_64KEY are used; they are applied to every open.
+    REGSAM samView = 0;
+
+    std::stop_token stop;
+};
+
+struct SnapshotCaptureResult
+{
+    size_t keysCaptured = 0;
+    size_t valuesCaptured = 0;
+    size_t keysFailed = 0;          // recorded as unreadable, without children or values
+    LSTATUS firstError = ERROR_SUCCESS;
+    bool cancelled = false;         // nothing was written
+    std::uint64_t fileBytes = 0;
+
+    [[nodiscard]] bool Succeeded() const noexcept
+    {
+        return keysFailed == 0 && !cancelled && firstError == ERROR_SUCCESS;
+    }
+};
+
+/**
+ * CaptureRegistrySnapshot - walks root\subKeyPath breadth-first and writes it to filePath in
+ * the RegistrySnapshot format. The file is written to filePath.tmp and moved into place once
+ * complete. Keys below the root that cannot be read are recorded as unreadable and counted in
+ * the result; throws RegException if the root cannot be opened or the file cannot be written.
+ */
+SnapshotCaptureResult CaptureRegistrySnapshot(HKEY root,
+                                              std::wstring const& subKeyPath,
+                                              std::wstring const& filePath,
+                                              SnapshotCaptureOptions const& options);
+
+enum class SnapshotChange
+{
+    KeyAdded,
+    KeyRemoved,
+    ValueAdded,
+    ValueRemoved,
+    ValueChanged        // type or data differ
+};
+
+struct SnapshotDiffEntry
+{
+    SnapshotChange change = SnapshotChange::KeyAdded;
+    std::wstring path;          // key path relative to the captured key
+    std::wstring valueName;     // value changes only
+};
+
+struct SnapshotDiffOptions
+{
+    // Skip the value comparison of keys whose last-write time did not change; every value
+    // write updates it. Off: compare the values of every key present in both snapshots.
+    bool trustLastWriteTime = true;
+};
+
+// Return false to stop the diff.
+using SnapshotDiffVisitor = std::function<bool(SnapshotDiffEntry const& entry)>;
+
+/**
+ * RegistrySnapshot - read-only, memory-mapped view of a captured subtree.
+ *
+ * File layout (native byte order, every section 8-byte aligned):
+ *   header, key records, value records, string records, UTF-16 string data, value data.
+ * Keys are stored breadth-first, so the children of a key form one contiguous run of key
+ * records sorted by folded name; the values of a key form one run sorted the same way.
+ * Names are interned in the string table (display and folded form), identical value data
+ * is stored once.
+ *
+ * Open() checks every record against the mapping once; lookups after that return views into
+ * the mapping without copying and stay valid while the snapshot is alive. Paths are relative
+ * to the captured key. Thread-safe: the mapping is never written.
+ */
+class RegistrySnapshot
+{
+public:
+    using KeyId = std::uint32_t;
+    static constexpr KeyId kRootKey = 0;
+    static constexpr KeyId kNoKey = 0xFFFFFFFFu;
+
+    struct KeyView
+    {
+        std::wstring_view name;             // empty for the root
+        KeyId parent = kNoKey;
+        std::uint32_t subKeyCount = 0;
+        std::uint32_t valueCount = 0;
+        FILETIME lastWriteTime = {};
+        bool readable = true;               // false if the key could not be read when captured
+    };
+
+    // Maps filePath. Throws RegException; ERROR_BAD_FORMAT for a damaged or foreign file.
+    static std::shared_ptr<const RegistrySnapshot> Open(std::wstring const& filePath);
+
+    ~RegistrySnapshot();
+
+    RegistrySnapshot(const RegistrySnapshot&) = delete;
+    RegistrySnapshot& operator=(const RegistrySnapshot&) = delete;
+
+    // Root key the snapshot was captured from; nullptr if it was not a predefined key.
+    [[nodiscard]] HKEY SourceRoot() const noexcept;
+    [[nodiscard]] std::wstring_view SourcePath() const noexcept;
+    [[nodiscard]] FILETIME CapturedAt() const noexcept;
+    [[nodiscard]] std::size_t KeyCount() const noexcept;
+    [[nodiscard]] std::size_t ValueCount() const noexcept;
+
+    // Unchecked: key must be a valid id and index below the key's count.
+    [[nodiscard]] KeyView Key(KeyId key) const noexcept;
+    [[nodiscard]] KeyId SubKey(KeyId key, std::size_t index) const noexcept;
+    [[nodiscard]] RegValueView Value(KeyId key, std::size_t index) const noexcept;
+
+    // Case-insensitive binary searches over the sorted runs.
+    [[nodiscard]] KeyId FindSubKey(KeyId key, std::wstring_view name) const;
+    [[nodiscard]] KeyId FindKey(std::wstring_view relativePath) const;
+    bool FindValue(KeyId key, std::wstring_view name, RegValueView& value) const;
+
+    // Same contracts as the registry-backed functions of the same names. Throw RegException
+    // (ERROR_FILE_NOT_FOUND) if relativePath is not in the snapshot.
+    size_t ForEachSubKey(std::wstring_view relativePath, size_t offset, size_t maxItems,
+                         SubKeyVisitor const& visit) const;
+    size_t ForEachValue(std::wstring_view relativePath, size_t offset, size_t maxItems,
+                        ValueVisitor const& visit) const;
+    std::vector<SubKeyInfo> ListSubKeysWithInfo(std::wstring_view relativePath, size_t offset,
+                                                size_t maxItems) const;
+
+private:
+    using KeyRecord = detail::SnapshotKeyRecord;
+    using ValueRecord = detail::SnapshotValueRecord;
+    using StringRecord = detail::SnapshotStringRecord;
+
+    RegistrySnapshot() = default;
+
+    // Points the section pointers into the view and checks every record. Open() only.
+    bool Validate() noexcept;
+    [[nodiscard]] std::wstring_view String(std::uint32_t id) const noexcept;
+    [[nodiscard]] KeyId RequireKey(std::wstring_view relativePath) const;
+
+    friend size_t DiffSnapshots(RegistrySnapshot const& before, RegistrySnapshot const& after,
+                                SnapshotDiffOptions const& options, SnapshotDiffVisitor const& visit);
+
+    const unsigned char* m_view = nullptr;
+    std::size_t m_size = 0;
+
+    const KeyRecord* m_keys = nullptr;
+    const ValueRecord* m_values = nullptr;
+    const StringRecord* m_strings = nullptr;
+    const wchar_t* m_text = nullptr;
+    const unsigned char* m_data = nullptr;
+
+    std::uint32_t m_keyCount = 0;
+    std::uint32_t m_valueCount = 0;
+    std::uint32_t m_stringCount = 0;
+    std::uint64_t m_textUnits = 0;
+    std::uint64_t m_dataBytes = 0;
+
+    HKEY m_sourceRoot = nullptr;
+    std::uint32_t m_sourcePath = 0;
+    std::uint64_t m_capturedAt = 0;
+};
+
+/**
+ * DiffSnapshots - reports what changed from 'before' to 'after' in one merge pass: the sorted
+ * child and value runs of both files are walked side by side, so the cost is linear in the
+ * number of keys and values. An added or removed key is reported once, not per descendant.
+ * Returns the number of entries passed to the visitor.
+ */
+size_t DiffSnapshots(RegistrySnapshot const& before,
+                     RegistrySnapshot const& after,
+                     SnapshotDiffOptions const& options,
+                     SnapshotDiffVisitor const& visit);
+
+} // namespace core::registry
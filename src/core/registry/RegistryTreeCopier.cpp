@@ -0,0 +1,332 @@
+// RegistryTreeCopier.cpp
+#include "RegistryTreeCopier.h"
+#include "RegistryCache.h"
+#include "RegistryHelpers.h"
+#include "TreeWalkQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core::registry
+{
+
+namespace {
+
+    constexpr REGSAM kViewMask = KEY_WOW64_32KEY | KEY_WOW64_64KEY;
+
+    std::wstring JoinPath(std::wstring const& base, std::wstring const& relative)
+    {
+        if (base.empty())
+        {
+            return relative;
+        }
+        if (relative.empty())
+        {
+            return base;
+        }
+        return base + L'\\' + relative;
+    }
+
+    bool IsSameOrBelow(HKEY root, std::wstring const& path, HKEY ancestorRoot, std::wstring const& ancestor)
+    {
+        if (root != ancestorRoot)
+        {
+            return false;
+        }
+
+        const std::wstring foldedPath = FoldRegistryName(path);
+        const std::wstring foldedAncestor = FoldRegistryName(ancestor);
+        if (foldedAncestor.empty())
+        {
+            return true;
+        }
+        if (foldedPath.compare(0, foldedAncestor.size(), foldedAncestor) != 0)
+        {
+            return false;
+        }
+        return foldedPath.size() == foldedAncestor.size() || foldedPath[foldedAncestor.size()] == L'\\';
+    }
+
+    // State shared by the walkers of one copy. Pending keys are paths relative to the source
+    // root of the copy; "" is the root itself.
+    struct CopyState
+    {
+        HKEY sourceRoot = nullptr;
+        std::wstring sourcePath;
+        HKEY targetRoot = nullptr;
+        std::wstring targetPath;
+        REGSAM samView = 0;
+        std::stop_token stop;
+
+        TreeCopyProgressCallback progress;
+        size_t progressInterval = 0;
+        std::mutex progressMutex;
+        size_t lastReported = 0;    // guarded by progressMutex
+
+        TreeWalkQueue<std::wstring> queue;
+
+        std::atomic<size_t> keysCopied{ 0 };
+        std::atomic<size_t> valuesCopied{ 0 };
+        std::atomic<size_t> keysFailed{ 0 };
+        std::atomic<LSTATUS> firstError{ ERROR_SUCCESS };
+
+        void RecordFailure(const LSTATUS code) noexcept
+        {
+            keysFailed.fetch_add(1, std::memory_order_relaxed);
+            LSTATUS expected = ERROR_SUCCESS;
+            firstError.compare_exchange_strong(expected, code == ERROR_SUCCESS ? ERROR_INTERNAL_ERROR : code,
+                                               std::memory_order_relaxed);
+        }
+
+        TreeCopyProgress Snapshot(const bool finished) const noexcept
+        {
+            TreeCopyProgress snapshot;
+            snapshot.keysCopied = keysCopied.load(std::memory_order_relaxed);
+            snapshot.valuesCopied = valuesCopied.load(std::memory_order_relaxed);
+            snapshot.keysFailed = keysFailed.load(std::memory_order_relaxed);
+            snapshot.finished = finished;
+            return snapshot;
+        }
+
+        // Walkers never wait for each other here; a report that finds the lock taken is skipped.
+        void MaybeReport()
+        {
+            if (!progress)
+            {
+                return;
+            }
+
+            std::unique_lock lock(progressMutex, std::try_to_lock);
+            if (!lock.owns_lock())
+            {
+                return;
+            }
+
+            const size_t processed = keysCopied.load(std::memory_order_relaxed) +
+                                     keysFailed.load(std::memory_order_relaxed);
+            if (processed - lastReported < progressInterval)
+            {
+                return;
+            }
+            lastReported = processed;
+            progress(Snapshot(false));
+        }
+    };
+
+    // Copies the values of one key and returns its children (relative to the copy root).
+    std::vector<std::wstring> CopyOneKey(CopyState& state, std::wstring const& relative)
+    {
+        const RegistryKey source = RegistryKey::Open(state.sourceRoot, JoinPath(state.sourcePath, relative),
+                                                     KEY_READ | state.samView);
+        const RegistryKey target = RegistryKey::Create(state.targetRoot, JoinPath(state.targetPath, relative),
+                                                       KEY_WRITE | state.samView);
+
+        std::wstring name; // the view is not null-terminated
+        LSTATUS valueError = ERROR_SUCCESS;
+        size_t copied = 0;
+        ForEachValue(source, 0, 0, [&](RegValueView const& value) {
+            name.assign(value.name);
+            const LSTATUS status = RegSetValueExW(target.Handle(), name.c_str(), 0, value.type,
+                                                  value.data, static_cast<DWORD>(value.size));
+            if (status == ERROR_SUCCESS)
+            {
+                ++copied;
+            }
+            else if (valueError == ERROR_SUCCESS)
+            {
+                valueError = status;
+            }
+            return !state.stop.stop_requested();
+        });
+        state.valuesCopied.fetch_add(copied, std::memory_order_relaxed);
+
+        if (valueError != ERROR_SUCCESS)
+        {
+            throw RegException(valueError, FormatWinErrorMessage(valueError));
+        }
+
+        const SubKeyList children = EnumerateSubKeyNames(source);
+        std::vector<std::wstring> result;
+        result.reserve(children.Size());
+        for (size_t i = 0; i < children.Size(); ++i)
+        {
+            const std::wstring_view child = children.Name(i);
+            if (relative.empty())
+            {
+                result.emplace_back(child);
+            }
+            else
+            {
+                std::wstring path;
+                path.reserve(relative.size() + 1 + child.size());
+                path.append(relative).append(1, L'\\').append(child);
+                result.push_back(std::move(path));
+            }
+        }
+        return result;
+    }
+
+    void RunWalker(CopyState& state)
+    {
+        std::wstring relative;
+        while (state.queue.Take(relative))
+        {
+            std::vector<std::wstring> children;
+            try
+            {
+                children = CopyOneKey(state, relative);
+                state.keysCopied.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (const RegException& ex)
+            {
+                state.RecordFailure(ex.code());
+            }
+            catch (const std::exception&)
+            {
+                state.RecordFailure(ERROR_INTERNAL_ERROR);
+            }
+
+            if (state.stop.stop_requested())
+            {
+                state.queue.Stop();
+            }
+            state.queue.Finish(children);
+
+            state.MaybeReport();
+        }
+    }
+
+    TreeCopyResult CopyNative(HKEY sourceRoot, std::wstring const& sourcePath,
+                              HKEY targetRoot, std::wstring const& targetPath, const REGSAM samView)
+    {
+        const RegistryKey source = RegistryKey::Open(sourceRoot, sourcePath, KEY_READ | samView);
+        const RegistryKey target = RegistryKey::Create(targetRoot, targetPath, KEY_WRITE | samView);
+
+        const LSTATUS status = RegCopyTreeW(source.Handle(), nullptr, target.Handle());
+        if (status != ERROR_SUCCESS)
+        {
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+
+        TreeCopyResult result;
+        result.usedNativeCopy = true;
+        return result;
+    }
+
+} // anonymous namespace
+
+TreeCopyResult CopyRegistryTree(HKEY sourceRoot,
+                                std::wstring const& sourcePath,
+                                HKEY targetRoot,
+                                std::wstring const& targetPath,
+                                TreeCopyOptions const& options)
+{
+    if (targetPath.empty())
+    {
+        throw RegException(ERROR_INVALID_PARAMETER, "Copy target must be a subkey, not a root key");
+    }
+    if (IsSameOrBelow(targetRoot, targetPath, sourceRoot, sourcePath))
+    {
+        throw RegException(ERROR_INVALID_PARAMETER, "Copy target lies inside the source key");
+    }
+
+    const REGSAM samView = options.samView & kViewMask;
+
+    const bool needsWalker = options.progress || options.stop.stop_possible();
+    if (options.allowNativeCopy && !needsWalker)
+    {
+        return CopyNative(sourceRoot, sourcePath, targetRoot, targetPath, samView);
+    }
+
+    auto state = std::make_shared<CopyState>();
+    state->sourceRoot = sourceRoot;
+    state->sourcePath = sourcePath;
+    state->targetRoot = targetRoot;
+    state->targetPath = targetPath;
+    state->samView = samView;
+    state->stop = options.stop;
+    state->progress = options.progress;
+    state->progressInterval = std::max<size_t>(options.progressInterval, 1);
+
+    // The root is copied up front so that its errors reach the caller as exceptions.
+    std::vector<std::wstring> children = CopyOneKey(*state, std::wstring());
+    state->keysCopied.store(1, std::memory_order_relaxed);
+    const size_t firstLevel = children.size();
+    state->queue.Seed(children);
+
+    // Helpers that start after the walk finished see it is over and return at once, so a busy
+    // pool only costs parallelism; the caller never waits for a helper to be scheduled.
+    const size_t helpers = options.threadManager != nullptr
+                               ? std::min(std::max<size_t>(options.maxConcurrency, 1) - 1, firstLevel)
+                               : 0;
+    for (size_t i = 0; i < helpers; ++i)
+    {
+        try
+        {
+            options.threadManager->enqueue([state]() { RunWalker(*state); }, options.priority);
+        }
+        catch (const std::exception&)
+        {
+            break; // pool is shutting down; the caller walks alone
+        }
+    }
+
+    RunWalker(*state);
+
+    // After a cancel, walkers still inside a key finish it before the result is read.
+    state->queue.WaitIdle();
+
+    TreeCopyResult result;
+    result.keysCopied = state->keysCopied.load(std::memory_order_relaxed);
+    result.valuesCopied = state->valuesCopied.load(std::memory_order_relaxed);
+    result.keysFailed = state->keysFailed.load(std::memory_order_relaxed);
+    result.firstError = state->firstError.load(std::memory_order_relaxed);
+    result.cancelled = state->queue.Stopped() || state->stop.stop_requested();
+
+    if (state->progress)
+    {
+        std::lock_guard lock(state->progressMutex);
+        state->progress(state->Snapshot(true));
+    }
+    return result;
+}
+
+void DeleteRegistryTree(HKEY root, std::wstring const& subKey, const REGSAM samView)
+{
+    if (subKey.empty())
+    {
+        throw RegException(ERROR_INVALID_PARAMETER, "Refusing to delete a root key");
+    }
+
+    {
+        const RegistryKey key = RegistryKey::Open(root, subKey, DELETE | KEY_READ | KEY_SET_VALUE | (samView & kViewMask));
+        const LSTATUS status = RegDeleteTreeW(key.Handle(), nullptr);
+        if (status != ERROR_SUCCESS)
+        {
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+    }
+
+    DeleteSubKey(root, subKey, samView & kViewMask);
+}
+
+void ExportRegistryTree(HKEY root,
+                        std::wstring const& subKey,
+                        std::wstring const& filePath,
+                        const DWORD format,
+                        const REGSAM samView)
+{
+    // Left enabled: another export may be running on a different worker.
+    EnablePrivilege(SE_BACKUP_NAME, true);
+
+    const RegistryKey key = RegistryKey::Open(root, subKey, KEY_READ | (samView & kViewMask));
+    const LSTATUS status = RegSaveKeyExW(key.Handle(), filePath.c_str(), nullptr, format);
+    if (status != ERROR_SUCCESS)
+    {
+        throw RegException(status, FormatWinErrorMessage(status));
+    }
+}
+
+} // namespace core::registry
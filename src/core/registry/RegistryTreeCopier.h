@@ -0,0 +1,96 @@
+// RegistryTreeCopier.h
+#pragma once
+
+#include <windows.h>
+#include <cstddef>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include "IThreadManager.h"
+
+namespace core::registry
+{
+
+struct TreeCopyProgress
+{
+    size_t keysCopied = 0;
+    size_t valuesCopied = 0;
+    size_t keysFailed = 0;
+    bool finished = false;
+};
+
+// May be called from any worker taking part in the copy, never from two at once.
+using TreeCopyProgressCallback = std::function<void(TreeCopyProgress const& progress)>;
+
+struct TreeCopyOptions
+{
+    // Pool used for helper walkers; with nullptr the copy runs on the calling thread only.
+    IThreadManager* threadManager = nullptr;
+    IThreadManager::TaskPriority priority = IThreadManager::TaskPriority::Normal;
+
+    // Walkers copying at the same time, the calling thread included. Each one opens its own
+    // key handles, so this also bounds the number of open handles per copy.
+    size_t maxConcurrency = 4;
+
+    // Let RegCopyTreeW do the whole copy when nothing needs per-key progress or cancellation.
+    bool allowNativeCopy = true;
+
+    // Only KEY_WOW64_32KEY / KEY_WOW64_64KEY are used; they are applied to every open.
+    REGSAM samView = 0;
+
+    TreeCopyProgressCallback progress;
+    size_t progressInterval = 256;   // keys between progress reports
+
+    std::stop_token stop;
+};
+
+struct TreeCopyResult
+{
+    size_t keysCopied = 0;           // unknown (0) when usedNativeCopy
+    size_t valuesCopied = 0;
+    size_t keysFailed = 0;           // keys that could not be read or written; the walk goes on
+    LSTATUS firstError = ERROR_SUCCESS;
+    bool cancelled = false;
+    bool usedNativeCopy = false;
+
+    [[nodiscard]] bool Succeeded() const noexcept
+    {
+        return keysFailed == 0 && !cancelled && firstError == ERROR_SUCCESS;
+    }
+};
+
+/**
+ * CopyRegistryTree - copies sourceRoot\sourcePath with all values and subkeys to
+ * targetRoot\targetPath, creating the target as needed. Existing target values are overwritten.
+ *
+ *  - Native path: one RegCopyTreeW call, used when allowed and neither progress nor a stop
+ *    token is supplied.
+ *  - Parallel path: the calling thread and up to maxConcurrency - 1 pool tasks (none without a
+ *    thread manager) share a queue of pending keys. A walker copies the values of one key and
+ *    queues its children, so sibling subtrees are copied concurrently. The caller returns only after every walker has let go.
+ *
+ * Key class names and security descriptors are not copied. Throws RegException if the source
+ * cannot be opened, the root of the target cannot be created, or the target lies inside the
+ * source; failures below the root are counted in the result instead.
+ */
+TreeCopyResult CopyRegistryTree(HKEY sourceRoot,
+                                std::wstring const& sourcePath,
+                                HKEY targetRoot,
+                                std::wstring const& targetPath,
+                                TreeCopyOptions const& options);
+
+// RegDeleteTreeW on root\subKey, then removes the key itself. Throws RegException.
+void DeleteRegistryTree(HKEY root, std::wstring const& subKey, REGSAM samView = 0);
+
+/**
+ * ExportRegistryTree - saves root\subKey to a hive file with RegSaveKeyExW (a single native call
+ * for the whole subtree). Enables SE_BACKUP_NAME for the process first; the file must not exist.
+ * Throws RegException.
+ */
+void ExportRegistryTree(HKEY root,
+                        std::wstring const& subKey,
+                        std::wstring const& filePath,
+                        DWORD format = REG_LATEST_FORMAT,
+                        REGSAM samView = 0);
+
+} // namespace core::registry
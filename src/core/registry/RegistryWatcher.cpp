@@ -0,0 +1,224 @@
+// RegistryWatcher.cpp
+#include "RegistryWatcher.h"
+#include "RegistryHelpers.h"
+
+#include <utility>
+
+namespace core::registry
+{
+
+RegistryWatcher::RegistryWatcher(const DWORD notifyFilter, const bool watchSubtree,
+                                 const std::size_t maxWatches, ChangeCallback onChange)
+    : m_notifyFilter(notifyFilter)
+    , m_watchSubtree(watchSubtree)
+    , m_maxWatches(maxWatches == 0 ? 1 : maxWatches)
+    , m_onChange(std::move(onChange))
+{
+}
+
+RegistryWatcher::~RegistryWatcher()
+{
+    DisarmAll();
+}
+
+/**
+ * Teardown
+ *
+ * Cancel the wait, wait for a callback that may still be running on the pool,
+ * then close the wait object and the event. The KEY_NOTIFY handle is closed by
+ * RegistryKey when the context is destroyed. Must not be called from WaitCallback
+ * or with any cache lock held.
+ */
+void RegistryWatcher::Teardown(std::vector<std::unique_ptr<WatchContext>>& contexts)
+{
+    for (const std::unique_ptr<WatchContext>& ctx : contexts)
+    {
+        if (ctx->wait != nullptr)
+        {
+            SetThreadpoolWait(ctx->wait, nullptr, nullptr);
+            WaitForThreadpoolWaitCallbacks(ctx->wait, TRUE);
+            CloseThreadpoolWait(ctx->wait);
+            ctx->wait = nullptr;
+        }
+
+        if (ctx->event != nullptr)
+        {
+            CloseHandle(ctx->event);
+            ctx->event = nullptr;
+        }
+    }
+    contexts.clear();
+}
+
+WatchTicket RegistryWatcher::Arm(HKEY root, const std::wstring& subKeyPath)
+{
+    if (subKeyPath.empty())
+    {
+        return {};
+    }
+
+    CacheKeyId id{root, FoldRegistryName(subKeyPath), std::wstring(), 0};
+
+    std::vector<std::unique_ptr<WatchContext>> toClose;
+    WatchTicket ticket;
+    {
+        std::lock_guard lock(m_mutex);
+        toClose = std::move(m_retired);
+        m_retired.clear();
+
+        const auto it = m_index.find(id);
+        if (it != m_index.end())
+        {
+            m_watches.splice(m_watches.begin(), m_watches, it->second);
+            ticket = (*it->second)->armed;
+        }
+    }
+
+    Teardown(toClose);
+    if (ticket)
+    {
+        return ticket;
+    }
+
+    auto ctx = std::make_unique<WatchContext>();
+    ctx->owner = this;
+    ctx->id = id;
+
+    try
+    {
+        ctx->key = RegistryKey::Open(root, subKeyPath, KEY_NOTIFY);
+        ctx->event = CreateRegistryChangeEvent(ctx->key, m_watchSubtree,
+                                               m_notifyFilter | REG_NOTIFY_THREAD_AGNOSTIC, TRUE);
+    }
+    catch (const RegException&)
+    {
+        return {};
+    }
+
+    ctx->wait = CreateThreadpoolWait(&RegistryWatcher::WaitCallback, ctx.get(), nullptr);
+    if (ctx->wait == nullptr)
+    {
+        CloseHandle(ctx->event);
+        return {};
+    }
+
+    ctx->armed = std::make_shared<std::atomic<bool>>(true);
+    ticket = ctx->armed;
+    SetThreadpoolWait(ctx->wait, ctx->event, nullptr);
+
+    std::vector<std::unique_ptr<WatchContext>> evicted;
+    {
+        std::lock_guard lock(m_mutex);
+
+        const auto it = m_index.find(id);
+        if (it != m_index.end())
+        {
+            // Another thread armed the same key meanwhile; keep theirs.
+            ticket = (*it->second)->armed;
+            toClose.push_back(std::move(ctx));
+        }
+        else
+        {
+            m_watches.push_front(std::move(ctx));
+            m_index.emplace(std::move(id), m_watches.begin());
+
+            while (m_watches.size() > m_maxWatches)
+            {
+                std::unique_ptr<WatchContext> oldest = std::move(m_watches.back());
+                m_watches.pop_back();
+                m_index.erase(oldest->id);
+                evicted.push_back(std::move(oldest));
+            }
+        }
+    }
+
+    Teardown(toClose);
+
+    // Entries covered by an evicted watch would otherwise never expire.
+    for (const std::unique_ptr<WatchContext>& old : evicted)
+    {
+        old->armed->store(false, std::memory_order_release);
+        if (m_onChange)
+        {
+            m_onChange(old->id.root, old->id.path, m_watchSubtree);
+        }
+    }
+    Teardown(evicted);
+
+    return ticket;
+}
+
+VOID CALLBACK RegistryWatcher::WaitCallback(PTP_CALLBACK_INSTANCE /*Instance*/, PVOID Parameter,
+                                            PTP_WAIT /*Wait*/, TP_WAIT_RESULT /*WaitResult*/)
+{
+    auto* ctx = static_cast<WatchContext*>(Parameter);
+    if (ctx == nullptr || ctx->owner == nullptr)
+    {
+        return;
+    }
+
+    ctx->owner->OnFired(ctx);
+}
+
+/**
+ * OnFired
+ *
+ * Runs on a pool thread when the key changed (or was deleted). The armed flag is
+ * cleared before invalidation so a concurrent cache fill cannot store an entry
+ * without expiry after the invalidation pass. The context is parked in m_retired;
+ * closing the wait object from inside its own callback is avoided.
+ */
+void RegistryWatcher::OnFired(WatchContext* ctx)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        const auto it = m_index.find(ctx->id);
+        if (it != m_index.end() && it->second->get() == ctx)
+        {
+            m_retired.push_back(std::move(*it->second));
+            m_watches.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    ctx->armed->store(false, std::memory_order_release);
+    m_fired.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_onChange)
+    {
+        m_onChange(ctx->id.root, ctx->id.path, m_watchSubtree);
+    }
+}
+
+void RegistryWatcher::DisarmAll()
+{
+    std::vector<std::unique_ptr<WatchContext>> toClose;
+    {
+        std::lock_guard lock(m_mutex);
+        toClose = std::move(m_retired);
+        m_retired.clear();
+
+        for (std::unique_ptr<WatchContext>& ctx : m_watches)
+        {
+            ctx->armed->store(false, std::memory_order_release);
+            toClose.push_back(std::move(ctx));
+        }
+        m_watches.clear();
+        m_index.clear();
+    }
+
+    Teardown(toClose);
+}
+
+std::size_t RegistryWatcher::WatchCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_watches.size();
+}
+
+std::size_t RegistryWatcher::FiredCount() const noexcept
+{
+    return m_fired.load(std::memory_order_relaxed);
+}
+
+} // namespace core::registry
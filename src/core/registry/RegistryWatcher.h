@@ -0,0 +1,105 @@
+// RegistryWatcher.h
+#pragma once
+
+#include "RegistryCache.h"
+#include "RegistryKey.h"
+
+#include <windows.h>
+#include <threadpoolapiset.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace core::registry
+{
+
+/**
+ * RegistryWatcher
+ *
+ * Keeps RegNotifyChangeKeyValue notifications armed on keys that have cached data,
+ * so RegistryFacade can keep those entries without a TTL and drop exactly the
+ * affected ones when the key changes.
+ *
+ * Design:
+ *  - One watch per (root, folded path). Each watch owns a KEY_NOTIFY handle, the
+ *    event from CreateRegistryChangeEvent and a PTP_WAIT on the process thread pool,
+ *    so the number of watches is not limited by WaitForMultipleObjects.
+ *  - Arm() returns a WatchTicket (shared armed flag). The cache only stores an entry
+ *    without expiry while that flag is still set, checked under the shard lock.
+ *  - A watch is one-shot: when it fires, the flag is cleared, the watch is retired
+ *    and the change callback invalidates the cached entries. The next cache fill for
+ *    that key arms a fresh watch.
+ *  - The number of watches is capped; the least recently armed watch is evicted and
+ *    its entries are invalidated, so no unwatched entry is left without a TTL.
+ *
+ * Thread-safety:
+ *  - Arm(), DisarmAll() and WatchCount() are thread-safe.
+ *  - The change callback runs on a thread-pool thread and must not call back into
+ *    the watcher.
+ */
+class RegistryWatcher
+{
+public:
+    // root, folded path of the changed key, whether the watch covered the subtree.
+    using ChangeCallback = std::function<void(HKEY root, const std::wstring& foldedPath, bool subtree)>;
+
+    RegistryWatcher(DWORD notifyFilter, bool watchSubtree, std::size_t maxWatches, ChangeCallback onChange);
+
+    ~RegistryWatcher();
+
+    RegistryWatcher(const RegistryWatcher&) = delete;
+    RegistryWatcher& operator=(const RegistryWatcher&) = delete;
+
+    /**
+     * Ensure a notification is armed for root\subKeyPath.
+     * Call before reading the data that will be cached, so a change between the
+     * read and the insert is still observed. Returns an empty ticket if the key
+     * cannot be watched (hive roots, missing rights or resource limits).
+     */
+    WatchTicket Arm(HKEY root, const std::wstring& subKeyPath);
+
+    // Cancel every watch without invoking the change callback.
+    void DisarmAll();
+
+    [[nodiscard]] std::size_t WatchCount() const;
+
+    [[nodiscard]] std::size_t FiredCount() const noexcept;
+
+private:
+    struct WatchContext
+    {
+        RegistryWatcher* owner = nullptr;
+        CacheKeyId id;
+        RegistryKey key;
+        HANDLE event = nullptr;
+        PTP_WAIT wait = nullptr;
+        std::shared_ptr<std::atomic<bool>> armed;
+    };
+
+    using WatchList = std::list<std::unique_ptr<WatchContext>>;
+
+    static VOID CALLBACK WaitCallback(PTP_CALLBACK_INSTANCE Instance, PVOID Parameter, PTP_WAIT Wait, TP_WAIT_RESULT WaitResult);
+
+    static void Teardown(std::vector<std::unique_ptr<WatchContext>>& contexts);
+
+    void OnFired(WatchContext* ctx);
+
+    DWORD m_notifyFilter;
+    bool m_watchSubtree;
+    std::size_t m_maxWatches;
+    ChangeCallback m_onChange;
+
+    mutable std::mutex m_mutex;
+    WatchList m_watches; // front = most recently armed
+    std::unordered_map<CacheKeyId, WatchList::iterator, CacheKeyIdHash> m_index;
+    std::vector<std::unique_ptr<WatchContext>> m_retired; // fired, awaiting Teardown
+
+    std::atomic<std::size_t> m_fired{ 0 };
+};
+
+} // namespace core::registry
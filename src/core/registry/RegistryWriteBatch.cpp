@@ -0,0 +1,240 @@
+// RegistryWriteBatch.cpp
+#include "RegistryWriteBatch.h"
+#include "RegistryCache.h"
+#include "RegistryHelpers.h"
+#include <ktmw32.h>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace core::registry
+{
+
+namespace {
+
+    constexpr REGSAM kViewMask = KEY_WOW64_32KEY | KEY_WOW64_64KEY;
+
+    template <typename T>
+    std::vector<unsigned char> ToBytes(const T& value)
+    {
+        std::vector<unsigned char> bytes(sizeof(T));
+        std::memcpy(bytes.data(), &value, sizeof(T));
+        return bytes;
+    }
+
+    // Closes the transaction handle; an uncommitted transaction is rolled back by the close.
+    struct TransactionHandle
+    {
+        HANDLE handle = INVALID_HANDLE_VALUE;
+
+        ~TransactionHandle()
+        {
+            if (handle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(handle);
+            }
+        }
+    };
+
+    LSTATUS OpenBatchKey(WriteBatch::Operation const& op, const bool create, const REGSAM samView,
+                         HANDLE transaction, RegistryKey& key)
+    {
+        const REGSAM sam = KEY_SET_VALUE | (samView & kViewMask);
+        HKEY handle = nullptr;
+        LSTATUS status;
+
+        if (create)
+        {
+            status = transaction != INVALID_HANDLE_VALUE
+                ? RegCreateKeyTransactedW(op.root, op.path.c_str(), 0, nullptr, REG_OPTION_NON_VOLATILE,
+                                          sam, nullptr, &handle, nullptr, transaction, nullptr)
+                : RegCreateKeyExW(op.root, op.path.c_str(), 0, nullptr, REG_OPTION_NON_VOLATILE,
+                                  sam, nullptr, &handle, nullptr);
+        }
+        else
+        {
+            status = transaction != INVALID_HANDLE_VALUE
+                ? RegOpenKeyTransactedW(op.root, op.path.c_str(), 0, sam, &handle, transaction, nullptr)
+                : RegOpenKeyExW(op.root, op.path.c_str(), 0, sam, &handle);
+        }
+
+        if (status == ERROR_SUCCESS)
+        {
+            key = RegistryKey(handle);
+        }
+        return status;
+    }
+
+    LSTATUS ApplyOperation(WriteBatch::Operation const& op, HKEY key)
+    {
+        const wchar_t* name = op.valueName.empty() ? nullptr : op.valueName.c_str();
+
+        if (op.erase)
+        {
+            const LSTATUS status = RegDeleteValueW(key, name);
+            return status == ERROR_FILE_NOT_FOUND ? ERROR_SUCCESS : status;
+        }
+
+        return RegSetValueExW(key, name, 0, op.type,
+                              op.data.empty() ? nullptr : op.data.data(),
+                              static_cast<DWORD>(op.data.size()));
+    }
+
+} // anonymous namespace
+
+WriteBatch& WriteBatch::SetValue(HKEY root, std::wstring path, std::wstring valueName,
+                                 const DWORD type, std::vector<unsigned char> data)
+{
+    m_operations.push_back(Operation{root, std::move(path), std::move(valueName), type, std::move(data), false});
+    return *this;
+}
+
+WriteBatch& WriteBatch::SetString(HKEY root, std::wstring path, std::wstring valueName,
+                                  std::wstring const& data, const DWORD regType)
+{
+    if (regType != REG_SZ && regType != REG_EXPAND_SZ)
+    {
+        throw RegException(ERROR_INVALID_PARAMETER,
+                          "Invalid string type. Use REG_SZ or REG_EXPAND_SZ");
+    }
+
+    std::vector<unsigned char> bytes((data.size() + 1) * sizeof(wchar_t));
+    std::memcpy(bytes.data(), data.c_str(), bytes.size());
+    return SetValue(root, std::move(path), std::move(valueName), regType, std::move(bytes));
+}
+
+WriteBatch& WriteBatch::SetDword(HKEY root, std::wstring path, std::wstring valueName, const DWORD data)
+{
+    return SetValue(root, std::move(path), std::move(valueName), REG_DWORD, ToBytes(data));
+}
+
+WriteBatch& WriteBatch::SetQword(HKEY root, std::wstring path, std::wstring valueName, const unsigned long long data)
+{
+    return SetValue(root, std::move(path), std::move(valueName), REG_QWORD, ToBytes(data));
+}
+
+WriteBatch& WriteBatch::SetBinary(HKEY root, std::wstring path, std::wstring valueName,
+                                  std::vector<unsigned char> data)
+{
+    return SetValue(root, std::move(path), std::move(valueName), REG_BINARY, std::move(data));
+}
+
+WriteBatch& WriteBatch::DeleteValue(HKEY root, std::wstring path, std::wstring valueName)
+{
+    m_operations.push_back(Operation{root, std::move(path), std::move(valueName), REG_NONE, {}, true});
+    return *this;
+}
+
+void WriteBatch::Reserve(const size_t operations)
+{
+    m_operations.reserve(operations);
+}
+
+void WriteBatch::Clear() noexcept
+{
+    m_operations.clear();
+}
+
+WriteBatchResult ApplyWriteBatch(WriteBatch const& batch, WriteBatchOptions const& options)
+{
+    WriteBatchResult result;
+    if (batch.Empty())
+    {
+        return result;
+    }
+
+    TransactionHandle transaction;
+    if (options.transacted)
+    {
+        transaction.handle = CreateTransaction(nullptr, nullptr, 0, 0, 0, options.transactionTimeoutMs, nullptr);
+        if (transaction.handle == INVALID_HANDLE_VALUE)
+        {
+            const LSTATUS status = static_cast<LSTATUS>(GetLastError());
+            throw RegException(status, FormatWinErrorMessage(status));
+        }
+    }
+
+    const bool stopOnError = options.transacted || !options.continueOnError;
+
+    // One handle per (root, folded path); a key that failed to open is retried by its next operation.
+    std::unordered_map<CacheKeyId, RegistryKey, CacheKeyIdHash> keys;
+
+    const auto& operations = batch.Operations();
+    for (size_t index = 0; index < operations.size(); ++index)
+    {
+        const WriteBatch::Operation& op = operations[index];
+        CacheKeyId id{op.root, FoldRegistryName(op.path), std::wstring(), 0};
+
+        auto it = keys.find(id);
+        LSTATUS status = ERROR_SUCCESS;
+        if (it == keys.end())
+        {
+            RegistryKey key;
+            status = OpenBatchKey(op, !op.erase && options.createMissingKeys, options.samView,
+                                  transaction.handle, key);
+            if (status == ERROR_SUCCESS)
+            {
+                it = keys.emplace(std::move(id), std::move(key)).first;
+                ++result.keysOpened;
+            }
+            else if (op.erase && status == ERROR_FILE_NOT_FOUND)
+            {
+                // Nothing to delete under a key that does not exist.
+                ++result.valuesDeleted;
+                continue;
+            }
+        }
+
+        if (status == ERROR_SUCCESS)
+        {
+            status = ApplyOperation(op, it->second.Handle());
+        }
+
+        if (status == ERROR_SUCCESS)
+        {
+            ++(op.erase ? result.valuesDeleted : result.valuesWritten);
+            continue;
+        }
+
+        if (result.operationsFailed++ == 0)
+        {
+            result.firstFailedIndex = index;
+            result.firstError = status;
+        }
+        if (stopOnError)
+        {
+            break;
+        }
+    }
+
+    // Transacted handles are closed before the transaction is committed or rolled back.
+    keys.clear();
+
+    if (options.transacted)
+    {
+        bool committed = false;
+        if (result.operationsFailed == 0)
+        {
+            committed = CommitTransaction(transaction.handle) != FALSE;
+            if (!committed)
+            {
+                result.firstError = static_cast<LSTATUS>(GetLastError());
+            }
+        }
+        else
+        {
+            RollbackTransaction(transaction.handle);
+        }
+
+        if (!committed)
+        {
+            result.rolledBack = true;
+            result.valuesWritten = 0;
+            result.valuesDeleted = 0;
+        }
+    }
+
+    return result;
+}
+
+} // namespace core::registry
@@ -0,0 +1,105 @@
+// RegistryWriteBatch.h
+#pragma once
+
+#include <windows.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace core::registry
+{
+
+/**
+ * WriteBatch - ordered list of value writes and deletions, applied by ApplyWriteBatch().
+ *
+ * Operations may target any number of keys; they are applied in the order they were added.
+ * Adding only records the operation; nothing touches the registry until the batch is applied.
+ */
+class WriteBatch
+{
+public:
+    struct Operation
+    {
+        HKEY root = nullptr;
+        std::wstring path;
+        std::wstring valueName;
+        DWORD type = REG_NONE;
+        std::vector<unsigned char> data;
+        bool erase = false;                 // DeleteValue; type and data unused
+    };
+
+    WriteBatch& SetValue(HKEY root, std::wstring path, std::wstring valueName,
+                         DWORD type, std::vector<unsigned char> data);
+
+    // regType must be REG_SZ or REG_EXPAND_SZ; throws RegException otherwise.
+    WriteBatch& SetString(HKEY root, std::wstring path, std::wstring valueName,
+                          std::wstring const& data, DWORD regType = REG_SZ);
+
+    WriteBatch& SetDword(HKEY root, std::wstring path, std::wstring valueName, DWORD data);
+
+    WriteBatch& SetQword(HKEY root, std::wstring path, std::wstring valueName, unsigned long long data);
+
+    WriteBatch& SetBinary(HKEY root, std::wstring path, std::wstring valueName,
+                          std::vector<unsigned char> data);
+
+    // Deleting a value (or a value of a key) that does not exist is not an error.
+    WriteBatch& DeleteValue(HKEY root, std::wstring path, std::wstring valueName);
+
+    void Reserve(size_t operations);
+    void Clear() noexcept;
+
+    [[nodiscard]] size_t Size() const noexcept { return m_operations.size(); }
+    [[nodiscard]] bool Empty() const noexcept { return m_operations.empty(); }
+    [[nodiscard]] std::vector<Operation> const& Operations() const noexcept { return m_operations; }
+
+private:
+    std::vector<Operation> m_operations;
+};
+
+struct WriteBatchOptions
+{
+    // Run the whole batch inside one KTM transaction: either every operation is committed
+    // or none is. Any failure stops the batch and rolls it back.
+    bool transacted = false;
+    DWORD transactionTimeoutMs = 0;         // 0 = no timeout
+
+    // Without a transaction: keep going past failed operations instead of stopping.
+    bool continueOnError = false;
+
+    // Set operations create missing keys; otherwise they fail with ERROR_FILE_NOT_FOUND.
+    bool createMissingKeys = true;
+
+    // Only KEY_WOW64_32KEY / KEY_WOW64_64KEY are used; they are applied to every open.
+    REGSAM samView = 0;
+};
+
+struct WriteBatchResult
+{
+    size_t valuesWritten = 0;
+    size_t valuesDeleted = 0;
+    size_t keysOpened = 0;                  // distinct keys, each opened once
+    size_t operationsFailed = 0;
+    size_t firstFailedIndex = 0;            // valid when operationsFailed > 0
+    LSTATUS firstError = ERROR_SUCCESS;
+    bool rolledBack = false;                // transacted batch that failed; nothing was written
+
+    [[nodiscard]] bool Succeeded() const noexcept
+    {
+        return operationsFailed == 0 && firstError == ERROR_SUCCESS && !rolledBack;
+    }
+};
+
+/**
+ * ApplyWriteBatch - applies the operations of batch in order.
+ *
+ * Each distinct key is opened once (KEY_SET_VALUE) on its first operation and the handle is
+ * reused for every later operation on it, so a bulk import pays one open per key instead of
+ * one per value. Transacted batches open their keys with RegCreateKeyTransactedW /
+ * RegOpenKeyTransactedW and close every handle before the commit.
+ *
+ * Per-operation failures are reported in the result; throws RegException only if the
+ * transaction cannot be created.
+ */
+WriteBatchResult ApplyWriteBatch(WriteBatch const& batch, WriteBatchOptions const& options);
+
+} // namespace core::registry
@@ -0,0 +1,498 @@
+// SearchIndex.cpp
+#include "SearchIndex.h"
+#include "RegistryCache.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace core::registry
+{
+
+namespace {
+
+    const HKEY kRoots[] = {
+        HKEY_CLASSES_ROOT, HKEY_CURRENT_USER, HKEY_LOCAL_MACHINE,
+        HKEY_USERS, HKEY_CURRENT_CONFIG
+    };
+    constexpr std::uint32_t kRootCount = sizeof(kRoots) / sizeof(kRoots[0]);
+
+    // File layout, native byte order:
+    //   magic, version, node count, then per node in id order (parents precede children):
+    //   parent, hive, name, lastWriteTime, filled, value count, values (name, type, complete, text).
+    // Strings are a u32 length followed by UTF-16 code units.
+    constexpr std::uint32_t kMagic = 0x58495352; // "RSIX"
+    constexpr std::uint32_t kVersion = 1;
+
+    ULONGLONG ToTicks(FILETIME const& time) noexcept
+    {
+        return (static_cast<ULONGLONG>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    }
+
+    class Writer
+    {
+    public:
+        void U8(const std::uint8_t v) { m_buffer.push_back(v); }
+        void U32(const std::uint32_t v) { Raw(&v, sizeof(v)); }
+        void U64(const std::uint64_t v) { Raw(&v, sizeof(v)); }
+
+        void Str(std::wstring const& s)
+        {
+            U32(static_cast<std::uint32_t>(s.size()));
+            Raw(s.data(), s.size() * sizeof(wchar_t));
+        }
+
+        std::vector<unsigned char> const& Buffer() const noexcept { return m_buffer; }
+
+    private:
+        void Raw(const void* data, const std::size_t size)
+        {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        }
+
+        std::vector<unsigned char> m_buffer;
+    };
+
+    // Every read is bounds-checked; after the first failure all reads fail.
+    class Reader
+    {
+    public:
+        Reader(const unsigned char* data, const std::size_t size) noexcept
+            : m_data(data), m_size(size)
+        {}
+
+        bool U8(std::uint8_t& v) noexcept { return Raw(&v, sizeof(v)); }
+        bool U32(std::uint32_t& v) noexcept { return Raw(&v, sizeof(v)); }
+        bool U64(std::uint64_t& v) noexcept { return Raw(&v, sizeof(v)); }
+
+        bool Str(std::wstring& s)
+        {
+            std::uint32_t length = 0;
+            if (!U32(length) || length > (m_size - m_offset) / sizeof(wchar_t))
+            {
+                m_offset = m_size + 1;
+                return false;
+            }
+            s.resize(length);
+            return Raw(s.data(), length * sizeof(wchar_t));
+        }
+
+        [[nodiscard]] bool AtEnd() const noexcept { return m_offset == m_size; }
+
+    private:
+        bool Raw(void* out, const std::size_t size) noexcept
+        {
+            if (m_offset > m_size || size > m_size - m_offset)
+            {
+                m_offset = m_size + 1;
+                return false;
+            }
+            std::memcpy(out, m_data + m_offset, size);
+            m_offset += size;
+            return true;
+        }
+
+        const unsigned char* m_data;
+        std::size_t m_size;
+        std::size_t m_offset = 0;
+    };
+
+    bool ReadWholeFile(std::wstring const& filePath, std::vector<unsigned char>& out)
+    {
+        HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        bool ok = false;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart >= 0 && size.QuadPart < 0x7FFFFFFF)
+        {
+            out.resize(static_cast<std::size_t>(size.QuadPart));
+            DWORD read = 0;
+            ok = out.empty() ||
+                 (ReadFile(file, out.data(), static_cast<DWORD>(out.size()), &read, nullptr) && read == out.size());
+        }
+        CloseHandle(file);
+        return ok;
+    }
+
+    bool WriteWholeFile(std::wstring const& filePath, std::vector<unsigned char> const& data)
+    {
+        const std::wstring tempPath = filePath + L".tmp";
+        HANDLE file = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        DWORD written = 0;
+        const bool ok = data.size() < 0x7FFFFFFF &&
+                        WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr) &&
+                        written == data.size();
+        CloseHandle(file);
+
+        if (!ok || !MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            DeleteFileW(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+} // anonymous namespace
+
+SearchIndex::SearchIndex(const std::size_t maxTextBytes)
+    : m_maxTextChars(maxTextBytes / sizeof(wchar_t))
+    , m_chunks(std::make_unique<std::atomic<Node*>[]>(kMaxChunks))
+{
+    std::unique_lock lock(m_mutex);
+    ResetLocked();
+}
+
+SearchIndex::~SearchIndex() = default;
+
+void SearchIndex::ResetLocked()
+{
+    for (Shard& shard : m_shards)
+    {
+        shard.edges.clear();
+    }
+    for (std::size_t i = 0; i < kMaxChunks; ++i)
+    {
+        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    std::lock_guard grow(m_growMutex);
+    m_ownedChunks.clear();
+    m_roots.fill(kNoNode);
+    m_nextId.store(1, std::memory_order_relaxed); // 0 is kNoNode
+    m_textChars.store(0, std::memory_order_relaxed);
+}
+
+SearchIndex::Shard& SearchIndex::EdgeShard(EdgeKey const& key) const noexcept
+{
+    // Top bits: the shard's own map buckets by the low ones.
+    constexpr int kShift = std::numeric_limits<std::size_t>::digits - 6;
+    static_assert(kShardCount == 64);
+    return m_shards[EdgeKeyHash{}(key) >> kShift];
+}
+
+SearchIndex::Shard& SearchIndex::NodeShard(const NodeId id) const noexcept
+{
+    return m_shards[id % kShardCount];
+}
+
+SearchIndex::Node& SearchIndex::NodeAt(const NodeId id) const noexcept
+{
+    return m_chunks[id / kChunkNodes].load(std::memory_order_acquire)[id % kChunkNodes];
+}
+
+bool SearchIndex::IsValid(const NodeId id) const noexcept
+{
+    return id != kNoNode && id < kMaxChunks * kChunkNodes && id < m_nextId.load(std::memory_order_acquire) &&
+           m_chunks[id / kChunkNodes].load(std::memory_order_acquire) != nullptr;
+}
+
+SearchIndex::NodeId SearchIndex::AllocateNode(const NodeId parent, const std::uint32_t hive, std::wstring name)
+{
+    const NodeId id = m_nextId.fetch_add(1, std::memory_order_acq_rel);
+    if (id >= kMaxChunks * kChunkNodes)
+    {
+        return kNoNode;
+    }
+
+    std::atomic<Node*>& slot = m_chunks[id / kChunkNodes];
+    Node* chunk = slot.load(std::memory_order_acquire);
+    if (chunk == nullptr)
+    {
+        std::lock_guard grow(m_growMutex);
+        chunk = slot.load(std::memory_order_acquire);
+        if (chunk == nullptr)
+        {
+            m_ownedChunks.push_back(std::make_unique<Node[]>(kChunkNodes));
+            chunk = m_ownedChunks.back().get();
+            slot.store(chunk, std::memory_order_release);
+        }
+    }
+
+    Node& node = chunk[id % kChunkNodes];
+    node.parent = parent;
+    node.hive = hive;
+    node.name = std::move(name);
+    return id;
+}
+
+std::size_t SearchIndex::FitTextBudget(std::vector<ValueEntry>& values) const
+{
+    const std::size_t used = m_textChars.load(std::memory_order_relaxed);
+    std::size_t kept = 0;
+    for (ValueEntry& value : values)
+    {
+        if (value.text.empty())
+        {
+            continue;
+        }
+        if (used + kept + value.text.size() > m_maxTextChars)
+        {
+            value.text = std::wstring();
+            value.textComplete = false;
+            continue;
+        }
+        kept += value.text.size();
+    }
+    return kept;
+}
+
+SearchIndex::NodeId SearchIndex::RootNode(HKEY root)
+{
+    std::uint32_t hive = 0;
+    while (hive < kRootCount && kRoots[hive] != root)
+    {
+        ++hive;
+    }
+    if (hive == kRootCount)
+    {
+        return kNoNode;
+    }
+
+    std::shared_lock lock(m_mutex);
+    {
+        std::lock_guard grow(m_growMutex);
+        if (m_roots[hive] != kNoNode)
+        {
+            return m_roots[hive];
+        }
+    }
+
+    // Allocated outside m_growMutex, which AllocateNode takes for a new chunk; a racing
+    // caller may waste an id, which only leaves an empty root behind.
+    const NodeId id = AllocateNode(kNoNode, hive, std::wstring());
+    std::lock_guard grow(m_growMutex);
+    if (m_roots[hive] == kNoNode)
+    {
+        m_roots[hive] = id;
+    }
+    return m_roots[hive];
+}
+
+SearchIndex::NodeId SearchIndex::ChildNode(const NodeId parent, const std::wstring_view name)
+{
+    std::shared_lock lock(m_mutex);
+    if (!IsValid(parent))
+    {
+        return kNoNode;
+    }
+
+    EdgeKey key{ parent, FoldRegistryName(name) };
+    Shard& shard = EdgeShard(key);
+    {
+        std::shared_lock shardLock(shard.mutex);
+        const auto it = shard.edges.find(key);
+        if (it != shard.edges.end())
+        {
+            return it->second;
+        }
+    }
+
+    std::unique_lock shardLock(shard.mutex);
+    const auto it = shard.edges.find(key);
+    if (it != shard.edges.end())
+    {
+        return it->second;
+    }
+
+    // The node is filled in before the edge is published under the shard lock.
+    const NodeId id = AllocateNode(parent, NodeAt(parent).hive, key.name);
+    if (id != kNoNode)
+    {
+        shard.edges.emplace(std::move(key), id);
+    }
+    return id;
+}
+
+bool SearchIndex::VisitValues(const NodeId node, FILETIME const& lastWriteTime, ValueEntryVisitor const& visit) const
+{
+    std::shared_lock lock(m_mutex);
+    if (!IsValid(node))
+    {
+        return false;
+    }
+
+    std::shared_lock nodeLock(NodeShard(node).mutex);
+    const Node& entry = NodeAt(node);
+    if (!entry.filled || entry.lastWriteTime != ToTicks(lastWriteTime))
+    {
+        return false;
+    }
+
+    for (const ValueEntry& value : entry.values)
+    {
+        visit(value);
+    }
+    return true;
+}
+
+void SearchIndex::Update(const NodeId node, FILETIME const& lastWriteTime, std::vector<ValueEntry> values)
+{
+    std::shared_lock lock(m_mutex);
+    if (!IsValid(node))
+    {
+        return;
+    }
+
+    const std::size_t added = FitTextBudget(values);
+    std::size_t removed = 0;
+    {
+        std::unique_lock nodeLock(NodeShard(node).mutex);
+        Node& entry = NodeAt(node);
+        for (const ValueEntry& value : entry.values)
+        {
+            removed += value.text.size();
+        }
+        entry.lastWriteTime = ToTicks(lastWriteTime);
+        entry.filled = true;
+        entry.values.swap(values);
+    }
+    m_textChars.fetch_add(added, std::memory_order_relaxed);
+    m_textChars.fetch_sub(removed, std::memory_order_relaxed);
+}
+
+bool SearchIndex::Load(std::wstring const& filePath)
+{
+    std::vector<unsigned char> data;
+    const bool read = ReadWholeFile(filePath, data);
+
+    std::unique_lock lock(m_mutex);
+    ResetLocked();
+    if (!read)
+    {
+        return false;
+    }
+
+    Reader reader(data.data(), data.size());
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint32_t count = 0;
+    if (!reader.U32(magic) || magic != kMagic || !reader.U32(version) || version != kVersion ||
+        !reader.U32(count) || count >= kMaxChunks * kChunkNodes)
+    {
+        return false;
+    }
+
+    bool ok = true;
+    for (std::uint32_t i = 0; i < count && ok; ++i)
+    {
+        NodeId parent = kNoNode;
+        std::uint32_t hive = 0;
+        std::wstring name;
+        std::uint64_t lastWrite = 0;
+        std::uint8_t filled = 0;
+        std::uint32_t valueCount = 0;
+        ok = reader.U32(parent) && reader.U32(hive) && reader.Str(name) &&
+             reader.U64(lastWrite) && reader.U8(filled) && reader.U32(valueCount) &&
+             (parent == kNoNode || IsValid(parent)) && hive < kRootCount;
+
+        std::vector<ValueEntry> values;
+        for (std::uint32_t v = 0; v < valueCount && ok; ++v)
+        {
+            ValueEntry value;
+            std::uint32_t type = 0;
+            std::uint8_t complete = 0;
+            ok = reader.Str(value.name) && reader.U32(type) && reader.U8(complete) && reader.Str(value.text);
+            value.type = type;
+            value.textComplete = complete != 0;
+            if (value.text.size() > kMaxIndexedText)
+            {
+                value.text.resize(kMaxIndexedText);
+                value.text.shrink_to_fit();
+                value.textComplete = false;
+            }
+            values.push_back(std::move(value));
+        }
+        if (!ok)
+        {
+            break;
+        }
+
+        // Ids are handed out in file order, so parents keep the ids the file refers to.
+        EdgeKey key{ parent, name };
+        const NodeId id = AllocateNode(parent, hive, std::move(name));
+        if (parent == kNoNode)
+        {
+            ok = m_roots[hive] == kNoNode;
+            m_roots[hive] = id;
+        }
+        else
+        {
+            Shard& shard = EdgeShard(key);
+            ok = shard.edges.emplace(std::move(key), id).second;
+        }
+
+        m_textChars.fetch_add(FitTextBudget(values), std::memory_order_relaxed);
+        Node& node = NodeAt(id);
+        node.lastWriteTime = lastWrite;
+        node.filled = filled != 0;
+        node.values = std::move(values);
+    }
+
+    if (!ok || !reader.AtEnd())
+    {
+        ResetLocked();
+        return false;
+    }
+    return true;
+}
+
+bool SearchIndex::Save(std::wstring const& filePath) const
+{
+    Writer writer;
+    {
+        // Exclusive, so no id is handed out between reading the count and the nodes.
+        std::unique_lock lock(m_mutex);
+        const NodeId end = static_cast<NodeId>(
+            std::min<std::size_t>(m_nextId.load(std::memory_order_relaxed), kMaxChunks * kChunkNodes));
+        writer.U32(kMagic);
+        writer.U32(kVersion);
+        writer.U32(end - 1);
+        for (NodeId i = 1; i < end; ++i)
+        {
+            const Node& node = NodeAt(i);
+            writer.U32(node.parent);
+            writer.U32(node.hive);
+            writer.Str(node.name);
+            writer.U64(node.lastWriteTime);
+            writer.U8(node.filled ? 1 : 0);
+            writer.U32(static_cast<std::uint32_t>(node.values.size()));
+            for (const ValueEntry& value : node.values)
+            {
+                writer.Str(value.name);
+                writer.U32(static_cast<std::uint32_t>(value.type));
+                writer.U8(value.textComplete ? 1 : 0);
+                writer.Str(value.text);
+            }
+        }
+    }
+    return WriteWholeFile(filePath, writer.Buffer());
+}
+
+void SearchIndex::Clear()
+{
+    std::unique_lock lock(m_mutex);
+    ResetLocked();
+}
+
+std::size_t SearchIndex::Size() const
+{
+    return std::min<std::size_t>(m_nextId.load(std::memory_order_relaxed), kMaxChunks * kChunkNodes) - 1;
+}
+
+std::size_t SearchIndex::TextChars() const noexcept
+{
+    return m_textChars.load(std::memory_order_relaxed);
+}
+
+} // namespace core::registry
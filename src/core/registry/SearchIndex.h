@@ -0,0 +1,168 @@
+// SearchIndex.h
+#pragma once
+
+#include <windows.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core::registry
+{
+
+/**
+ * SearchIndex - what a previous search saw, so the next one can skip unchanged keys.
+ *
+ * Keys form a trie of path components (one node per key, children found through a
+ * (parent, folded name) edge table). A node records the key's last-write time and the
+ * names, types and string data of its values as of that time. A key's last-write time
+ * changes whenever one of its values does, so a later search that sees the same time
+ * (reported by the parent's subkey enumeration) visits the recorded values instead of
+ * enumerating and reading them again.
+ *
+ * String data is kept up to kMaxIndexedText characters per value, and up to maxTextBytes
+ * for the whole index; longer values, and every value once the budget is used up, are
+ * marked incomplete and re-read when a data match needs them. Keys deleted from the
+ * registry stay in the index until Clear().
+ *
+ * Thread-safe. Edges are spread over kShardCount shards by hash, each with its own
+ * std::shared_mutex; a node's values are guarded by the shard of its id. Nodes live in
+ * fixed-size chunks that never move, so creating a child only locks one shard and walkers
+ * of different keys rarely contend. Load, Save and Clear lock the whole index.
+ */
+class SearchIndex
+{
+public:
+    using NodeId = std::uint32_t;
+    static constexpr NodeId kNoNode = 0;
+    static constexpr std::size_t kMaxIndexedText = 256;
+    static constexpr std::size_t kDefaultMaxTextBytes = 32 * 1024 * 1024;
+    static constexpr std::size_t kShardCount = 64;
+
+    struct ValueEntry
+    {
+        std::wstring name;
+        DWORD type = 0;
+        std::wstring text;          // string data (REG_SZ, REG_EXPAND_SZ, REG_MULTI_SZ), else empty
+        bool textComplete = true;
+    };
+
+    using ValueEntryVisitor = std::function<void(ValueEntry const& value)>;
+
+    explicit SearchIndex(std::size_t maxTextBytes = kDefaultMaxTextBytes);
+    ~SearchIndex();
+
+    SearchIndex(const SearchIndex&) = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    // Node of a predefined root key; kNoNode for anything else.
+    NodeId RootNode(HKEY root);
+
+    // Node of parent's child called name (case-insensitive), created if missing.
+    NodeId ChildNode(NodeId parent, std::wstring_view name);
+
+    // Visits the recorded values of node if they were recorded at lastWriteTime; returns
+    // false (visiting nothing) if the node is unknown, was never filled, or is out of date.
+    bool VisitValues(NodeId node, FILETIME const& lastWriteTime, ValueEntryVisitor const& visit) const;
+
+    void Update(NodeId node, FILETIME const& lastWriteTime, std::vector<ValueEntry> values);
+
+    /**
+     * Load replaces the contents with the file's; it returns false, leaving the index empty,
+     * if the file is missing or not a valid index. Save writes to filePath.tmp and moves it
+     * over filePath, so a crash mid-save keeps the previous file.
+     */
+    bool Load(std::wstring const& filePath);
+    bool Save(std::wstring const& filePath) const;
+
+    void Clear();
+
+    [[nodiscard]] std::size_t Size() const;
+
+    // Characters of value data currently held, against the maxTextBytes budget.
+    [[nodiscard]] std::size_t TextChars() const noexcept;
+
+private:
+    // parent, hive and name are set before the node is published and never change; the
+    // rest is guarded by the node's shard.
+    struct Node
+    {
+        NodeId parent = kNoNode;
+        std::uint32_t hive = 0;     // index into the predefined roots, for root nodes
+        std::wstring name;          // folded; empty for root nodes
+        ULONGLONG lastWriteTime = 0;
+        bool filled = false;
+        std::vector<ValueEntry> values;
+    };
+
+    struct EdgeKey
+    {
+        NodeId parent = kNoNode;
+        std::wstring name;
+
+        bool operator==(const EdgeKey& other) const noexcept
+        {
+            return parent == other.parent && name == other.name;
+        }
+    };
+
+    struct EdgeKeyHash
+    {
+        std::size_t operator()(const EdgeKey& key) const noexcept
+        {
+            std::size_t h = std::hash<std::wstring_view>{}(key.name);
+            h ^= std::hash<NodeId>{}(key.parent) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            return h;
+        }
+    };
+
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<EdgeKey, NodeId, EdgeKeyHash> edges;
+    };
+
+    static constexpr std::size_t kChunkNodes = 4096;
+    static constexpr std::size_t kMaxChunks = 16 * 1024;     // 64M keys
+
+    Shard& EdgeShard(EdgeKey const& key) const noexcept;
+    Shard& NodeShard(NodeId id) const noexcept;
+    Node& NodeAt(NodeId id) const noexcept;
+    [[nodiscard]] bool IsValid(NodeId id) const noexcept;
+
+    // Takes a fresh id and fills in its fixed fields; kNoNode once the index is full.
+    NodeId AllocateNode(NodeId parent, std::uint32_t hive, std::wstring name);
+
+    // Drops the text of the values that do not fit the budget any more. Returns the
+    // characters kept.
+    std::size_t FitTextBudget(std::vector<ValueEntry>& values) const;
+
+    // Caller holds m_mutex exclusively.
+    void ResetLocked();
+
+    std::size_t m_maxTextChars;
+
+    // Shared by every operation on nodes, exclusive for Load, Save and Clear.
+    mutable std::shared_mutex m_mutex;
+    mutable std::array<Shard, kShardCount> m_shards;
+
+    // Chunk pointers are published with release and never change until ResetLocked.
+    // Id 0 is unused so that 0 can mean "no node".
+    std::unique_ptr<std::atomic<Node*>[]> m_chunks;
+    std::vector<std::unique_ptr<Node[]>> m_ownedChunks;    // guarded by m_growMutex
+    std::atomic<NodeId> m_nextId{ 1 };
+    std::atomic<std::size_t> m_textChars{ 0 };
+
+    std::mutex m_growMutex;                     // chunk allocation and m_roots
+    std::array<NodeId, 5> m_roots{};            // per predefined root, in SearchIndex.cpp's kRoots order
+};
+
+} // namespace core::registry
@@ -0,0 +1,123 @@
+// TreeWalkQueue.h
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace core::registry
+{
+
+/**
+ * TreeWalkQueue - pending keys of a tree walk shared by several walkers.
+ *
+ * A walker loops on Take() / Finish(): it takes a key, processes it and hands back its
+ * children. The walk is over when nothing is queued and no walker holds a key (nobody can
+ * queue more), or after Stop(). Items are taken LIFO, so the queue stays about
+ * depth x fan-out long instead of holding a whole level of a wide tree.
+ */
+template <typename Item>
+class TreeWalkQueue
+{
+public:
+    TreeWalkQueue() = default;
+
+    TreeWalkQueue(const TreeWalkQueue&) = delete;
+    TreeWalkQueue& operator=(const TreeWalkQueue&) = delete;
+
+    // Queues the starting items. Call before any walker runs.
+    void Seed(std::vector<Item>& items)
+    {
+        std::lock_guard lock(m_mutex);
+        for (Item& item : items)
+        {
+            m_pending.push_back(std::move(item));
+        }
+    }
+
+    // Blocks until an item is available. Returns false once the walk is over.
+    bool Take(Item& out)
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_done || !m_pending.empty() || m_active == 0; });
+        if (m_done)
+        {
+            return false;
+        }
+        if (m_pending.empty())
+        {
+            m_done = true;
+            lock.unlock();
+            m_cv.notify_all();
+            return false;
+        }
+        out = std::move(m_pending.back());
+        m_pending.pop_back();
+        ++m_active;
+        return true;
+    }
+
+    // Ends the item returned by the last Take() and queues its children.
+    void Finish(std::vector<Item>& children)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            --m_active;
+            if (!m_done)
+            {
+                for (Item& child : children)
+                {
+                    m_pending.push_back(std::move(child));
+                }
+            }
+            if (m_pending.empty() && m_active == 0)
+            {
+                m_done = true;
+            }
+        }
+        m_cv.notify_all();
+    }
+
+    // Ends the walk: queued items are dropped, Take() returns false from now on.
+    void Stop()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_done = true;
+            m_stopped = true;
+            m_pending.clear();
+        }
+        m_cv.notify_all();
+    }
+
+    // Waits until no walker holds an item; after a Stop() walkers may still finish one each.
+    void WaitIdle()
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_active == 0; });
+    }
+
+    [[nodiscard]] bool Stopped() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_stopped;
+    }
+
+    [[nodiscard]] std::size_t Pending() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_pending.size();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<Item> m_pending;
+    std::size_t m_active = 0;   // walkers holding an item
+    bool m_done = false;
+    bool m_stopped = false;
+};
+
+} // namespace core::registry
@@ -0,0 +1,151 @@
+// Utf16Matcher.cpp
+#include "Utf16Matcher.h"
+#include <cwctype>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#define REGISTRY_MATCHER_SSE2 1
+#endif
+
+namespace core::registry
+{
+
+namespace {
+
+    wchar_t FoldChar(const wchar_t c) noexcept
+    {
+        if (c < 0x80)
+        {
+            return (c >= L'a' && c <= L'z') ? static_cast<wchar_t>(c - (L'a' - L'A')) : c;
+        }
+        return static_cast<wchar_t>(std::towupper(c));
+    }
+
+    wchar_t OtherCase(const wchar_t c) noexcept
+    {
+        if (c < 0x80)
+        {
+            return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + (L'a' - L'A')) : c;
+        }
+        return static_cast<wchar_t>(std::towlower(c));
+    }
+
+#ifdef REGISTRY_MATCHER_SSE2
+    // Bit 2k of the result is set when lane k equals a or b.
+    int MatchMask(const wchar_t* text, const __m128i a, const __m128i b) noexcept
+    {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+        const __m128i hit = _mm_or_si128(_mm_cmpeq_epi16(chunk, a), _mm_cmpeq_epi16(chunk, b));
+        return _mm_movemask_epi8(hit) & 0x5555;
+    }
+#endif
+
+} // anonymous namespace
+
+Utf16Matcher::Utf16Matcher(const std::wstring_view pattern, const bool caseSensitive)
+    : m_pattern(pattern)
+    , m_caseSensitive(caseSensitive)
+{
+    if (m_pattern.empty())
+    {
+        return;
+    }
+
+    if (!caseSensitive)
+    {
+        for (wchar_t& c : m_pattern)
+        {
+            c = FoldChar(c);
+        }
+    }
+
+    m_first = m_pattern.front();
+    m_last = m_pattern.back();
+    m_firstAlt = caseSensitive ? m_first : OtherCase(m_first);
+    m_lastAlt = caseSensitive ? m_last : OtherCase(m_last);
+}
+
+bool Utf16Matcher::MatchesAt(const wchar_t* text) const noexcept
+{
+    if (m_caseSensitive)
+    {
+        return std::wstring_view(text, m_pattern.size()) == m_pattern;
+    }
+    for (size_t i = 0; i < m_pattern.size(); ++i)
+    {
+        if (FoldChar(text[i]) != m_pattern[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Utf16Matcher::FindScalar(const std::wstring_view haystack, size_t from) const noexcept
+{
+    const size_t lastStart = haystack.size() - m_pattern.size();
+    for (; from <= lastStart; ++from)
+    {
+        const wchar_t c = haystack[from];
+        if ((c == m_first || c == m_firstAlt) && MatchesAt(haystack.data() + from))
+        {
+            return from;
+        }
+    }
+    return std::wstring_view::npos;
+}
+
+bool Utf16Matcher::Find(const std::wstring_view haystack) const noexcept
+{
+    if (m_pattern.empty())
+    {
+        return true;
+    }
+    if (haystack.size() < m_pattern.size())
+    {
+        return false;
+    }
+
+    size_t start = 0;
+
+#ifdef REGISTRY_MATCHER_SSE2
+    if constexpr (sizeof(wchar_t) == 2)
+    {
+        const size_t lastStart = haystack.size() - m_pattern.size();
+        const size_t tailOffset = m_pattern.size() - 1;
+
+        const __m128i first = _mm_set1_epi16(static_cast<short>(m_first));
+        const __m128i firstAlt = _mm_set1_epi16(static_cast<short>(m_firstAlt));
+        const __m128i last = _mm_set1_epi16(static_cast<short>(m_last));
+        const __m128i lastAlt = _mm_set1_epi16(static_cast<short>(m_lastAlt));
+
+        // Each block tests the 8 start positions [start, start + 8).
+        for (; start + 8 <= lastStart + 1; start += 8)
+        {
+            const wchar_t* text = haystack.data() + start;
+            int mask = MatchMask(text, first, firstAlt) & MatchMask(text + tailOffset, last, lastAlt);
+            while (mask != 0)
+            {
+                unsigned long bit = 0;
+#if defined(_MSC_VER)
+                _BitScanForward(&bit, static_cast<unsigned long>(mask));
+#else
+                bit = static_cast<unsigned long>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+                if (MatchesAt(text + bit / 2))
+                {
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+        }
+    }
+#endif
+
+    return FindScalar(haystack, start) != std::wstring_view::npos;
+}
+
+} // namespace core::registry
@@ -0,0 +1,46 @@
+// Utf16Matcher.h
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace core::registry
+{
+
+/**
+ * Utf16Matcher - substring search for one fixed pattern in UTF-16 text.
+ *
+ * Case-insensitive matching folds to upper case like FoldRegistryName: ASCII directly,
+ * other characters with towupper (no locale-specific or multi-character mappings).
+ *
+ * Where SSE2 is available (every x64 build), candidates are found 8 code units at a time by
+ * comparing the pattern's first and last characters (both cases) against the haystack; only
+ * positions where both match are verified. Otherwise, and for the tail, a scalar loop is used.
+ */
+class Utf16Matcher
+{
+public:
+    Utf16Matcher() = default;
+    Utf16Matcher(std::wstring_view pattern, bool caseSensitive);
+
+    [[nodiscard]] bool Find(std::wstring_view haystack) const noexcept;
+
+    [[nodiscard]] bool Empty() const noexcept { return m_pattern.empty(); }
+    [[nodiscard]] std::wstring const& Pattern() const noexcept { return m_pattern; }
+
+private:
+    [[nodiscard]] bool MatchesAt(const wchar_t* text) const noexcept;
+    [[nodiscard]] size_t FindScalar(std::wstring_view haystack, size_t from) const noexcept;
+
+    std::wstring m_pattern;     // folded unless case-sensitive
+    bool m_caseSensitive = false;
+
+    // First and last pattern characters in both cases (equal when case-sensitive).
+    wchar_t m_first = 0;
+    wchar_t m_firstAlt = 0;
+    wchar_t m_last = 0;
+    wchar_t m_lastAlt = 0;
+};
+
+} // namespace core::registry
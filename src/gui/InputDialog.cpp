@@ -0,0 +1,274 @@
+// InputDialog.cpp
+#include "InputDialog.h"
+#include <cwchar>
+#include <utility>
+#include <vector>
+
+// Control ids of the dialogs below (IDOK / IDCANCEL for the buttons).
+static constexpr WORD IDC_PROMPT_LABEL = 100;
+static constexpr WORD IDC_PROMPT_EDIT = 101;
+static constexpr WORD IDC_SEARCH_KEYS = 102;
+static constexpr WORD IDC_SEARCH_VALUES = 103;
+static constexpr WORD IDC_SEARCH_DATA = 104;
+static constexpr WORD IDC_SEARCH_CASE = 105;
+
+// Predefined control classes, by atom (see DLGITEMTEMPLATE).
+static constexpr WORD DLG_CLASS_BUTTON = 0x0080;
+static constexpr WORD DLG_CLASS_EDIT = 0x0081;
+static constexpr WORD DLG_CLASS_STATIC = 0x0082;
+
+// -------------------- In-memory dialog template --------------------
+namespace
+{
+    // DLGTEMPLATE followed by its DLGITEMTEMPLATEs, laid out as DialogBoxIndirectParamW expects:
+    // WORD-aligned strings, DWORD-aligned items. Coordinates are dialog units.
+    class DialogTemplate
+    {
+    public:
+        DialogTemplate(const wchar_t* title, short width, short height)
+        {
+            AddDWord(WS_POPUP | WS_CAPTION | WS_SYSMENU | DS_MODALFRAME | DS_CENTER | DS_SETFONT);
+            AddDWord(0);           // extended style
+            m_data.push_back(0);   // item count, patched by AddControl
+            m_data.push_back(0);   // x
+            m_data.push_back(0);   // y
+            m_data.push_back(static_cast<WORD>(width));
+            m_data.push_back(static_cast<WORD>(height));
+            m_data.push_back(0);   // no menu
+            m_data.push_back(0);   // default dialog class
+            AddString(title);
+            m_data.push_back(8);   // point size
+            AddString(L"MS Shell Dlg");
+        }
+
+        void AddControl(WORD classAtom, const wchar_t* text, WORD id, DWORD style,
+                        short x, short y, short width, short height)
+        {
+            if (m_data.size() % 2 != 0)
+            {
+                m_data.push_back(0);
+            }
+            AddDWord(WS_CHILD | WS_VISIBLE | style);
+            AddDWord(0);
+            m_data.push_back(static_cast<WORD>(x));
+            m_data.push_back(static_cast<WORD>(y));
+            m_data.push_back(static_cast<WORD>(width));
+            m_data.push_back(static_cast<WORD>(height));
+            m_data.push_back(id);
+            m_data.push_back(0xFFFF);
+            m_data.push_back(classAtom);
+            AddString(text);
+            m_data.push_back(0);   // no creation data
+
+            ++m_data[kItemCountIndex];
+        }
+
+        [[nodiscard]] const DLGTEMPLATE* Get() const noexcept
+        {
+            return reinterpret_cast<const DLGTEMPLATE*>(m_data.data());
+        }
+
+    private:
+        static constexpr size_t kItemCountIndex = 4; // after the style and extended style DWORDs
+
+        std::vector<WORD> m_data;
+
+        void AddDWord(DWORD value)
+        {
+            m_data.push_back(static_cast<WORD>(value & 0xFFFF));
+            m_data.push_back(static_cast<WORD>(value >> 16));
+        }
+
+        void AddString(const wchar_t* text)
+        {
+            for (; *text != L'\0'; ++text)
+            {
+                m_data.push_back(static_cast<WORD>(*text));
+            }
+            m_data.push_back(0);
+        }
+    };
+
+    std::wstring GetControlText(HWND dialog, const int id)
+    {
+        HWND control = GetDlgItem(dialog, id);
+        const int length = GetWindowTextLengthW(control);
+        std::wstring text(static_cast<size_t>(length > 0 ? length : 0) + 1, L'\0');
+        const int copied = GetWindowTextW(control, text.data(), static_cast<int>(text.size()));
+        text.resize(static_cast<size_t>(copied > 0 ? copied : 0));
+        return text;
+    }
+}
+
+// -------------------- Text prompt --------------------
+namespace
+{
+    struct PromptState
+    {
+        const wchar_t* label;
+        std::wstring const* initial;
+        std::wstring result;
+    };
+
+    INT_PTR CALLBACK PromptDialogProc(HWND dialog, UINT msg, WPARAM wParam, LPARAM lParam)
+    {
+        switch (msg)
+        {
+            case WM_INITDIALOG:
+            {
+                auto* state = reinterpret_cast<PromptState*>(lParam);
+                SetWindowLongPtrW(dialog, DWLP_USER, lParam);
+                SetDlgItemTextW(dialog, IDC_PROMPT_LABEL, state->label);
+                SetDlgItemTextW(dialog, IDC_PROMPT_EDIT, state->initial->c_str());
+
+                HWND edit = GetDlgItem(dialog, IDC_PROMPT_EDIT);
+                SendMessageW(edit, EM_SETSEL, 0, -1);
+                SetFocus(edit);
+                return FALSE; // focus was set here
+            }
+
+            case WM_COMMAND:
+            {
+                const WORD id = LOWORD(wParam);
+                if (id == IDOK)
+                {
+                    auto* state = reinterpret_cast<PromptState*>(GetWindowLongPtrW(dialog, DWLP_USER));
+                    state->result = GetControlText(dialog, IDC_PROMPT_EDIT);
+                    EndDialog(dialog, IDOK);
+                    return TRUE;
+                }
+                if (id == IDCANCEL)
+                {
+                    EndDialog(dialog, IDCANCEL);
+                    return TRUE;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+        return FALSE;
+    }
+}
+
+std::optional<std::wstring> PromptForText(HINSTANCE instance, HWND owner, const wchar_t* title,
+                                          const wchar_t* label, std::wstring const& initial)
+{
+    DialogTemplate dialog(title, 280, 62);
+    dialog.AddControl(DLG_CLASS_STATIC, L"", IDC_PROMPT_LABEL, SS_LEFT, 7, 7, 266, 10);
+    dialog.AddControl(DLG_CLASS_EDIT, L"", IDC_PROMPT_EDIT, WS_BORDER | WS_TABSTOP | ES_AUTOHSCROLL,
+                      7, 20, 266, 14);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"OK", IDOK, WS_TABSTOP | BS_DEFPUSHBUTTON, 169, 41, 50, 14);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"Cancel", IDCANCEL, WS_TABSTOP | BS_PUSHBUTTON, 223, 41, 50, 14);
+
+    PromptState state{ label, &initial, {} };
+    const INT_PTR answer = DialogBoxIndirectParamW(instance, dialog.Get(), owner, &PromptDialogProc,
+                                                   reinterpret_cast<LPARAM>(&state));
+    if (answer != IDOK)
+    {
+        return std::nullopt;
+    }
+    return state.result;
+}
+
+// -------------------- Find dialog --------------------
+namespace
+{
+    bool IsChecked(HWND dialog, const int id)
+    {
+        return IsDlgButtonChecked(dialog, id) == BST_CHECKED;
+    }
+
+    void SetChecked(HWND dialog, const int id, const bool checked)
+    {
+        CheckDlgButton(dialog, id, checked ? BST_CHECKED : BST_UNCHECKED);
+    }
+
+    INT_PTR CALLBACK SearchDialogProc(HWND dialog, UINT msg, WPARAM wParam, LPARAM lParam)
+    {
+        switch (msg)
+        {
+            case WM_INITDIALOG:
+            {
+                auto* query = reinterpret_cast<core::registry::SearchQuery*>(lParam);
+                SetWindowLongPtrW(dialog, DWLP_USER, lParam);
+                SetDlgItemTextW(dialog, IDC_PROMPT_EDIT, query->pattern.c_str());
+                SetChecked(dialog, IDC_SEARCH_KEYS, query->matchKeyNames);
+                SetChecked(dialog, IDC_SEARCH_VALUES, query->matchValueNames);
+                SetChecked(dialog, IDC_SEARCH_DATA, query->matchData);
+                SetChecked(dialog, IDC_SEARCH_CASE, query->caseSensitive);
+
+                HWND edit = GetDlgItem(dialog, IDC_PROMPT_EDIT);
+                SendMessageW(edit, EM_SETSEL, 0, -1);
+                SetFocus(edit);
+                return FALSE; // focus was set here
+            }
+
+            case WM_COMMAND:
+            {
+                const WORD id = LOWORD(wParam);
+                if (id == IDOK)
+                {
+                    std::wstring pattern = GetControlText(dialog, IDC_PROMPT_EDIT);
+                    const bool keys = IsChecked(dialog, IDC_SEARCH_KEYS);
+                    const bool values = IsChecked(dialog, IDC_SEARCH_VALUES);
+                    const bool data = IsChecked(dialog, IDC_SEARCH_DATA);
+                    if (pattern.empty() || (!keys && !values && !data))
+                    {
+                        MessageBeep(MB_ICONWARNING); // nothing to look for; keep the dialog open
+                        return TRUE;
+                    }
+
+                    auto* query = reinterpret_cast<core::registry::SearchQuery*>(GetWindowLongPtrW(dialog, DWLP_USER));
+                    query->pattern = std::move(pattern);
+                    query->matchKeyNames = keys;
+                    query->matchValueNames = values;
+                    query->matchData = data;
+                    query->caseSensitive = IsChecked(dialog, IDC_SEARCH_CASE);
+                    EndDialog(dialog, IDOK);
+                    return TRUE;
+                }
+                if (id == IDCANCEL)
+                {
+                    EndDialog(dialog, IDCANCEL);
+                    return TRUE;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+        return FALSE;
+    }
+}
+
+bool PromptForSearch(HINSTANCE instance, HWND owner, core::registry::SearchQuery& query)
+{
+    DialogTemplate dialog(L"Find", 280, 96);
+    dialog.AddControl(DLG_CLASS_STATIC, L"Find what:", IDC_PROMPT_LABEL, SS_LEFT, 7, 7, 266, 10);
+    dialog.AddControl(DLG_CLASS_EDIT, L"", IDC_PROMPT_EDIT, WS_BORDER | WS_TABSTOP | ES_AUTOHSCROLL,
+                      7, 20, 266, 14);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"&Key names", IDC_SEARCH_KEYS, WS_TABSTOP | BS_AUTOCHECKBOX,
+                      7, 41, 80, 10);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"&Value names", IDC_SEARCH_VALUES, WS_TABSTOP | BS_AUTOCHECKBOX,
+                      92, 41, 80, 10);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"&Data", IDC_SEARCH_DATA, WS_TABSTOP | BS_AUTOCHECKBOX,
+                      177, 41, 80, 10);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"Match &case", IDC_SEARCH_CASE, WS_TABSTOP | BS_AUTOCHECKBOX,
+                      7, 56, 80, 10);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"Find", IDOK, WS_TABSTOP | BS_DEFPUSHBUTTON, 169, 75, 50, 14);
+    dialog.AddControl(DLG_CLASS_BUTTON, L"Cancel", IDCANCEL, WS_TABSTOP | BS_PUSHBUTTON, 223, 75, 50, 14);
+
+    // The dialog edits a copy, so a cancel leaves query as it was.
+    core::registry::SearchQuery edited = query;
+    const INT_PTR answer = DialogBoxIndirectParamW(instance, dialog.Get(), owner, &SearchDialogProc,
+                                                   reinterpret_cast<LPARAM>(&edited));
+    if (answer != IDOK)
+    {
+        return false;
+    }
+    query = std::move(edited);
+    return true;
+}
@@ -0,0 +1,20 @@
+// InputDialog.h
+#pragma once
+
+// Small modal dialogs built from in-memory templates, so the GUI needs no resource script.
+// All functions run a nested message loop and must be called on the UI thread.
+
+#include <windows.h>
+#include <optional>
+#include <string>
+#include "../core/registry/RegistrySearch.h"
+
+// Asks for one line of text under label. initial is shown selected. Returns std::nullopt if
+// the dialog was cancelled; an empty string is returned as is.
+std::optional<std::wstring> PromptForText(HINSTANCE instance, HWND owner, const wchar_t* title,
+                                          const wchar_t* label, std::wstring const& initial);
+
+// Find dialog: pattern, what to match (key names, value names, string data) and case. query
+// supplies the initial state and receives the choice; returns false if the dialog was
+// cancelled, leaving query untouched. The pattern is never empty on success.
+bool PromptForSearch(HINSTANCE instance, HWND owner, core::registry::SearchQuery& query);
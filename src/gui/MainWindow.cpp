@@ -9,19 +9,273 @@
 //  - RegistryFacade has ListSubKeys(...) and is usable from background threads.
 
 #include "MainWindow.h"
+#include "InputDialog.h"
 #include "RegistryTreeView.h"
 #include "IThreadManager.h"
 #include "../core/registry/RegistryFacade.h"
+#include "../core/registry/RegistrySearch.h"
+#include "../core/registry/SearchIndex.h"
+#include "../core/metrics/RuntimeMetrics.h"
 
 
 #include <windows.h>
 #include <commctrl.h>
+#include <commdlg.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdarg>
+#include <cstring>
+#include <cwchar>
 #include <iostream>
+#include <optional>
+#include <shlobj.h>
+#include <string>
 
 // Window class name used for RegisterClassEx / CreateWindowEx
 static const wchar_t MAIN_WNDCLASS_NAME[] = L"RegistryEditor.MainWindow";
 
+// Stats panel: WM_TIMER id, refresh period and height.
+static constexpr UINT_PTR STATS_TIMER_ID = 1;
+static constexpr UINT STATS_REFRESH_MS = 1000;
+static constexpr int STATS_PANEL_HEIGHT = 200;
+
+// Search results panel height; Key column width.
+static constexpr int RESULTS_PANEL_HEIGHT = 200;
+static constexpr int RESULTS_KEY_COLUMN_WIDTH = 420;
+
+// Filter of the snapshot open / save dialogs.
+static const wchar_t SNAPSHOT_FILE_FILTER[] = L"Registry snapshots (*.rsnap)\0*.rsnap\0All files (*.*)\0*.*\0";
+
+// Menu command ids (WM_COMMAND).
+static constexpr UINT IDM_EXIT = 40001;
+static constexpr UINT IDM_OPEN_SNAPSHOT = 40002;
+static constexpr UINT IDM_SHOW_LIVE = 40003;
+static constexpr UINT IDM_COPY_KEY = 40101;
+static constexpr UINT IDM_MOVE_KEY = 40102;
+static constexpr UINT IDM_EXPORT_KEY = 40103;
+static constexpr UINT IDM_CANCEL_OPERATIONS = 40104;
+static constexpr UINT IDM_CAPTURE_SNAPSHOT = 40105;
+static constexpr UINT IDM_FIND = 40201;
+static constexpr UINT IDM_CANCEL_SEARCH = 40202;
+static constexpr UINT IDM_SEARCH_RESULTS = 40203;
+
+// -------------------- Command helpers --------------------
+namespace
+{
+    struct HiveAlias
+    {
+        const wchar_t* longName;
+        const wchar_t* shortName;
+        HKEY root;
+    };
+
+    const HiveAlias kHives[] = {
+        { L"HKEY_CLASSES_ROOT", L"HKCR", HKEY_CLASSES_ROOT },
+        { L"HKEY_CURRENT_USER", L"HKCU", HKEY_CURRENT_USER },
+        { L"HKEY_LOCAL_MACHINE", L"HKLM", HKEY_LOCAL_MACHINE },
+        { L"HKEY_USERS", L"HKU", HKEY_USERS },
+        { L"HKEY_CURRENT_CONFIG", L"HKCC", HKEY_CURRENT_CONFIG },
+    };
+
+    // "HKEY_CURRENT_USER\Software\X" (or "HKCU\Software\X") -> root and subkey path.
+    bool ParseKeyPath(std::wstring const& text, HKEY& root, std::wstring& subKeyPath)
+    {
+        const size_t separator = text.find(L'\\');
+        const std::wstring hive = text.substr(0, separator);
+        for (const HiveAlias& alias : kHives)
+        {
+            if (CompareStringOrdinal(hive.c_str(), -1, alias.longName, -1, TRUE) == CSTR_EQUAL ||
+                CompareStringOrdinal(hive.c_str(), -1, alias.shortName, -1, TRUE) == CSTR_EQUAL)
+            {
+                root = alias.root;
+                subKeyPath = separator == std::wstring::npos ? std::wstring() : text.substr(separator + 1);
+                while (!subKeyPath.empty() && subKeyPath.back() == L'\\')
+                {
+                    subKeyPath.pop_back();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Common open / save dialog; std::nullopt if cancelled.
+    std::optional<std::wstring> AskFileName(HWND owner, const bool save, const wchar_t* filter,
+                                            const wchar_t* defaultExtension)
+    {
+        wchar_t fileName[MAX_PATH] = L"";
+
+        OPENFILENAMEW ofn;
+        ZeroMemory(&ofn, sizeof(OPENFILENAMEW));
+        ofn.lStructSize = sizeof(OPENFILENAMEW);
+        ofn.hwndOwner = owner;
+        ofn.lpstrFilter = filter;
+        ofn.lpstrFile = fileName;
+        ofn.nMaxFile = MAX_PATH;
+        ofn.lpstrDefExt = defaultExtension;
+        ofn.Flags = OFN_PATHMUSTEXIST | OFN_NOCHANGEDIR | (save ? OFN_OVERWRITEPROMPT : OFN_FILEMUSTEXIST);
+
+        const BOOL chosen = save ? GetSaveFileNameW(&ofn) : GetOpenFileNameW(&ofn);
+        if (chosen == FALSE)
+        {
+            return std::nullopt;
+        }
+        return std::wstring(fileName);
+    }
+
+    // root\subKeyPath with the hive's long name, as the user types it.
+    std::wstring FormatKeyPath(HKEY root, std::wstring const& subKeyPath)
+    {
+        std::wstring text = L"?";
+        for (const HiveAlias& alias : kHives)
+        {
+            if (alias.root == root)
+            {
+                text = alias.longName;
+                break;
+            }
+        }
+        if (!subKeyPath.empty())
+        {
+            text += L'\\';
+            text += subKeyPath;
+        }
+        return text;
+    }
+
+    // %LOCALAPPDATA%\SP_COURSE_WORK\search.idx, creating the directory; empty if unavailable,
+    // in which case the index lives for this run only.
+    std::wstring SearchIndexPath()
+    {
+        wchar_t base[MAX_PATH];
+        const DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", base, MAX_PATH);
+        if (length == 0 || length >= MAX_PATH)
+        {
+            return {};
+        }
+
+        const std::wstring directory = std::wstring(base, length) + L"\\SP_COURSE_WORK";
+        const int created = SHCreateDirectoryExW(nullptr, directory.c_str(), nullptr);
+        if (created != ERROR_SUCCESS && created != ERROR_ALREADY_EXISTS)
+        {
+            return {};
+        }
+        return directory + L"\\search.idx";
+    }
+}
+
+// -------------------- Stats panel text --------------------
+namespace
+{
+    using core::metrics::LatencySummary;
+    using core::registry::RegistryFacade;
+
+    // Counts print as %llu, which every CRT in use accepts (unlike %zu).
+    unsigned long long Count(const std::uint64_t value)
+    {
+        return static_cast<unsigned long long>(value);
+    }
+
+    std::wstring FormatDuration(const std::uint64_t ns)
+    {
+        wchar_t buffer[32];
+        if (ns < 1000)
+        {
+            std::swprintf(buffer, 32, L"%llu ns", Count(ns));
+        }
+        else if (ns < 1000000)
+        {
+            std::swprintf(buffer, 32, L"%.1f us", static_cast<double>(ns) / 1e3);
+        }
+        else if (ns < 1000000000)
+        {
+            std::swprintf(buffer, 32, L"%.2f ms", static_cast<double>(ns) / 1e6);
+        }
+        else
+        {
+            std::swprintf(buffer, 32, L"%.2f s", static_cast<double>(ns) / 1e9);
+        }
+        return buffer;
+    }
+
+    void AppendLine(std::wstring& text, const wchar_t* format, ...)
+    {
+        wchar_t buffer[256];
+        va_list args;
+        va_start(args, format);
+        std::vswprintf(buffer, 256, format, args);
+        va_end(args);
+        text += buffer;
+        text += L"\r\n";
+    }
+
+    // The metric names are ASCII.
+    std::wstring Widen(const char* text)
+    {
+        return std::wstring(text, text + std::strlen(text));
+    }
+
+    void AppendLatencyRow(std::wstring& text, const char* name, LatencySummary const& latency)
+    {
+        AppendLine(text, L"  %-10ls %10llu %10ls %10ls %10ls %10ls %10ls", Widen(name).c_str(), Count(latency.count),
+                   FormatDuration(latency.p50Ns).c_str(), FormatDuration(latency.p90Ns).c_str(),
+                   FormatDuration(latency.p99Ns).c_str(), FormatDuration(latency.p999Ns).c_str(),
+                   FormatDuration(latency.maxNs).c_str());
+    }
+
+    std::wstring FormatStats(core::metrics::MetricsSnapshot const& current,
+                             core::metrics::MetricsSnapshot const* previous)
+    {
+        std::wstring text;
+        if (current.registry)
+        {
+            const RegistryFacade::PerformanceStats& stats = *current.registry;
+            const size_t lookups = stats.cacheHits + stats.cacheMisses;
+            AppendLine(text, L"Registry: cache %.1f%% of %llu lookups, %llu keys opened, %llu values read, %llu written",
+                       lookups == 0 ? 0.0 : 100.0 * static_cast<double>(stats.cacheHits) / static_cast<double>(lookups),
+                       Count(lookups), Count(stats.keysOpened), Count(stats.valuesRead), Count(stats.valuesWritten));
+            AppendLine(text, L"  %-10ls %10ls %10ls %10ls %10ls %10ls %10ls",
+                       L"operation", L"count", L"p50", L"p90", L"p99", L"p99.9", L"max");
+            for (size_t i = 0; i < RegistryFacade::kOperationKindCount; ++i)
+            {
+                AppendLatencyRow(text, RegistryFacade::OperationName(static_cast<RegistryFacade::OperationKind>(i)),
+                                 stats.latency[i]);
+            }
+            for (size_t i = 0; i < RegistryFacade::kHiveCount; ++i)
+            {
+                const RegistryFacade::HiveCacheStats& hive = stats.cacheByHive[i];
+                if (hive.hits + hive.misses > 0)
+                {
+                    AppendLine(text, L"  %-20ls cache %5.1f%% (%llu hits, %llu misses)",
+                               Widen(RegistryFacade::HiveName(static_cast<RegistryFacade::Hive>(i))).c_str(),
+                               100.0 * hive.HitRatio(), Count(hive.hits), Count(hive.misses));
+                }
+            }
+        }
+
+        if (current.threadPool)
+        {
+            const LatencySummary& wait = current.threadPool->waitTime;
+            AppendLine(text, L"Thread pool: %llu queued; wait p50 %ls, p99 %ls, max %ls over %llu tasks",
+                       Count(current.threadPool->queuedTasks), FormatDuration(wait.p50Ns).c_str(),
+                       FormatDuration(wait.p99Ns).c_str(), FormatDuration(wait.maxNs).c_str(), Count(wait.count));
+        }
+
+        if (current.logger)
+        {
+            const core::logging::LoggerStats* before =
+                previous != nullptr && previous->logger ? &*previous->logger : nullptr;
+            const core::metrics::LoggerRates rates = core::metrics::ComputeLoggerRates(
+                *current.logger, before, previous != nullptr ? current.taken - previous->taken
+                                                             : std::chrono::steady_clock::duration::zero());
+            AppendLine(text, L"Logger: %llu queued, %llu written, %llu dropped; drop rate %.2f%% (%.1f/s)",
+                       Count(current.logger->queue_size), Count(current.logger->written_count),
+                       Count(current.logger->dropped_count), 100.0 * rates.dropRatio, rates.droppedPerSecond);
+        }
+        return text;
+    }
+}
+
 // -------------------- Helpers: set/get 'this' pointer on HWND --------------------
 void
 MainWindow::SetThisPtr(HWND hwnd, MainWindow* self)
@@ -82,6 +336,43 @@ MainWindow::CreateChildControls()
     // Populate top-level hive nodes (HKEY_CURRENT_USER, etc).
     m_tree->PopulateHives();
 
+    // Stats panel starts hidden; F12 shows it.
+    m_statsPanel = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+                                   WS_CHILD | WS_VSCROLL | ES_MULTILINE | ES_READONLY | ES_AUTOVSCROLL,
+                                   0, 0, 0, 0, m_hwnd, nullptr, m_hInstance, nullptr);
+    if (m_statsPanel != nullptr)
+    {
+        SendMessageW(m_statsPanel, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(ANSI_FIXED_FONT)), FALSE);
+    }
+
+    // Search results start hidden too; the rows are drawn from the tree's hits on demand.
+    m_resultsPanel = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
+                                     WS_CHILD | WS_TABSTOP | LVS_REPORT | LVS_OWNERDATA | LVS_SINGLESEL |
+                                     LVS_SHOWSELALWAYS,
+                                     0, 0, 0, 0, m_hwnd, nullptr, m_hInstance, nullptr);
+    if (m_resultsPanel != nullptr)
+    {
+        ListView_SetExtendedListViewStyle(m_resultsPanel, LVS_EX_FULLROWSELECT);
+
+        const struct
+        {
+            const wchar_t* title;
+            int width;
+        } columns[] = { { L"Key", RESULTS_KEY_COLUMN_WIDTH }, { L"Value", 160 }, { L"Match", 90 } };
+        for (int i = 0; i < 3; ++i)
+        {
+            LVCOLUMNW column;
+            ZeroMemory(&column, sizeof(LVCOLUMNW));
+            column.mask = LVCF_TEXT | LVCF_WIDTH;
+            column.pszText = const_cast<LPWSTR>(columns[i].title);
+            column.cx = columns[i].width;
+            ListView_InsertColumn(m_resultsPanel, i, &column);
+        }
+    }
+
+    // The index makes repeated searches skip unchanged subtrees; it is kept between runs.
+    m_tree->SetSearchIndex(std::make_shared<core::registry::SearchIndex>(), SearchIndexPath());
+
     return true;
 }
 
@@ -89,21 +380,505 @@ MainWindow::CreateChildControls()
 void
 MainWindow::LayoutChildren(int width, int height)
 {
+    // Panels stack up from the bottom; each takes at most a third of the height when both show.
+    const bool showStats = m_statsVisible && m_statsPanel != nullptr;
+    const bool showResults = m_resultsVisible && m_resultsPanel != nullptr;
+    const int share = height / ((showStats ? 1 : 0) + (showResults ? 1 : 0) + 1);
+
+    int treeHeight = height;
+    if (showStats)
+    {
+        const int panelHeight = std::min(STATS_PANEL_HEIGHT, share);
+        treeHeight -= panelHeight;
+        MoveWindow(m_statsPanel, 0, treeHeight, width, panelHeight, TRUE);
+    }
+    if (showResults)
+    {
+        const int panelHeight = std::min(RESULTS_PANEL_HEIGHT, share);
+        treeHeight -= panelHeight;
+        MoveWindow(m_resultsPanel, 0, treeHeight, width, panelHeight, TRUE);
+    }
+
     if (m_tree != nullptr && m_tree->Handle() != nullptr)
     {
-        MoveWindow(m_tree->Handle(), 0, 0, width, height, TRUE);
+        MoveWindow(m_tree->Handle(), 0, 0, width, treeHeight, TRUE);
         m_tree->UpdateColumnWidth();
     }
 }
 
+void
+MainWindow::Relayout()
+{
+    RECT client;
+    GetClientRect(m_hwnd, &client);
+    LayoutChildren(client.right - client.left, client.bottom - client.top);
+}
+
+// -------------------- Stats panel --------------------
+void
+MainWindow::ToggleStatsPanel()
+{
+    if (m_statsPanel == nullptr)
+    {
+        return;
+    }
+
+    m_statsVisible = !m_statsVisible;
+    ShowWindow(m_statsPanel, m_statsVisible ? SW_SHOW : SW_HIDE);
+    if (m_statsVisible)
+    {
+        m_lastStats.reset();
+        RefreshStatsPanel();
+        SetTimer(m_hwnd, STATS_TIMER_ID, STATS_REFRESH_MS, nullptr);
+    }
+    else
+    {
+        KillTimer(m_hwnd, STATS_TIMER_ID);
+    }
+
+    Relayout();
+}
+
+void
+MainWindow::RefreshStatsPanel()
+{
+    if (!m_statsVisible || m_metrics == nullptr)
+    {
+        return;
+    }
+
+    auto current = std::make_unique<core::metrics::MetricsSnapshot>(m_metrics->Snapshot());
+    const std::wstring text = FormatStats(*current, m_lastStats.get());
+    SetWindowTextW(m_statsPanel, text.c_str());
+    m_lastStats = std::move(current);
+}
+
+// -------------------- Menu --------------------
+HMENU
+MainWindow::CreateMainMenu()
+{
+    HMENU menuBar = CreateMenu();
+    m_fileMenu = CreatePopupMenu();
+    m_keyMenu = CreatePopupMenu();
+    m_searchMenu = CreatePopupMenu();
+    if (menuBar == nullptr || m_fileMenu == nullptr || m_keyMenu == nullptr || m_searchMenu == nullptr)
+    {
+        return nullptr; // the window is then created without a menu
+    }
+
+    AppendMenuW(m_fileMenu, MF_STRING, IDM_OPEN_SNAPSHOT, L"&Open Snapshot...");
+    AppendMenuW(m_fileMenu, MF_STRING, IDM_SHOW_LIVE, L"Show &Live Registry");
+    AppendMenuW(m_fileMenu, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(m_fileMenu, MF_STRING, IDM_EXIT, L"E&xit");
+
+    AppendMenuW(m_keyMenu, MF_STRING, IDM_COPY_KEY, L"&Copy To...");
+    AppendMenuW(m_keyMenu, MF_STRING, IDM_MOVE_KEY, L"&Move To...");
+    AppendMenuW(m_keyMenu, MF_STRING, IDM_EXPORT_KEY, L"&Export...");
+    AppendMenuW(m_keyMenu, MF_STRING, IDM_CAPTURE_SNAPSHOT, L"Capture &Snapshot...");
+    AppendMenuW(m_keyMenu, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(m_keyMenu, MF_STRING, IDM_CANCEL_OPERATIONS, L"Cancel &Operations");
+
+    AppendMenuW(m_searchMenu, MF_STRING, IDM_FIND, L"&Find...\tCtrl+F");
+    AppendMenuW(m_searchMenu, MF_STRING, IDM_CANCEL_SEARCH, L"&Cancel Search");
+    AppendMenuW(m_searchMenu, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(m_searchMenu, MF_STRING, IDM_SEARCH_RESULTS, L"&Results Panel");
+
+    AppendMenuW(menuBar, MF_POPUP, reinterpret_cast<UINT_PTR>(m_fileMenu), L"&File");
+    AppendMenuW(menuBar, MF_POPUP, reinterpret_cast<UINT_PTR>(m_keyMenu), L"&Key");
+    AppendMenuW(menuBar, MF_POPUP, reinterpret_cast<UINT_PTR>(m_searchMenu), L"&Search");
+    return menuBar;
+}
+
+void
+MainWindow::OnInitMenuPopup(HMENU menu) const
+{
+    if (m_tree == nullptr)
+    {
+        return;
+    }
+
+    if (menu == m_fileMenu)
+    {
+        EnableMenuItem(menu, IDM_SHOW_LIVE, MF_BYCOMMAND | (m_tree->ShowsSnapshot() ? MF_ENABLED : MF_GRAYED));
+        return;
+    }
+    if (menu == m_searchMenu)
+    {
+        // Search walks the live registry only.
+        EnableMenuItem(menu, IDM_FIND, MF_BYCOMMAND | (m_tree->ShowsSnapshot() ? MF_GRAYED : MF_ENABLED));
+        EnableMenuItem(menu, IDM_CANCEL_SEARCH, MF_BYCOMMAND | (m_tree->IsSearching() ? MF_ENABLED : MF_GRAYED));
+        CheckMenuItem(menu, IDM_SEARCH_RESULTS, MF_BYCOMMAND | (m_resultsVisible ? MF_CHECKED : MF_UNCHECKED));
+        return;
+    }
+    if (menu != m_keyMenu)
+    {
+        return;
+    }
+
+    // Hive roots cannot be copied or moved, and a snapshot is read-only.
+    const std::optional<std::wstring> path = m_tree->GetItemPath(m_tree->GetSelectedItem());
+    const bool live = !m_tree->ShowsSnapshot();
+    const bool canCopy = live && path.has_value() && !path->empty();
+    const bool canExport = live && path.has_value();
+
+    EnableMenuItem(menu, IDM_COPY_KEY, MF_BYCOMMAND | (canCopy ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(menu, IDM_MOVE_KEY, MF_BYCOMMAND | (canCopy ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(menu, IDM_EXPORT_KEY, MF_BYCOMMAND | (canExport ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(menu, IDM_CAPTURE_SNAPSHOT, MF_BYCOMMAND | (canExport ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(menu, IDM_CANCEL_OPERATIONS,
+                   MF_BYCOMMAND | (m_tree->HasTreeOps() ? MF_ENABLED : MF_GRAYED));
+}
+
+void
+MainWindow::ShowTreeContextMenu()
+{
+    if (m_tree == nullptr || m_keyMenu == nullptr)
+    {
+        return;
+    }
+
+    POINT screen;
+    GetCursorPos(&screen);
+
+    TVHITTESTINFO hit;
+    ZeroMemory(&hit, sizeof(TVHITTESTINFO));
+    hit.pt = screen;
+    ScreenToClient(m_tree->Handle(), &hit.pt);
+    HTREEITEM item = TreeView_HitTest(m_tree->Handle(), &hit);
+    if (item == nullptr)
+    {
+        return;
+    }
+
+    // The commands act on the selection, so the clicked item becomes selected first.
+    TreeView_SelectItem(m_tree->Handle(), item);
+    TrackPopupMenu(m_keyMenu, TPM_RIGHTBUTTON, screen.x, screen.y, 0, m_hwnd, nullptr);
+}
+
+void
+MainWindow::OnCommand(const UINT commandId)
+{
+    switch (commandId)
+    {
+        case IDM_EXIT:
+            DestroyWindow(m_hwnd);
+            break;
+
+        case IDM_OPEN_SNAPSHOT:
+            OpenSnapshotFile();
+            break;
+
+        case IDM_SHOW_LIVE:
+            ShowLiveRegistry();
+            break;
+
+        case IDM_COPY_KEY:
+            CopySelectedKey(false);
+            break;
+
+        case IDM_MOVE_KEY:
+            CopySelectedKey(true);
+            break;
+
+        case IDM_EXPORT_KEY:
+            ExportSelectedKey();
+            break;
+
+        case IDM_CAPTURE_SNAPSHOT:
+            CaptureSelectedKey();
+            break;
+
+        case IDM_CANCEL_OPERATIONS:
+            if (m_tree != nullptr)
+            {
+                m_tree->CancelTreeOps();
+            }
+            break;
+
+        case IDM_FIND:
+            FindInRegistry();
+            break;
+
+        case IDM_CANCEL_SEARCH:
+            if (m_tree != nullptr)
+            {
+                m_tree->CancelSearch();
+            }
+            break;
+
+        case IDM_SEARCH_RESULTS:
+            SetResultsPanelVisible(!m_resultsVisible);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void
+MainWindow::CopySelectedKey(const bool move)
+{
+    if (m_tree == nullptr)
+    {
+        return;
+    }
+
+    HTREEITEM item = m_tree->GetSelectedItem();
+    const std::optional<std::wstring> source = m_tree->GetItemFullPath(item);
+    if (!source)
+    {
+        return;
+    }
+
+    const std::optional<std::wstring> target = PromptForText(
+        m_hInstance, m_hwnd, move ? L"Move Key" : L"Copy Key",
+        L"Destination key, starting with the hive (HKEY_CURRENT_USER\\...):",
+        move ? *source : *source + L" - Copy");
+    if (!target)
+    {
+        return;
+    }
+
+    HKEY targetRoot = nullptr;
+    std::wstring targetPath;
+    if (!ParseKeyPath(*target, targetRoot, targetPath) || targetPath.empty())
+    {
+        MessageBoxW(m_hwnd, L"The destination must be a key below one of the predefined hives.",
+                    move ? L"Move Key" : L"Copy Key", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    if (!m_tree->StartCopy(item, targetRoot, targetPath, move))
+    {
+        MessageBoxW(m_hwnd, L"The selected key cannot be copied or moved.",
+                    move ? L"Move Key" : L"Copy Key", MB_OK | MB_ICONWARNING);
+    }
+}
+
+void
+MainWindow::ExportSelectedKey()
+{
+    if (m_tree == nullptr)
+    {
+        return;
+    }
+
+    HTREEITEM item = m_tree->GetSelectedItem();
+    if (!m_tree->GetItemPath(item))
+    {
+        return;
+    }
+
+    const std::optional<std::wstring> file = AskFileName(
+        m_hwnd, true, L"Registry hive files (*.hiv)\0*.hiv\0All files (*.*)\0*.*\0", L"hiv");
+    if (!file)
+    {
+        return;
+    }
+
+    // RegSaveKeyExW refuses to overwrite; the save dialog has already asked.
+    DeleteFileW(file->c_str());
+
+    if (!m_tree->StartExport(item, *file))
+    {
+        MessageBoxW(m_hwnd, L"The selected key cannot be exported.", L"Export Key", MB_OK | MB_ICONWARNING);
+    }
+}
+
+void
+MainWindow::CaptureSelectedKey()
+{
+    if (m_tree == nullptr)
+    {
+        return;
+    }
+
+    HTREEITEM item = m_tree->GetSelectedItem();
+    if (!m_tree->GetItemPath(item))
+    {
+        return;
+    }
+
+    const std::optional<std::wstring> file = AskFileName(m_hwnd, true, SNAPSHOT_FILE_FILTER, L"rsnap");
+    if (!file)
+    {
+        return;
+    }
+
+    if (!m_tree->StartCapture(item, *file))
+    {
+        MessageBoxW(m_hwnd, L"The selected key cannot be captured.", L"Capture Snapshot", MB_OK | MB_ICONWARNING);
+    }
+}
+
+void
+MainWindow::OpenSnapshotFile()
+{
+    if (m_tree == nullptr || m_facade == nullptr)
+    {
+        return;
+    }
+
+    const std::optional<std::wstring> file = AskFileName(m_hwnd, false, SNAPSHOT_FILE_FILTER, L"rsnap");
+    if (!file)
+    {
+        return;
+    }
+
+    std::shared_ptr<const core::registry::RegistrySnapshot> snapshot;
+    try
+    {
+        snapshot = m_facade->OpenSnapshot(*file);
+    }
+    catch (const std::exception& ex)
+    {
+        const std::string reason = ex.what();
+        const std::wstring text = L"The snapshot could not be opened: " + std::wstring(reason.begin(), reason.end());
+        MessageBoxW(m_hwnd, text.c_str(), L"Open Snapshot", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    // Hits of a running search point into the live registry, which is no longer shown.
+    m_tree->CancelSearch();
+    m_tree->SetSnapshot(std::move(snapshot));
+}
+
+void
+MainWindow::ShowLiveRegistry()
+{
+    if (m_tree != nullptr && m_tree->ShowsSnapshot())
+    {
+        m_tree->SetSnapshot(nullptr);
+    }
+}
+
+// -------------------- Search results --------------------
+void
+MainWindow::FindInRegistry()
+{
+    if (m_tree == nullptr || m_tree->ShowsSnapshot())
+    {
+        return;
+    }
+
+    if (!m_lastQuery)
+    {
+        m_lastQuery = std::make_unique<core::registry::SearchQuery>();
+    }
+    if (!PromptForSearch(m_hInstance, m_hwnd, *m_lastQuery))
+    {
+        return;
+    }
+
+    if (!m_tree->StartSearch(*m_lastQuery))
+    {
+        MessageBoxW(m_hwnd, L"The search could not be started.", L"Find", MB_OK | MB_ICONWARNING);
+        return;
+    }
+    UpdateResultsPanel(true); // the previous hits are gone
+    SetResultsPanelVisible(true);
+}
+
+void
+MainWindow::SetResultsPanelVisible(const bool visible)
+{
+    if (m_resultsPanel == nullptr || visible == m_resultsVisible)
+    {
+        return;
+    }
+
+    m_resultsVisible = visible;
+    ShowWindow(m_resultsPanel, visible ? SW_SHOW : SW_HIDE);
+    Relayout();
+}
+
+void
+MainWindow::UpdateResultsPanel(const bool reset) const
+{
+    if (m_resultsPanel == nullptr || m_tree == nullptr)
+    {
+        return;
+    }
+
+    // Hits are only appended while a search runs, so the rows already shown stay valid.
+    ListView_SetItemCountEx(m_resultsPanel, m_tree->SearchHits().size(),
+                            reset ? 0 : LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+}
+
+void
+MainWindow::GetResultDispInfo(NMLVDISPINFOW* info) const
+{
+    LVITEMW& item = info->item;
+    const std::vector<core::registry::SearchHit>& hits = m_tree->SearchHits();
+    if ((item.mask & LVIF_TEXT) == 0 || item.cchTextMax <= 0 || item.iItem < 0 ||
+        static_cast<size_t>(item.iItem) >= hits.size())
+    {
+        return;
+    }
+
+    const core::registry::SearchHit& hit = hits[static_cast<size_t>(item.iItem)];
+    std::wstring text;
+    switch (item.iSubItem)
+    {
+        case 0:
+            text = FormatKeyPath(hit.root, hit.keyPath);
+            break;
+        case 1:
+            text = hit.kind == core::registry::SearchHitKind::KeyName
+                       ? std::wstring()
+                       : hit.valueName.empty() ? std::wstring(L"(Default)") : hit.valueName;
+            break;
+        default:
+            text = hit.kind == core::registry::SearchHitKind::KeyName   ? L"key name"
+                   : hit.kind == core::registry::SearchHitKind::ValueName ? L"value name"
+                                                                           : L"data";
+            break;
+    }
+
+    const size_t length = std::min(text.size(), static_cast<size_t>(item.cchTextMax - 1));
+    std::wmemcpy(item.pszText, text.c_str(), length);
+    item.pszText[length] = L'\0';
+}
+
+void
+MainWindow::OpenSearchResult(const int index) const
+{
+    const std::vector<core::registry::SearchHit>& hits = m_tree->SearchHits();
+    if (index < 0 || static_cast<size_t>(index) >= hits.size())
+    {
+        return;
+    }
+
+    const core::registry::SearchHit& hit = hits[static_cast<size_t>(index)];
+    if (m_tree->RevealKey(hit.root, hit.keyPath))
+    {
+        SetFocus(m_tree->Handle());
+    }
+}
+
 // -------------------- Initialize / Create window --------------------
-MainWindow::MainWindow(HINSTANCE hInstance, IThreadManager* threadManager, core::registry::RegistryFacade* facade)
+MainWindow::MainWindow(HINSTANCE hInstance, IThreadManager* threadManager, core::registry::RegistryFacade* facade,
+                       core::metrics::RuntimeMetrics* metrics)
     : m_hInstance(hInstance)
     , m_hwnd(nullptr)
+    , m_fileMenu(nullptr)
+    , m_keyMenu(nullptr)
+    , m_searchMenu(nullptr)
     , m_tree(nullptr)
     , m_threadManager(threadManager)
     , m_facade(facade)
+    , m_statsPanel(nullptr)
+    , m_statsVisible(false)
+    , m_metrics(metrics)
+    , m_resultsPanel(nullptr)
+    , m_resultsVisible(false)
 {
+    if (m_metrics == nullptr)
+    {
+        m_ownedMetrics = std::make_unique<core::metrics::RuntimeMetrics>(
+            core::metrics::RuntimeMetrics::Sources{facade, threadManager, nullptr});
+        m_metrics = m_ownedMetrics.get();
+    }
 }
 
 MainWindow::~MainWindow()
@@ -117,7 +892,7 @@ MainWindow::Initialize(int nCmdShow)
 {
     INITCOMMONCONTROLSEX icc;
     icc.dwSize = sizeof(INITCOMMONCONTROLSEX);
-    icc.dwICC  = ICC_TREEVIEW_CLASSES;
+    icc.dwICC  = ICC_TREEVIEW_CLASSES | ICC_LISTVIEW_CLASSES;
     BOOL icc_ok = InitCommonControlsEx(&icc);
     if (icc_ok == FALSE)
     {
@@ -139,7 +914,7 @@ MainWindow::Initialize(int nCmdShow)
                              800,
                              600,
                              nullptr,
-                             nullptr,
+                             CreateMainMenu(),
                              m_hInstance,
                              this); // lpParam
 
@@ -163,6 +938,18 @@ MainWindow::RunMessageLoop()
     MSG msg;
     while (GetMessageW(&msg, nullptr, 0, 0) > 0)
     {
+        // F12 reaches whichever child has focus (usually the tree), so it is caught here.
+        if (msg.message == WM_KEYDOWN && msg.wParam == VK_F12)
+        {
+            ToggleStatsPanel();
+            continue;
+        }
+        if (msg.message == WM_KEYDOWN && msg.wParam == 'F' && GetKeyState(VK_CONTROL) < 0)
+        {
+            FindInRegistry();
+            continue;
+        }
+
         TranslateMessage(&msg);
         DispatchMessageW(&msg);
     }
@@ -181,9 +968,27 @@ MainWindow::HandleNotify(LPNMHDR pnmh)
     // If the notification originates from our tree control, forward to wrapper.
     if (m_tree != nullptr && pnmh->hwndFrom == m_tree->Handle())
     {
+        if (pnmh->code == NM_RCLICK)
+        {
+            ShowTreeContextMenu();
+            return TRUE; // no default handling
+        }
         return m_tree->HandleNotify(pnmh);
     }
 
+    if (m_resultsPanel != nullptr && pnmh->hwndFrom == m_resultsPanel && m_tree != nullptr)
+    {
+        if (pnmh->code == LVN_GETDISPINFOW)
+        {
+            GetResultDispInfo(reinterpret_cast<NMLVDISPINFOW*>(pnmh));
+        }
+        else if (pnmh->code == LVN_ITEMACTIVATE)
+        {
+            OpenSearchResult(reinterpret_cast<NMITEMACTIVATE*>(pnmh)->iItem);
+        }
+        return 0;
+    }
+
     // No special handling; return 0.
     return 0;
 }
@@ -201,6 +1006,13 @@ MainWindow::HandleAppMessage(UINT msg, WPARAM wParam, LPARAM /*lParam*/) const
             }
             return 0;
         }
+        case WM_APP_TREE_INSERT_CONTINUE:
+        {
+            if (m_tree) {
+                m_tree->ContinueInsertion();
+            }
+            return 0;
+        }
         case WM_APP_TREE_EXPAND_RESULT:
         {
             ExpandResult* res = reinterpret_cast<ExpandResult*>(wParam);
@@ -219,6 +1031,36 @@ MainWindow::HandleAppMessage(UINT msg, WPARAM wParam, LPARAM /*lParam*/) const
             return 0;
         }
 
+        case WM_APP_TREE_OP_PROGRESS:
+        {
+            auto* progress = reinterpret_cast<TreeOpProgress*>(wParam);
+            if (progress != nullptr && m_tree != nullptr)
+            {
+                m_tree->HandleTreeOpProgress(progress); // UI thread; this deletes progress
+            }
+            else
+            {
+                delete progress;
+            }
+            return 0;
+        }
+
+        case WM_APP_SEARCH_RESULTS:
+        {
+            auto* results = reinterpret_cast<SearchResults*>(wParam);
+            if (results != nullptr && m_tree != nullptr)
+            {
+                m_tree->HandleSearchResults(results); // UI thread; this deletes results
+                UpdateResultsPanel(false);
+            }
+            else
+            {
+                delete results;
+            }
+            return 0;
+        }
+
+        case WM_APP_TREE_OP_ERROR:
         case WM_APP_OPERATION_ERROR:
         {
             auto* err = reinterpret_cast<std::wstring*>(wParam);
@@ -272,6 +1114,7 @@ MainWindow::OnSize(int width, int height)
 LRESULT
 MainWindow::OnDestroy()
 {
+    KillTimer(m_hwnd, STATS_TIMER_ID);
     PostQuitMessage(0);
     return 0;
 }
@@ -313,8 +1156,40 @@ MainWindow::StaticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
             return self->HandleNotify(pnmh);
         }
 
+        case WM_COMMAND:
+        {
+            // Menu commands; control notifications carry the control's HWND in lParam.
+            if (lParam == 0)
+            {
+                self->OnCommand(LOWORD(wParam));
+                return 0;
+            }
+            break;
+        }
+
+        case WM_INITMENUPOPUP:
+        {
+            self->OnInitMenuPopup(reinterpret_cast<HMENU>(wParam));
+            return 0;
+        }
+
+        case WM_TIMER:
+        {
+            if (wParam == STATS_TIMER_ID)
+            {
+                self->RefreshStatsPanel();
+                return 0;
+            }
+            break;
+        }
+
         case WM_APP_TREE_EXPAND_RESULT:
+        case WM_APP_TREE_OP_ERROR:
         case WM_APP_OPERATION_ERROR:
+        case WM_APP_UPDATE_COLUMN_WIDTH:
+        case WM_APP_TREE_INSERT_CONTINUE:
+        case WM_APP_TREE_OP_PROGRESS:
+        case WM_APP_SEARCH_RESULTS:
         {
             return self->HandleAppMessage(static_cast<UINT>(msg), wParam, lParam);
         }
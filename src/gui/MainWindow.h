@@ -7,7 +7,8 @@
 #include "Messages.h"
 
 class IThreadManager;
-namespace core::registry { class RegistryFacade; }
+namespace core::registry { class RegistryFacade; struct SearchQuery; }
+namespace core::metrics { class RuntimeMetrics; struct MetricsSnapshot; }
 class RegistryTreeView;
 
 class MainWindow
@@ -15,7 +16,9 @@ class MainWindow
 public:
     // Construct with non-owning pointers to thread manager and facade.
     // Must be created on the UI thread (where the window will live).
-    MainWindow(HINSTANCE hInstance, IThreadManager* threadManager, core::registry::RegistryFacade* facade);
+    // metrics feeds the stats panel (F12); if null, one is made over threadManager and facade.
+    MainWindow(HINSTANCE hInstance, IThreadManager* threadManager, core::registry::RegistryFacade* facade,
+               core::metrics::RuntimeMetrics* metrics = nullptr);
 
     // Non-copyable
     MainWindow(const MainWindow&) = delete;
@@ -49,14 +52,37 @@ public:
     // Return pointer to the internal RegistryTreeView instance (non-owning).
     [[nodiscard]] RegistryTreeView* GetTreeView() const noexcept;
 
+    // Show or hide the stats panel below the tree; refreshed once a second while shown.
+    void
+    ToggleStatsPanel();
+
+    // Run a menu command (IDM_*). UI thread.
+    void
+    OnCommand(UINT commandId);
+
 private:
     HINSTANCE m_hInstance;
     HWND m_hwnd;                      // main window handle
+    HMENU m_fileMenu;
+    HMENU m_keyMenu;                  // "Key" submenu of the menu bar, also the tree's context menu
+    HMENU m_searchMenu;
     std::unique_ptr<RegistryTreeView> m_tree; // owned child control wrapper
 
     IThreadManager* m_threadManager;  // non-owning
     core::registry::RegistryFacade* m_facade; // non-owning
 
+    // Stats panel: read-only multiline edit, hidden until toggled.
+    HWND m_statsPanel;
+    bool m_statsVisible;
+    core::metrics::RuntimeMetrics* m_metrics; // non-owning, or m_ownedMetrics
+    std::unique_ptr<core::metrics::RuntimeMetrics> m_ownedMetrics;
+    std::unique_ptr<core::metrics::MetricsSnapshot> m_lastStats; // previous refresh, for rates
+
+    // Search results panel: virtual report list over the tree's hits, shown by the first search.
+    HWND m_resultsPanel;
+    bool m_resultsVisible;
+    std::unique_ptr<core::registry::SearchQuery> m_lastQuery; // offered again by the next Find
+
     // Register and unregister: RegisterClassExW / UnregisterClassW
     [[nodiscard]] bool
     RegisterWindowClass() const;
@@ -65,10 +91,65 @@ private:
     bool
     CreateChildControls();
 
-    // Layout child controls on WM_SIZE (simple split).
+    // Menu bar (File, Key, Search); owned by the window once it is created.
+    HMENU
+    CreateMainMenu();
+
+    // Enables the commands that apply to the selected item and to what the tree shows
+    // (WM_INITMENUPOPUP).
+    void
+    OnInitMenuPopup(HMENU menu) const;
+
+    // Right click on the tree: select the item under the cursor and show the Key menu there.
+    void
+    ShowTreeContextMenu();
+
+    // Key menu commands on the selected tree item.
+    void
+    CopySelectedKey(bool move);
+
+    void
+    ExportSelectedKey();
+
+    void
+    CaptureSelectedKey();
+
+    // File menu: browse a snapshot file, or go back to the live registry.
+    void
+    OpenSnapshotFile();
+
+    void
+    ShowLiveRegistry();
+
+    // Search menu: ask for a query, start it and show the results panel.
+    void
+    FindInRegistry();
+
+    void
+    SetResultsPanelVisible(bool visible);
+
+    // Results panel: row count follows the tree's hits; activating a row reveals its key.
+    void
+    UpdateResultsPanel(bool reset) const;
+
+    void
+    GetResultDispInfo(NMLVDISPINFOW* info) const;
+
+    void
+    OpenSearchResult(int index) const;
+
+    // Layout child controls on WM_SIZE: tree on top, then the results and stats panels if shown.
     void
     LayoutChildren(int width, int height);
 
+    // LayoutChildren over the current client area, after a panel was shown or hidden.
+    void
+    Relayout();
+
+    // Re-reads the metrics and rewrites the stats panel text (UI thread, WM_TIMER).
+    void
+    RefreshStatsPanel();
+
     // Static window procedure - routes messages to instance.
     static LRESULT CALLBACK
     StaticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -8,5 +8,8 @@ inline constexpr UINT WM_APP_TREE_EXPAND_RESULT = (WM_APP + 0x101);
 inline constexpr UINT WM_APP_TREE_OP_ERROR      = (WM_APP + 0x102);
 inline constexpr UINT WM_APP_LIST_VALUES_RESULT = (WM_APP + 0x103);
 inline constexpr UINT WM_APP_UPDATE_COLUMN_WIDTH = (WM_APP + 0x104);
+inline constexpr UINT WM_APP_TREE_INSERT_CONTINUE = (WM_APP + 0x105);
+inline constexpr UINT WM_APP_TREE_OP_PROGRESS = (WM_APP + 0x106);
+inline constexpr UINT WM_APP_SEARCH_RESULTS = (WM_APP + 0x107);
 inline  constexpr UINT WM_APP_OPERATION_ERROR    = (WM_APP + 0x200);
 #endif //MESSAGES_H
@@ -1,14 +1,21 @@
 
 #include "RegistryTreeView.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <commctrl.h>
 #include <new>
 #include <sstream>
 #include <windows.h>
-#include "IThreadManager.h"   // thread pool interface (assumed enqueue(std::function<void()>))
+#include "IThreadManager.h"   // thread pool interface (enqueue with TaskPriority)
 #include "../core/registry/RegistryFacade.h"
+#include "../core/registry/SearchIndex.h"
 
-static constexpr LPARAM DUMMY_CHILD_LPARAM = static_cast<LPARAM>(1);
+// Node ids are small positive integers, so the placeholder uses a value no id can take.
+static constexpr LPARAM LOAD_MORE_LPARAM = static_cast<LPARAM>(-1);
+
+static void
+PostTreeError(HWND uiWnd, char const* what);
 
 static bool
 IsTreeItemDummy(HWND treeHwnd, HTREEITEM item);
@@ -16,6 +23,9 @@ IsTreeItemDummy(HWND treeHwnd, HTREEITEM item);
 static void
 SetTreeItemParam(HWND treeHwnd, HTREEITEM item, LPARAM param);
 
+static std::wstring
+HiveName(HKEY hive);
+
 static LPARAM
 GetTreeItemParam(HWND treeHwnd, HTREEITEM item);
 
@@ -32,6 +42,11 @@ RegistryTreeView::RegistryTreeView() noexcept
 
 RegistryTreeView::~RegistryTreeView()
 {
+    // Running workers would keep posting to the main window and using the facade.
+    CancelTreeOps();
+    CancelSearch();
+    CancelAllExpands();
+
     if (m_hwnd != nullptr)
     {
         DestroyWindow(m_hwnd);
@@ -48,6 +63,12 @@ RegistryTreeView::Initialize(HWND parentWnd, HINSTANCE instance, IThreadManager*
     m_threadManager = threadManager;
     m_facade = facade;
 
+    // Status texts are appended to the title the window was created with.
+    const int titleLength = GetWindowTextLengthW(m_parentWnd);
+    m_baseTitle.assign(static_cast<size_t>(std::max(titleLength, 0)) + 1, L'\0');
+    const int titleCopied = GetWindowTextW(m_parentWnd, m_baseTitle.data(), static_cast<int>(m_baseTitle.size()));
+    m_baseTitle.resize(static_cast<size_t>(std::max(titleCopied, 0)));
+
     RECT rcClient;
     int width;
     int height;
@@ -97,8 +118,15 @@ RegistryTreeView::Initialize(HWND parentWnd, HINSTANCE instance, IThreadManager*
 }
 
 
+void RegistryTreeView::SetPrefetchEnabled(bool enabled) noexcept
+{
+    m_prefetchEnabled = enabled;
+}
+
 void RegistryTreeView::UpdateColumnWidth() const
 {
+    m_widthUpdatePosted = false;
+
     if (m_hwnd == nullptr) return;
 
     const int maxWidth = CalculateMaxItemWidth();
@@ -115,38 +143,41 @@ int RegistryTreeView::CalculateMaxItemWidth() const
 {
     if (m_hwnd == nullptr) return 800;
 
+    // Labels are measured once as they are inserted (see MeasureLabels).
+    return m_maxLabelWidth + 100; // 100 pixels padding
+}
+
+void RegistryTreeView::MeasureLabels(std::vector<std::wstring> const& labels, size_t first, size_t last)
+{
+    if (m_hwnd == nullptr || first >= last) return;
+
     HDC hdc = GetDC(m_hwnd);
-    if (hdc == nullptr) return 800;
+    if (hdc == nullptr) return;
 
     const auto hFont = reinterpret_cast<HFONT>(SendMessage(m_hwnd, WM_GETFONT, 0, 0));
     const auto hOldFont = static_cast<HFONT>(SelectObject(hdc, hFont));
 
-    int maxWidth = 0;
-
-    std::lock_guard guard(m_mapMutex);
-    for (const auto& pair : m_itemPathMap) {
-        HTREEITEM item = pair.first;
-
-        wchar_t buffer[256] = {0};
-        TVITEMW tvi;
-        ZeroMemory(&tvi, sizeof(TVITEMW));
-        tvi.mask = TVIF_TEXT;
-        tvi.hItem = item;
-        tvi.pszText = buffer;
-        tvi.cchTextMax = 255;
-
-        if (TreeView_GetItem(m_hwnd, &tvi)) {
-            SIZE size = {0};
-            if (GetTextExtentPoint32W(hdc, buffer, wcslen(buffer), &size)) {
-                maxWidth = std::max(maxWidth, static_cast<int>(size.cx));
-            }
+    for (size_t i = first; i < last; ++i)
+    {
+        SIZE size = {0, 0};
+        if (GetTextExtentPoint32W(hdc, labels[i].c_str(), static_cast<int>(labels[i].size()), &size))
+        {
+            m_maxLabelWidth = std::max(m_maxLabelWidth, static_cast<int>(size.cx));
         }
     }
 
     SelectObject(hdc, hOldFont);
     ReleaseDC(m_hwnd, hdc);
+}
 
-    return maxWidth + 100; // 100 pixels padding
+void RegistryTreeView::ScheduleColumnWidthUpdate() const
+{
+    // Coalesce: at most one WM_APP_UPDATE_COLUMN_WIDTH in the queue at a time.
+    if (m_widthUpdatePosted)
+    {
+        return;
+    }
+    m_widthUpdatePosted = PostMessage(m_parentWnd, WM_APP_UPDATE_COLUMN_WIDTH, 0, 0) != FALSE;
 }
 
 
@@ -159,24 +190,65 @@ HWND RegistryTreeView::Handle() const noexcept
 void RegistryTreeView::PopulateHives()
 {
     // HKEY_CLASSES_ROOT
-    InsertNode(nullptr, L"HKEY_CLASSES_ROOT", std::wstring(), HKEY_CLASSES_ROOT, true);
+    InsertNode(nullptr, L"HKEY_CLASSES_ROOT", HKEY_CLASSES_ROOT, true);
 
     // HKEY_CURRENT_USER
-    InsertNode(nullptr, L"HKEY_CURRENT_USER", std::wstring(), HKEY_CURRENT_USER, true);
+    InsertNode(nullptr, L"HKEY_CURRENT_USER", HKEY_CURRENT_USER, true);
 
     // HKEY_LOCAL_MACHINE
-    InsertNode(nullptr, L"HKEY_LOCAL_MACHINE", std::wstring(), HKEY_LOCAL_MACHINE, true);
+    InsertNode(nullptr, L"HKEY_LOCAL_MACHINE", HKEY_LOCAL_MACHINE, true);
 
     // HKEY_USERS
-    InsertNode(nullptr, L"HKEY_USERS", std::wstring(), HKEY_USERS, true);
+    InsertNode(nullptr, L"HKEY_USERS", HKEY_USERS, true);
 
     // HKEY_CURRENT_CONFIG
-    InsertNode(nullptr, L"HKEY_CURRENT_CONFIG", std::wstring(), HKEY_CURRENT_CONFIG, true);
+    InsertNode(nullptr, L"HKEY_CURRENT_CONFIG", HKEY_CURRENT_CONFIG, true);
+}
+
+void RegistryTreeView::SetSnapshot(std::shared_ptr<const core::registry::RegistrySnapshot> snapshot)
+{
+    Clear();
+    m_snapshot = std::move(snapshot);
+
+    if (m_snapshot == nullptr)
+    {
+        PopulateHives();
+        return;
+    }
+
+    // The top-level node stands for the captured key, so node paths are snapshot-relative.
+    std::wstring label = HiveName(m_snapshot->SourceRoot());
+    if (!m_snapshot->SourcePath().empty())
+    {
+        label += L'\\';
+        label += m_snapshot->SourcePath();
+    }
+    label += L" (snapshot)";
+
+    const core::registry::RegistrySnapshot::KeyView root =
+        m_snapshot->Key(core::registry::RegistrySnapshot::kRootKey);
+    InsertNode(nullptr, label, m_snapshot->SourceRoot(), root.subKeyCount > 0);
+}
+
+bool RegistryTreeView::ShowsSnapshot() const noexcept
+{
+    return m_snapshot != nullptr;
 }
 
 HTREEITEM
-RegistryTreeView::InsertNode(HTREEITEM parent, std::wstring const& name, std::wstring const& fullPath, HKEY hiveRoot, bool hasChildren)
+RegistryTreeView::InsertNode(HTREEITEM parent, std::wstring const& name, HKEY hiveRoot, bool hasChildren)
 {
+    const TreeNode* parentNode = parent != nullptr ? NodeFromItem(parent) : nullptr;
+    if (parent != nullptr && parentNode == nullptr)
+    {
+        return nullptr;
+    }
+
+    const std::uint32_t parentId = parent != nullptr
+        ? static_cast<std::uint32_t>(parentNode - m_nodes.data())
+        : 0;
+    const std::uint32_t id = AddNode(parentId, name, hiveRoot);
+
     TVINSERTSTRUCTW tvins;
     ZeroMemory(&tvins, sizeof(TVINSERTSTRUCTW));
     tvins.hParent = parent;
@@ -184,109 +256,228 @@ RegistryTreeView::InsertNode(HTREEITEM parent, std::wstring const& name, std::ws
 
     TVITEMW item;
     ZeroMemory(&item, sizeof(TVITEMW));
-    item.mask = TVIF_TEXT | TVIF_PARAM;
-    item.pszText = const_cast<LPWSTR>(name.c_str());
-    item.lParam = 0; // default param; we may override for dummy child
-    item.cchTextMax = 255;
+    item.mask = TVIF_TEXT | TVIF_PARAM | TVIF_CHILDREN;
+    item.pszText = LPSTR_TEXTCALLBACKW;
+    item.cChildren = hasChildren ? I_CHILDRENCALLBACK : 0;
     tvins.item = item;
 
-    // Create item
-    auto inserted = reinterpret_cast<HTREEITEM>(SendMessageW(m_hwnd, TVM_INSERTITEMW, 0, reinterpret_cast<LPARAM>(&tvins)));
-
+    HTREEITEM inserted = InsertItemInternal(tvins, id);
     if (inserted == nullptr)
     {
         return nullptr;
     }
 
-    wchar_t buf[512];
-    ZeroMemory(buf, sizeof(buf));
-    TVITEMW tvi;
-    ZeroMemory(&tvi, sizeof(tvi));
-    tvi.mask = TVIF_TEXT;
-    tvi.hItem = inserted;
-    tvi.pszText = buf;
-    tvi.cchTextMax = static_cast<int>(sizeof(buf) / sizeof(wchar_t)) - 1;
-
-    if (TreeView_GetItem(m_hwnd, &tvi))
+    if (!hasChildren)
     {
-        wchar_t dbg[600];
-        swprintf_s(dbg, L"[InsertNode] inserted item %p text = \"%s\" fullPath = \"%s\"\n",
-                   (void*)inserted, buf, fullPath.c_str());
-        OutputDebugStringW(dbg);
+        m_nodes[id].flags |= NodeLoaded;
     }
 
+    const std::vector<std::wstring> label{ name };
+    MeasureLabels(label, 0, 1);
+    ScheduleColumnWidthUpdate();
+
+    return inserted;
+}
+
+std::uint32_t RegistryTreeView::AddNode(std::uint32_t parent, std::wstring_view name, HKEY hive)
+{
+    if (m_nodes.empty())
     {
-        std::lock_guard guard(m_mapMutex);
-        m_itemPathMap.insert(std::make_pair(inserted, fullPath));
-        m_itemHiveMap.insert(std::make_pair(inserted, hiveRoot));
-        PostMessage(m_parentWnd, WM_APP_UPDATE_COLUMN_WIDTH, 0, 0);
+        m_nodes.emplace_back(); // id 0: "no node"
     }
 
-    if (hasChildren)
+    const std::wstring& interned = *m_names.emplace(name).first;
+
+    TreeNode node;
+    node.name = &interned;
+    node.hive = hive;
+    node.parent = parent;
+
+    if (!m_freeNodes.empty())
     {
-        AddDummyChild(inserted);
+        const std::uint32_t id = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        m_nodes[id] = node;
+        return id;
     }
 
-    return inserted;
+    m_nodes.push_back(node);
+    return static_cast<std::uint32_t>(m_nodes.size() - 1);
 }
 
-void
-RegistryTreeView::RequestExpand(HTREEITEM item) const
+void RegistryTreeView::ReleaseNode(const std::uint32_t id, HTREEITEM item)
 {
-    if (item == nullptr)
+    if (id == 0 || id >= m_nodes.size() || m_nodes[id].item != item)
     {
         return;
     }
 
-    std::wstring parentPath;
-    HKEY hiveRoot = nullptr;
-
+    // Late results for the id must not reach whichever node reuses it.
+    const auto pending = m_pendingExpand.find(id);
+    if (pending != m_pendingExpand.end())
     {
-        std::lock_guard guard(m_mapMutex);
-        const auto itPath = m_itemPathMap.find(item);
-        if (itPath != m_itemPathMap.end())
-        {
-            parentPath = itPath->second;
-        }
-        else
+        pending->second.stop.request_stop();
+        m_pendingExpand.erase(pending);
+    }
+    std::erase_if(m_insertQueue, [id](InsertBatch const& batch) {
+        return batch.result->parentNode == id;
+    });
+    m_nextPageOffset.erase(item);
+    for (auto& [operationId, op] : m_treeOps)
+    {
+        if (op.reloadNode == id)
         {
-            parentPath = std::wstring(); // empty => root of hive
+            op.reloadNode = 0;
         }
+    }
+    if (m_reveal && m_reveal->nodeId == id)
+    {
+        m_reveal.reset();
+    }
 
-        auto itHive = m_itemHiveMap.find(item);
-        if (itHive != m_itemHiveMap.end())
-        {
-            hiveRoot = itHive->second;
-        }
-        else
+    m_nodes[id] = TreeNode{};
+    m_freeNodes.push_back(id);
+}
+
+const RegistryTreeView::TreeNode* RegistryTreeView::NodeFromItem(HTREEITEM item) const
+{
+    if (item == nullptr || m_hwnd == nullptr)
+    {
+        return nullptr;
+    }
+
+    TVITEMW tvi;
+    ZeroMemory(&tvi, sizeof(TVITEMW));
+    tvi.mask = TVIF_PARAM;
+    tvi.hItem = item;
+    if (TreeView_GetItem(m_hwnd, &tvi) == FALSE)
+    {
+        return nullptr;
+    }
+
+    const auto id = static_cast<size_t>(tvi.lParam);
+    if (tvi.lParam <= 0 || id >= m_nodes.size() || m_nodes[id].item != item)
+    {
+        return nullptr;
+    }
+    return &m_nodes[id];
+}
+
+RegistryTreeView::TreeNode* RegistryTreeView::NodeFromItem(HTREEITEM item)
+{
+    return const_cast<TreeNode*>(static_cast<const RegistryTreeView*>(this)->NodeFromItem(item));
+}
+
+std::wstring RegistryTreeView::BuildPath(std::uint32_t id) const
+{
+    // Hive roots (parent == 0) are not part of the path.
+    size_t length = 0;
+    size_t depth = 0;
+    for (std::uint32_t cur = id; cur != 0 && m_nodes[cur].parent != 0; cur = m_nodes[cur].parent)
+    {
+        length += m_nodes[cur].name->size();
+        ++depth;
+    }
+
+    if (depth == 0)
+    {
+        return {};
+    }
+
+    std::wstring path(length + depth - 1, L'\\');
+    size_t end = path.size();
+    for (std::uint32_t cur = id; cur != 0 && m_nodes[cur].parent != 0; cur = m_nodes[cur].parent)
+    {
+        const std::wstring& name = *m_nodes[cur].name;
+        end -= name.size();
+        path.replace(end, name.size(), name);
+        if (end > 0)
         {
-            hiveRoot = HKEY_CURRENT_USER; // fallback; shouldn't happen
+            --end; // keep the separator
         }
     }
+    return path;
+}
+
+void
+RegistryTreeView::RequestExpand(HTREEITEM item)
+{
+    if (item == nullptr)
+    {
+        return;
+    }
+
+    // Children are loaded once; later expands just show them.
+    const TreeNode* node = NodeFromItem(item);
+    if (node == nullptr || (node->flags & NodeLoaded) != 0)
+    {
+        return;
+    }
 
+    RequestPage(item, 0);
+}
+
+void
+RegistryTreeView::RequestPage(HTREEITEM item, const size_t offset)
+{
     if (m_threadManager == nullptr || m_facade == nullptr)
     {
         return;
     }
 
-    if (!HasDummyChild(item))
+    const TreeNode* node = NodeFromItem(item);
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    const auto nodeId = static_cast<std::uint32_t>(node - m_nodes.data());
+
+    // The previous page is fetched but not inserted yet: its placeholder (or, at offset 0, the
+    // NodeLoaded flag) is updated only once it is, and asking again would insert it twice.
+    if (IsInserting(nodeId))
+    {
+        return;
+    }
+
+    // A second request for the same node joins the one in flight.
+    const auto [pending, inserted] = m_pendingExpand.try_emplace(nodeId);
+    if (!inserted)
     {
         return;
     }
+    pending->second.requestId = ++m_lastRequestId;
+    const std::uint64_t requestId = pending->second.requestId;
+    std::stop_token stop = pending->second.stop.get_token();
+
+    std::wstring parentPath = BuildPath(nodeId);
+    HKEY hiveRoot = node->hive;
 
     HWND uiWnd = m_parentWnd;
     HKEY rootCopy = hiveRoot;
-    std::wstring pathCopy = parentPath;
+    std::wstring pathCopy = std::move(parentPath);
     HTREEITEM parentCopy = item;
     core::registry::RegistryFacade* facadeCopy = m_facade;
+    std::shared_ptr<const core::registry::RegistrySnapshot> snapshot = m_snapshot;
 
-    ExpandResult* res = nullptr;
-    try
+    // A snapshot is already in memory; there is nothing to warm.
+    const bool prefetch = m_prefetchEnabled && snapshot == nullptr;
+
+    IThreadManager* threadManager = m_threadManager;
+
+    // Interactive: the user is waiting for these children; prefetch work queued behind it
+    // runs as Background and cannot delay the click.
+    m_threadManager->enqueue([uiWnd, rootCopy, pathCopy, parentCopy, nodeId, requestId, stop, facadeCopy, snapshot, offset, prefetch, threadManager]()
     {
-        std::vector<std::wstring> names = facadeCopy->ListSubKeys(rootCopy, pathCopy, KEY_READ, core::registry::RegistryFacade::ListOptions{});
+        // Cancelled while queued (collapse, Clear): leave the pool to visible nodes.
+        if (stop.stop_requested())
+        {
+            return;
+        }
 
+        // This lambda runs on a worker thread.
         // Allocate result on heap for PostMessage handoff; UI thread will delete.
-        res = new (std::nothrow) ExpandResult();
+        ExpandResult* res = new (std::nothrow) ExpandResult();
         if (res == nullptr)
         {
             // allocation failed; nothing we can do but bail.
@@ -294,37 +485,148 @@ RegistryTreeView::RequestExpand(HTREEITEM item) const
         }
 
         res->parentItem = parentCopy;
+        res->parentNode = nodeId;
+        res->requestId = requestId;
         res->hiveRoot = rootCopy;
         res->parentFullPath = pathCopy;
-        res->children = std::move(names);
+        res->offset = offset;
         res->errorCode = ERROR_SUCCESS;
 
+        std::vector<core::registry::SubKeyInfo> children;
+        try
+        {
+            // One extra entry tells whether another page exists without counting the key.
+            core::registry::RegistryFacade::ListOptions options;
+            options.offset = offset;
+            options.maxItems = kExpandPageSize + 1;
+
+            children = snapshot != nullptr
+                ? facadeCopy->ListSubKeysWithInfo(*snapshot, pathCopy, options)
+                : facadeCopy->ListSubKeysWithInfo(rootCopy, pathCopy, KEY_READ, options);
+            if (children.size() > kExpandPageSize)
+            {
+                children.pop_back();
+                res->hasMore = true;
+            }
+
+            res->children.reserve(children.size());
+            res->childChildren.reserve(children.size());
+            for (const core::registry::SubKeyInfo& child : children)
+            {
+                res->children.push_back(child.name);
+                res->childChildren.push_back(!child.hasInfo ? I_CHILDRENCALLBACK
+                                             : (child.subKeyCount > 0 ? 1 : 0));
+            }
+        }
+        catch (const RegException& ex)
+        {
+            res->children.clear();
+            res->errorCode = ex.code();
+            if (!stop.stop_requested())
+            {
+                PostTreeError(uiWnd, ex.what());
+            }
+        }
+        catch (const std::exception& ex)
+        {
+            res->children.clear();
+            res->errorCode = ERROR_INTERNAL_ERROR;
+            if (!stop.stop_requested())
+            {
+                PostTreeError(uiWnd, ex.what());
+            }
+        }
+
+        // The UI thread already forgot a cancelled request; don't post work for it.
+        if (stop.stop_requested())
+        {
+            delete res;
+            return;
+        }
+
+        // Posted even on failure so the UI thread clears the in-flight marker.
         BOOL posted = PostMessageW(uiWnd, WM_APP_TREE_EXPAND_RESULT, reinterpret_cast<WPARAM>(res), 0);
         if (posted == FALSE)
         {
             delete res;
-            res = nullptr;
         }
-    }
-    catch (const std::exception& ex)
-    {
-        std::wstring* err = new (std::nothrow) std::wstring();
-        if (err != nullptr)
+
+        // After the page is on its way: warm the cache one level down so the next
+        // expand is answered from memory.
+        if (prefetch && !children.empty() && !stop.stop_requested())
         {
-            std::wstring msg = std::wstring(L"Failed to list subkeys: ") + std::wstring(ex.what(), ex.what() + strlen(ex.what()));
-            *err = msg;
-            BOOL postedErr = PostMessageW(uiWnd, WM_APP_TREE_OP_ERROR, reinterpret_cast<WPARAM>(err), 0);
-            if (postedErr == FALSE)
+            try
+            {
+                threadManager->enqueue([rootCopy, pathCopy, facadeCopy, stop, children = std::move(children)]()
+                {
+                    if (stop.stop_requested())
+                    {
+                        return;
+                    }
+
+                    try
+                    {
+                        facadeCopy->PrefetchSubKeyListings(rootCopy, pathCopy, KEY_READ, children,
+                                                           kPrefetchMaxChildSubKeys, kPrefetchBudget, stop);
+                    }
+                    catch (const std::exception&)
+                    {
+                        // Prefetch is best effort.
+                    }
+                }, IThreadManager::TaskPriority::Background);
+            }
+            catch (const std::exception&)
             {
-                delete err;
+                // Pool is shutting down; skip the prefetch.
             }
         }
+    }, IThreadManager::TaskPriority::Interactive);
+}
+
+bool RegistryTreeView::IsInSubtree(std::uint32_t id, const std::uint32_t ancestor) const
+{
+    for (; id != 0 && id < m_nodes.size(); id = m_nodes[id].parent)
+    {
+        if (id == ancestor)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RegistryTreeView::CancelExpands(const std::uint32_t nodeId)
+{
+    for (auto it = m_pendingExpand.begin(); it != m_pendingExpand.end();)
+    {
+        if (IsInSubtree(it->first, nodeId))
+        {
+            it->second.stop.request_stop();
+            it = m_pendingExpand.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
-    // m_threadManager->enqueue([uiWnd, rootCopy, pathCopy, parentCopy, facadeCopy]()
-    // {
-    //     // This lambda runs on a worker thread.
-    // });
+}
 
+bool RegistryTreeView::IsInserting(const std::uint32_t nodeId) const
+{
+    return std::any_of(m_insertQueue.begin(), m_insertQueue.end(),
+                       [nodeId](InsertBatch const& batch)
+                       {
+                           return batch.result->parentNode == nodeId;
+                       });
+}
+
+void RegistryTreeView::CancelAllExpands()
+{
+    for (auto& [nodeId, pending] : m_pendingExpand)
+    {
+        pending.stop.request_stop();
+    }
+    m_pendingExpand.clear();
 }
 
 void RegistryTreeView::HandleExpandResult(ExpandResult* result)
@@ -336,94 +638,898 @@ void RegistryTreeView::HandleExpandResult(ExpandResult* result)
 
     HTREEITEM parent = result->parentItem;
 
-    if (HasDummyChild(parent))
+    // Drop results of cancelled or superseded requests before touching the control.
+    const auto pending = m_pendingExpand.find(result->parentNode);
+    if (pending == m_pendingExpand.end() || pending->second.requestId != result->requestId)
     {
-        RemoveDummyChild(parent);
+        delete result;
+        return;
     }
+    m_pendingExpand.erase(pending);
 
-    for (std::size_t i = 0; i < result->children.size(); ++i)
-    {
-        std::wstring const& childName = result->children[i];
+    const bool known = result->parentNode < m_nodes.size() &&
+                       m_nodes[result->parentNode].item == parent;
 
-        std::wstring childFullPath;
-        if (result->parentFullPath.empty())
-        {
-            childFullPath = childName;
-        }
-        else
+    // The item may have been deleted while the worker was running.
+    if (!known || result->errorCode != ERROR_SUCCESS)
+    {
+        if (m_reveal && m_reveal->nodeId == result->parentNode)
         {
-            childFullPath = result->parentFullPath + L"\\" + childName;
+            m_reveal.reset(); // its children will not arrive
         }
-
-        HTREEITEM newItem = InsertNode(parent, childName, childFullPath, result->hiveRoot, true);
-        (void)newItem;
+        delete result;
+        return;
     }
 
-    delete result;
+    m_insertQueue.push_back(InsertBatch{ std::unique_ptr<ExpandResult>(result), 0 });
+    if (!m_insertContinuePosted)
+    {
+        ContinueInsertion(); // otherwise the queued continuation picks it up
+    }
 }
 
-void RegistryTreeView::HandleOperationError(std::wstring* errorText) const
+void RegistryTreeView::ContinueInsertion()
 {
-    if (errorText == nullptr)
+    m_insertContinuePosted = false;
+
+    if (m_hwnd == nullptr || m_insertQueue.empty())
     {
         return;
     }
 
-    MessageBoxW(m_parentWnd, errorText->c_str(), L"Registry operation error", MB_OK | MB_ICONERROR);
+    const auto deadline = std::chrono::steady_clock::now() + kInsertSliceBudget;
 
-    delete errorText;
-}
+    // One repaint per slice instead of one per inserted item.
+    SendMessageW(m_hwnd, WM_SETREDRAW, FALSE, 0);
 
-std::optional<std::wstring>
-RegistryTreeView::GetItemPath(HTREEITEM item) const
-{
-    if (item == nullptr)
+    while (!m_insertQueue.empty() && std::chrono::steady_clock::now() < deadline)
     {
-        return {};
+        InsertBatch& batch = m_insertQueue.front();
+        ExpandResult& result = *batch.result;
+        HTREEITEM parent = result.parentItem;
+
+        if (batch.next == 0)
+        {
+            m_nodes[result.parentNode].flags |= NodeLoaded;
+            if (result.offset > 0)
+            {
+                RemoveLoadMoreChild(parent);
+            }
+        }
+
+        const size_t chunkEnd = std::min(result.children.size(), batch.next + kInsertChunkSize);
+        InsertChildren(result, batch.next, chunkEnd);
+        MeasureLabels(result.children, batch.next, chunkEnd);
+
+        if (batch.next == 0 && result.offset == 0 && chunkEnd > 0)
+        {
+            // The control could not expand an item that had no children yet.
+            TreeView_Expand(m_hwnd, parent, TVE_EXPAND);
+        }
+        batch.next = chunkEnd;
+
+        if (batch.next < result.children.size())
+        {
+            continue; // re-check the deadline between chunks
+        }
+
+        if (result.hasMore)
+        {
+            m_nextPageOffset[parent] = result.offset + result.children.size();
+            AddLoadMoreChild(parent);
+        }
+        else
+        {
+            m_nextPageOffset.erase(parent);
+            if (result.offset == 0 && result.children.empty())
+            {
+                SetItemHasChildren(parent, false);
+            }
+        }
+
+        m_insertQueue.pop_front();
     }
 
-    std::lock_guard guard(m_mapMutex);
-    auto it = m_itemPathMap.find(item);
-    if (it == m_itemPathMap.end())
+    SendMessageW(m_hwnd, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(m_hwnd, nullptr, FALSE);
+
+    ScheduleColumnWidthUpdate();
+
+    if (!m_insertQueue.empty())
     {
-        return {};
+        // Yield to input and paint messages before the next slice.
+        m_insertContinuePosted = PostMessageW(m_parentWnd, WM_APP_TREE_INSERT_CONTINUE, 0, 0) != FALSE;
+    }
+
+    if (m_reveal)
+    {
+        ContinueReveal();
     }
-    return {it->second};
 }
 
-void
-RegistryTreeView::Clear()
+void RegistryTreeView::InsertChildren(ExpandResult const& result, size_t first, size_t last)
 {
-    if (m_hwnd != nullptr)
+    for (size_t i = first; i < last; ++i)
     {
-        TreeView_DeleteAllItems(m_hwnd);
+        const std::uint32_t id = AddNode(result.parentNode, result.children[i], result.hiveRoot);
+        const int cChildren = i < result.childChildren.size() ? result.childChildren[i] : I_CHILDRENCALLBACK;
+        if (cChildren == 0)
+        {
+            m_nodes[id].flags |= NodeLoaded; // known leaf: never request an expand
+        }
+
+        // The label is supplied on demand through TVN_GETDISPINFO, and so is the expand
+        // button when the child's subkey count is unknown.
+        TVINSERTSTRUCTW tvins;
+        ZeroMemory(&tvins, sizeof(TVINSERTSTRUCTW));
+        tvins.hParent = result.parentItem;
+        tvins.hInsertAfter = TVI_LAST;
+        tvins.item.mask = TVIF_TEXT | TVIF_PARAM | TVIF_CHILDREN;
+        tvins.item.pszText = LPSTR_TEXTCALLBACKW;
+        tvins.item.cChildren = cChildren;
+
+        InsertItemInternal(tvins, id);
     }
+}
 
-    std::lock_guard<std::mutex> guard(m_mapMutex);
-    m_itemPathMap.clear();
-    m_itemHiveMap.clear();
+void RegistryTreeView::SetItemHasChildren(HTREEITEM item, bool hasChildren) const
+{
+    TVITEMW tvi;
+    ZeroMemory(&tvi, sizeof(TVITEMW));
+    tvi.mask = TVIF_CHILDREN;
+    tvi.hItem = item;
+    tvi.cChildren = hasChildren ? 1 : 0;
+    TreeView_SetItem(m_hwnd, &tvi);
 }
 
-LRESULT RegistryTreeView::HandleNotify(LPNMHDR pnmh)
+void RegistryTreeView::HandleGetDispInfo(LPNMTVDISPINFOW info) const
 {
+    TVITEMW& item = info->item;
+
+    // lParam is always supplied with the notification, so no lookup is needed.
+    const auto id = static_cast<size_t>(item.lParam);
+    if (item.lParam <= 0 || id >= m_nodes.size())
     {
-        wchar_t buf[256];
-        wsprintfW(buf, L"[RegistryTreeView::HandleNotify] this=0x%p hwndFrom=0x%p code=%d (0x%X)\n",
-                  reinterpret_cast<void*>(this),
-                  reinterpret_cast<void*>(pnmh ? pnmh->hwndFrom : nullptr),
-                  pnmh ? pnmh->code : 0,
-                  pnmh ? pnmh->code : 0);
-        OutputDebugStringW(buf);
+        return;
     }
+    const TreeNode& node = m_nodes[id];
 
-    if (pnmh == nullptr)
+    if ((item.mask & TVIF_TEXT) != 0)
     {
-        return 0;
+        item.pszText = const_cast<LPWSTR>(node.name->c_str());
     }
 
-    if (pnmh->hwndFrom != m_hwnd)
+    if ((item.mask & TVIF_CHILDREN) != 0)
     {
-        return 0;
+        // Unloaded keys show an expander; the real answer arrives with the expand result.
+        const bool loaded = (node.flags & NodeLoaded) != 0;
+        item.cChildren = (!loaded || TreeView_GetChild(m_hwnd, item.hItem) != nullptr) ? 1 : 0;
+    }
+}
+
+void RegistryTreeView::HandleOperationError(std::wstring* errorText) const
+{
+    if (errorText == nullptr)
+    {
+        return;
+    }
+
+    MessageBoxW(m_parentWnd, errorText->c_str(), L"Registry operation error", MB_OK | MB_ICONERROR);
+
+    delete errorText;
+}
+
+std::optional<std::wstring>
+RegistryTreeView::GetItemPath(HTREEITEM item) const
+{
+    if (item == nullptr)
+    {
+        return {};
+    }
+
+    const TreeNode* node = NodeFromItem(item);
+    if (node == nullptr)
+    {
+        return {};
+    }
+    return BuildPath(static_cast<std::uint32_t>(node - m_nodes.data()));
+}
+
+std::optional<std::wstring>
+RegistryTreeView::GetItemFullPath(HTREEITEM item) const
+{
+    const TreeNode* node = NodeFromItem(item);
+    if (node == nullptr)
+    {
+        return {};
+    }
+
+    std::wstring path = HiveName(node->hive);
+    const std::wstring subKeyPath = BuildPath(static_cast<std::uint32_t>(node - m_nodes.data()));
+    if (!subKeyPath.empty())
+    {
+        path += L'\\';
+        path += subKeyPath;
+    }
+    return path;
+}
+
+HTREEITEM RegistryTreeView::GetSelectedItem() const noexcept
+{
+    return m_hwnd != nullptr ? TreeView_GetSelection(m_hwnd) : nullptr;
+}
+
+void
+RegistryTreeView::Clear()
+{
+    if (m_hwnd != nullptr)
+    {
+        TreeView_DeleteAllItems(m_hwnd);
+    }
+
+    CancelAllExpands();
+    m_nextPageOffset.clear();
+    m_insertQueue.clear();
+    m_reveal.reset();
+    m_maxLabelWidth = 0;
+
+    // Running copies keep going, but the nodes they would reload are gone.
+    for (auto& [operationId, op] : m_treeOps)
+    {
+        op.reloadNode = 0;
+    }
+
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_names.clear();
+}
+
+// -------------------- Subtree operations --------------------
+
+static void
+PostTreeOpProgress(HWND uiWnd, TreeOpProgress* progress)
+{
+    if (progress == nullptr)
+    {
+        return;
+    }
+    if (PostMessageW(uiWnd, WM_APP_TREE_OP_PROGRESS, reinterpret_cast<WPARAM>(progress), 0) == FALSE)
+    {
+        delete progress;
+    }
+}
+
+std::uint64_t RegistryTreeView::BeginTreeOp(const std::uint32_t reloadNode, const wchar_t* verb)
+{
+    const std::uint64_t operationId = ++m_lastTreeOpId;
+    TreeOp& op = m_treeOps[operationId];
+    op.reloadNode = reloadNode;
+    op.verb = verb;
+    return operationId;
+}
+
+void RegistryTreeView::EndTreeOp(const std::uint64_t operationId)
+{
+    m_treeOps.erase(operationId);
+    if (m_treeOps.empty())
+    {
+        m_treeOpStatus.clear();
+        UpdateTitle();
+    }
+}
+
+void RegistryTreeView::UpdateTitle() const
+{
+    std::wstring title = m_baseTitle;
+    for (const std::wstring* status : { &m_treeOpStatus, &m_searchStatus })
+    {
+        if (!status->empty())
+        {
+            title += L" - " + *status;
+        }
+    }
+    SetWindowTextW(m_parentWnd, title.c_str());
+}
+
+bool RegistryTreeView::StartCopy(HTREEITEM sourceItem, HKEY targetRoot, std::wstring const& targetPath, const bool move)
+{
+    if (m_threadManager == nullptr || m_facade == nullptr || m_snapshot != nullptr)
+    {
+        return false;
+    }
+
+    const TreeNode* node = NodeFromItem(sourceItem);
+    if (node == nullptr || node->parent == 0)
+    {
+        return false; // hive roots cannot be copied or moved
+    }
+
+    const auto nodeId = static_cast<std::uint32_t>(node - m_nodes.data());
+    const std::uint64_t operationId = BeginTreeOp(move ? node->parent : 0, move ? L"Moving" : L"Copying");
+    std::stop_token stop = m_treeOps[operationId].stop.get_token();
+
+    HWND uiWnd = m_parentWnd;
+    HKEY sourceRoot = node->hive;
+    std::wstring sourcePath = BuildPath(nodeId);
+    core::registry::RegistryFacade* facade = m_facade;
+    IThreadManager* threadManager = m_threadManager;
+
+    try
+    {
+        // The copying task is Normal; the walkers it adds are Background, so browsing stays responsive.
+        m_threadManager->enqueue([uiWnd, operationId, stop, sourceRoot, sourcePath, targetRoot, targetPath, move, facade, threadManager]()
+        {
+            core::registry::TreeCopyOptions options;
+            options.threadManager = threadManager;
+            options.priority = IThreadManager::TaskPriority::Background;
+            options.maxConcurrency = kTreeOpConcurrency;
+            options.stop = stop;
+            options.progress = [uiWnd, operationId](core::registry::TreeCopyProgress const& progress)
+            {
+                if (progress.finished)
+                {
+                    return; // the final message below carries the result
+                }
+                TreeOpProgress* msg = new (std::nothrow) TreeOpProgress();
+                if (msg != nullptr)
+                {
+                    msg->operationId = operationId;
+                    msg->keysCopied = progress.keysCopied;
+                    msg->valuesCopied = progress.valuesCopied;
+                    msg->keysFailed = progress.keysFailed;
+                }
+                PostTreeOpProgress(uiWnd, msg);
+            };
+
+            TreeOpProgress* done = new (std::nothrow) TreeOpProgress();
+            if (done == nullptr)
+            {
+                return;
+            }
+            done->operationId = operationId;
+            done->finished = true;
+
+            try
+            {
+                const core::registry::TreeCopyResult result = move
+                    ? facade->MoveKeyTree(sourceRoot, sourcePath, targetRoot, targetPath, options)
+                    : facade->CopyKeyTree(sourceRoot, sourcePath, targetRoot, targetPath, options);
+                done->keysCopied = result.keysCopied;
+                done->valuesCopied = result.valuesCopied;
+                done->keysFailed = result.keysFailed;
+                done->cancelled = result.cancelled;
+                done->errorCode = result.firstError;
+            }
+            catch (const RegException& ex)
+            {
+                done->errorCode = ex.code();
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+            catch (const std::exception& ex)
+            {
+                done->errorCode = ERROR_INTERNAL_ERROR;
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+
+            // Posted even after a cancel so the UI thread forgets the operation.
+            PostTreeOpProgress(uiWnd, done);
+        }, IThreadManager::TaskPriority::Normal);
+    }
+    catch (const std::exception&)
+    {
+        EndTreeOp(operationId);
+        return false;
+    }
+
+    m_treeOpStatus = std::wstring(m_treeOps[operationId].verb) + L"...";
+    UpdateTitle();
+    return true;
+}
+
+bool RegistryTreeView::StartExport(HTREEITEM sourceItem, std::wstring const& filePath)
+{
+    if (m_threadManager == nullptr || m_facade == nullptr || m_snapshot != nullptr)
+    {
+        return false;
+    }
+
+    const TreeNode* node = NodeFromItem(sourceItem);
+    if (node == nullptr)
+    {
+        return false;
+    }
+
+    const std::uint64_t operationId = BeginTreeOp(0, L"Exporting");
+
+    HWND uiWnd = m_parentWnd;
+    HKEY root = node->hive;
+    std::wstring path = BuildPath(static_cast<std::uint32_t>(node - m_nodes.data()));
+    core::registry::RegistryFacade* facade = m_facade;
+
+    try
+    {
+        m_threadManager->enqueue([uiWnd, operationId, root, path, filePath, facade]()
+        {
+            TreeOpProgress* done = new (std::nothrow) TreeOpProgress();
+            if (done == nullptr)
+            {
+                return;
+            }
+            done->operationId = operationId;
+            done->finished = true;
+
+            try
+            {
+                facade->ExportKey(root, path, filePath);
+            }
+            catch (const RegException& ex)
+            {
+                done->errorCode = ex.code();
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+            catch (const std::exception& ex)
+            {
+                done->errorCode = ERROR_INTERNAL_ERROR;
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+
+            PostTreeOpProgress(uiWnd, done);
+        }, IThreadManager::TaskPriority::Normal);
+    }
+    catch (const std::exception&)
+    {
+        EndTreeOp(operationId);
+        return false;
+    }
+
+    m_treeOpStatus = L"Exporting...";
+    UpdateTitle();
+    return true;
+}
+
+bool RegistryTreeView::StartCapture(HTREEITEM sourceItem, std::wstring const& filePath)
+{
+    if (m_threadManager == nullptr || m_facade == nullptr || m_snapshot != nullptr)
+    {
+        return false;
+    }
+
+    const TreeNode* node = NodeFromItem(sourceItem);
+    if (node == nullptr)
+    {
+        return false;
+    }
+
+    const std::uint64_t operationId = BeginTreeOp(0, L"Capturing");
+    std::stop_token stop = m_treeOps[operationId].stop.get_token();
+
+    HWND uiWnd = m_parentWnd;
+    HKEY root = node->hive;
+    std::wstring path = BuildPath(static_cast<std::uint32_t>(node - m_nodes.data()));
+    core::registry::RegistryFacade* facade = m_facade;
+
+    try
+    {
+        m_threadManager->enqueue([uiWnd, operationId, stop, root, path, filePath, facade]()
+        {
+            TreeOpProgress* done = new (std::nothrow) TreeOpProgress();
+            if (done == nullptr)
+            {
+                return;
+            }
+            done->operationId = operationId;
+            done->finished = true;
+
+            try
+            {
+                core::registry::SnapshotCaptureOptions options;
+                options.stop = stop;
+                const core::registry::SnapshotCaptureResult result = facade->CaptureSnapshot(root, path, filePath, options);
+                done->keysCopied = result.keysCaptured;
+                done->valuesCopied = result.valuesCaptured;
+                done->keysFailed = result.keysFailed;
+                done->cancelled = result.cancelled;
+                done->errorCode = result.firstError;
+            }
+            catch (const RegException& ex)
+            {
+                done->errorCode = ex.code();
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+            catch (const std::exception& ex)
+            {
+                done->errorCode = ERROR_INTERNAL_ERROR;
+                done->errorText.assign(ex.what(), ex.what() + strlen(ex.what()));
+            }
+
+            PostTreeOpProgress(uiWnd, done);
+        }, IThreadManager::TaskPriority::Background);
+    }
+    catch (const std::exception&)
+    {
+        EndTreeOp(operationId);
+        return false;
+    }
+
+    m_treeOpStatus = L"Capturing...";
+    UpdateTitle();
+    return true;
+}
+
+void RegistryTreeView::HandleTreeOpProgress(TreeOpProgress* progress)
+{
+    if (progress == nullptr)
+    {
+        return;
+    }
+    const std::unique_ptr<TreeOpProgress> owned(progress);
+
+    const auto it = m_treeOps.find(progress->operationId);
+    if (it == m_treeOps.end())
+    {
+        return; // cancelled
+    }
+
+    if (!progress->finished)
+    {
+        std::wstring title = it->second.verb;
+        title += L"... " + std::to_wstring(progress->keysCopied) + L" keys, " +
+                 std::to_wstring(progress->valuesCopied) + L" values";
+        if (progress->keysFailed > 0)
+        {
+            title += L", " + std::to_wstring(progress->keysFailed) + L" failed";
+        }
+        m_treeOpStatus = std::move(title);
+        UpdateTitle();
+        return;
+    }
+
+    const std::uint32_t reloadNode = it->second.reloadNode;
+    const std::wstring verb = it->second.verb;
+    EndTreeOp(progress->operationId);
+
+    // The item may have been deleted while the operation was running.
+    if (reloadNode != 0 && reloadNode < m_nodes.size() &&
+        NodeFromItem(m_nodes[reloadNode].item) == &m_nodes[reloadNode])
+    {
+        ReloadChildren(reloadNode);
+    }
+
+    if (!progress->errorText.empty() || progress->keysFailed > 0)
+    {
+        std::wstring text = verb + L" failed";
+        if (!progress->errorText.empty())
+        {
+            text += L": " + progress->errorText;
+        }
+        else
+        {
+            const std::string reason = core::registry::FormatWinErrorMessage(progress->errorCode);
+            text += L" for " + std::to_wstring(progress->keysFailed) + L" keys: " +
+                    std::wstring(reason.begin(), reason.end());
+        }
+        MessageBoxW(m_parentWnd, text.c_str(), L"Error", MB_OK | MB_ICONERROR);
+    }
+}
+
+void RegistryTreeView::CancelTreeOps()
+{
+    for (auto& [operationId, op] : m_treeOps)
+    {
+        op.stop.request_stop();
+    }
+    m_treeOps.clear();
+    m_treeOpStatus.clear();
+    UpdateTitle();
+}
+
+bool RegistryTreeView::HasTreeOps() const noexcept
+{
+    return !m_treeOps.empty();
+}
+
+// -------------------- Search --------------------
+
+static void
+PostSearchResults(HWND uiWnd, SearchResults* results)
+{
+    if (results == nullptr)
+    {
+        return;
+    }
+    if (PostMessageW(uiWnd, WM_APP_SEARCH_RESULTS, reinterpret_cast<WPARAM>(results), 0) == FALSE)
+    {
+        delete results;
+    }
+}
+
+void RegistryTreeView::SetSearchIndex(std::shared_ptr<core::registry::SearchIndex> index, std::wstring filePath)
+{
+    m_searchIndex = std::move(index);
+    m_searchIndexPath = std::move(filePath);
+    m_searchIndexLoaded = false;
+}
+
+const std::vector<core::registry::SearchHit>& RegistryTreeView::SearchHits() const noexcept
+{
+    return m_searchHits;
+}
+
+bool RegistryTreeView::StartSearch(core::registry::SearchQuery query)
+{
+    if (m_threadManager == nullptr || query.pattern.empty() || m_snapshot != nullptr)
+    {
+        return false;
+    }
+
+    CancelSearch();
+    m_searchStop = std::stop_source();
+    m_searchPattern = query.pattern;
+    const std::uint64_t searchId = ++m_searchId;
+
+    HWND uiWnd = m_parentWnd;
+    std::stop_token stop = m_searchStop.get_token();
+    IThreadManager* threadManager = m_threadManager;
+    std::shared_ptr<core::registry::SearchIndex> index = m_searchIndex;
+    std::wstring indexPath = m_searchIndexPath;
+    const bool loadIndex = index && !indexPath.empty() && !m_searchIndexLoaded;
+
+    try
+    {
+        // Background: a full-registry walk must not delay expands the user is waiting for.
+        m_threadManager->enqueue([uiWnd, searchId, stop, query = std::move(query), threadManager, index, indexPath,
+                                  loadIndex]()
+        {
+            if (loadIndex)
+            {
+                index->Load(indexPath); // a missing or stale file leaves the index empty
+            }
+
+            core::registry::SearchOptions options;
+            options.threadManager = threadManager;
+            options.maxConcurrency = kSearchConcurrency;
+            options.stop = stop;
+            options.index = index.get();
+
+            const core::registry::SearchHitSink sink = [uiWnd, searchId](std::vector<core::registry::SearchHit>& hits)
+            {
+                SearchResults* batch = new (std::nothrow) SearchResults();
+                if (batch != nullptr)
+                {
+                    batch->searchId = searchId;
+                    batch->hits = std::move(hits);
+                }
+                PostSearchResults(uiWnd, batch);
+            };
+
+            SearchResults* done = new (std::nothrow) SearchResults();
+            if (done == nullptr)
+            {
+                return;
+            }
+            done->searchId = searchId;
+            done->finished = true;
+
+            try
+            {
+                done->stats = core::registry::SearchRegistry(query, options, sink);
+                if (index && !indexPath.empty() && !done->stats.cancelled)
+                {
+                    index->Save(indexPath);
+                }
+            }
+            catch (const std::exception&)
+            {
+                done->stats.cancelled = true;
+            }
+
+            PostSearchResults(uiWnd, done);
+        }, IThreadManager::TaskPriority::Background);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    m_searchIndexLoaded = m_searchIndexLoaded || loadIndex;
+    m_searchRunning = true;
+    m_searchHits.clear();
+    UpdateSearchTitle(false);
+    return true;
+}
+
+void RegistryTreeView::CancelSearch()
+{
+    m_searchStop.request_stop();
+    ++m_searchId; // late batches of the cancelled search no longer match
+    m_searchRunning = false;
+    m_searchStatus.clear();
+    UpdateTitle();
+}
+
+bool RegistryTreeView::IsSearching() const noexcept
+{
+    return m_searchRunning;
+}
+
+void RegistryTreeView::HandleSearchResults(SearchResults* results)
+{
+    if (results == nullptr)
+    {
+        return;
+    }
+    const std::unique_ptr<SearchResults> owned(results);
+
+    if (results->searchId != m_searchId)
+    {
+        return;
+    }
+
+    m_searchHits.insert(m_searchHits.end(),
+                        std::make_move_iterator(results->hits.begin()),
+                        std::make_move_iterator(results->hits.end()));
+    if (results->finished)
+    {
+        m_searchRunning = false;
+    }
+    UpdateSearchTitle(results->finished);
+}
+
+void RegistryTreeView::UpdateSearchTitle(const bool finished)
+{
+    m_searchStatus = L"Search \"" + m_searchPattern + L"\": " + std::to_wstring(m_searchHits.size()) + L" hits";
+    if (!finished)
+    {
+        m_searchStatus += L"...";
+    }
+    UpdateTitle();
+}
+
+// -------------------- Reveal --------------------
+
+bool RegistryTreeView::RevealKey(HKEY root, std::wstring const& subKeyPath)
+{
+    if (m_hwnd == nullptr || m_snapshot != nullptr)
+    {
+        return false;
+    }
+
+    HTREEITEM hiveItem = TreeView_GetRoot(m_hwnd);
+    for (; hiveItem != nullptr; hiveItem = TreeView_GetNextSibling(m_hwnd, hiveItem))
+    {
+        const TreeNode* node = NodeFromItem(hiveItem);
+        if (node != nullptr && node->hive == root)
+        {
+            break;
+        }
+    }
+    if (hiveItem == nullptr)
+    {
+        return false;
+    }
+
+    RevealState reveal;
+    reveal.nodeId = static_cast<std::uint32_t>(NodeFromItem(hiveItem) - m_nodes.data());
+    for (size_t start = 0; start <= subKeyPath.size();)
+    {
+        size_t end = subKeyPath.find(L'\\', start);
+        if (end == std::wstring::npos)
+        {
+            end = subKeyPath.size();
+        }
+        if (end > start)
+        {
+            reveal.components.emplace_back(subKeyPath, start, end - start);
+        }
+        start = end + 1;
+    }
+
+    m_reveal = std::move(reveal);
+    ContinueReveal();
+    return true;
+}
+
+void RegistryTreeView::ContinueReveal()
+{
+    while (m_reveal)
+    {
+        RevealState& reveal = *m_reveal;
+        TreeNode& node = m_nodes[reveal.nodeId];
+        HTREEITEM item = node.item;
+        if (NodeFromItem(item) != &node)
+        {
+            m_reveal.reset(); // deleted on the way
+            return;
+        }
+
+        if (reveal.next == reveal.components.size())
+        {
+            TreeView_SelectItem(m_hwnd, item);
+            TreeView_EnsureVisible(m_hwnd, item);
+            m_reveal.reset();
+            return;
+        }
+
+        // Wait until the node's children are fetched and inserted.
+        const std::uint32_t nodeId = reveal.nodeId;
+        if (IsInserting(nodeId) || m_pendingExpand.contains(nodeId))
+        {
+            return;
+        }
+        if ((node.flags & NodeLoaded) == 0)
+        {
+            RequestExpand(item); // continued from ContinueInsertion
+            return;
+        }
+
+        std::wstring const& wanted = reveal.components[reveal.next];
+        std::uint32_t found = 0;
+        for (HTREEITEM child = TreeView_GetChild(m_hwnd, item); child != nullptr;
+             child = TreeView_GetNextSibling(m_hwnd, child))
+        {
+            const TreeNode* childNode = NodeFromItem(child);
+            if (childNode != nullptr &&
+                CompareStringOrdinal(childNode->name->c_str(), -1, wanted.c_str(), -1, TRUE) == CSTR_EQUAL)
+            {
+                found = static_cast<std::uint32_t>(childNode - m_nodes.data());
+                break;
+            }
+        }
+
+        if (found != 0)
+        {
+            TreeView_Expand(m_hwnd, item, TVE_EXPAND);
+            reveal.nodeId = found;
+            ++reveal.next;
+            continue;
+        }
+
+        // Not among the children inserted so far: fetch the next page, if there is one.
+        const auto more = m_nextPageOffset.find(item);
+        if (more != m_nextPageOffset.end())
+        {
+            RequestPage(item, more->second);
+            return;
+        }
+
+        // The rest of the path no longer exists; stop at its deepest existing ancestor.
+        reveal.components.resize(reveal.next);
+    }
+}
+
+void RegistryTreeView::ReloadChildren(const std::uint32_t nodeId)
+{
+    HTREEITEM item = m_nodes[nodeId].item;
+
+    CancelExpands(nodeId);
+    m_nextPageOffset.erase(item);
+    std::erase_if(m_insertQueue, [this, nodeId](InsertBatch const& batch) {
+        return IsInSubtree(batch.result->parentNode, nodeId);
+    });
+
+    // Each deleted item releases its node through TVN_DELETEITEM.
+    while (HTREEITEM child = TreeView_GetChild(m_hwnd, item))
+    {
+        TreeView_DeleteItem(m_hwnd, child);
+    }
+    m_nodes[nodeId].flags &= static_cast<std::uint8_t>(~NodeLoaded);
+
+    if ((TreeView_GetItemState(m_hwnd, item, TVIS_EXPANDED) & TVIS_EXPANDED) != 0)
+    {
+        RequestPage(item, 0);
+    }
+}
+
+LRESULT RegistryTreeView::HandleNotify(LPNMHDR pnmh)
+{
+    if (pnmh == nullptr)
+    {
+        return 0;
+    }
+
+    if (pnmh->hwndFrom != m_hwnd)
+    {
+        return 0;
     }
 
     switch (pnmh->code)
@@ -442,27 +1548,53 @@ LRESULT RegistryTreeView::HandleNotify(LPNMHDR pnmh)
                         RequestExpand(itemToExpand);
                     }
                 }
+                else if ((action & TVE_COLLAPSE) != 0)
+                {
+                    const auto id = static_cast<std::uint32_t>(pTree->itemNew.lParam);
+                    if (pTree->itemNew.lParam > 0 && id < m_nodes.size())
+                    {
+                        CancelExpands(id);
+                    }
+                }
             }
             return 0;
         }
 
-        // Post-expand (already expanded) — optional: sometimes easier to react to this
-        case TVN_ITEMEXPANDED:
+        case TVN_DELETEITEMW:
         {
-            LPNMTREEVIEWW pTree = reinterpret_cast<LPNMTREEVIEWW>(pnmh);
-            if (pTree != nullptr)
+            const auto* pTree = reinterpret_cast<LPNMTREEVIEWW>(pnmh);
+            if (pTree->itemOld.lParam > 0)
+            {
+                ReleaseNode(static_cast<std::uint32_t>(pTree->itemOld.lParam), pTree->itemOld.hItem);
+            }
+            return 0;
+        }
+
+        case TVN_GETDISPINFOW:
+        {
+            HandleGetDispInfo(reinterpret_cast<LPNMTVDISPINFOW>(pnmh));
+            return 0;
+        }
+
+        // The "load more" placeholder is painted once it scrolls into view: fetch the next page.
+        case NM_CUSTOMDRAW:
+        {
+            auto* pDraw = reinterpret_cast<LPNMTVCUSTOMDRAW>(pnmh);
+            if (pDraw->nmcd.dwDrawStage == CDDS_PREPAINT)
             {
-                // Similar handling as above (but note action may be TVE_EXPAND or TVE_COLLAPSE)
-                if ((pTree->action & TVE_EXPAND) != 0)
+                return m_nextPageOffset.empty() ? CDRF_DODEFAULT : CDRF_NOTIFYITEMDRAW;
+            }
+            if (pDraw->nmcd.dwDrawStage == CDDS_ITEMPREPAINT && pDraw->nmcd.lItemlParam == LOAD_MORE_LPARAM)
+            {
+                HTREEITEM placeholder = reinterpret_cast<HTREEITEM>(pDraw->nmcd.dwItemSpec);
+                HTREEITEM parent = TreeView_GetParent(m_hwnd, placeholder);
+                const auto it = m_nextPageOffset.find(parent);
+                if (it != m_nextPageOffset.end())
                 {
-                    HTREEITEM item = pTree->itemNew.hItem;
-                    if (item != nullptr)
-                    {
-                        RequestExpand(item);
-                    }
+                    RequestPage(parent, it->second);
                 }
             }
-            return 0;
+            return CDRF_DODEFAULT;
         }
 
         // Selection changed — keep as before
@@ -496,7 +1628,7 @@ LRESULT RegistryTreeView::HandleNotify(LPNMHDR pnmh)
     return 0;
 }
 
-void RegistryTreeView::AddDummyChild(HTREEITEM parent)
+void RegistryTreeView::AddLoadMoreChild(HTREEITEM parent)
 {
     TVINSERTSTRUCTW tvins;
     ZeroMemory(&tvins, sizeof(TVINSERTSTRUCTW));
@@ -506,8 +1638,8 @@ void RegistryTreeView::AddDummyChild(HTREEITEM parent)
     TVITEMW item;
     ZeroMemory(&item, sizeof(TVITEMW));
     item.mask = TVIF_TEXT | TVIF_PARAM;
-    item.pszText = const_cast<LPWSTR>(L"");
-    item.lParam = DUMMY_CHILD_LPARAM;
+    item.pszText = const_cast<LPWSTR>(L"Loading more...");
+    item.lParam = LOAD_MORE_LPARAM;
 
     tvins.item = item;
 
@@ -515,66 +1647,68 @@ void RegistryTreeView::AddDummyChild(HTREEITEM parent)
     (void)child;
 }
 
-bool RegistryTreeView::HasDummyChild(HTREEITEM parent) const
+void RegistryTreeView::RemoveLoadMoreChild(HTREEITEM parent) const
 {
-    HTREEITEM firstChild = TreeView_GetChild(m_hwnd, parent);
-    if (firstChild == nullptr)
+    HTREEITEM lastChild = nullptr;
+    for (HTREEITEM child = TreeView_GetChild(m_hwnd, parent); child != nullptr;
+         child = TreeView_GetNextSibling(m_hwnd, child))
     {
-        return false;
+        lastChild = child;
+    }
+    if (lastChild == nullptr)
+    {
+        return;
     }
 
     TVITEMW tvi;
     ZeroMemory(&tvi, sizeof(TVITEMW));
     tvi.mask = TVIF_PARAM;
-    tvi.hItem = firstChild;
+    tvi.hItem = lastChild;
 
-    BOOL got = TreeView_GetItem(m_hwnd, &tvi);
-    if (got == FALSE)
+    if (TreeView_GetItem(m_hwnd, &tvi) != FALSE && tvi.lParam == LOAD_MORE_LPARAM)
     {
-        return false;
+        TreeView_DeleteItem(m_hwnd, lastChild);
     }
-
-    if (tvi.lParam == DUMMY_CHILD_LPARAM)
-    {
-        return true;
-    }
-    return false;
 }
 
-void RegistryTreeView::RemoveDummyChild(HTREEITEM parent) const
+HTREEITEM RegistryTreeView::InsertItemInternal(TVINSERTSTRUCTW const& tvins, std::uint32_t nodeId)
 {
-    HTREEITEM firstChild = TreeView_GetChild(m_hwnd, parent);
-    if (firstChild == nullptr)
+    TVINSERTSTRUCTW insCopy = tvins; // copy
+    insCopy.item.mask |= TVIF_PARAM;
+    insCopy.item.lParam = static_cast<LPARAM>(nodeId);
+
+    HTREEITEM inserted = TreeView_InsertItem(m_hwnd, &insCopy);
+    if (inserted != nullptr)
     {
-        return;
+        m_nodes[nodeId].item = inserted;
     }
+    return inserted;
+}
 
-    TVITEMW tvi;
-    ZeroMemory(&tvi, sizeof(TVITEMW));
-    tvi.mask = TVIF_PARAM;
-    tvi.hItem = firstChild;
-
-    BOOL got = TreeView_GetItem(m_hwnd, &tvi);
-    if (got == FALSE)
+static void
+PostTreeError(HWND uiWnd, char const* what)
+{
+    std::wstring* err = new (std::nothrow) std::wstring();
+    if (err == nullptr)
     {
         return;
     }
 
-    if (tvi.lParam == DUMMY_CHILD_LPARAM)
+    *err = std::wstring(L"Failed to list subkeys: ") + std::wstring(what, what + strlen(what));
+    BOOL postedErr = PostMessageW(uiWnd, WM_APP_TREE_OP_ERROR, reinterpret_cast<WPARAM>(err), 0);
+    if (postedErr == FALSE)
     {
-        TreeView_DeleteItem(m_hwnd, firstChild);
+        delete err;
     }
 }
 
-HTREEITEM RegistryTreeView::InsertItemInternal(HTREEITEM parent, TVINSERTSTRUCTW const& tvins, std::wstring const& fullPath, HKEY hiveRoot) const
+static std::wstring
+HiveName(HKEY hive)
 {
-    TVINSERTSTRUCTW insCopy = tvins; // copy
-    HTREEITEM inserted = TreeView_InsertItem(m_hwnd, &insCopy);
-    if (inserted != nullptr)
-    {
-        std::lock_guard<std::mutex> guard(m_mapMutex);
-        m_itemPathMap.insert(std::make_pair(inserted, fullPath));
-        m_itemHiveMap.insert(std::make_pair(inserted, hiveRoot));
-    }
-    return inserted;
+    if (hive == HKEY_CLASSES_ROOT) return L"HKEY_CLASSES_ROOT";
+    if (hive == HKEY_CURRENT_USER) return L"HKEY_CURRENT_USER";
+    if (hive == HKEY_LOCAL_MACHINE) return L"HKEY_LOCAL_MACHINE";
+    if (hive == HKEY_USERS) return L"HKEY_USERS";
+    if (hive == HKEY_CURRENT_CONFIG) return L"HKEY_CURRENT_CONFIG";
+    return L"(unknown hive)";
 }
@@ -6,25 +6,36 @@
 //
 // Design notes (summary):
 //  - All Win32 control calls must run on the UI thread.
-//  - TV item -> full path mapping is kept in an internal map (HTREEITEM -> std::wstring).
+//  - Each TV item's lParam is an id into a parent-linked node table (parent id, interned
+//    name, hive, flags). Full paths are rebuilt on demand by walking the parent chain.
 //  - When a node expands, the handler enqueues a background task on IThreadManager.
-//    The worker calls RegistryFacade::ListSubKeys(...) and posts an ExpandResult* to the
-//    main window using PostMessage. The main window MUST forward that pointer to
-//    RegistryTreeView::HandleExpandResult(ExpandResult*). UI thread will free ExpandResult.
+//    The worker calls RegistryFacade::ForEachSubKey(...) for one page of children and posts
+//    an ExpandResult* to the main window using PostMessage. The main window MUST forward that
+//    pointer to RegistryTreeView::HandleExpandResult(ExpandResult*). UI thread will free ExpandResult.
+//  - Large keys are filled page by page: if more children remain, a "load more" placeholder
+//    is appended and the next page is requested when that placeholder is first painted.
 //  - The component does NOT own the RegistryFacade or IThreadManager pointers; those are non-owning.
 
 #include <windows.h>
 #include <commctrl.h>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
-#include <mutex>
+#include <unordered_set>
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <optional>
+#include <stop_token>
 #include "Messages.h"
+#include "../core/registry/RegistrySearch.h"
 namespace core::registry
 {
     class RegistryFacade;
+    class SearchIndex;
+    class RegistrySnapshot;
 }
 
 class IThreadManager; // forward (your threadpool interface)
@@ -33,10 +44,39 @@ class IThreadManager; // forward (your threadpool interface)
 struct ExpandResult
 {
     HTREEITEM parentItem;               // which tree item to populate (UI thread's HTREEITEM)
+    std::uint32_t parentNode = 0;       // node table id of parentItem
+    std::uint64_t requestId = 0;        // matches the pending request that produced this result
     HKEY       hiveRoot;                // HKEY_CURRENT_USER etc. - useful for re-querying or further ops
     std::wstring parentFullPath;        // full path to parent (e.g. L"Software\\MyApp")
     std::vector<std::wstring> children; // child subkey names (just names, not full paths)
+    std::vector<int> childChildren;     // per child: 1 has subkeys, 0 leaf, I_CHILDRENCALLBACK unknown
     LSTATUS    errorCode;               // ERROR_SUCCESS on success, otherwise set
+    size_t     offset = 0;              // index of children[0] among the parent's subkeys
+    bool       hasMore = false;         // further pages remain after this one
+};
+
+// Progress of a subtree copy, move or export started by RegistryTreeView::StartCopy/StartExport.
+// Posted with WM_APP_TREE_OP_PROGRESS (heap pointer in wParam); the UI thread frees it.
+struct TreeOpProgress
+{
+    std::uint64_t operationId = 0;
+    size_t keysCopied = 0;
+    size_t valuesCopied = 0;
+    size_t keysFailed = 0;
+    bool finished = false;              // last message of the operation
+    bool cancelled = false;
+    LSTATUS errorCode = ERROR_SUCCESS;  // first failure, if any
+    std::wstring errorText;             // set when the operation stopped with an exception
+};
+
+// A batch of hits of the search started by RegistryTreeView::StartSearch. Posted with
+// WM_APP_SEARCH_RESULTS (heap pointer in wParam); the UI thread frees it.
+struct SearchResults
+{
+    std::uint64_t searchId = 0;
+    std::vector<core::registry::SearchHit> hits;
+    bool finished = false;              // last message of the search; stats are set
+    core::registry::SearchStats stats;
 };
 
 // RegistryTreeView: manages a TreeView control and lazy-loading of children via RegistryFacade.
@@ -69,29 +109,42 @@ public:
     // Call on UI thread.
     void PopulateHives();
 
-    // Insert a node under 'parent'. name is the displayed label; fullPath is used for lookups (e.g. "Software\\MyApp").
-    // If hasChildren==true, the implementation will add a single dummy child to show an expand glyph.
+    // Insert a node under 'parent'. name is the displayed label and the key name; its path is
+    // the parent's path plus name. Top-level nodes (parent == nullptr) stand for hiveRoot itself
+    // and do not contribute their label to paths.
+    // If hasChildren==true, the item reports I_CHILDRENCALLBACK so an expand glyph is shown until it is loaded.
     // Returns the HTREEITEM inserted (or nullptr on failure). UI thread.
-    HTREEITEM InsertNode(HTREEITEM parent, std::wstring const& name, std::wstring const& fullPath, HKEY hiveRoot, bool hasChildren);
+    HTREEITEM InsertNode(HTREEITEM parent, std::wstring const& name, HKEY hiveRoot, bool hasChildren);
 
     // Ask the tree wrapper to expand 'item' by enqueuing a background task which will
     // call RegistryFacade::ListSubKeys(hiveRoot, fullPath, ...) and post an ExpandResult.
     // This method is intended to be called on the UI thread in response to TVN_ITEMEXPANDING.
-    void RequestExpand(HTREEITEM item) const;
+    void RequestExpand(HTREEITEM item);
 
     // Called by the UI thread when the main window receives WM_APP_TREE_EXPAND_RESULT and
     // has ownership of the ExpandResult pointer (wParam). This method must run on UI thread.
-    // It inserts children under ExpandResult->parentItem and deletes the ExpandResult object.
+    // It takes ownership of the ExpandResult and inserts children under ExpandResult->parentItem
+    // in time-sliced chunks (see ContinueInsertion).
     void HandleExpandResult(ExpandResult* result);
 
+    // Insert the next slice of queued children. Called by HandleExpandResult and by the main
+    // window on WM_APP_TREE_INSERT_CONTINUE, which is posted while work remains. UI thread.
+    void ContinueInsertion();
+
     // Optional: called by UI thread when an expand operation failed; result may be nullptr.
     // You can show an error message. The worker may PostMessage WM_APP_TREE_OP_ERROR with heap 'std::wstring*' (the message).
     void HandleOperationError(std::wstring* errorText) const;
 
-    // Find the full registry path for an HTREEITEM. Returns std::nullopt if item unknown.
-    // UI thread only.
+    // Find the full registry path for an HTREEITEM by walking its node's parent chain.
+    // Returns std::nullopt if item unknown. UI thread only.
     std::optional<std::wstring>GetItemPath(HTREEITEM item) const;
 
+    // As GetItemPath, prefixed with the hive name: HKEY_CURRENT_USER\Software. UI thread only.
+    std::optional<std::wstring> GetItemFullPath(HTREEITEM item) const;
+
+    // Currently selected item, or nullptr. UI thread.
+    HTREEITEM GetSelectedItem() const noexcept;
+
     // Cleanup all items and mappings. UI thread.
     void Clear();
 
@@ -101,6 +154,60 @@ public:
     LRESULT HandleNotify(LPNMHDR pnmh);
     void UpdateColumnWidth() const;
 
+    // Copy (move == false) or move the key shown by sourceItem, with its whole subtree, to
+    // targetRoot\targetPath. Runs on the thread pool, copying sibling subtrees on several workers;
+    // progress is shown in the main window title. After a move the source's parent is reloaded.
+    // Returns false if the item is not a registry key. UI thread.
+    bool StartCopy(HTREEITEM sourceItem, HKEY targetRoot, std::wstring const& targetPath, bool move);
+
+    // Save the key shown by sourceItem to a hive file (RegSaveKeyExW) on the thread pool. UI thread.
+    bool StartExport(HTREEITEM sourceItem, std::wstring const& filePath);
+
+    // Capture the subtree of sourceItem into a snapshot file (RegistryFacade::CaptureSnapshot)
+    // on the thread pool; cancelled by CancelTreeOps. Open it with SetSnapshot. UI thread.
+    bool StartCapture(HTREEITEM sourceItem, std::wstring const& filePath);
+
+    // Called by the main window on WM_APP_TREE_OP_PROGRESS; takes ownership of progress. UI thread.
+    void HandleTreeOpProgress(TreeOpProgress* progress);
+
+    // Ask every running copy, move or export to stop; their results are ignored. UI thread.
+    void CancelTreeOps();
+    bool HasTreeOps() const noexcept;
+
+    // Search the registry on the thread pool (see core::registry::SearchRegistry). A new search
+    // replaces the running one. Hits are collected in SearchHits() as they stream in and counted
+    // in the main window title. UI thread.
+    bool StartSearch(core::registry::SearchQuery query);
+    void CancelSearch();
+    bool IsSearching() const noexcept;
+
+    // Called by the main window on WM_APP_SEARCH_RESULTS; takes ownership of results. UI thread.
+    void HandleSearchResults(SearchResults* results);
+
+    const std::vector<core::registry::SearchHit>& SearchHits() const noexcept;
+
+    // Index shared by later searches (nullptr: none). With a file path the first search loads
+    // the index from it, on its worker, and every search that ran to completion saves it
+    // there. UI thread.
+    void SetSearchIndex(std::shared_ptr<core::registry::SearchIndex> index, std::wstring filePath = {});
+
+    // Select and scroll to the key root\subKeyPath (a search hit, say). Its ancestors are
+    // expanded one level at a time as their children arrive, fetching further pages of a large
+    // key as needed; if part of the path no longer exists, the deepest existing ancestor is
+    // selected. A later call replaces an unfinished one. Live registry only. UI thread.
+    bool RevealKey(HKEY root, std::wstring const& subKeyPath);
+
+    // Browse a captured snapshot instead of the live registry: the tree is cleared and shows
+    // one top-level node for the captured key, expanded from the snapshot without touching the
+    // registry. Copy, export and search are refused while a snapshot is shown. nullptr goes
+    // back to the live hives. UI thread.
+    void SetSnapshot(std::shared_ptr<const core::registry::RegistrySnapshot> snapshot);
+    bool ShowsSnapshot() const noexcept;
+
+    // When enabled (default), the expand worker also caches the child listings one level
+    // below the expanded node, within a fixed budget. UI thread.
+    void SetPrefetchEnabled(bool enabled) noexcept;
+
 private:
     HWND m_parentWnd;   // main window (for PostMessage targets and layout)
     HWND m_hwnd;        // tree-view control handle (SysTreeView32)
@@ -108,27 +215,159 @@ private:
     IThreadManager* m_threadManager;                     // non-owning
     core::registry::RegistryFacade* m_facade;            // non-owning
 
-    // Map to keep full path and hive for each HTREEITEM. Only accessed on UI thread.
-    mutable std::unordered_map<HTREEITEM, std::wstring> m_itemPathMap;
-    mutable std::unordered_map<HTREEITEM, HKEY> m_itemHiveMap;
+    // Node table. Id 0 is reserved for "not a registry node"; ids index m_nodes and are stored
+    // in the item lParam. The node of a deleted item is released on TVN_DELETEITEM and its id
+    // reused, so the table stays as large as the tree currently shown. Names are interned, so
+    // repeated key names (Shell, open, command, ...) are stored once. Only accessed on UI thread.
+    enum NodeFlags : std::uint8_t
+    {
+        NodeLoaded = 0x01,   // children fetched; no longer answers I_CHILDRENCALLBACK with 1
+    };
 
-    // If you want to be extra defensive (in debug), you can protect map with this mutex. UI thread access is expected.
-    mutable std::mutex m_mapMutex;
+    struct TreeNode
+    {
+        const std::wstring* name = nullptr;  // interned, owned by m_names
+        HTREEITEM item = nullptr;
+        HKEY hive = nullptr;
+        std::uint32_t parent = 0;            // 0 for hive roots
+        std::uint8_t flags = 0;
+    };
 
+    std::vector<TreeNode> m_nodes;
+    std::vector<std::uint32_t> m_freeNodes;     // released ids, reused by AddNode
+    std::unordered_set<std::wstring> m_names;
 
-    int CalculateMaxItemWidth() const;
+    std::uint32_t AddNode(std::uint32_t parent, std::wstring_view name, HKEY hive);
+    // Called for every deleted item: forgets the node's pending work and frees its id.
+    void ReleaseNode(std::uint32_t id, HTREEITEM item);
+    TreeNode* NodeFromItem(HTREEITEM item);
+    const TreeNode* NodeFromItem(HTREEITEM item) const;
+    std::wstring BuildPath(std::uint32_t id) const;
 
-    // Internal helpers (implementation private)
-    void
-    AddDummyChild(HTREEITEM parent);
+    // Children fetched per background request.
+    static constexpr size_t kExpandPageSize = 256;
+
+    // Prefetch limits: skip children with more subkeys than this, and query at most
+    // kPrefetchBudget grandchildren per expand.
+    static constexpr size_t kPrefetchMaxChildSubKeys = 256;
+    static constexpr size_t kPrefetchBudget = 1024;
+    bool m_prefetchEnabled = true;
+
+    // Snapshot being browsed; nullptr for the live registry. Workers hold their own reference.
+    std::shared_ptr<const core::registry::RegistrySnapshot> m_snapshot;
+
+    // Page requests in flight, by node id. A repeated request joins the pending one; collapse
+    // and Clear() request a stop and forget it, so late results no longer match. UI thread only.
+    struct PendingExpand
+    {
+        std::stop_source stop;
+        std::uint64_t requestId = 0;
+    };
 
-    bool
-    HasDummyChild(HTREEITEM parent) const;
+    std::unordered_map<std::uint32_t, PendingExpand> m_pendingExpand;
+    std::uint64_t m_lastRequestId = 0;
 
-    void
-    RemoveDummyChild(HTREEITEM parent) const;
+    // Cancels the requests of nodeId and of every node below it.
+    void CancelExpands(std::uint32_t nodeId);
+    void CancelAllExpands();
+    bool IsInSubtree(std::uint32_t id, std::uint32_t ancestor) const;
 
-    // Insert item (UI thread) low-level helper that also registers item path/hive in maps.
+    // Next child index to fetch for parents that still show a "load more" placeholder. UI thread only.
+    std::unordered_map<HTREEITEM, size_t> m_nextPageOffset;
+
+    // Enqueue a worker that lists one page of item's children starting at offset. Does nothing
+    // while a page of the node is still fetched or inserted.
+    void RequestPage(HTREEITEM item, size_t offset);
+
+    // True while a fetched page of nodeId waits in (or is being inserted from) m_insertQueue.
+    bool IsInserting(std::uint32_t nodeId) const;
+
+    void AddLoadMoreChild(HTREEITEM parent);
+    void RemoveLoadMoreChild(HTREEITEM parent) const;
+
+    // Subtree operations in flight, by operation id. UI thread only.
+    struct TreeOp
+    {
+        std::stop_source stop;
+        std::uint32_t reloadNode = 0;   // node whose children are reloaded when the op ends; 0 none
+        const wchar_t* verb = L"";      // for the title bar
+    };
+
+    // Walkers per copy (the task itself included); they run as Background work.
+    static constexpr size_t kTreeOpConcurrency = 4;
+
+    std::unordered_map<std::uint64_t, TreeOp> m_treeOps;
+    std::uint64_t m_lastTreeOpId = 0;
+
+    std::uint64_t BeginTreeOp(std::uint32_t reloadNode, const wchar_t* verb);
+    void EndTreeOp(std::uint64_t operationId);
+
+    // Drops the loaded children of a node and fetches them again if it is expanded.
+    void ReloadChildren(std::uint32_t nodeId);
+
+    // Main window title: the title it had at Initialize, followed by the status of running
+    // subtree operations and of the last search, each kept on its own. UI thread only.
+    std::wstring m_baseTitle;
+    std::wstring m_treeOpStatus;
+    std::wstring m_searchStatus;
+
+    void UpdateTitle() const;
+
+    // Search state. Only results carrying m_searchId are kept. UI thread only.
+    static constexpr size_t kSearchConcurrency = 4;
+
+    std::stop_source m_searchStop;
+    std::uint64_t m_searchId = 0;
+    std::wstring m_searchPattern;
+    std::vector<core::registry::SearchHit> m_searchHits;
+    bool m_searchRunning = false;
+    std::shared_ptr<core::registry::SearchIndex> m_searchIndex;
+    std::wstring m_searchIndexPath;
+    bool m_searchIndexLoaded = false;   // a search has been started with the current index
+
+    void UpdateSearchTitle(bool finished);
+
+    // RevealKey in progress: the deepest node reached and the path components still to find.
+    // Continued whenever inserted children may contain the next component. UI thread only.
+    struct RevealState
+    {
+        std::uint32_t nodeId = 0;
+        std::vector<std::wstring> components;
+        size_t next = 0;
+    };
+
+    std::optional<RevealState> m_reveal;
+
+    void ContinueReveal();
+
+    // Incremental insertion: results are queued and inserted a chunk at a time until
+    // the slice budget is used up, with redraw disabled for the slice.
+    struct InsertBatch
+    {
+        std::unique_ptr<ExpandResult> result;
+        size_t next = 0; // index of the next child to insert
+    };
+
+    static constexpr size_t kInsertChunkSize = 64;
+    static constexpr std::chrono::milliseconds kInsertSliceBudget{ 8 };
+
+    std::deque<InsertBatch> m_insertQueue;          // UI thread only
+    bool m_insertContinuePosted = false;
+
+    // Widest label seen so far, measured at insertion; avoids re-measuring every item.
+    int m_maxLabelWidth = 0;
+    mutable bool m_widthUpdatePosted = false;
+
+    void InsertChildren(ExpandResult const& result, size_t first, size_t last);
+    void MeasureLabels(std::vector<std::wstring> const& labels, size_t first, size_t last);
+    void ScheduleColumnWidthUpdate() const;
+    void SetItemHasChildren(HTREEITEM item, bool hasChildren) const;
+    void HandleGetDispInfo(LPNMTVDISPINFOW info) const;
+
+    int CalculateMaxItemWidth() const;
+
+    // Internal helpers (implementation private)
+    // Insert item (UI thread) low-level helper that also links the node to its HTREEITEM.
     HTREEITEM
-    InsertItemInternal(HTREEITEM parent, TVINSERTSTRUCTW const& tvins, std::wstring const& fullPath, HKEY hiveRoot) const;
+    InsertItemInternal(TVINSERTSTRUCTW const& tvins, std::uint32_t nodeId);
 };
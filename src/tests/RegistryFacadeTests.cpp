@@ -0,0 +1,119 @@
+// RegistryFacadeTests.cpp
+// Checks of RegistryFacade against a scratch key, HKCU\Software\SP_COURSE_WORK\core_tests-<pid>,
+// which is deleted again (with the parent, if that is left empty). Exits non-zero on failure.
+#include <windows.h>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+#include "registry/RegistryFacade.h"
+
+using namespace core::registry;
+
+namespace {
+
+    int g_failures = 0;
+
+    void Check(const bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct ScratchKey
+    {
+        std::wstring path = L"Software\\SP_COURSE_WORK\\core_tests-" + std::to_wstring(GetCurrentProcessId());
+
+        ~ScratchKey()
+        {
+            RegDeleteTreeW(HKEY_CURRENT_USER, path.c_str());
+            RegDeleteKeyExW(HKEY_CURRENT_USER, path.c_str(), 0, 0);
+            // Fails while the parent has other children, which is what we want.
+            RegDeleteKeyExW(HKEY_CURRENT_USER, L"Software\\SP_COURSE_WORK", 0, 0);
+        }
+    };
+
+    std::vector<unsigned char> RawString(std::wstring const& text)
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(text.c_str());
+        return {bytes, bytes + (text.size() + 1) * sizeof(wchar_t)};
+    }
+
+    std::wstring Expand(std::wstring const& text)
+    {
+        std::wstring expanded(ExpandEnvironmentStringsW(text.c_str(), nullptr, 0), L'\0');
+        expanded.resize(ExpandEnvironmentStringsW(text.c_str(), expanded.data(), static_cast<DWORD>(expanded.size())) - 1);
+        return expanded;
+    }
+
+    // A REG_EXPAND_SZ value keeps its type and raw data in the cache whichever call fills it,
+    // and GetStringValue returns it expanded from the registry and from the cache alike.
+    void ExpandStringThroughBothPaths(std::wstring const& keyPath)
+    {
+        const std::wstring name = L"Expand";
+        const std::wstring raw = L"%SystemRoot%\\core_tests";
+        const std::wstring expanded = Expand(raw);
+        const std::vector<std::wstring> names{name};
+
+        {
+            const RegistryKey key = RegistryKey::Create(HKEY_CURRENT_USER, keyPath);
+            SetStringValue(key, name, raw, REG_EXPAND_SZ);
+        }
+
+        // GetStringValue fills the cache, ReadValues reads it back.
+        {
+            RegistryFacade facade;
+            Check(facade.GetStringValue(HKEY_CURRENT_USER, keyPath, name, KEY_READ, {}) == expanded,
+                  "GetStringValue (registry) expands REG_EXPAND_SZ");
+
+            const std::vector<ValueReadResult> values = facade.ReadValues(HKEY_CURRENT_USER, keyPath, names);
+            Check(facade.GetStats().cacheHits == 1, "ReadValues is answered from the GetStringValue entry");
+            Check(values.size() == 1 && values[0].Found(), "ReadValues finds the value");
+            Check(!values.empty() && values[0].type == REG_EXPAND_SZ, "cached type is REG_EXPAND_SZ");
+            Check(!values.empty() && values[0].data == RawString(raw), "cached data is the unexpanded string");
+        }
+
+        // ReadValues fills the cache, GetStringValue reads it back.
+        {
+            RegistryFacade facade;
+            const std::vector<ValueReadResult> values = facade.ReadValues(HKEY_CURRENT_USER, keyPath, names);
+            Check(!values.empty() && values[0].type == REG_EXPAND_SZ, "ReadValues (registry) reports REG_EXPAND_SZ");
+
+            Check(facade.GetStringValue(HKEY_CURRENT_USER, keyPath, name, KEY_READ, {}) == expanded,
+                  "GetStringValue (cache) expands REG_EXPAND_SZ");
+            Check(facade.GetStats().cacheHits == 1, "GetStringValue is answered from the ReadValues entry");
+        }
+    }
+
+} // anonymous namespace
+
+int wmain()
+{
+    const ScratchKey scratch;
+    try
+    {
+        ExpandStringThroughBothPaths(scratch.path);
+    }
+    catch (const std::exception& ex)
+    {
+        std::fprintf(stderr, "FAILED: unexpected exception: %s\n", ex.what());
+        ++g_failures;
+    }
+
+    if (g_failures == 0)
+    {
+        std::printf("RegistryFacadeTests: all checks passed\n");
+    }
+    return g_failures == 0 ? 0 : 1;
+}
+
+#if defined(__MINGW32__)
+// MinGW links main() unless -municode is given.
+extern "C" int main()
+{
+    return wmain();
+}
+#endif
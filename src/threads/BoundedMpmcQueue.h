@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ *  BoundedMpmcQueue
+ *
+ *  Fixed-capacity multi-producer / multi-consumer FIFO (Vyukov's bounded queue).
+ *  Each slot carries a sequence number that tells producers and consumers whether it
+ *  is free or filled for the current lap, so push and pop are one CAS on the shared
+ *  index plus plain loads and stores on the slot. No locks, no allocation after
+ *  construction.
+ *
+ *  tryPush returns false when full and tryPop returns false when empty; pop can also
+ *  fail while the producer of the oldest slot is still writing it.
+ *
+ *  Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class BoundedMpmcQueue
+{
+public:
+    explicit BoundedMpmcQueue(std::size_t capacity)
+    {
+        std::size_t rounded = 2;
+        while (rounded < capacity)
+        {
+            rounded <<= 1;
+        }
+        m_mask = rounded - 1;
+        m_slots = std::make_unique<Slot[]>(rounded);
+        for (std::size_t i = 0; i < rounded; ++i)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedMpmcQueue()
+    {
+        T discarded;
+        while (tryPop(discarded))
+        {
+        }
+    }
+
+    BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+    BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+
+    bool tryPush(T&& value)
+    {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &m_slots[pos & m_mask];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        ::new (static_cast<void*>(slot->storage)) T(std::move(value));
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out)
+    {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &m_slots[pos & m_mask];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        T* item = std::launder(reinterpret_cast<T*>(slot->storage));
+        out = std::move(*item);
+        item->~T();
+        slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{ 0 };
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask = 0;
+
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{ 0 };
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{ 0 };
+};
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "InlineTask.h"
+#include "TaskFuture.h"
+#include "metrics/LatencyHistogram.h"
+
 #include <functional>
-#include <future>
 #include <chrono>
 #include <cstddef>
+#include <tuple>
 #include <utility>
 #include <type_traits>
 #include <memory>
@@ -14,11 +18,14 @@
  *  Minimal abstract interface for a thread manager / pool.
  *
  *  Concrete implementations must implement:
- *    - enqueue: push a void() task into the queue / runtime.
- *    - scheduleRecurringGeneric: schedule a void() task to run every interval milliseconds and return an id.
+ *    - enqueue: push a void() task with a TaskPriority into the queue / runtime.
+ *    - scheduleRecurringGeneric: schedule a void() task to run every interval milliseconds
+ *      (fixed-rate or fixed-delay) and return an id.
  *    - cancelRecurring: cancel an active recurring task by id.
  *    - shutdown: stop the pool.
  *
+ *  stats() is optional; the default reports nothing.
+ *
  *  The templated helpers `submit` and the templated `scheduleRecurring`
  *  are implemented in terms of the non-template virtual functions.
  *
@@ -27,38 +34,101 @@
 class IThreadManager
 {
 public:
-    using Task = std::function<void()>;
+    // Move-only, small-buffer callable; lambdas capturing a few pointers do not allocate.
+    using Task = InlineTask;
     using RecurringId = std::size_t;
 
+    /**
+     * FixedRate  - runs are due every interval measured from the previous due time; if the
+     *              runtime falls behind by a whole interval it skips ahead instead of bursting.
+     * FixedDelay - the next run is due interval after the previous run finished, so runs
+     *              never overlap and a slow task stretches the period.
+     */
+    enum class RecurringMode
+    {
+        FixedRate,
+        FixedDelay
+    };
+
+    /**
+     * Interactive - work the user is waiting on (expanding the clicked node).
+     * Normal      - default.
+     * Background  - speculative or housekeeping work (prefetch, cache cleanup).
+     *               Implementations may limit how many background tasks run at once.
+     * Lower classes are aged so they are not starved by a stream of higher-priority work.
+     */
+    enum class TaskPriority
+    {
+        Interactive = 0,
+        Normal = 1,
+        Background = 2
+    };
+
+    /**
+     * Point-in-time pool metrics.
+     *  - queuedTasks: tasks waiting for a worker.
+     *  - waitTime: time from enqueue() until a worker started the task, for the tasks the
+     *    implementation timestamps (see the implementation).
+     */
+    struct Stats
+    {
+        std::size_t queuedTasks = 0;
+        core::metrics::LatencySummary waitTime;
+    };
+
     virtual ~IThreadManager() = default;
 
     /**
      * Enqueue a void() task to be executed by the thread manager.
      * This is the only pure-virtual primitive required from implementors.
+     * Implementations should add `using IThreadManager::enqueue;` to keep the overload below.
      */
-    virtual void enqueue(Task task) = 0;
+    virtual void enqueue(Task task, TaskPriority priority) = 0;
+
+    void enqueue(Task task)
+    {
+        enqueue(std::move(task), TaskPriority::Normal);
+    }
 
     /**
-     * Templated submit: wraps callable into a packaged_task, enqueues it and
-     * returns a std::future<R>. Implementations must provide enqueue().
+     * Templated submit: moves the callable and its arguments into a Task, enqueues it and
+     * returns a TaskFuture<R>. Implementations must provide enqueue().
+     * The future's shared state comes from a per-thread pool, so no std::packaged_task or
+     * std::bind is involved. If the pool drops the task unrun, get() throws broken_promise.
      *
      * Usage:
      *   auto fut = mgr->submit([](){ return 42; });
      *   int v = fut.get();
      */
-    template <typename F, typename... Args>
+    template <typename F, typename... Args,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TaskPriority>>>
     auto submit(F&& f, Args&&... args)
     {
-        using Result = std::invoke_result_t<F, Args...>;
-        using Packaged = std::packaged_task<Result()>;
+        return submit(TaskPriority::Normal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Same as above with an explicit priority:
+     *   auto fut = mgr->submit(IThreadManager::TaskPriority::Background, [](){ ... });
+     */
+    template <typename F, typename... Args>
+    auto submit(const TaskPriority priority, F&& f, Args&&... args)
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>&, std::decay_t<Args>&...>;
 
-        Packaged task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-        std::future<Result> fut = task.get_future();
+        detail::FutureState<Result>* state = detail::FutureState<Result>::Acquire();
+        TaskFuture<Result> fut(state);
 
-        enqueue([t = std::move(task)]() mutable
+        enqueue([promise = detail::PromiseRef<Result>(state),
+                 fn = std::forward<F>(f),
+                 bound = std::make_tuple(std::forward<Args>(args)...)]() mutable
         {
-            t();
-        });
+            auto call = [&fn, &bound]() -> Result
+            {
+                return std::apply(fn, bound);
+            };
+            promise.Run(call);
+        }, priority);
 
         return fut;
     }
@@ -66,18 +136,38 @@ public:
     /**
      * Non-template primitive for recurring tasks: concrete classes implement this.
      * The pool returns an id which can be later passed to cancelRecurring(id).
+     * The first run is due one interval after the call.
      */
-    virtual RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task) = 0;
+    virtual RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task, RecurringMode mode) = 0;
 
     /**
-     * Convenience templated wrapper to schedule arbitrary callables.
+     * Fixed-rate overload kept for existing callers.
+     * Implementations overriding the primitive should add `using IThreadManager::scheduleRecurringGeneric;`.
+     */
+    RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task)
+    {
+        return scheduleRecurringGeneric(interval, std::move(task), RecurringMode::FixedRate);
+    }
+
+    /**
+     * Convenience templated wrapper to schedule arbitrary callables (fixed-rate).
      */
     template <typename F, typename... Args>
     RecurringId
     scheduleRecurring(std::chrono::milliseconds interval, F&& f, Args&&... args)
     {
-        Task task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        return scheduleRecurringGeneric(interval, std::move(task));
+        return scheduleRecurringGeneric(interval, BindRecurring(std::forward<F>(f), std::forward<Args>(args)...),
+                                        RecurringMode::FixedRate);
+    }
+
+    /**
+     * Same as above with an explicit RecurringMode.
+     */
+    template <typename F, typename... Args>
+    RecurringId
+    scheduleRecurring(RecurringMode mode, std::chrono::milliseconds interval, F&& f, Args&&... args)
+    {
+        return scheduleRecurringGeneric(interval, BindRecurring(std::forward<F>(f), std::forward<Args>(args)...), mode);
     }
 
     /**
@@ -91,4 +181,20 @@ public:
      * If graceful == false stop immediately (may abandon queued tasks).
      */
     virtual void shutdown(bool graceful) = 0;
+
+    [[nodiscard]] virtual Stats stats() const
+    {
+        return {};
+    }
+
+private:
+    // Recurring tasks are invoked repeatedly, so arguments are passed as lvalues each time.
+    template <typename F, typename... Args>
+    static Task BindRecurring(F&& f, Args&&... args)
+    {
+        return [fn = std::forward<F>(f), bound = std::make_tuple(std::forward<Args>(args)...)]() mutable
+        {
+            std::apply(fn, bound);
+        };
+    }
 };
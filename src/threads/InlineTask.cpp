@@ -0,0 +1,102 @@
+#include "InlineTask.h"
+
+#include <array>
+
+namespace
+{
+    constexpr std::array<std::size_t, 3> kBlockSizes{ 64, 128, 256 };
+    constexpr std::size_t kMaxCachedBlocks = 256; // per size class and thread
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct BlockCache
+    {
+        std::array<FreeBlock*, kBlockSizes.size()> heads{};
+        std::array<std::size_t, kBlockSizes.size()> counts{};
+
+        BlockCache() = default;
+        BlockCache(const BlockCache&) = delete;
+        BlockCache& operator=(const BlockCache&) = delete;
+
+        ~BlockCache()
+        {
+            for (FreeBlock* head : heads)
+            {
+                while (head != nullptr)
+                {
+                    FreeBlock* next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    BlockCache& LocalCache()
+    {
+        thread_local BlockCache cache;
+        return cache;
+    }
+
+    // Index of the smallest class that fits, or kBlockSizes.size() when none does.
+    std::size_t SizeClass(const std::size_t size) noexcept
+    {
+        for (std::size_t i = 0; i < kBlockSizes.size(); ++i)
+        {
+            if (size <= kBlockSizes[i])
+            {
+                return i;
+            }
+        }
+        return kBlockSizes.size();
+    }
+}
+
+void* TaskAllocate(const std::size_t size)
+{
+    const std::size_t cls = SizeClass(size);
+    if (cls == kBlockSizes.size())
+    {
+        return ::operator new(size);
+    }
+
+    BlockCache& cache = LocalCache();
+    if (FreeBlock* block = cache.heads[cls])
+    {
+        cache.heads[cls] = block->next;
+        --cache.counts[cls];
+        return block;
+    }
+
+    return ::operator new(kBlockSizes[cls]);
+}
+
+void TaskDeallocate(void* block, const std::size_t size) noexcept
+{
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    const std::size_t cls = SizeClass(size);
+    if (cls == kBlockSizes.size())
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    BlockCache& cache = LocalCache();
+    if (cache.counts[cls] >= kMaxCachedBlocks)
+    {
+        ::operator delete(block);
+        return;
+    }
+
+    auto* node = static_cast<FreeBlock*>(block);
+    node->next = cache.heads[cls];
+    cache.heads[cls] = node;
+    ++cache.counts[cls];
+}
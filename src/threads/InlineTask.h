@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ *  Task block allocator
+ *
+ *  Thread-local free lists for small fixed size classes (64, 128 and 256 bytes). A block
+ *  freed on a worker goes to that worker's list and is reused by the next task the worker
+ *  spawns, so recursive fan-out stops hitting the global heap after warm-up. Larger
+ *  requests and lists that are already full fall through to operator new/delete.
+ *
+ *  TaskDeallocate must be given the same size that was passed to TaskAllocate.
+ */
+void* TaskAllocate(std::size_t size);
+void TaskDeallocate(void* block, std::size_t size) noexcept;
+
+/**
+ *  InlineTask
+ *
+ *  Move-only replacement for std::function<void()> used as IThreadManager::Task.
+ *
+ *  - Callables up to kInlineSize bytes that are nothrow-movable are stored in place,
+ *    so a typical lambda (a few pointers and ids) costs no allocation.
+ *  - Larger callables are stored in a block from TaskAllocate().
+ *  - Move-only callables (holding unique_ptr, promises, ...) are accepted.
+ *  - Invocable any number of times; recurring timers rely on that.
+ */
+class InlineTask
+{
+public:
+    static constexpr std::size_t kInlineSize = 48;
+
+    InlineTask() noexcept = default;
+
+    InlineTask(std::nullptr_t) noexcept
+    {}
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, InlineTask> && std::is_invocable_v<Fn&>>>
+    InlineTask(F&& f)
+    {
+        if constexpr (std::is_same_v<Fn, std::function<void()>>)
+        {
+            if (!f)
+            {
+                return;
+            }
+        }
+
+        if constexpr (kFitsInline<Fn>)
+        {
+            ::new (static_cast<void*>(m_buffer)) Fn(std::forward<F>(f));
+            m_ops = &kInlineOps<Fn>;
+        }
+        else
+        {
+            void* block = TaskAllocate(sizeof(Fn));
+            try
+            {
+                ::new (block) Fn(std::forward<F>(f));
+            }
+            catch (...)
+            {
+                TaskDeallocate(block, sizeof(Fn));
+                throw;
+            }
+            *reinterpret_cast<void**>(m_buffer) = block;
+            m_ops = &kHeapOps<Fn>;
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineTask& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        if (m_ops == nullptr)
+        {
+            throw std::bad_function_call();
+        }
+        m_ops->invoke(m_buffer);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_ops != nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (m_ops != nullptr)
+        {
+            m_ops->destroy(m_buffer);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept; // leaves src destroyed
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr bool kFitsInline =
+        sizeof(Fn) <= kInlineSize &&
+        alignof(Fn) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<Fn>;
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps{
+        [](void* storage) { (*static_cast<Fn*>(storage))(); },
+        [](void* dst, void* src) noexcept
+        {
+            Fn* from = static_cast<Fn*>(src);
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); }
+    };
+
+    // Storage holds a pointer to the block; moving just transfers the pointer.
+    template <typename Fn>
+    static constexpr Ops kHeapOps{
+        [](void* storage) { (**static_cast<Fn**>(storage))(); },
+        [](void* dst, void* src) noexcept
+        {
+            *static_cast<void**>(dst) = *static_cast<void**>(src);
+        },
+        [](void* storage) noexcept
+        {
+            Fn* fn = *static_cast<Fn**>(storage);
+            fn->~Fn();
+            TaskDeallocate(fn, sizeof(Fn));
+        }
+    };
+
+    void moveFrom(InlineTask& other) noexcept
+    {
+        if (other.m_ops != nullptr)
+        {
+            other.m_ops->move(m_buffer, other.m_buffer);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_buffer[kInlineSize];
+    const Ops* m_ops = nullptr;
+};
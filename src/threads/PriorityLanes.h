@@ -0,0 +1,150 @@
+#pragma once
+
+#include "IThreadManager.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <utility>
+
+/**
+ *  PriorityLanes
+ *
+ *  Three FIFO lanes (Interactive, Normal, Background) with aging. Not thread-safe;
+ *  the owning pool guards it with its queue mutex.
+ *
+ *  pop() serves Interactive first. A Normal entry that waited longer than
+ *  kNormalAgeLimit, or a Background entry older than kBackgroundAgeLimit, is served
+ *  ahead of it, so a steady stream of interactive work cannot starve the other lanes.
+ *  The caller decides whether Background may be served at all (see StdThreadPool's
+ *  background concurrency limit).
+ */
+template <typename T>
+class PriorityLanes
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TaskPriority = IThreadManager::TaskPriority;
+
+    static constexpr std::chrono::milliseconds kNormalAgeLimit{ 100 };
+    static constexpr std::chrono::milliseconds kBackgroundAgeLimit{ 1000 };
+
+    void push(T item, const TaskPriority priority, const Clock::time_point now)
+    {
+        m_lanes[LaneIndex(priority)].push_back(Entry{ std::move(item), now });
+    }
+
+    /**
+     * Takes the next entry by the rules above. With urgentOnly, only Interactive entries
+     * and entries past their age limit are taken. Returns false if nothing qualifies.
+     * queuedAt, if given, receives the time the entry was pushed.
+     */
+    bool pop(T& out, TaskPriority& priority, const Clock::time_point now,
+             const bool allowBackground, const bool urgentOnly = false,
+             Clock::time_point* queuedAt = nullptr)
+    {
+        const std::size_t background = LaneIndex(TaskPriority::Background);
+        const std::size_t normal = LaneIndex(TaskPriority::Normal);
+        const std::size_t interactive = LaneIndex(TaskPriority::Interactive);
+
+        if (allowBackground && overdue(background, now, kBackgroundAgeLimit))
+        {
+            return take(background, out, priority, queuedAt);
+        }
+        if (overdue(normal, now, kNormalAgeLimit))
+        {
+            return take(normal, out, priority, queuedAt);
+        }
+        if (!m_lanes[interactive].empty())
+        {
+            return take(interactive, out, priority, queuedAt);
+        }
+        if (urgentOnly)
+        {
+            return false;
+        }
+        if (!m_lanes[normal].empty())
+        {
+            return take(normal, out, priority, queuedAt);
+        }
+        if (allowBackground && !m_lanes[background].empty())
+        {
+            return take(background, out, priority, queuedAt);
+        }
+        return false;
+    }
+
+    // Ignores priorities and limits; used to drain on shutdown.
+    bool popAny(T& out)
+    {
+        TaskPriority priority;
+        for (std::size_t lane = 0; lane < kLaneCount; ++lane)
+        {
+            if (!m_lanes[lane].empty())
+            {
+                return take(lane, out, priority, nullptr);
+            }
+        }
+        return false;
+    }
+
+    [[nodiscard]] bool hasRunnable(const bool allowBackground) const noexcept
+    {
+        return !m_lanes[LaneIndex(TaskPriority::Interactive)].empty() ||
+               !m_lanes[LaneIndex(TaskPriority::Normal)].empty() ||
+               (allowBackground && !m_lanes[LaneIndex(TaskPriority::Background)].empty());
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_lanes[0].size() + m_lanes[1].size() + m_lanes[2].size();
+    }
+
+    void clear() noexcept
+    {
+        for (std::deque<Entry>& lane : m_lanes)
+        {
+            lane.clear();
+        }
+    }
+
+private:
+    static constexpr std::size_t kLaneCount = 3;
+
+    struct Entry
+    {
+        T item;
+        Clock::time_point queuedAt;
+    };
+
+    static constexpr std::size_t LaneIndex(const TaskPriority priority) noexcept
+    {
+        return static_cast<std::size_t>(priority);
+    }
+
+    [[nodiscard]] bool overdue(const std::size_t lane, const Clock::time_point now,
+                               const std::chrono::milliseconds limit) const noexcept
+    {
+        return !m_lanes[lane].empty() && now - m_lanes[lane].front().queuedAt > limit;
+    }
+
+    bool take(const std::size_t lane, T& out, TaskPriority& priority, Clock::time_point* queuedAt)
+    {
+        if (queuedAt != nullptr)
+        {
+            *queuedAt = m_lanes[lane].front().queuedAt;
+        }
+        out = std::move(m_lanes[lane].front().item);
+        m_lanes[lane].pop_front();
+        priority = static_cast<TaskPriority>(lane);
+        return true;
+    }
+
+    std::array<std::deque<Entry>, kLaneCount> m_lanes;
+};
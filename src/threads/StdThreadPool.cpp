@@ -1,11 +1,41 @@
 #include "StdThreadPool.h"
 
 #include <chrono>
-#include <functional>
+#include <new>
 #include <stdexcept>
 
-StdThreadPool::StdThreadPool(const std::size_t numThreads)
+namespace
+{
+    // Set on WorkStealing worker threads so enqueue() can push to the caller's own deque.
+    thread_local const StdThreadPool* t_currentPool = nullptr;
+    thread_local std::size_t t_workerIndex = 0;
+
+    // WorkStealing deques hold Task*; nodes come from the per-thread task block cache.
+    struct TaskNodeDeleter
+    {
+        void operator()(IThreadManager::Task* task) const noexcept
+        {
+            task->~InlineTask();
+            TaskDeallocate(task, sizeof(IThreadManager::Task));
+        }
+    };
+
+    using TaskNode = std::unique_ptr<IThreadManager::Task, TaskNodeDeleter>;
+
+    TaskNode MakeTaskNode(IThreadManager::Task&& task)
+    {
+        void* block = TaskAllocate(sizeof(IThreadManager::Task));
+        return TaskNode(::new (block) IThreadManager::Task(std::move(task)));
+    }
+}
+
+StdThreadPool::StdThreadPool(const std::size_t numThreads, const SchedulingMode mode)
     : m_numThreads(numThreads)
+    , m_mode(mode)
+    , m_timerQueue([this](Task task)
+    {
+        this->enqueue(std::move(task));
+    })
 {
     if (m_numThreads == 0)
     {
@@ -16,6 +46,26 @@ StdThreadPool::StdThreadPool(const std::size_t numThreads)
             m_numThreads = hc;
     }
 
+    m_backgroundLimit = m_numThreads > 1 ? m_numThreads - 1 : 1;
+
+    if (m_mode == SchedulingMode::WorkStealing)
+    {
+        m_localQueues.reserve(m_numThreads);
+        for (std::size_t i = 0; i < m_numThreads; ++i)
+        {
+            m_localQueues.push_back(std::make_unique<WorkStealingDeque<Task>>());
+        }
+
+        for (std::size_t i = 0; i < m_numThreads; ++i)
+        {
+            m_workers.emplace_back([this, i](const std::stop_token &st) -> void
+            {
+                this->stealingWorkerLoop(st, i);
+            });
+        }
+        return;
+    }
+
     for (std::size_t i = 0; i < m_numThreads; ++i)
     {
         m_workers.emplace_back([this](const std::stop_token &st) -> void
@@ -33,10 +83,54 @@ StdThreadPool::~StdThreadPool()
     }
     catch (...)
     {}
+
+    discardQueuedTasks();
 }
 
-void StdThreadPool::enqueue(Task task)
+void StdThreadPool::enqueue(Task task, const TaskPriority priority)
 {
+    if (m_mode == SchedulingMode::WorkStealing)
+    {
+        // Counted before the push: a worker may take the task and decrement before we
+        // continue; one that sees the count but no task yet yields and retries.
+        std::atomic<std::size_t>& pending =
+            priority == TaskPriority::Background ? m_pendingBackground : m_pendingTasks;
+        pending.fetch_add(1);
+
+        try
+        {
+            if (t_currentPool == this && priority == TaskPriority::Normal)
+            {
+                // Spawned from one of our workers. Accepted during a graceful drain so that
+                // recursive operations already running can finish; that worker drains it.
+                if (m_discard.load())
+                {
+                    throw std::runtime_error("enqueue on stopped thread pool");
+                }
+                m_localQueues[t_workerIndex]->push(MakeTaskNode(std::move(task)).release());
+            }
+            else
+            {
+                TaskNode owned = MakeTaskNode(std::move(task));
+                std::lock_guard lock(m_injectMutex);
+                if (m_stopping.load() && (t_currentPool != this || m_discard.load()))
+                {
+                    throw std::runtime_error("enqueue on stopped thread pool");
+                }
+                m_injected.push(owned.release(), priority, std::chrono::steady_clock::now());
+                m_injectedCount.fetch_add(1);
+            }
+        }
+        catch (...)
+        {
+            pending.fetch_sub(1);
+            throw;
+        }
+
+        wakeIdleWorker();
+        return;
+    }
+
     {
         std::lock_guard lock(m_mutex);
         if (m_stopping.load())
@@ -44,40 +138,73 @@ void StdThreadPool::enqueue(Task task)
             throw std::runtime_error("enqueue on stopped thread pool");
         }
 
-        m_tasks.emplace_back(std::move(task));
+        m_tasks.push(std::move(task), priority, std::chrono::steady_clock::now());
     }
 
     m_cv.notify_one();
 }
 
+bool StdThreadPool::backgroundAllowed() const noexcept
+{
+    return m_discard.load() || m_runningBackground.load() < m_backgroundLimit;
+}
+
+// Frees a background slot and hands it to a parked worker if background work is waiting.
+void StdThreadPool::finishBackground()
+{
+    if (m_mode == SchedulingMode::WorkStealing)
+    {
+        m_runningBackground.fetch_sub(1);
+        if (m_pendingBackground.load() != 0)
+        {
+            wakeIdleWorker();
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_runningBackground.fetch_sub(1);
+    }
+    m_cv.notify_one();
+}
+
 void StdThreadPool::workerLoop(std::stop_token stoken)
 {
-    while (!stoken.stop_requested())
+    // Exits only once stopping and the queue is empty, so a graceful shutdown drains it.
+    while (true)
     {
         Task task;
+        TaskPriority priority = TaskPriority::Normal;
+        std::chrono::steady_clock::time_point now;
+        std::chrono::steady_clock::time_point queuedAt;
 
         {
             std::unique_lock lock(m_mutex);
-            m_cv.wait(lock, [this, &stoken] -> bool
+            m_cv.wait(lock, [this, &stoken]() -> bool
             {
-                return m_stopping.load() || !m_tasks.empty() || stoken.stop_requested();
+                return m_tasks.hasRunnable(backgroundAllowed()) ||
+                       ((m_stopping.load() || stoken.stop_requested()) && m_tasks.empty());
             });
 
-            if (m_stopping.load() && m_tasks.empty())
+            if (m_tasks.empty())
             {
                 return;
             }
 
-            if (!m_tasks.empty())
+            const bool allowBackground = backgroundAllowed();
+            now = std::chrono::steady_clock::now();
+            if (!m_tasks.pop(task, priority, now, allowBackground, false, &queuedAt))
             {
-                task = std::move(m_tasks.front());
-                m_tasks.pop_front();
+                continue;
             }
-            else
+
+            if (priority == TaskPriority::Background)
             {
-                continue;
+                m_runningBackground.fetch_add(1);
             }
         }
+        m_waitTime.Record(now - queuedAt);
 
         try
         {
@@ -86,90 +213,239 @@ void StdThreadPool::workerLoop(std::stop_token stoken)
         catch (...)
         {
         }
+        task = nullptr;
+
+        if (priority == TaskPriority::Background)
+        {
+            finishBackground();
+        }
     }
 }
 
-IThreadManager::RecurringId
-StdThreadPool::scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task)
+/**
+ * stealingWorkerLoop
+ *
+ * Urgent injected work first (Interactive or aged), then the own deque (newest task,
+ * still warm in cache), then the remaining injected work, then the other workers' deques.
+ * A worker parks on m_cv only after incrementing m_idleWorkers and re-checking the pending
+ * counters under m_mutex; producers increment a counter before reading m_idleWorkers,
+ * so a wake-up cannot be lost.
+ */
+void StdThreadPool::stealingWorkerLoop(std::stop_token stoken, const std::size_t index)
 {
-    RecurringId id = m_nextRecurringId.fetch_add(1);
-
-    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    t_currentPool = this;
+    t_workerIndex = index;
 
-    std::jthread timerThread([this, interval, task = std::move(task), cancelled](const std::stop_token &st)
+    while (true)
     {
-        while (!st.stop_requested() && !cancelled->load())
+        TaskPriority priority = TaskPriority::Normal;
+        if (Task* task = takeTask(index, priority))
         {
-            std::this_thread::sleep_for(interval);
-
-            if (st.stop_requested() || cancelled->load())
+            runTask(task);
+            if (priority == TaskPriority::Background)
             {
-                break;
+                finishBackground();
             }
+            continue;
+        }
 
-            try
-            {
-                this->enqueue(task);
-            }
-            catch (...)
-            {
-                break;
-            }
+        if (hasRunnableWork())
+        {
+            // Another worker is between taking a task and decrementing the counter.
+            std::this_thread::yield();
+            continue;
         }
-    });
 
-    TimerRecord rec;
-    rec.cancelled = cancelled;
-    rec.thread = std::move(timerThread);
+        std::unique_lock lock(m_mutex);
+        m_idleWorkers.fetch_add(1);
+        m_cv.wait(lock, [this, &stoken]() -> bool
+        {
+            return hasRunnableWork() || m_stopping.load() || stoken.stop_requested();
+        });
+        m_idleWorkers.fetch_sub(1);
 
-    {
-        std::lock_guard lock(m_mutex);
-        m_timers.emplace(id, std::move(rec));
+        if ((m_stopping.load() || stoken.stop_requested()) &&
+            m_pendingTasks.load() == 0 && m_pendingBackground.load() == 0)
+        {
+            return;
+        }
     }
+}
 
-    return id;
+bool StdThreadPool::hasRunnableWork() const noexcept
+{
+    return m_pendingTasks.load() != 0 || (m_pendingBackground.load() != 0 && backgroundAllowed());
 }
 
-void
-StdThreadPool::cancelRecurring(RecurringId id)
+StdThreadPool::Task* StdThreadPool::takeTask(const std::size_t index, TaskPriority& priority)
 {
-    std::lock_guard lock(m_mutex);
-    const auto it = m_timers.find(id);
-    if (it != m_timers.end())
+    if (Task* task = takeInjected(priority, true))
     {
-        it->second.cancelled->store(true);
-        it->second.thread.request_stop();
-        m_timers.erase(it);
+        return task;
     }
+
+    if (Task* task = m_localQueues[index]->pop())
+    {
+        m_pendingTasks.fetch_sub(1);
+        priority = TaskPriority::Normal;
+        return task;
+    }
+
+    if (Task* task = takeInjected(priority, false))
+    {
+        return task;
+    }
+
+    for (std::size_t i = 1; i < m_numThreads; ++i)
+    {
+        if (Task* task = m_localQueues[(index + i) % m_numThreads]->steal())
+        {
+            m_pendingTasks.fetch_sub(1);
+            priority = TaskPriority::Normal;
+            return task;
+        }
+    }
+
+    return nullptr;
 }
 
-void StdThreadPool::shutdown(const bool graceful)
+// The background slot is claimed under m_injectMutex so concurrent takers cannot overshoot the limit.
+StdThreadPool::Task* StdThreadPool::takeInjected(TaskPriority& priority, const bool urgentOnly)
 {
+    if (m_injectedCount.load() == 0)
     {
-        std::lock_guard lock(m_mutex);
-        m_stopping.store(true);
+        return nullptr;
+    }
 
-        if (!graceful)
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point queuedAt;
+    Task* task = nullptr;
+    {
+        std::lock_guard lock(m_injectMutex);
+        if (!m_injected.pop(task, priority, now, backgroundAllowed(), urgentOnly, &queuedAt))
         {
-            m_tasks.clear();
+            return nullptr;
         }
+
+        m_injectedCount.fetch_sub(1);
+        if (priority == TaskPriority::Background)
+        {
+            m_runningBackground.fetch_add(1);
+            m_pendingBackground.fetch_sub(1);
+        }
+        else
+        {
+            m_pendingTasks.fetch_sub(1);
+        }
+    }
+    m_waitTime.Record(now - queuedAt);
+    return task;
+}
+
+void StdThreadPool::runTask(Task* task)
+{
+    const TaskNode owned(task);
+    if (m_discard.load())
+    {
+        return;
+    }
+
+    try
+    {
+        (*owned)();
+    }
+    catch (...)
+    {
     }
+}
 
-    std::vector<RecurringId> ids;
+void StdThreadPool::wakeIdleWorker()
+{
+    if (m_idleWorkers.load() == 0)
     {
+        return;
+    }
+
+    {
+        // Serializes with a worker that is between its predicate check and the wait.
         std::lock_guard lock(m_mutex);
-        ids.reserve(m_timers.size());
-        for (const std::pair<const unsigned long long, TimerRecord> &p : m_timers)
+    }
+    m_cv.notify_one();
+}
+
+// Frees tasks left in the WorkStealing queues; only called once the workers are gone.
+void StdThreadPool::discardQueuedTasks()
+{
+    for (const std::unique_ptr<WorkStealingDeque<Task>> &queue : m_localQueues)
+    {
+        while (Task* task = queue->steal())
         {
-            ids.push_back(p.first);
+            TaskNodeDeleter{}(task);
         }
     }
 
-    for (const size_t id : ids)
+    std::lock_guard lock(m_injectMutex);
+    Task* task = nullptr;
+    while (m_injected.popAny(task))
+    {
+        TaskNodeDeleter{}(task);
+    }
+    m_injectedCount.store(0);
+    m_pendingTasks.store(0);
+    m_pendingBackground.store(0);
+}
+
+IThreadManager::Stats StdThreadPool::stats() const
+{
+    Stats result;
+    if (m_mode == SchedulingMode::WorkStealing)
+    {
+        result.queuedTasks = m_pendingTasks.load() + m_pendingBackground.load();
+    }
+    else
+    {
+        std::lock_guard lock(m_mutex);
+        result.queuedTasks = m_tasks.size();
+    }
+    result.waitTime = m_waitTime.Summary();
+    return result;
+}
+
+IThreadManager::RecurringId
+StdThreadPool::scheduleRecurringGeneric(const std::chrono::milliseconds interval, Task task, const RecurringMode mode)
+{
+    if (m_stopping.load())
+    {
+        throw std::runtime_error("scheduleRecurring on stopped thread pool");
+    }
+
+    const RecurringId id = m_nextRecurringId.fetch_add(1);
+    m_timerQueue.schedule(id, interval, mode, std::move(task));
+    return id;
+}
+
+void
+StdThreadPool::cancelRecurring(const RecurringId id)
+{
+    m_timerQueue.cancel(id);
+}
+
+void StdThreadPool::shutdown(const bool graceful)
+{
     {
-        cancelRecurring(id);
+        std::scoped_lock lock(m_mutex, m_injectMutex);
+        m_stopping.store(true);
+
+        if (!graceful)
+        {
+            m_tasks.clear();
+            m_discard.store(true);
+        }
     }
 
+    // Joins the timer thread; FixedDelay runs still queued will not re-arm.
+    m_timerQueue.stop();
+
     m_cv.notify_all();
 
     for (std::jthread &w : m_workers)
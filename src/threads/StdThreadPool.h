@@ -1,16 +1,38 @@
 #pragma once
 
 #include "IThreadManager.h"
+#include "PriorityLanes.h"
+#include "TimerQueue.h"
+#include "WorkStealingDeque.h"
 
 #include <thread>
 #include <vector>
-#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
-#include <unordered_map>
 #include <memory>
 
+/**
+ *  SchedulingMode
+ *
+ *  SharedQueue  - one FIFO queue behind a single mutex; simple and fair.
+ *  WorkStealing - every worker owns a lock-free deque. enqueue() from a worker thread pushes
+ *                 to that worker's deque (LIFO, cache-friendly for recursive fan-out), enqueue()
+ *                 from any other thread goes to a global injection queue. Idle workers take
+ *                 from their own deque, then the injection queue, then steal from other workers.
+ *
+ *  Priorities (both modes): queued tasks are served Interactive first, with aging for the
+ *  lower classes (see PriorityLanes). At most numThreads - 1 Background tasks run at once,
+ *  so one worker is always free to pick up interactive work. In WorkStealing mode only
+ *  Normal tasks spawned by a worker go to its local deque; Interactive and Background tasks
+ *  always go through the injection lanes, and Interactive ones are checked before the local deque.
+ */
+enum class SchedulingMode
+{
+    SharedQueue,
+    WorkStealing
+};
+
 class StdThreadPool final : public IThreadManager
 {
 public:
@@ -18,37 +40,71 @@ public:
      * Create a thread pool.
      * If numThreads == 0 the pool will use std::thread::hardware_concurrency() or 1.
      */
-    explicit StdThreadPool(std::size_t numThreads = 0);
+    explicit StdThreadPool(std::size_t numThreads = 0, SchedulingMode mode = SchedulingMode::SharedQueue);
 
     ~StdThreadPool() override;
 
     StdThreadPool(const StdThreadPool&) = delete;
     StdThreadPool& operator=(const StdThreadPool&) = delete;
 
-    void enqueue(Task task) override;
+    using IThreadManager::enqueue;
+
+    void enqueue(Task task, TaskPriority priority) override;
+
+    using IThreadManager::scheduleRecurringGeneric;
 
-    RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task) override;
+    RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task, RecurringMode mode) override;
 
     void cancelRecurring(RecurringId id) override;
 
     void shutdown(bool graceful) override;
 
+    [[nodiscard]] SchedulingMode mode() const noexcept { return m_mode; }
+
+    // waitTime covers tasks taken from the priority lanes; in WorkStealing mode tasks a
+    // worker pushed to its own deque are not timestamped and not included.
+    [[nodiscard]] Stats stats() const override;
+
 private:
     void workerLoop(std::stop_token stoken);
 
+    [[nodiscard]] bool backgroundAllowed() const noexcept;
+    void finishBackground();
+
+    // WorkStealing mode.
+    void stealingWorkerLoop(std::stop_token stoken, std::size_t index);
+    [[nodiscard]] bool hasRunnableWork() const noexcept;
+    Task* takeTask(std::size_t index, TaskPriority& priority);
+    Task* takeInjected(TaskPriority& priority, bool urgentOnly);
+    void runTask(Task* task);
+    void wakeIdleWorker();
+    void discardQueuedTasks();
+
     std::size_t m_numThreads;
+    SchedulingMode m_mode;
+    std::size_t m_backgroundLimit = 1;
+    std::atomic<std::size_t> m_runningBackground{ 0 };
     std::vector<std::jthread> m_workers;
-    std::deque<Task> m_tasks;
-    std::mutex m_mutex;
+    PriorityLanes<Task> m_tasks;
+    mutable std::mutex m_mutex;
     std::condition_variable m_cv;
     std::atomic<bool> m_stopping{ false };
 
-    struct TimerRecord
-    {
-        std::shared_ptr<std::atomic_bool> cancelled;
-        std::jthread thread;
-    };
+    // WorkStealing mode: tasks are heap-allocated and owned by whoever takes them.
+    // m_mutex/m_cv are only used to park idle workers. m_pendingTasks counts queued
+    // Interactive/Normal tasks, m_pendingBackground queued Background tasks.
+    std::vector<std::unique_ptr<WorkStealingDeque<Task>>> m_localQueues;
+    PriorityLanes<Task*> m_injected;
+    std::mutex m_injectMutex;
+    std::atomic<std::size_t> m_injectedCount{ 0 };
+    std::atomic<std::size_t> m_pendingTasks{ 0 };
+    std::atomic<std::size_t> m_pendingBackground{ 0 };
+    std::atomic<std::size_t> m_idleWorkers{ 0 };
+    std::atomic<bool> m_discard{ false };
+
+    core::metrics::LatencyHistogram m_waitTime;
 
-    std::unordered_map<RecurringId, TimerRecord> m_timers;
+    // One thread for all recurring tasks; due runs are enqueue()d to the workers.
+    TimerQueue m_timerQueue;
     std::atomic<RecurringId> m_nextRecurringId{ 1 };
 };
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace detail
+{
+    struct VoidResult
+    {};
+
+    /**
+     *  FutureState
+     *
+     *  Shared state between one submitted task and its TaskFuture. Two references exist
+     *  from the start (task side and future side); the last one to let go returns the
+     *  state to a small thread-local free list, so steady-state submit() reuses slots
+     *  instead of allocating. Completion is signalled with std::atomic wait/notify.
+     */
+    template <typename R>
+    class FutureState
+    {
+        static_assert(!std::is_reference_v<R>, "TaskFuture does not support reference results");
+
+    public:
+        static FutureState* Acquire()
+        {
+            Pool& pool = LocalPool();
+            FutureState* state = nullptr;
+            if (!pool.free.empty())
+            {
+                state = pool.free.back();
+                pool.free.pop_back();
+            }
+            else
+            {
+                state = new FutureState();
+            }
+            state->m_refs.store(2, std::memory_order_relaxed);
+            return state;
+        }
+
+        void Release() noexcept
+        {
+            if (m_refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+
+            m_value.reset();
+            m_error = nullptr;
+            m_ready.store(false, std::memory_order_relaxed);
+
+            Pool& pool = LocalPool();
+            if (pool.free.size() < kMaxPooled)
+            {
+                try
+                {
+                    pool.free.push_back(this);
+                    return;
+                }
+                catch (...)
+                {
+                }
+            }
+            delete this;
+        }
+
+        template <typename F>
+        void Run(F& f) noexcept
+        {
+            try
+            {
+                if constexpr (std::is_void_v<R>)
+                {
+                    f();
+                    m_value.emplace();
+                }
+                else
+                {
+                    m_value.emplace(f());
+                }
+            }
+            catch (...)
+            {
+                m_error = std::current_exception();
+            }
+            Publish();
+        }
+
+        void Fail(std::exception_ptr error) noexcept
+        {
+            m_error = std::move(error);
+            Publish();
+        }
+
+        [[nodiscard]] bool Ready() const noexcept
+        {
+            return m_ready.load(std::memory_order_acquire);
+        }
+
+        void Wait() const noexcept
+        {
+            while (!m_ready.load(std::memory_order_acquire))
+            {
+                m_ready.wait(false, std::memory_order_acquire);
+            }
+        }
+
+        // Call once, after Wait().
+        R Take()
+        {
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+            if constexpr (!std::is_void_v<R>)
+            {
+                return std::move(*m_value);
+            }
+        }
+
+    private:
+        using Storage = std::conditional_t<std::is_void_v<R>, VoidResult, R>;
+
+        static constexpr std::size_t kMaxPooled = 64;
+
+        struct Pool
+        {
+            std::vector<FutureState*> free;
+
+            ~Pool()
+            {
+                for (const FutureState* state : free)
+                {
+                    delete state;
+                }
+            }
+        };
+
+        static Pool& LocalPool()
+        {
+            thread_local Pool pool;
+            return pool;
+        }
+
+        void Publish() noexcept
+        {
+            m_ready.store(true, std::memory_order_release);
+            m_ready.notify_all();
+        }
+
+        std::atomic<int> m_refs{ 0 };
+        std::atomic<bool> m_ready{ false };
+        std::optional<Storage> m_value;
+        std::exception_ptr m_error;
+    };
+
+    /**
+     *  Task-side reference held by the submitted callable. If the task is destroyed
+     *  without running (pool discarded it), the future gets std::future_errc::broken_promise.
+     */
+    template <typename R>
+    class PromiseRef
+    {
+    public:
+        explicit PromiseRef(FutureState<R>* state) noexcept
+            : m_state(state)
+        {}
+
+        PromiseRef(PromiseRef&& other) noexcept
+            : m_state(std::exchange(other.m_state, nullptr))
+        {}
+
+        PromiseRef(const PromiseRef&) = delete;
+        PromiseRef& operator=(const PromiseRef&) = delete;
+        PromiseRef& operator=(PromiseRef&&) = delete;
+
+        ~PromiseRef()
+        {
+            if (m_state == nullptr)
+            {
+                return;
+            }
+            if (!m_state->Ready())
+            {
+                m_state->Fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+            m_state->Release();
+        }
+
+        template <typename F>
+        void Run(F& f) noexcept
+        {
+            if (m_state != nullptr && !m_state->Ready())
+            {
+                m_state->Run(f);
+            }
+        }
+
+    private:
+        FutureState<R>* m_state;
+    };
+}
+
+/**
+ *  TaskFuture
+ *
+ *  Result handle returned by IThreadManager::submit. Like std::future: move-only,
+ *  get() blocks, returns the result once and rethrows the task's exception.
+ */
+template <typename R>
+class TaskFuture
+{
+public:
+    TaskFuture() noexcept = default;
+
+    explicit TaskFuture(detail::FutureState<R>* state) noexcept
+        : m_state(state)
+    {}
+
+    TaskFuture(TaskFuture&& other) noexcept
+        : m_state(std::exchange(other.m_state, nullptr))
+    {}
+
+    TaskFuture& operator=(TaskFuture&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_state = std::exchange(other.m_state, nullptr);
+        }
+        return *this;
+    }
+
+    TaskFuture(const TaskFuture&) = delete;
+    TaskFuture& operator=(const TaskFuture&) = delete;
+
+    ~TaskFuture()
+    {
+        release();
+    }
+
+    [[nodiscard]] bool valid() const noexcept
+    {
+        return m_state != nullptr;
+    }
+
+    [[nodiscard]] bool ready() const noexcept
+    {
+        return m_state != nullptr && m_state->Ready();
+    }
+
+    void wait() const
+    {
+        if (m_state == nullptr)
+        {
+            throw std::future_error(std::future_errc::no_state);
+        }
+        m_state->Wait();
+    }
+
+    R get()
+    {
+        wait();
+        detail::FutureState<R>* state = std::exchange(m_state, nullptr);
+
+        struct Releaser
+        {
+            detail::FutureState<R>* state;
+            ~Releaser() { state->Release(); }
+        } releaser{ state };
+
+        return state->Take();
+    }
+
+private:
+    void release() noexcept
+    {
+        if (m_state != nullptr)
+        {
+            std::exchange(m_state, nullptr)->Release();
+        }
+    }
+
+    detail::FutureState<R>* m_state = nullptr;
+};
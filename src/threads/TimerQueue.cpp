@@ -0,0 +1,196 @@
+#include "TimerQueue.h"
+
+#include <stdexcept>
+#include <utility>
+
+TimerQueue::TimerQueue(Dispatch dispatch)
+    : m_dispatch(std::move(dispatch))
+{
+}
+
+TimerQueue::~TimerQueue()
+{
+    stop();
+}
+
+void TimerQueue::schedule(const RecurringId id, const std::chrono::milliseconds interval,
+                          const RecurringMode mode, Task task)
+{
+    auto timer = std::make_shared<Timer>();
+    timer->id = id;
+    // A zero interval would make the timer thread spin.
+    timer->interval = interval.count() > 0 ? Clock::duration(interval) : Clock::duration(std::chrono::milliseconds(1));
+    timer->mode = mode;
+    timer->task = std::make_shared<Task>(std::move(task));
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_stopping)
+        {
+            throw std::runtime_error("schedule on stopped timer queue");
+        }
+
+        if (!m_thread.joinable())
+        {
+            m_thread = std::jthread([this]
+            {
+                this->timerLoop();
+            });
+        }
+
+        const Clock::time_point due = Clock::now() + timer->interval;
+        m_timers.emplace(id, timer);
+        m_heap.push(Deadline{ due, std::move(timer) });
+    }
+
+    m_cv.notify_one();
+}
+
+bool TimerQueue::cancel(const RecurringId id)
+{
+    std::lock_guard lock(m_mutex);
+    const auto it = m_timers.find(id);
+    if (it == m_timers.end())
+    {
+        return false;
+    }
+
+    it->second->cancelled.store(true);
+    m_timers.erase(it);
+
+    // The heap entry is dropped when it reaches the top; nothing to wake for.
+    return true;
+}
+
+void TimerQueue::stop()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+        for (const std::pair<const RecurringId, std::shared_ptr<Timer>> &p : m_timers)
+        {
+            p.second->cancelled.store(true);
+        }
+        m_timers.clear();
+        m_heap = {};
+    }
+
+    m_cv.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+std::size_t TimerQueue::size() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_timers.size();
+}
+
+void TimerQueue::timerLoop()
+{
+    std::unique_lock lock(m_mutex);
+    while (!m_stopping)
+    {
+        if (m_heap.empty())
+        {
+            m_cv.wait(lock, [this]() -> bool
+            {
+                return m_stopping || !m_heap.empty();
+            });
+            continue;
+        }
+
+        const Deadline& top = m_heap.top();
+        if (top.timer->cancelled.load())
+        {
+            m_heap.pop();
+            continue;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (now < top.due)
+        {
+            // Copied: the heap may change while we wait. Woken early by schedule/cancel/stop,
+            // the loop re-evaluates the earliest deadline.
+            const Clock::time_point wakeAt = top.due;
+            m_cv.wait_until(lock, wakeAt);
+            continue;
+        }
+
+        std::shared_ptr<Timer> timer = top.timer;
+        const Clock::time_point due = top.due;
+        m_heap.pop();
+
+        if (timer->mode == RecurringMode::FixedRate)
+        {
+            Clock::time_point next = due + timer->interval;
+            if (next <= now)
+            {
+                next = now + timer->interval;
+            }
+            m_heap.push(Deadline{ next, timer });
+        }
+
+        lock.unlock();
+        fire(timer);
+        lock.lock();
+    }
+}
+
+/**
+ * fire
+ *
+ * Called without the lock. FixedDelay timers are not in the heap while their run is
+ * pending; the dispatched wrapper re-arms them once the task has returned.
+ */
+void TimerQueue::fire(const std::shared_ptr<Timer>& timer)
+{
+    Task run = [this, timer]
+    {
+        if (timer->cancelled.load())
+        {
+            return;
+        }
+
+        try
+        {
+            (*timer->task)();
+        }
+        catch (...)
+        {
+        }
+
+        if (timer->mode == RecurringMode::FixedDelay)
+        {
+            this->rearm(timer);
+        }
+    };
+
+    try
+    {
+        m_dispatch(std::move(run));
+    }
+    catch (...)
+    {
+        std::lock_guard lock(m_mutex);
+        timer->cancelled.store(true);
+        m_timers.erase(timer->id);
+    }
+}
+
+void TimerQueue::rearm(const std::shared_ptr<Timer>& timer)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_stopping || timer->cancelled.load())
+        {
+            return;
+        }
+        m_heap.push(Deadline{ Clock::now() + timer->interval, timer });
+    }
+
+    m_cv.notify_one();
+}
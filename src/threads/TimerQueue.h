@@ -0,0 +1,93 @@
+#pragma once
+
+#include "IThreadManager.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *  TimerQueue
+ *
+ *  One thread that serves every recurring task of an executor.
+ *
+ *  - Due times live in a min-heap ordered by steady_clock deadline; the thread sleeps on a
+ *    condition variable until the earliest deadline, so schedule(), cancel() and stop()
+ *    take effect immediately instead of after a sleeping interval.
+ *  - When a timer is due its task is handed to the dispatch function (normally the pool's
+ *    enqueue). The queue lock is not held while dispatching.
+ *  - Cancelled timers are dropped lazily when they reach the top of the heap.
+ *  - If dispatch throws (the executor is stopping) the timer is cancelled.
+ *
+ *  The thread is started on the first schedule() call.
+ *  The executor must finish running dispatched tasks before the TimerQueue is destroyed.
+ */
+class TimerQueue
+{
+public:
+    using Task = IThreadManager::Task;
+    using RecurringId = IThreadManager::RecurringId;
+    using RecurringMode = IThreadManager::RecurringMode;
+    using Dispatch = std::function<void(Task)>;
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimerQueue(Dispatch dispatch);
+
+    ~TimerQueue();
+
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    // Throws std::runtime_error after stop().
+    void schedule(RecurringId id, std::chrono::milliseconds interval, RecurringMode mode, Task task);
+
+    // A run that was already dispatched but has not started yet is skipped. Returns false for unknown ids.
+    bool cancel(RecurringId id);
+
+    // Cancels every timer and joins the timer thread. Idempotent.
+    void stop();
+
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    struct Timer
+    {
+        RecurringId id = 0;
+        Clock::duration interval{};
+        RecurringMode mode = RecurringMode::FixedRate;
+        std::shared_ptr<Task> task;
+        std::atomic<bool> cancelled{ false };
+    };
+
+    struct Deadline
+    {
+        Clock::time_point due;
+        std::shared_ptr<Timer> timer;
+
+        bool operator>(const Deadline& other) const noexcept
+        {
+            return due > other.due;
+        }
+    };
+
+    void timerLoop();
+    void fire(const std::shared_ptr<Timer>& timer);
+    void rearm(const std::shared_ptr<Timer>& timer);
+
+    Dispatch m_dispatch;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<>> m_heap;
+    std::unordered_map<RecurringId, std::shared_ptr<Timer>> m_timers;
+    bool m_stopping = false;
+
+    std::jthread m_thread;
+};
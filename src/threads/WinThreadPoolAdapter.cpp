@@ -7,7 +7,52 @@
 #include <stdexcept>
 #include <cassert>
 
-WinThreadPoolAdapter::WinThreadPoolAdapter() = default;
+namespace
+{
+    // Negative FILETIME = due time relative to now, in 100 ns units.
+    FILETIME RelativeDueTime(const LONG delayMs)
+    {
+        FILETIME ft = { 0 };
+        const LONGLONG due100ns = -static_cast<LONGLONG>(delayMs) * 10000LL;
+        const auto due = static_cast<ULONGLONG>(due100ns);
+        ft.dwLowDateTime = static_cast<DWORD>(due & 0xffffffffULL);
+        ft.dwHighDateTime = static_cast<DWORD>(due >> 32);
+        return ft;
+    }
+}
+
+WinThreadPoolAdapter::WinThreadPoolAdapter()
+{
+    static constexpr TP_CALLBACK_PRIORITY kPriorities[kLaneCount] = {
+        TP_CALLBACK_PRIORITY_HIGH,   // Interactive
+        TP_CALLBACK_PRIORITY_NORMAL, // Normal
+        TP_CALLBACK_PRIORITY_LOW     // Background
+    };
+
+    for (std::size_t i = 0; i < kLaneCount; ++i)
+    {
+        auto lane = std::make_unique<Lane>();
+        lane->owner = this;
+        lane->index = i;
+        lane->lastServed.store(GetTickCount64());
+
+        InitializeThreadpoolEnvironment(&lane->environment);
+        SetThreadpoolCallbackPriority(&lane->environment, kPriorities[i]);
+
+        lane->work = CreateThreadpoolWork(&WinThreadPoolAdapter::WorkCallback, lane.get(), &lane->environment);
+        if (lane->work == nullptr)
+        {
+            DestroyThreadpoolEnvironment(&lane->environment);
+            for (std::size_t j = 0; j < i; ++j)
+            {
+                CloseThreadpoolWork(m_lanes[j]->work);
+                DestroyThreadpoolEnvironment(&m_lanes[j]->environment);
+            }
+            throw std::runtime_error("CreateThreadpoolWork failed");
+        }
+        m_lanes[i] = std::move(lane);
+    }
+}
 
 WinThreadPoolAdapter::~WinThreadPoolAdapter()
 {
@@ -22,72 +67,157 @@ WinThreadPoolAdapter::~WinThreadPoolAdapter()
 /**
  * enqueue
  *
- * Create a PTP_WORK object with a heap-allocated WorkContext containing the std::function.
- * Submit the work object to the default process thread pool using SubmitThreadpoolWork.
- *
- * The WorkCallback will:
- *  - cast the Parameter back to WorkContext*
- *  - invoke the stored function()
- *  - call WaitForThreadpoolWorkCallbacks(Work, FALSE) if needed (not required here)
- *  - CloseThreadpoolWork(Work)
- *  - delete the WorkContext
+ * Move the task into its lane's ring (or the overflow deque when the ring is full) and
+ * post one callback of that lane's work object with SubmitThreadpoolWork.
  *
- * This pattern gives per-call context and ensures safe cleanup after callback finishes.
+ * The task is published before the submit, so the callback posted here always finds
+ * it, or another callback took it first. An item that sits behind a slot another
+ * producer has claimed but not written yet is picked up by the callback of that
+ * producer's own submission.
  */
-void WinThreadPoolAdapter::enqueue(Task task)
+void WinThreadPoolAdapter::enqueue(Task task, const TaskPriority priority)
 {
+    m_submitting.fetch_add(1);
+    struct SubmitGuard
+    {
+        std::atomic<std::size_t>& counter;
+        ~SubmitGuard() { counter.fetch_sub(1); }
+    } guard{ m_submitting };
+
     if (m_shuttingDown.load())
     {
         throw std::runtime_error("WinThreadPoolAdapter is shutting down");
     }
 
-    const auto ctx = new WorkContext{ std::move(task) };
+    Lane& lane = *m_lanes[static_cast<std::size_t>(priority)];
 
-    PTP_WORK work = CreateThreadpoolWork(&WinThreadPoolAdapter::WorkCallback, ctx, nullptr);
+    // Counted before the push: a callback may pop the task and decrement before we continue.
+    lane.pending.fetch_add(1);
+    QueuedTask queued{ std::move(task), std::chrono::steady_clock::now() };
+    if (!lane.queue.tryPush(std::move(queued)))
+    {
+        try
+        {
+            std::lock_guard lock(lane.overflowMutex);
+            lane.overflow.push_back(std::move(queued));
+            lane.overflowSize.fetch_add(1);
+        }
+        catch (...)
+        {
+            lane.pending.fetch_sub(1);
+            throw;
+        }
+    }
 
-    if (work == nullptr)
+    SubmitThreadpoolWork(lane.work);
+}
+
+bool WinThreadPoolAdapter::popTask(Lane& lane, QueuedTask& task)
+{
+    bool found = lane.queue.tryPop(task);
+
+    if (!found && lane.overflowSize.load() != 0)
     {
-        delete ctx;
-        throw std::runtime_error("CreateThreadpoolWork failed");
+        std::lock_guard lock(lane.overflowMutex);
+        if (!lane.overflow.empty())
+        {
+            task = std::move(lane.overflow.front());
+            lane.overflow.pop_front();
+            lane.overflowSize.fetch_sub(1);
+            found = true;
+        }
     }
 
-    SubmitThreadpoolWork(work);
+    if (found)
+    {
+        lane.pending.fetch_sub(1);
+        lane.lastServed.store(GetTickCount64());
+    }
+    return found;
+}
+
+/**
+ * popStarved
+ *
+ * Aging: take one task from a lane below laneIndex that has work queued but has not
+ * been served for longer than its limit (Normal 100 ms, Background 1 s).
+ */
+bool WinThreadPoolAdapter::popStarved(const std::size_t laneIndex, QueuedTask& task)
+{
+    static constexpr ULONGLONG kAgeLimitMs[kLaneCount] = { 0, 100, 1000 };
+
+    const ULONGLONG now = GetTickCount64();
+    for (std::size_t i = kLaneCount; i-- > laneIndex + 1;)
+    {
+        Lane& lower = *m_lanes[i];
+        if (lower.pending.load() != 0 && now - lower.lastServed.load() > kAgeLimitMs[i] &&
+            popTask(lower, task))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Destroys tasks that will never run; only called once no callback is outstanding.
+void WinThreadPoolAdapter::drainQueue(Lane& lane)
+{
+    QueuedTask queued;
+    while (popTask(lane, queued))
+    {
+        queued.task = nullptr;
+    }
 }
 
 /**
  * static WorkCallback
  *
- * Called by the Windows thread pool on a worker thread when SubmitThreadpoolWork is executed.
+ * Called by the Windows thread pool on a worker thread once per SubmitThreadpoolWork.
  *
  * Parameters:
  *  - Instance: callback instance (unused here)
- *  - Parameter: pointer passed at CreateThreadpoolWork time (WorkContext*)
- *  - Work: the PTP_WORK representing this work item
+ *  - Parameter: the Lane the work object belongs to
+ *  - Work: the lane's shared PTP_WORK (never closed here)
  *
- * Implementation:
- *  - cast Parameter -> WorkContext*
- *  - invoke function()
- *  - call CloseThreadpoolWork(Work) to release the work object. CloseThreadpoolWork
- *    will free it immediately if no callbacks outstanding or asynchronously otherwise.
- *  - delete the WorkContext
+ * Runs queued tasks until the lane is empty, serving starved lower lanes first; a
+ * callback that finds nothing left (another callback already ran its task) returns.
  */
-VOID CALLBACK WinThreadPoolAdapter::WorkCallback(PTP_CALLBACK_INSTANCE /*Instance*/, PVOID Parameter, PTP_WORK Work)
+VOID CALLBACK WinThreadPoolAdapter::WorkCallback(PTP_CALLBACK_INSTANCE /*Instance*/, PVOID Parameter, PTP_WORK /*Work*/)
 {
-    const WorkContext* ctx = static_cast<WorkContext*>(Parameter);
-    if (ctx == nullptr)
+    auto* lane = static_cast<Lane*>(Parameter);
+    if (lane == nullptr || lane->owner == nullptr)
     {
         return;
     }
 
-    try
+    WinThreadPoolAdapter* self = lane->owner;
+
+    QueuedTask queued;
+    while (self->popStarved(lane->index, queued) || popTask(*lane, queued))
     {
-        ctx->function();
+        self->m_waitTime.RecordSince(queued.queuedAt);
+        try
+        {
+            queued.task();
+        }
+        catch (...)
+        {}
+        queued.task = nullptr;
     }
-    catch (...)
-    {}
+}
 
-    CloseThreadpoolWork(Work);
-    delete ctx;
+IThreadManager::Stats WinThreadPoolAdapter::stats() const
+{
+    Stats result;
+    for (const std::unique_ptr<Lane> &lane : m_lanes)
+    {
+        if (lane)
+        {
+            result.queuedTasks += lane->pending.load();
+        }
+    }
+    result.waitTime = m_waitTime.Summary();
+    return result;
 }
 
 /**
@@ -99,7 +229,8 @@ VOID CALLBACK WinThreadPoolAdapter::WorkCallback(PTP_CALLBACK_INSTANCE /*Instanc
  *
  * We store the TimerContext so we can cancel and close the timer later on cancelRecurring or shutdown.
  */
-IThreadManager::RecurringId WinThreadPoolAdapter::scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task)
+IThreadManager::RecurringId WinThreadPoolAdapter::scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task,
+                                                                           const RecurringMode mode)
 {
     if (m_shuttingDown.load())
     {
@@ -109,21 +240,20 @@ IThreadManager::RecurringId WinThreadPoolAdapter::scheduleRecurringGeneric(std::
     RecurringId id = m_nextId.fetch_add(1);
 
     std::unique_ptr<TimerContext> ctx = std::make_unique<TimerContext>();
-    ctx->function = std::move(task);
+    ctx->owner = this;
+    ctx->function = std::make_shared<Task>(std::move(task));
     ctx->periodMs = static_cast<LONG>(interval.count());
+    ctx->mode = mode;
     ctx->timer = CreateThreadpoolTimer(&WinThreadPoolAdapter::TimerCallback, ctx.get(), nullptr);
     if (ctx->timer == nullptr)
     {
         throw std::runtime_error("CreateThreadpoolTimer failed");
     }
 
-    FILETIME ft = { 0 };
-    const LONGLONG due100ns = -static_cast<LONGLONG>(ctx->periodMs) * 10000LL;
-    const auto due = static_cast<ULONGLONG>(due100ns);
-    ft.dwLowDateTime = static_cast<DWORD>(due & 0xffffffffULL);
-    ft.dwHighDateTime = static_cast<DWORD>(due >> 32);
+    FILETIME ft = RelativeDueTime(ctx->periodMs);
 
-    SetThreadpoolTimer(ctx->timer, &ft, ctx->periodMs, 0);
+    // The timer is armed before it is published, so cancelRecurring never sees a half-set timer.
+    SetThreadpoolTimer(ctx->timer, &ft, mode == RecurringMode::FixedDelay ? 0 : ctx->periodMs, 0);
     {
         std::lock_guard lock(m_mutex);
         m_timers.emplace(id, std::move(ctx));
@@ -135,30 +265,49 @@ IThreadManager::RecurringId WinThreadPoolAdapter::scheduleRecurringGeneric(std::
 /**
  * TimerCallback
  *
- * The callback receives the TimerContext in Parameter. We need to resubmit the user's
- * Task to the thread pool for execution. To reuse the WorkCallback machinery, we allocate
- * a WorkContext and create+submit a PTP_WORK with the WorkContext as Parameter.
+ * The callback receives the TimerContext in Parameter. FixedRate ticks hand the user's
+ * Task to enqueue() so a slow run does not hold up the timer; the queued item shares
+ * ownership of the Task.
+ *
+ * FixedDelay timers are one-shot: the task runs right here on the pool thread and the
+ * timer is re-armed after it returns, unless the timer was cancelled meanwhile.
  *
  * Important: Do not free the TimerContext here. It remains owned by m_timers until cancelRecurring.
  */
-VOID CALLBACK WinThreadPoolAdapter::TimerCallback(PTP_CALLBACK_INSTANCE /*Instance*/, PVOID Parameter, PTP_TIMER /*Timer*/)
+VOID CALLBACK WinThreadPoolAdapter::TimerCallback(PTP_CALLBACK_INSTANCE /*Instance*/, PVOID Parameter, PTP_TIMER Timer)
 {
     const auto tctx = static_cast<TimerContext*>(Parameter);
-    if (tctx == nullptr)
+    if (tctx == nullptr || tctx->cancelled.load())
     {
         return;
     }
 
-    const auto wctx = new WorkContext{ tctx->function };
-
-    PTP_WORK work = CreateThreadpoolWork(&WinThreadPoolAdapter::WorkCallback, wctx, nullptr);
-    if (work == nullptr)
+    if (tctx->mode == RecurringMode::FixedDelay)
     {
-        delete wctx;
+        try
+        {
+            (*tctx->function)();
+        }
+        catch (...)
+        {}
+
+        if (!tctx->cancelled.load())
+        {
+            FILETIME ft = RelativeDueTime(tctx->periodMs);
+            SetThreadpoolTimer(Timer, &ft, 0, 0);
+        }
         return;
     }
 
-    SubmitThreadpoolWork(work);
+    try
+    {
+        tctx->owner->enqueue([function = tctx->function]
+        {
+            (*function)();
+        });
+    }
+    catch (...)
+    {}
 }
 
 /**
@@ -183,10 +332,26 @@ void WinThreadPoolAdapter::cancelRecurring(RecurringId id)
         m_timers.erase(it);
     }
 
-    SetThreadpoolTimer(ctx->timer, nullptr, 0, 0);
-    WaitForThreadpoolTimerCallbacks(ctx->timer, TRUE); // TRUE cancels pending callbacks
+    CancelTimer(*ctx);
+}
+
+/**
+ * CancelTimer
+ *
+ * A FixedDelay callback that was running when the flag was set may have re-armed the
+ * timer, so after waiting for it the timer is cleared and waited on a second time.
+ */
+void WinThreadPoolAdapter::CancelTimer(TimerContext& ctx)
+{
+    ctx.cancelled.store(true);
+
+    SetThreadpoolTimer(ctx.timer, nullptr, 0, 0);
+    WaitForThreadpoolTimerCallbacks(ctx.timer, TRUE); // TRUE cancels pending callbacks
+
+    SetThreadpoolTimer(ctx.timer, nullptr, 0, 0);
+    WaitForThreadpoolTimerCallbacks(ctx.timer, TRUE);
 
-    CloseThreadpoolTimer(ctx->timer);
+    CloseThreadpoolTimer(ctx.timer);
 }
 
 /**
@@ -199,11 +364,12 @@ void WinThreadPoolAdapter::cancelRecurring(RecurringId id)
  *  - flip m_shuttingDown
  *  - snapshot current timers and cancel them (SetThreadpoolTimer(NULL...))
  *  - WaitForThreadpoolTimerCallbacks + CloseThreadpoolTimer for each
- *  - There is no global list of PTP_WORK objects created by clients here; each created work
- *    object is closed by its callback, so after the above waits outstanding work callbacks
- *    should complete. If you need to track every work object created externally, keep a list.
+ *  - wait for enqueue() calls already past the shutdown check to submit
+ *  - WaitForThreadpoolWorkCallbacks on each lane's work object: graceful waits for every
+ *    posted callback (the queues drain), otherwise callbacks not yet started are cancelled
+ *  - destroy whatever is still queued, close the work objects and their environments
  */
-void WinThreadPoolAdapter::shutdown(bool /*graceful*/)
+void WinThreadPoolAdapter::shutdown(const bool graceful)
 {
     bool expected = false;
     if (!m_shuttingDown.compare_exchange_strong(expected, true))
@@ -223,8 +389,26 @@ void WinThreadPoolAdapter::shutdown(bool /*graceful*/)
 
     for (const std::unique_ptr<TimerContext> &ctx : timers)
     {
-        SetThreadpoolTimer(ctx->timer, nullptr, 0, 0);
-        WaitForThreadpoolTimerCallbacks(ctx->timer, TRUE);
-        CloseThreadpoolTimer(ctx->timer);
+        CancelTimer(*ctx);
+    }
+
+    while (m_submitting.load() != 0)
+    {
+        SwitchToThread();
+    }
+
+    // Waiting on a lane also lets its callbacks serve starved lower lanes, so wait on every
+    // lane before draining any of them.
+    for (const std::unique_ptr<Lane> &lane : m_lanes)
+    {
+        WaitForThreadpoolWorkCallbacks(lane->work, graceful ? FALSE : TRUE);
+    }
+
+    for (const std::unique_ptr<Lane> &lane : m_lanes)
+    {
+        drainQueue(*lane);
+        CloseThreadpoolWork(lane->work);
+        lane->work = nullptr;
+        DestroyThreadpoolEnvironment(&lane->environment);
     }
 }
@@ -2,9 +2,12 @@
 #pragma once
 
 #include "IThreadManager.h"
+#include "BoundedMpmcQueue.h"
 
 #include <windows.h>
 #include <threadpoolapiset.h>
+#include <array>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
 #include <memory>
@@ -17,13 +20,20 @@
  * APIs (work objects and timers).
  *
  * Notes:
- *  - This implementation creates one PTP_WORK per submitted Task. The PTP_WORK
- *    is created with the task context pointer and submitted immediately.
- *    The callback will execute the task and free the context and Close the work object.
- *    This is simple and safe but incurs allocation cost per task.
+ *  - One PTP_WORK per TaskPriority is created up front and shared by every Task of that
+ *    priority. enqueue() moves the task into the lane's lock-free bounded ring (a
+ *    mutex-protected overflow deque takes the excess when the ring is full) and calls
+ *    SubmitThreadpoolWork once, so each submission is one callback; a callback runs queued
+ *    tasks until its lane is empty. Tasks are InlineTask, so submission normally does not allocate.
+ *
+ *  - Each lane's work object is bound to a callback environment with TP_CALLBACK_PRIORITY
+ *    HIGH / NORMAL / LOW. The pool itself does not age priorities, so a callback first
+ *    serves a lower lane that has not been served for its age limit.
  *
  *  - scheduleRecurringGeneric uses CreateThreadpoolTimer and SetThreadpoolTimer,
  *    storing the PTP_TIMER in m_timers; cancelRecurring cancels and closes the timer.
+ *    FixedRate uses a periodic timer that submits a work item per tick. FixedDelay uses
+ *    a one-shot timer whose callback runs the task and then re-arms the timer.
  *
  *  - shutdown() cancels and waits for timers and outstanding work callbacks to finish
  *    using WaitForThreadpoolTimerCallbacks / WaitForThreadpoolWorkCallbacks.
@@ -40,34 +50,78 @@ public:
     WinThreadPoolAdapter(const WinThreadPoolAdapter&) = delete;
     WinThreadPoolAdapter& operator=(const WinThreadPoolAdapter&) = delete;
 
-    void enqueue(Task task) override;
+    using IThreadManager::enqueue;
+
+    void enqueue(Task task, TaskPriority priority) override;
 
-    RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task) override;
+    using IThreadManager::scheduleRecurringGeneric;
+
+    RecurringId scheduleRecurringGeneric(std::chrono::milliseconds interval, Task task, RecurringMode mode) override;
 
     void cancelRecurring(RecurringId id) override;
 
     void shutdown(bool graceful) override;
 
+    // waitTime covers every task passed to enqueue(), including recurring runs.
+    [[nodiscard]] Stats stats() const override;
+
 private:
-    struct WorkContext
+    static constexpr std::size_t kQueueCapacity = 1024;
+
+    struct QueuedTask
     {
-        Task function;
+        Task task;
+        std::chrono::steady_clock::time_point queuedAt;
     };
 
     struct TimerContext
     {
-        Task function;
+        WinThreadPoolAdapter* owner;
+        // Shared with in-flight FixedRate work items, which may outlive cancelRecurring.
+        std::shared_ptr<Task> function;
         LONG periodMs;
+        RecurringMode mode;
         PTP_TIMER timer;
+        std::atomic<bool> cancelled{ false };
+    };
+
+    static void CancelTimer(TimerContext& ctx);
+
+    struct Lane
+    {
+        WinThreadPoolAdapter* owner = nullptr;
+        std::size_t index = 0;
+        TP_CALLBACK_ENVIRON environment{};
+        PTP_WORK work = nullptr;
+        BoundedMpmcQueue<QueuedTask> queue{ kQueueCapacity };
+        std::mutex overflowMutex;
+        std::deque<QueuedTask> overflow;
+        std::atomic<std::size_t> overflowSize{ 0 };
+        std::atomic<std::size_t> pending{ 0 };
+        std::atomic<ULONGLONG> lastServed{ 0 };
     };
 
+    static constexpr std::size_t kLaneCount = 3;
+
+    static bool popTask(Lane& lane, QueuedTask& task);
+    bool popStarved(std::size_t laneIndex, QueuedTask& task);
+    static void drainQueue(Lane& lane);
+
     std::mutex m_mutex;
     std::atomic<RecurringId> m_nextId{ 1 };
 
+    // Indexed by TaskPriority.
+    std::array<std::unique_ptr<Lane>, kLaneCount> m_lanes;
+
+    // enqueue() calls between the shutdown check and SubmitThreadpoolWork; shutdown waits for them.
+    std::atomic<std::size_t> m_submitting{ 0 };
+
     std::unordered_map<RecurringId, std::unique_ptr<TimerContext>> m_timers;
 
     std::atomic<bool> m_shuttingDown{ false };
 
+    core::metrics::LatencyHistogram m_waitTime;
+
     static VOID CALLBACK WorkCallback(PTP_CALLBACK_INSTANCE Instance, PVOID Parameter, PTP_WORK Work);
 
     static VOID CALLBACK TimerCallback(PTP_CALLBACK_INSTANCE Instance, PVOID Parameter, PTP_TIMER Timer);
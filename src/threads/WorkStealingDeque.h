@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ *  WorkStealingDeque
+ *
+ *  Chase-Lev work-stealing deque of raw pointers.
+ *
+ *  - push / pop are called only by the owning worker and operate on the bottom end (LIFO),
+ *    which keeps recently spawned work hot in that worker's cache.
+ *  - steal may be called by any thread and takes from the top end (FIFO).
+ *  - No locks: the owner and thieves only race on the last element, resolved by a CAS on top.
+ *
+ *  The ring grows when full. Old rings are kept until the deque is destroyed, because a thief
+ *  may still be reading from one; growth is rare and geometric, so this costs little memory.
+ *
+ *  The deque does not own the pointed-to objects.
+ */
+template <typename T>
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(std::int64_t initialCapacity = 256)
+    {
+        std::int64_t capacity = 1;
+        while (capacity < initialCapacity)
+        {
+            capacity <<= 1;
+        }
+        m_rings.push_back(std::make_unique<Ring>(capacity));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(T* item)
+    {
+        const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = m_top.load(std::memory_order_acquire);
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+
+        if (b - t > ring->capacity - 1)
+        {
+            m_rings.push_back(ring->grow(b, t));
+            ring = m_rings.back().get();
+            m_ring.store(ring, std::memory_order_release);
+        }
+
+        ring->store(b, item);
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only. Returns nullptr when empty.
+    T* pop()
+    {
+        const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = ring->load(b);
+        if (t == b)
+        {
+            // Last element: race against thieves for it.
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                item = nullptr;
+            }
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread. Returns nullptr when empty or when another thread won the race.
+    T* steal()
+    {
+        std::int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+        {
+            return nullptr;
+        }
+
+        Ring* ring = m_ring.load(std::memory_order_acquire);
+        T* item = ring->load(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Approximate; for wake-up heuristics only.
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Ring
+    {
+        explicit Ring(const std::int64_t cap)
+            : capacity(cap)
+            , mask(cap - 1)
+            , slots(new std::atomic<T*>[static_cast<std::size_t>(cap)])
+        {
+        }
+
+        T* load(const std::int64_t index) const noexcept
+        {
+            return slots[static_cast<std::size_t>(index & mask)].load(std::memory_order_relaxed);
+        }
+
+        void store(const std::int64_t index, T* item) noexcept
+        {
+            slots[static_cast<std::size_t>(index & mask)].store(item, std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<Ring> grow(const std::int64_t bottom, const std::int64_t top) const
+        {
+            auto bigger = std::make_unique<Ring>(capacity * 2);
+            for (std::int64_t i = top; i < bottom; ++i)
+            {
+                bigger->store(i, load(i));
+            }
+            return bigger;
+        }
+
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    alignas(64) std::atomic<std::int64_t> m_top{ 0 };
+    alignas(64) std::atomic<std::int64_t> m_bottom{ 0 };
+    alignas(64) std::atomic<Ring*> m_ring{ nullptr };
+
+    // Current ring is m_rings.back(); earlier ones are retired but kept alive for thieves.
+    std::vector<std::unique_ptr<Ring>> m_rings;
+};
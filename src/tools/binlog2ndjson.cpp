@@ -0,0 +1,131 @@
+// binlog2ndjson.cpp
+// Converts a binary log (.rlog, or its compressed .rlogz container) back to NDJSON.
+// A compressed NDJSON log (.logz from FileLogger rotation) is decompressed as is.
+//
+// Usage: binlog2ndjson <input> [output]     (output defaults to stdout)
+#include <windows.h>
+#include <shellapi.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "loggin/BinaryLogFormat.h"
+
+using namespace core::logging;
+
+static bool writeAll(HANDLE out, std::string const& bytes)
+{
+    size_t offset = 0;
+    while (offset < bytes.size())
+    {
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(bytes.size() - offset, 1u << 20));
+        DWORD written = 0;
+        if (!WriteFile(out, bytes.data() + offset, chunk, &written, nullptr) || written == 0)
+        {
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::fwprintf(stderr, L"usage: binlog2ndjson <input.rlog|input.rlogz|input.logz> [output.ndjson]\n");
+        return 2;
+    }
+
+    std::string bytes;
+    if (!readLogFileBytes(argv[1], bytes))
+    {
+        std::fwprintf(stderr, L"binlog2ndjson: cannot read %ls (error %lu)\n", argv[1], GetLastError());
+        return 1;
+    }
+
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (argc == 3)
+    {
+        out = CreateFileW(argv[2], GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (out == INVALID_HANDLE_VALUE)
+        {
+            std::fwprintf(stderr, L"binlog2ndjson: cannot create %ls (error %lu)\n", argv[2], GetLastError());
+            return 1;
+        }
+    }
+
+    const auto magic = BinaryLogEncoder::kMagic;
+    const bool binary = bytes.size() >= sizeof(magic) && std::memcmp(bytes.data(), &magic, sizeof(magic)) == 0;
+
+    int status = 0;
+    bool writeFailed = false;           // as opposed to corrupt input
+    DWORD writeError = ERROR_SUCCESS;
+    if (!binary)
+    {
+        // Already text (a decompressed NDJSON log): pass it through.
+        if (!writeAll(out, bytes))
+        {
+            writeFailed = true;
+            writeError = GetLastError();
+            status = 1;
+        }
+    }
+    else
+    {
+        BinaryLogReader reader;
+        reader.openBuffer(std::move(bytes));
+
+        std::string chunk;
+        LogRecord record;
+        unsigned long long count = 0;
+        while (reader.next(record))
+        {
+            record.appendNDJsonLine(chunk);
+            ++count;
+            if (chunk.size() >= 1u << 20)
+            {
+                if (!writeAll(out, chunk)) { writeFailed = true; writeError = GetLastError(); status = 1; break; }
+                chunk.clear();
+            }
+        }
+        if (status == 0 && !writeAll(out, chunk))
+        {
+            writeFailed = true;
+            writeError = GetLastError();
+            status = 1;
+        }
+        if (reader.failed())
+        {
+            std::fwprintf(stderr, L"binlog2ndjson: corrupt input after %llu records\n", count);
+            status = 1;
+        }
+    }
+
+    if (writeFailed)
+    {
+        std::fwprintf(stderr, L"binlog2ndjson: write failed (error %lu)\n", writeError);
+    }
+    if (argc == 3)
+    {
+        CloseHandle(out);
+    }
+    return status;
+}
+
+#if defined(__MINGW32__)
+// MinGW links main() unless -municode is given.
+extern "C" int main()
+{
+    int argc = 0;
+    wchar_t** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == nullptr)
+    {
+        return 1;
+    }
+    const int status = wmain(argc, argv);
+    LocalFree(argv);
+    return status;
+}
+#endif